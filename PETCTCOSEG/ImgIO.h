@@ -9,6 +9,10 @@
 #include <itkImageFileWriter.h>
 #include <itkImageFileReader.h>
 #include <itkExtractImageFilter.h>
+#include <itkImageIOFactory.h>
+#include <itkImportImageFilter.h>
+#include <itkCastImageFilter.h>
+#include "optnet_vce_lib/optnet/_base/io/mapped_volume.hxx"
 
 /*! \class IMGIO
 *  \brief The image IO class
@@ -24,6 +28,8 @@ public:
 
 	template <typename Timage, typename TImagePointer> 
 		static TImagePointer LoadImg(string filename);
+	template <typename Timage>
+		static typename Timage::Pointer MapImg(string filename, optnet::io::mapped_volume& volume);
 	template <typename Timage, typename TImagePointer>
 		static bool  WriteImg(TImagePointer Img, std::string filename); 
 	template <typename Timage, typename TImagePointer, typename SizeType, typename IndexType, typename PointType, typename SpacingType> 
@@ -41,6 +47,17 @@ public:
 	*  \return An ITK image.
 	*/
 
+	/*! \fn template <typename Timage> static typename Timage::Pointer MapImg(string filename, optnet::io::mapped_volume& volume)
+	*  \brief An image loader that maps the voxels of an uncompressed Analyze or NRRD file.
+	*  Voxels are paged in from the file on first access instead of being read up front.
+	*  The geometry is read by ITK, as in LoadImg. Files that cannot be mapped are loaded
+	*  with LoadImg.
+	*  \param filename the name of the image needed to be loaded.
+	*  \param volume the mapping; it must outlive the returned image when the file type
+	*  matches the pixel type, since the image then uses the mapped voxels directly.
+	*  \return An ITK image.
+	*/
+
 	/*! \fn static template <typename Timage, typename TImagePointer> static bool  WriteImg(TImagePointer Img, std::string filename)
 	*  \brief An image Writer.
 	*  \param Img the image needed to be writen.
@@ -81,6 +98,85 @@ TImagePointer IMGIO::LoadImg(string filename)
 	return reader->GetOutput();
 }
 
+template <typename TPixel, typename Timage>
+typename Timage::Pointer ImportMappedImg(optnet::io::mapped_volume& volume, itk::ImageIOBase* io)
+{
+	const unsigned int Dimension = Timage::ImageDimension;
+	typedef itk::ImportImageFilter< TPixel, Dimension > ImportType;
+	typedef typename ImportType::OutputImageType MappedImageType;
+
+	typename ImportType::Pointer importer = ImportType::New();
+	typename ImportType::SizeType size;
+	typename ImportType::IndexType start;
+	typename ImportType::OriginType origin;
+	typename ImportType::SpacingType spacing;
+	typename ImportType::DirectionType direction;
+	size_t count = 1;
+	for ( unsigned int i = 0; i < Dimension; i++ )
+	{
+		size[i] = io->GetDimensions( i );
+		start[i] = 0;
+		origin[i] = io->GetOrigin( i );
+		spacing[i] = io->GetSpacing( i );
+		for ( unsigned int j = 0; j < Dimension; j++ )
+		{
+			direction[j][i] = io->GetDirection( i )[j];
+		}
+		count *= size[i];
+	}
+	typename ImportType::RegionType region;
+	region.SetSize( size );
+	region.SetIndex( start );
+	importer->SetRegion( region );
+	importer->SetOrigin( origin );
+	importer->SetSpacing( spacing );
+	importer->SetDirection( direction );
+	importer->SetImportPointer( static_cast< TPixel* >( volume.data() ), count, false );
+
+	// In place, a cast to the same pixel type passes the mapped buffer through.
+	typedef itk::CastImageFilter< MappedImageType, Timage > CastType;
+	typename CastType::Pointer caster = CastType::New();
+	caster->SetInput( importer->GetOutput() );
+	caster->InPlaceOn();
+	caster->Update();
+	return caster->GetOutput();
+}
+
+template <typename Timage>
+typename Timage::Pointer IMGIO::MapImg(string filename, optnet::io::mapped_volume& volume)
+{
+	const unsigned int Dimension = Timage::ImageDimension;
+	itk::ImageIOBase::Pointer io = itk::ImageIOFactory::CreateImageIO( filename.c_str(), itk::ImageIOFactory::ReadMode );
+
+	if ( !io.IsNull() && volume.open( filename.c_str() ) )
+	{
+		io->SetFileName( filename );
+		io->ReadImageInformation();
+
+		bool same = ( io->GetNumberOfComponents() == 1 && io->GetNumberOfDimensions() == Dimension );
+		for ( unsigned int i = 0; same && i < 4; i++ )
+		{
+			same = ( volume.size( i ) == ( i < Dimension ? io->GetDimensions( i ) : 1 ) );
+		}
+
+		if ( same )
+		{
+			switch ( volume.datatype() )
+			{
+			case DT_UNSIGNED_CHAR:	return ImportMappedImg< unsigned char, Timage >( volume, io );
+			case DT_SIGNED_SHORT:	return ImportMappedImg< short, Timage >( volume, io );
+			case DT_SIGNED_INT:		return ImportMappedImg< int, Timage >( volume, io );
+			case DT_FLOAT:			return ImportMappedImg< float, Timage >( volume, io );
+			case DT_DOUBLE:			return ImportMappedImg< double, Timage >( volume, io );
+			default:				break;
+			}
+		}
+		volume.close();
+	}
+
+	return LoadImg< Timage, typename Timage::Pointer >( filename );
+}
+
 template <typename Timage, typename TImagePointer>
 bool IMGIO::WriteImg(TImagePointer Img, std::string filename)
 {
@@ -7,6 +7,7 @@
 #include "time.h"
 #include "optnet_vce_lib/optnet/_base/array_ref.hxx"
 #include "optnet_vce_lib/optnet_graphcut/optnet_gs_gt_multi_dir.hxx"
+#include "optnet_vce_lib/optnet/_xtra/iwt.hxx"
 
 #include "itkPluginUtilities.h"
 
@@ -30,10 +31,19 @@ int main(int argc, char* argv[]){
 	const char * inputCTFile = inputVolume_CT.c_str();
 	const char * inputPETFile = inputVolume_PET.c_str();
 	int flagMultiSeeds = flag_MultiSeeds;
+	int multiLesion = flag_MultiLesion;
 	int withContext = 1;
 	int contextCoef = Context_Coef;
 	float upThres = up_Thres;
 	float lowThres = low_Thres;
+	int autoThres = auto_Thres;
+	float geodesicRadius = geodesic_Radius;
+	float diffusionAmount = diffusion_Amount;
+	int supervoxelSize = supervoxel_Size;
+	float supervoxelPreflood = supervoxel_Preflood;
+	float starRadius = star_Radius;
+	int starLevel = star_Level;
+	int starSmoothness = star_Smoothness;
 	const char * seedOb = inputVolume_OBJ.c_str();
 	const char * seedBg = inputVolume_BKG.c_str();	
 	const char * datacost_ct = inputVolume_CT_cost.c_str();
@@ -42,15 +52,39 @@ int main(int argc, char* argv[]){
 
 
 	int numSurf_graphcut = 2;
-	
+
+	// Every lesion keeps its own connected component.
+	if ( multiLesion == 1 )
+		flagMultiSeeds = 1;
+
 	typedef ImageType3DFLOAT InputImageType;
 	typedef ImageType3DCHAR OutputImageType;
 	typedef ImageType3DCHAR SeedImageType;
 	typedef ImageType3DFLOAT InternalImageType;
 	
 	InputImageType::Pointer originCTImage, originPETImage;
-	originCTImage = ImageIO.LoadImg< InputImageType, InputImageType::Pointer>( inputCTFile );
-	originPETImage = ImageIO.LoadImg< InputImageType, InputImageType::Pointer>( inputPETFile );
+	// Uncompressed inputs are mapped rather than read; the mappings back
+	// the images, so they stay open until the end of main.
+	optnet::io::mapped_volume ctVolume, petVolume;
+	originCTImage = ImageIO.MapImg< InputImageType >( inputCTFile, ctVolume );
+	originPETImage = ImageIO.MapImg< InputImageType >( inputPETFile, petVolume );
+
+	// The costs are built voxel by voxel, so the PET is brought onto the
+	// CT grid when the two volumes were not sampled or oriented alike.
+	InputImageType::SizeType ctSize = originCTImage->GetLargestPossibleRegion().GetSize();
+	InputImageType::SizeType petSize = originPETImage->GetLargestPossibleRegion().GetSize();
+	if ( ctSize != petSize || originCTImage->GetSpacing() != originPETImage->GetSpacing() || originCTImage->GetOrigin() != originPETImage->GetOrigin() ||
+		originCTImage->GetDirection() != originPETImage->GetDirection() )
+	{
+		cout << "Resampling the PET image onto the CT grid" << endl;
+		originPETImage = ResampleToReference< InputImageType >( originPETImage, originCTImage );
+	}
+
+	if ( diffusionAmount > 0 )
+	{
+		cout << "Smoothing the PET image" << endl;
+		DiffuseImage< InputImageType >( originPETImage, diffusionAmount );
+	}
 	
 	SeedImageType::Pointer seedImage[2];
 	seedImage[0] = ImageIO.LoadImg< SeedImageType, SeedImageType::Pointer>( seedOb );
@@ -110,6 +144,46 @@ int main(int argc, char* argv[]){
 
 	InternalImageType::IndexType index3D;
 
+	// Geodesic seed-distance stage: the voxels that are farther than
+	// geodesicRadius from the ob seeds are removed from the bg seed
+	// region, i.e., they get hard background t-links.
+	if ( geodesicRadius > 0 )
+	{
+		ImageType3DFLOAT::Pointer geodesicImage = ComputeGeodesicDistance< InternalImageType, SeedImageType >( scalePETImage, scaleCTImage, seedImage[0], seedImage[1], geodesicRadius );
+		itk::ImageRegionIterator< ImageType3DFLOAT > geodesicIt( geodesicImage, geodesicImage->GetLargestPossibleRegion() );
+		itk::ImageRegionIterator< SeedImageType > regionIt( seedImage[1], seedImage[1]->GetLargestPossibleRegion() );
+		long numBg = 0;
+		for ( geodesicIt.GoToBegin(), regionIt.GoToBegin(); !regionIt.IsAtEnd(); ++geodesicIt, ++regionIt )
+		{
+			if ( regionIt.Get() != 0 && geodesicIt.Get() >= geodesicRadius )
+			{
+				regionIt.Set( 0 );
+				numBg++;
+			}
+		}
+		cout << numBg << " voxels are beyond the geodesic radius" << endl;
+	}
+
+	// In the multi-lesion mode the ob seed image holds one ID per lesion.
+	// The IDs are kept for the lesion subgraphs, and the seeds are
+	// binarized so that the region costs are shared by all lesions.
+	OptNet::label_type lesionSeeds, lesionRegion;
+	if ( multiLesion == 1 )
+	{
+		lesionSeeds.create( CostImgSize[0], CostImgSize[1], CostImgSize[2] );
+		lesionRegion.create( CostImgSize[0], CostImgSize[1], CostImgSize[2] );
+
+		for( index3D[2] = 0;index3D[2] < static_cast<int> (CostImgSize[2]); ++index3D[2] )
+		   for ( index3D[1] = 0; index3D[1] < static_cast<int> (CostImgSize[1]); ++index3D[1] )
+			   for( index3D[0] = 0; index3D[0] < static_cast<int> (CostImgSize[0]); ++index3D[0] )
+			   {
+				  lesionSeeds( index3D[0], index3D[1], index3D[2] ) = seedImage[0]->GetPixel( index3D );
+				  lesionRegion( index3D[0], index3D[1], index3D[2] ) = seedImage[1]->GetPixel( index3D );
+				  if ( seedImage[0]->GetPixel( index3D ) != 0 )
+					  seedImage[0]->SetPixel( index3D, 1 );
+			   }
+	}
+
 	InternalImageType::Pointer costCTRegionImage, costPETRegionImage;
 	if (useCost == 1)
 	{
@@ -118,6 +192,8 @@ int main(int argc, char* argv[]){
 	}
 	else
 	{
+		if ( autoThres == 1 )
+			SelectPETThresholds< InputImageType >( originPETImage, upThres, lowThres );
 		costPETRegionImage = ComputePETRegionCost<InputImageType, SeedImageType>( originPETImage, seedImage[0], upThres, lowThres);
 		costCTRegionImage = ComputeRegionCost<InternalImageType, SeedImageType>( scaleCTImage, seedImage[0]);
 	}
@@ -186,8 +262,13 @@ int main(int argc, char* argv[]){
     //
     OptNet::net_type resImage( CostImgSize[0], CostImgSize[1], CostImgSize[2], numSurf_graphcut);
     OptNet optnet_graphcut;
-	cout << "Create the graph " << endl;
-    optnet_graphcut.create( CostImgSize[0], CostImgSize[1],CostImgSize[2], 0, numSurf_graphcut  );
+	if ( multiLesion != 1 && supervoxelSize <= 0 && starRadius <= 0 )
+	{
+		// The lesion, supervoxel and star graphs are created by
+		// solve_lesions(), solve_supervoxels() and solve_star().
+		cout << "Create the graph " << endl;
+		optnet_graphcut.create( CostImgSize[0], CostImgSize[1],CostImgSize[2], 0, numSurf_graphcut  );
+	}
 	
 	
 	
@@ -212,7 +293,49 @@ int main(int argc, char* argv[]){
 		optnet_graphcut.set_cutcut_relation( cut_context );
 	}
 		
-    optnet_graphcut.solve_all ( resImage, NULL);
+	if ( multiLesion == 1 )
+	{
+		OptNet::lesion_roi_vector lesionRois;
+		OptNet::find_lesion_rois( lesionSeeds, lesionRegion, lesionRois );
+		cout << "Solve " << lesionRois.size() << " lesion subgraphs" << endl;
+		optnet_graphcut.solve_lesions( lesionSeeds, lesionRois, resImage, NULL );
+	}
+	else if ( supervoxelSize > 0 )
+	{
+		// Supervoxels: the watershed regions of the CT gradient magnitude.
+		ImageType3DFLOAT::Pointer gradientImage = GradientMagnitude< InternalImageType >( scaleCTImage );
+		optnet::array_ref<float> relief( gradientImage->GetBufferPointer(), CostImgSize[0], CostImgSize[1], CostImgSize[2] );
+		optnet::xtra::iwt<float> supervoxels( relief );
+		supervoxels.set_preflood_height( supervoxelPreflood );
+		supervoxels.set_min_size( supervoxelSize );
+		supervoxels.compute();
+		cout << "Solve on " << supervoxels.num_regions() << " supervoxels" << endl;
+		optnet_graphcut.solve_supervoxels( supervoxels.labels(), supervoxels.num_regions(), resImage, NULL );
+	}
+	else if ( starRadius > 0 )
+	{
+		// Spherical columns from the centroid of the object seeds.
+		double center[3] = { 0, 0, 0 };
+		long numOb = 0;
+		for ( seedObIt.GoToBegin(); !seedObIt.IsAtEnd(); ++seedObIt )
+		{
+			if ( seedObIt.Get() != 0 )
+			{
+				for ( int d = 0; d < 3; d++ )
+					center[d] += seedObIt.GetIndex()[d];
+				numOb++;
+			}
+		}
+		for ( int d = 0; d < 3; d++ )
+			center[d] = ( numOb > 0 ) ? center[d] / numOb : 0.5 * ( CostImgSize[d] - 1 );
+
+		const OptNet::sphere_mesh_type& directions = optnet::xtra::graphics::sphere_mesh_cache<double>::global().get( 20, starLevel );
+		size_t numSamples = (size_t)ceil( starRadius ) + 1;
+		cout << "Solve on " << directions.num_vertices() << " spherical columns of " << numSamples << " samples" << endl;
+		optnet_graphcut.solve_star( center, directions, numSamples, 1.0, starSmoothness, resImage, NULL );
+	}
+	else
+		optnet_graphcut.solve_all ( resImage, NULL);
     cout<<"solve the graph"<<endl;
     cost_ob.clear();
     cost_bg.clear();
@@ -224,33 +347,15 @@ int main(int argc, char* argv[]){
 	float diff = ((float)t2 - (float)t1) / CLOCKS_PER_SEC;
 	cout << "The running time is " << diff << endl;
 
-    OutputImageType::Pointer resultImage[3];
-    typedef itk::CastImageFilter< InternalImageType, OutputImageType > CastType;
-
-	
-	for( int i = 0; i < 3; i++ )
+	// The binary result of every graph cut surface, one bit per voxel.
+	std::vector< optnet::bit_volume > resultMask( numSurf_graphcut );
+	for ( int i = 0; i < numSurf_graphcut; i++ )
 	{
-	   CastType::Pointer caster = CastType::New();
-	   caster->SetInput( scaleCTImage );
-	   caster->Update();
-	   resultImage[i] = caster->GetOutput();
-	   resultImage[i]->FillBuffer( 0 );
+		resultMask[i].create( CostImgSize[0], CostImgSize[1], CostImgSize[2] );
+		resultMask[i].assign( &resImage( 0, 0, 0, i ) );
 	}
-
-	for ( index3D[2] = 0; index3D[2] < static_cast<int>(CostImgSize[2]); ++index3D[2] )
-        for ( index3D[1] = 0; index3D[1] < static_cast<int>(CostImgSize[1]); ++index3D[1] )
-            for( index3D[0] = 0; index3D[0] < static_cast<int>(CostImgSize[0]); ++index3D[0] )
-			{
-				  int tmpValue = 0;
-				  
-				  for ( int i = 0; i < numSurf_graphcut; i++ )
-				  {
-					  tmpValue =  resImage( index3D[0], index3D[1], index3D[2], i ) * 255;
-					  resultImage[i]->SetPixel(index3D, tmpValue );
-				  }
-
-				  
-			}              
+	if ( multiLesion != 1 )    // Otherwise the lesion IDs are used below.
+		resImage.clear();
 
 	string resultFileName0, resultFileName1;
 	
@@ -288,14 +393,31 @@ int main(int argc, char* argv[]){
 	}
     	
 	OutputImageType::Pointer morpImage_CT[2];
-		
-	morpImage_CT[0] = MorpSmooth< OutputImageType >( resultImage[0], seed, 0, 0, flagMultiSeeds );
-	morpImage_CT[1] = MorpSmooth< OutputImageType >( resultImage[0], seed, 1, 1, flagMultiSeeds );
-
 	OutputImageType::Pointer morpImage_PET[2];
-		
-	morpImage_PET[0] = MorpSmooth< OutputImageType >( resultImage[1], seed, 0, 0, flagMultiSeeds );
-	morpImage_PET[1] = MorpSmooth< OutputImageType >( resultImage[1], seed, 1, 1, flagMultiSeeds );
+	optnet::bit_volume morpMask;
+
+	for ( int r = 0; r < 2; r++ )
+	{
+		MorpSmooth( resultMask[0], seed, r, r, flagMultiSeeds, morpMask );
+		morpImage_CT[r] = BitVolumeToImage< OutputImageType >( morpMask, scaleCTImage, 255 );
+		MorpSmooth( resultMask[1], seed, r, r, flagMultiSeeds, morpMask );
+		morpImage_PET[r] = BitVolumeToImage< OutputImageType >( morpMask, scaleCTImage, 255 );
+	}
+
+	if ( multiLesion == 1 )
+	{
+		// Write the lesion IDs instead of the binary masks. The opening
+		// never adds voxels, so every kept voxel has an ID.
+		for ( index3D[2] = 0; index3D[2] < static_cast<int>(CostImgSize[2]); ++index3D[2] )
+			for ( index3D[1] = 0; index3D[1] < static_cast<int>(CostImgSize[1]); ++index3D[1] )
+				for( index3D[0] = 0; index3D[0] < static_cast<int>(CostImgSize[0]); ++index3D[0] )
+				{
+					if ( morpImage_CT[1]->GetPixel( index3D ) != 0 )
+						morpImage_CT[1]->SetPixel( index3D, resImage( index3D[0], index3D[1], index3D[2], 0 ) );
+					if ( morpImage_PET[1]->GetPixel( index3D ) != 0 )
+						morpImage_PET[1]->SetPixel( index3D, resImage( index3D[0], index3D[1], index3D[2], 1 ) );
+				}
+	}
 
 
 	string morpFileName[2];
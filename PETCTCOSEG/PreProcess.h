@@ -7,14 +7,21 @@
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkConstNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
 #include "itkGradientAnisotropicDiffusionImageFilter.h"
 #include "itkAntiAliasBinaryImageFilter.h"
-#include "itkConnectedThresholdImageFilter.h"
-#include "itkBinaryDilateImageFilter.h"
-#include "itkBinaryErodeImageFilter.h"
-#include "itkBinaryBallStructuringElement.h"
 #include "itkStatisticsImageFilter.h"
+#include "itkResampleImageFilter.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkContinuousIndex.h"
 #include "ImageType.h"
+#include "optnet_vce_lib/optnet/_alpha/fast_marching3.hxx"
+#include "optnet_vce_lib/optnet/_base/array_ref.hxx"
+#include "optnet_vce_lib/optnet/_base/bit_volume.hxx"
+#include "optnet_vce_lib/optnet/_utils/interp_bspline3.hxx"
+#include "optnet_vce_lib/optnet/_utils/regiongrow.hxx"
+#include "optnet_vce_lib/optnet/_alpha/diffuse3.hxx"
+#include "optnet_vce_lib/optnet/_xtra/kmeans.hxx"
 
 
 using namespace std;
@@ -128,6 +135,37 @@ typename TInputImageType::Pointer antiAlias( typename TInputImageType::Pointer i
 	return castFilter->GetOutput();
 	
 }
+// Data-driven PET thresholds: the uptake is clustered into background,
+// intermediate and avid classes by k-means, and the boundaries between
+// the classes replace lowThres and upThres (both relative to the PET
+// intensity range, as in ComputePETRegionCost). The thresholds are kept
+// if the image has fewer than three distinct uptake levels.
+template < typename TInputImageType >
+void SelectPETThresholds( typename TInputImageType::Pointer inputImage, float& upThres, float& lowThres )
+{
+	const size_t n = inputImage->GetBufferedRegion().GetNumberOfPixels();
+	double means[3];
+	int kused = optnet::xtra::kmeans_scalar( inputImage->GetBufferPointer(), n, 3, means );
+	if ( kused < 3 )
+	{
+		cout << "Too few uptake levels for automatic thresholds" << endl;
+		return;
+	}
+
+	typedef itk::MinimumMaximumImageCalculator<TInputImageType> CalculatorType;
+	typename CalculatorType::Pointer cal = CalculatorType::New();
+	cal->SetImage( inputImage );
+	cal->SetRegion( inputImage->GetLargestPossibleRegion() );
+	cal->Compute();
+	double fMin = cal->GetMinimum();
+	double fScale = 1.0 / ( cal->GetMaximum() - fMin );
+
+	lowThres = ( 0.5 * ( means[0] + means[1] ) - fMin ) * fScale;
+	upThres = ( 0.5 * ( means[1] + means[2] ) - fMin ) * fScale;
+	cout << "Uptake class means are " << means[0] << ", " << means[1] << ", " << means[2] << endl;
+	cout << "Automatic thresholds are " << lowThres << " and " << upThres << endl;
+}
+
 template <typename TInputImageType, typename TObImageType >
 typename TInputImageType::Pointer ComputePETRegionCost( typename TInputImageType::Pointer inputImage, typename TObImageType::Pointer obImage, float upThres, float lowThres)
 {
@@ -306,80 +344,295 @@ typename TInputImageType::Pointer ComputeRegionCost( typename TInputImageType::P
 	
 }
 
+// Region-of-interest indicator of the geodesic marching: the nonzero
+// voxels of a seed image (see fast_marching3::solve).
+template < typename TObImageType >
+struct GeodesicROI
+{
+	GeodesicROI( typename TObImageType::Pointer image )
+	{
+		typename TObImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+		buffer = image->GetBufferPointer();
+		s0 = size[0];
+		s1 = size[1];
+	}
+	inline bool operator()( size_t i0, size_t i1, size_t i2 ) const
+	{
+		return buffer[ ( i2 * s1 + i1 ) * s0 + i0 ] != 0;
+	}
+	const typename TObImageType::PixelType* buffer;
+	size_t s0, s1;
+};
+
+// Geodesic distance from the ob seeds (1-voxels of obImage), marched with
+// fast_marching3 inside the bg seed region (1-voxels of regionImage).
+// The speed is high in PET-avid tissue and low across CT edges, and it
+// never exceeds 1, so the distance is at least the Euclidean distance in
+// voxels. Marching stops at maxDistance; voxels that are not reached
+// before it get the largest float value.
+template <typename TInputImageType, typename TObImageType >
+ImageType3DFLOAT::Pointer ComputeGeodesicDistance( typename TInputImageType::Pointer petImage, typename TInputImageType::Pointer ctImage, typename TObImageType::Pointer obImage, typename TObImageType::Pointer regionImage, float maxDistance )
+{
+	typedef itk::GradientMagnitudeRecursiveGaussianImageFilter< TInputImageType, ImageType3DFLOAT > GradientType;
+	typename GradientType::Pointer gradient = GradientType::New();
+	gradient->SetInput( ctImage );
+	gradient->SetSigma( ctImage->GetSpacing()[0] );
+	gradient->Update();
+	ImageType3DFLOAT::Pointer speedImage = gradient->GetOutput();
+
+	typedef itk::StatisticsImageFilter<ImageType3DFLOAT> StatisticsFilterType;
+	typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
+	statisticsFilter->SetInput( speedImage );
+	statisticsFilter->Update();
+	float gMean = statisticsFilter->GetMean();
+	if ( gMean <= 0 )
+		gMean = 1;
+
+	typedef itk::MinimumMaximumImageCalculator<TInputImageType> CalculatorType;
+	typename CalculatorType::Pointer cal = CalculatorType::New();
+	cal->SetImage( petImage );
+	cal->SetRegion( petImage->GetLargestPossibleRegion() );
+	cal->Compute();
+	float pMin = static_cast<float>(cal->GetMinimum());
+
+	// The PET uptake is normalized by the mean uptake of the ob seeds, so
+	// that hot spots brighter than the lesion do not set the scale.
+	typedef itk::ImageRegionIterator< TInputImageType > IteratorInputType;
+	typedef itk::ImageRegionIteratorWithIndex< TObImageType > IteratorObType;
+	IteratorInputType petIt( petImage, petImage->GetLargestPossibleRegion() );
+	IteratorObType obIt( obImage, obImage->GetLargestPossibleRegion() );
+	double sum = 0;
+	long numPt = 0;
+	for ( petIt.GoToBegin(), obIt.GoToBegin(); !petIt.IsAtEnd(); ++petIt, ++obIt)
+	{
+		if ( obIt.Get() != 0 )
+		{
+			sum = sum + petIt.Get();
+			numPt++;
+		}
+	}
+	float pScale = ( numPt > 0 && sum / numPt > pMin ) ? 1.0 / ( sum / numPt - pMin ) : 0.0;
+
+	// speed = (0.1 + 0.9 * min(normalized PET, 1)) / (1 + CT gradient / mean gradient)
+	IteratorType3DFLOAT speedIt( speedImage, speedImage->GetLargestPossibleRegion() );
+	for ( petIt.GoToBegin(), speedIt.GoToBegin(); !speedIt.IsAtEnd(); ++petIt, ++speedIt)
+	{
+		float pet = ( petIt.Get() - pMin ) * pScale;
+		if ( pet > 1 )
+			pet = 1;
+		speedIt.Set( ( 0.1 + 0.9 * pet ) / ( 1 + speedIt.Get() / gMean ) );
+	}
+
+	ImageType3DFLOAT::Pointer timeImage = ImageType3DFLOAT::New();
+	timeImage->SetRegions( speedImage->GetLargestPossibleRegion() );
+	timeImage->CopyInformation( speedImage );
+	timeImage->Allocate();
+	timeImage->FillBuffer( std::numeric_limits<float>::max() );
+
+	typename TInputImageType::SizeType size = speedImage->GetLargestPossibleRegion().GetSize();
+	optnet::array_ref<float> speed( speedImage->GetBufferPointer(), size[0], size[1], size[2] );
+	optnet::array_ref<float> time( timeImage->GetBufferPointer(), size[0], size[1], size[2] );
+
+	// The bucketed queue is accurate to half a voxel, which is plenty for
+	// a distance threshold.
+	typedef optnet::fast_marching3<float, float> MarchingType;
+	MarchingType marching;
+	marching.set_queue( MarchingType::UNTIDY_QUEUE );
+	marching.create( time, &speed );
+
+	MarchingType::node_type node;
+	node.value = 0;
+	for ( obIt.GoToBegin(); !obIt.IsAtEnd(); ++obIt)
+	{
+		if ( obIt.Get() != 0 )
+		{
+			node.index[0] = obIt.GetIndex()[0];
+			node.index[1] = obIt.GetIndex()[1];
+			node.index[2] = obIt.GetIndex()[2];
+			marching.trial_nodes().push_back( node );
+		}
+	}
+	cout << "Geodesic marching from " << marching.trial_nodes().size() << " seeds" << endl;
+
+	marching.solve( GeodesicROI<TObImageType>( regionImage ), maxDistance );
+	return timeImage;
+}
+
+// Resamples inputImage onto the grid (size, spacing, origin and
+// direction) of referenceImage with a cubic B-spline, e.g., the PET onto
+// the CT grid.
+template < typename TInputImageType >
+typename TInputImageType::Pointer ResampleToReference( typename TInputImageType::Pointer inputImage, typename TInputImageType::Pointer referenceImage )
+{
+	typedef typename TInputImageType::PixelType PixelType;
+
+	// The grid walk below needs the two grids to share their axes. An
+	// input in another orientation goes through ITK's resampler, which
+	// maps every output voxel through physical space.
+	if ( inputImage->GetDirection() != referenceImage->GetDirection() )
+	{
+		typedef itk::BSplineInterpolateImageFunction< TInputImageType, double > InterpolatorType;
+		typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+		interpolator->SetSplineOrder( 3 );
+
+		typedef itk::ResampleImageFilter< TInputImageType, TInputImageType > ResampleFilterType;
+		typename ResampleFilterType::Pointer resampler = ResampleFilterType::New();
+		resampler->SetInput( inputImage );
+		resampler->SetInterpolator( interpolator );
+		resampler->SetOutputParametersFromImage( referenceImage );
+		resampler->SetDefaultPixelValue( 0 );
+		resampler->Update();
+		return resampler->GetOutput();
+	}
+
+	typename TInputImageType::SizeType inSize = inputImage->GetLargestPossibleRegion().GetSize();
+	typename TInputImageType::SizeType refSize = referenceImage->GetLargestPossibleRegion().GetSize();
+
+	// The first reference voxel, in input voxels; the shared direction
+	// is applied to the offset between the origins.
+	itk::ContinuousIndex< double, 3 > start;
+	inputImage->TransformPhysicalPointToContinuousIndex( referenceImage->GetOrigin(), start );
+
+	double origin[3], step[3];
+	for ( int d = 0; d < 3; d++ )
+	{
+		origin[d] = start[d];
+		step[d] = referenceImage->GetSpacing()[d] / inputImage->GetSpacing()[d];
+	}
+
+	typename TInputImageType::Pointer outputImage = TInputImageType::New();
+	outputImage->SetRegions( referenceImage->GetLargestPossibleRegion() );
+	outputImage->CopyInformation( referenceImage );
+	outputImage->Allocate();
+
+	optnet::array_ref<PixelType> input( inputImage->GetBufferPointer(), inSize[0], inSize[1], inSize[2] );
+	optnet::array_ref<PixelType> output( outputImage->GetBufferPointer(), refSize[0], refSize[1], refSize[2] );
+
+	optnet::utils::interp_bspline3<PixelType> interp;
+	interp.create( input, 3 );
+	interp.interpolate_grid( output, origin, step );
+	return outputImage;
+}
+
+// Gradient magnitude of inputImage, smoothed at the scale of one voxel.
+template < typename TInputImageType >
+ImageType3DFLOAT::Pointer GradientMagnitude( typename TInputImageType::Pointer inputImage )
+{
+	typedef itk::GradientMagnitudeRecursiveGaussianImageFilter< TInputImageType, ImageType3DFLOAT > GradientType;
+	typename GradientType::Pointer gradient = GradientType::New();
+	gradient->SetInput( inputImage );
+	gradient->SetSigma( inputImage->GetSpacing()[0] );
+	gradient->Update();
+	return gradient->GetOutput();
+}
+
+// Edge-preserving smoothing of inputImage (in place) by diffuse3. The
+// diffusivity falls off with the gradient magnitude, so that the lesion
+// boundary is kept while the noise inside the uptake is flattened.
+template < typename TInputImageType >
+void DiffuseImage( typename TInputImageType::Pointer inputImage, float amount )
+{
+	typedef typename TInputImageType::PixelType PixelType;
+	typedef itk::GradientMagnitudeRecursiveGaussianImageFilter< TInputImageType, ImageType3DFLOAT > GradientType;
+	typename GradientType::Pointer gradient = GradientType::New();
+	gradient->SetInput( inputImage );
+	gradient->SetSigma( inputImage->GetSpacing()[0] );
+	gradient->Update();
+	ImageType3DFLOAT::Pointer weightImage = gradient->GetOutput();
+
+	typedef itk::StatisticsImageFilter<ImageType3DFLOAT> StatisticsFilterType;
+	typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
+	statisticsFilter->SetInput( weightImage );
+	statisticsFilter->Update();
+	float gMean = statisticsFilter->GetMean();
+	if ( gMean <= 0 )
+		gMean = 1;
+
+	// weight = 1 / (1 + (gradient / mean gradient)^2)
+	IteratorType3DFLOAT weightIt( weightImage, weightImage->GetLargestPossibleRegion() );
+	for ( weightIt.GoToBegin(); !weightIt.IsAtEnd(); ++weightIt )
+	{
+		float g = weightIt.Get() / gMean;
+		weightIt.Set( 1.0 / ( 1.0 + g * g ) );
+	}
+
+	typename TInputImageType::SizeType size = inputImage->GetLargestPossibleRegion().GetSize();
+	optnet::array_ref<PixelType> image( inputImage->GetBufferPointer(), size[0], size[1], size[2] );
+	optnet::array_ref<float> weights( weightImage->GetBufferPointer(), size[0], size[1], size[2] );
+	bool converged = optnet::diffuse3( image, weights, amount, 0.1, 0.01, 200 );
+	cout << "Diffusion " << ( converged ? "converged" : "stopped at the iteration limit" ) << endl;
+}
+
 template < typename TInputImageType >
 typename TInputImageType::Pointer ConnectThres( typename TInputImageType::Pointer inputImage, typename TInputImageType::IndexType& index )
 {
-	typedef itk::ConnectedThresholdImageFilter< TInputImageType, TInputImageType > ConnectedFilterType;
-    typename ConnectedFilterType::Pointer connectedThreshold = ConnectedFilterType::New();
-	connectedThreshold->SetInput( inputImage );
-	connectedThreshold->SetLower(  254  );
-    connectedThreshold->SetUpper(  255  );
-	connectedThreshold->SetReplaceValue( 255 );
-	connectedThreshold->SetSeed( index );
-	connectedThreshold->Update();
-	return connectedThreshold->GetOutput();
+	// Keep the 6-connected voxels in [254, 255] that reach the seed; the
+	// scanline fill queues runs of voxels instead of single voxels.
+	typedef typename TInputImageType::PixelType PixelType;
+	typename TInputImageType::SizeType size = inputImage->GetLargestPossibleRegion().GetSize();
+
+	typename TInputImageType::Pointer outputImage = TInputImageType::New();
+	outputImage->SetRegions( inputImage->GetLargestPossibleRegion() );
+	outputImage->CopyInformation( inputImage );
+	outputImage->Allocate();
+	outputImage->FillBuffer( 0 );
+
+	if ( index[0] < 0 || index[1] < 0 || index[2] < 0 ||
+		(size_t)index[0] >= size[0] || (size_t)index[1] >= size[1] || (size_t)index[2] >= size[2] )
+		return outputImage;
+
+	optnet::array_ref<PixelType> input( inputImage->GetBufferPointer(), size[0], size[1], size[2] );
+	optnet::array_ref<PixelType> output( outputImage->GetBufferPointer(), size[0], size[1], size[2] );
+	optnet::utils::regiongrow_3d( input, index[0], index[1], index[2],
+		optnet::utils::regiongrow_range<PixelType>( 254, 255 ), output, (PixelType)255, 6 );
+	return outputImage;
 	
 }
+// Set a bit volume from the voxels of an image in [lower, upper].
 template < typename TInputImageType >
-typename TInputImageType::Pointer MorpSmooth( typename TInputImageType::Pointer inputImage, typename TInputImageType::IndexType& index, typename TInputImageType::PixelType TubeRadius1, typename TInputImageType::PixelType TubeRadius2, int flagNoConnected )
+void ImageToBitVolume( typename TInputImageType::Pointer inputImage, typename TInputImageType::PixelType lower, typename TInputImageType::PixelType upper, optnet::bit_volume& mask )
 {
-    typename TInputImageType::Pointer tmpImage;
-	if (flagNoConnected == 1)
-	tmpImage = inputImage;
-	else
+	typename TInputImageType::SizeType size = inputImage->GetLargestPossibleRegion().GetSize();
+	mask.create( size[0], size[1], size[2] );
+	mask.assign( inputImage->GetBufferPointer(), lower, upper );
+}
+
+// Create an image with the geometry of the reference image; the voxels
+// set in the mask get the given value and all others 0.
+template < typename TOutputImageType >
+typename TOutputImageType::Pointer BitVolumeToImage( const optnet::bit_volume& mask, const itk::ImageBase<3>* reference, typename TOutputImageType::PixelType value )
+{
+	typename TOutputImageType::Pointer outputImage = TOutputImageType::New();
+	outputImage->SetRegions( reference->GetLargestPossibleRegion() );
+	outputImage->CopyInformation( reference );
+	outputImage->Allocate();
+	mask.copy_to( outputImage->GetBufferPointer(), value );
+	return outputImage;
+}
+
+// Keep the component of the mask connected to the seed (unless
+// flagNoConnected is 1), then open it with balls of the given radii.
+template < typename TIndexType >
+void MorpSmooth( const optnet::bit_volume& inputMask, const TIndexType& index, int TubeRadius1, int TubeRadius2, int flagNoConnected, optnet::bit_volume& outputMask )
+{
+	outputMask = inputMask;
+	if ( flagNoConnected != 1 )
 	{
-		typedef itk::ConnectedThresholdImageFilter< TInputImageType, TInputImageType > ConnectedFilterType;
-		typename ConnectedFilterType::Pointer connectedThreshold = ConnectedFilterType::New();
-		//connectedThreshold->SetInput( erodeImageFilter->GetOutput() );
-		connectedThreshold->SetInput( inputImage );
-		connectedThreshold->SetLower(  254  );
-		connectedThreshold->SetUpper(  255  );
-		connectedThreshold->SetReplaceValue( 255 );
-		connectedThreshold->SetSeed( index );
-		connectedThreshold->Update();
-		tmpImage = connectedThreshold->GetOutput();
+		if ( index[0] < 0 || index[1] < 0 || index[2] < 0 )
+			outputMask.clear();
+		else
+			outputMask.keep_component( index[0], index[1], index[2] );
 	}
+	outputMask.erode( TubeRadius1 );
+	outputMask.dilate( TubeRadius2 );
+}
 
-	typedef itk::BinaryBallStructuringElement< float, 3> StructuringElementType;
-
-    StructuringElementType structuringElement1;
-    structuringElement1.SetRadius( TubeRadius1 );
-    structuringElement1.CreateStructuringElement();
-
-	typedef itk::BinaryErodeImageFilter< TInputImageType, TInputImageType, StructuringElementType > ErodeImageFilterType;
-    typename ErodeImageFilterType::Pointer erodeImageFilter = ErodeImageFilterType::New();
-	//erodeImageFilter->SetInput( inputImage );
-	erodeImageFilter->SetInput( tmpImage );
-	erodeImageFilter->SetKernel( structuringElement1 );
-	erodeImageFilter->SetErodeValue( 255 );
-	erodeImageFilter->Update();
-
-    /*
-	//temporary test
-	index[0]=42; index[1]=44; index[2]=44;
-    typename ConnectedFilterType::Pointer connectedThreshold2 = ConnectedFilterType::New();
-	connectedThreshold2->SetInput( erodeImageFilter->GetOutput() );
-	//connectedThreshold->SetInput( inputImage );
-	connectedThreshold2->SetLower(  254  );
-    connectedThreshold2->SetUpper(  255  );
-	connectedThreshold2->SetReplaceValue( 255 );
-	connectedThreshold2->SetSeed( index );
-	connectedThreshold2->Update();
-	*/
-
-
-    StructuringElementType structuringElement2;
-    structuringElement2.SetRadius( TubeRadius2 );
-    structuringElement2.CreateStructuringElement();
-
-	typedef itk::BinaryDilateImageFilter< TInputImageType, TInputImageType, StructuringElementType > DilateImageFilterType;
-    typename DilateImageFilterType::Pointer dilateImageFilter = DilateImageFilterType::New();
-	//dilateImageFilter->SetInput( connectedThreshold2->GetOutput() );
-	dilateImageFilter->SetInput( erodeImageFilter->GetOutput() );
-	dilateImageFilter->SetKernel( structuringElement2 );
-	dilateImageFilter->SetDilateValue( 255 );
-	dilateImageFilter->Update();
-
-	return dilateImageFilter->GetOutput();
-	
+template < typename TInputImageType >
+typename TInputImageType::Pointer MorpSmooth( typename TInputImageType::Pointer inputImage, typename TInputImageType::IndexType& index, typename TInputImageType::PixelType TubeRadius1, typename TInputImageType::PixelType TubeRadius2, int flagNoConnected )
+{
+	// The connected filter keeps [254, 255]; the erosion only 255.
+	optnet::bit_volume mask, smoothMask;
+	ImageToBitVolume<TInputImageType>( inputImage, ( flagNoConnected == 1 ) ? 255 : 254, 255, mask );
+	MorpSmooth( mask, index, TubeRadius1, TubeRadius2, flagNoConnected, smoothMask );
+	return BitVolumeToImage<TInputImageType>( smoothMask, inputImage, 255 );
 }
\ No newline at end of file
@@ -19,7 +19,20 @@
 
 extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char* []);
 
+int optnetGraphCutTest(int, char* []);
+int optnetBitVolumeTest(int, char* []);
+int optnetMaxflowLayoutTest(int, char* []);
+int optnetResolveTest(int, char* []);
+int optnetColumnPruningTest(int, char* []);
+int optnetSupervoxelTest(int, char* []);
+
 void RegisterTests()
 {
   StringToTestFunctionMap["ModuleEntryPoint"] = ModuleEntryPoint;
+  StringToTestFunctionMap["optnetGraphCutTest"] = optnetGraphCutTest;
+  StringToTestFunctionMap["optnetBitVolumeTest"] = optnetBitVolumeTest;
+  StringToTestFunctionMap["optnetMaxflowLayoutTest"] = optnetMaxflowLayoutTest;
+  StringToTestFunctionMap["optnetResolveTest"] = optnetResolveTest;
+  StringToTestFunctionMap["optnetColumnPruningTest"] = optnetColumnPruningTest;
+  StringToTestFunctionMap["optnetSupervoxelTest"] = optnetSupervoxelTest;
 }
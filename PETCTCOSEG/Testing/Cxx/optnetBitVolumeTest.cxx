@@ -0,0 +1,65 @@
+#include "itkBinaryBallStructuringElement.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+#include "optnet/_base/bit_volume.hxx"
+
+// The ball of bit_volume::erode() and dilate() must be the ball of
+// itk::BinaryBallStructuringElement, which MorpSmooth() used before:
+// the same voxels, 19 of them for a radius of 1. Dilating a single
+// voxel gives the ball; eroding the ball back must leave only the
+// center voxel.
+int optnetBitVolumeTest(int, char* [])
+{
+  typedef itk::BinaryBallStructuringElement< unsigned char, 3 > BallType;
+
+  int errors = 0;
+
+  for ( int r = 1; r <= 2; r++ )
+  {
+    BallType ball;
+    ball.SetRadius( r );
+    ball.CreateStructuringElement();
+
+    const int s = 2 * r + 3, c = r + 1;
+    optnet::bit_volume volume( s, s, s );
+    volume.set( c, c, c, true );
+    volume.dilate( r );
+
+    int itkSize = 0;
+    for ( unsigned int n = 0; n < ball.Size(); n++ )
+    {
+      BallType::OffsetType d = ball.GetOffset( n );
+      bool inBall = ball[n] != 0;
+      if ( inBall )
+        itkSize++;
+      if ( volume.get( c + d[0], c + d[1], c + d[2] ) != inBall )
+        errors++;
+    }
+
+    if ( ( r == 1 && itkSize != 19 ) || (int)volume.count() != itkSize )
+    {
+      std::cerr << "Radius " << r << ": ITK ball " << itkSize << " voxels, bit_volume ball "
+                << volume.count() << std::endl;
+      errors++;
+    }
+
+    volume.erode( r );
+    if ( volume.count() != 1 || !volume.get( c, c, c ) )
+    {
+      std::cerr << "Radius " << r << ": eroding the ball left " << volume.count() << " voxels" << std::endl;
+      errors++;
+    }
+  }
+
+  if ( errors != 0 )
+  {
+    std::cerr << errors << " errors" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "bit_volume balls match ITK" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+// The solver's assertions are part of what is tested here.
+#ifdef NDEBUG
+# undef NDEBUG
+#endif
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+// optnet_graphcut is written against the std namespace, as in PETCTCOSEG.cxx.
+using namespace std;
+
+#include "optnet_graphcut/optnet_gs_gt_multi_dir.hxx"
+
+// Solve a graph-cut-only problem, set up the way the CLI sets it up:
+// no graph search surface and no graph search cost. The object costs
+// favour a cube in the middle of the volume, which must come out as
+// the object.
+int optnetGraphCutTest(int, char* [])
+{
+  typedef optnet::optnet_gs_gt_multi_dir<int, long, optnet::net_f_xy> OptNet;
+
+  const int s0 = 12, s1 = 10, s2 = 8;
+
+  OptNet::cost_array_type cost_ob, cost_bg, cost_neigh;
+  cost_ob.create( s0, s1, s2, 1 );
+  cost_bg.create( s0, s1, s2, 1 );
+  cost_neigh.create( s0, s1, s2, 1 );
+
+  for ( int i2 = 0; i2 < s2; i2++ )
+    for ( int i1 = 0; i1 < s1; i1++ )
+      for ( int i0 = 0; i0 < s0; i0++ )
+      {
+        bool inside = i0 >= 3 && i0 < 9 && i1 >= 3 && i1 < 7 && i2 >= 2 && i2 < 6;
+        cost_ob( i0, i1, i2, 0 ) = inside ? 100 : 0;
+        cost_bg( i0, i1, i2, 0 ) = inside ? 0 : 100;
+        cost_neigh( i0, i1, i2, 0 ) = 0;
+      }
+
+  OptNet optnet_graphcut;
+  optnet_graphcut.create( s0, s1, s2, 0, 1 );
+  optnet_graphcut.set_ob_cost( cost_ob );
+  optnet_graphcut.set_bg_cost( cost_bg );
+  optnet_graphcut.set_neigh_cost( cost_neigh );
+  long neigh_coef[1] = { 1 };
+  optnet_graphcut.set_neigh_coef( neigh_coef );
+
+  OptNet::net_type resImage( s0, s1, s2, 1 );
+  long flow = -1;
+  optnet_graphcut.solve_all( resImage, &flow );
+
+  int errors = 0;
+  for ( int i2 = 0; i2 < s2; i2++ )
+    for ( int i1 = 0; i1 < s1; i1++ )
+      for ( int i0 = 0; i0 < s0; i0++ )
+      {
+        bool inside = i0 >= 3 && i0 < 9 && i1 >= 3 && i1 < 7 && i2 >= 2 && i2 < 6;
+        if ( ( resImage( i0, i1, i2, 0 ) != 0 ) != inside )
+          errors++;
+      }
+
+  if ( errors != 0 )
+  {
+    std::cerr << errors << " voxels labelled wrongly" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Graph-cut-only solve passed, flow " << flow << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+#include "optnet/_utils/maxflow_bench.hxx"
+
+// The structure-of-arrays solver must find the same maximum flow and the
+// same minimum cut as optnet_fs_maxflow. Both solvers are built from the
+// synthetic benchmark graph, for several sizes (including short columns)
+// and several pseudo-random capacities.
+int optnetMaxflowLayoutTest(int, char* [])
+{
+  const size_t sizes[][3] = { { 9, 7, 5 }, { 16, 12, 10 }, { 20, 6, 2 }, { 3, 4, 3 } };
+
+  int errors = 0;
+
+  for ( unsigned int n = 0; n < sizeof( sizes ) / sizeof( sizes[0] ); n++ )
+  {
+    for ( unsigned int seed = 1; seed <= 3; seed++ )
+    {
+      const size_t s0 = sizes[n][0], s1 = sizes[n][1], s2 = sizes[n][2];
+
+      optnet::optnet_fs_maxflow<long> aos;
+      optnet::optnet_fs_maxflow_soa<long> soa;
+      optnet::utils::build_maxflow_bench_graph( aos, s0, s1, s2, seed );
+      optnet::utils::build_maxflow_bench_graph( soa, s0, s1, s2, seed );
+
+      long flowAos = aos.solve();
+      long flowSoa = soa.solve();
+      if ( flowAos != flowSoa )
+      {
+        std::cerr << s0 << "x" << s1 << "x" << s2 << ", seed " << seed << ": flow "
+                  << flowSoa << ", expected " << flowAos << std::endl;
+        errors++;
+      }
+
+      int cutErrors = 0;
+      for ( size_t i2 = 0; i2 < s2; i2++ )
+        for ( size_t i1 = 0; i1 < s1; i1++ )
+          for ( size_t i0 = 0; i0 < s0; i0++ )
+            if ( aos.in_source_set( i0, i1, i2 ) != soa.in_source_set( i0, i1, i2 ) )
+              cutErrors++;
+
+      if ( cutErrors != 0 )
+      {
+        std::cerr << s0 << "x" << s1 << "x" << s2 << ", seed " << seed << ": "
+                  << cutErrors << " nodes on the wrong side of the cut" << std::endl;
+        errors++;
+      }
+    }
+  }
+
+  if ( errors != 0 )
+  {
+    std::cerr << errors << " errors" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "SoA max-flow matches optnet_fs_maxflow" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "optnet/_fs/optnet_fs_maxflow.hxx"
+#include "optnet/_xtra/bk_fs_maxflow.hxx"
+
+namespace
+{
+
+const size_t s0 = 12, s1 = 10, s2 = 8;
+
+// Linear congruential generator (portable and repeatable).
+unsigned int NextRandom( unsigned int& seed )
+{
+  seed = seed * 1103515245u + 12345u;
+  return ( seed >> 16 ) & 0x7FFF;
+}
+
+// Columns with infinite intra- and inter-column arcs, as in a graph search.
+void BuildGraph( optnet::optnet_fs_maxflow<long>& solver, const std::vector<long>& s, const std::vector<long>& t )
+{
+  solver.create( s0, s1, s2 );
+  for ( size_t i2 = 0; i2 < s2; i2++ )
+    for ( size_t i1 = 0; i1 < s1; i1++ )
+      for ( size_t i0 = 0; i0 < s0; i0++ )
+      {
+        size_t n = ( i2 * s1 + i1 ) * s0 + i0;
+        solver.add_st_arc( s[n], t[n], i0, i1, i2 );
+        if ( i2 > 0 )
+          solver.add_arc( i0, i1, i2, i0, i1, i2 - 1 );
+        if ( i2 > 0 && i0 + 1 < s0 )
+        {
+          solver.add_arc( i0, i1, i2, i0 + 1, i1, i2 - 1 );
+          solver.add_arc( i0 + 1, i1, i2, i0, i1, i2 - 1 );
+        }
+        if ( i2 > 0 && i1 + 1 < s1 )
+        {
+          solver.add_arc( i0, i1, i2, i0, i1 + 1, i2 - 1 );
+          solver.add_arc( i0, i1 + 1, i2, i0, i1, i2 - 1 );
+        }
+      }
+}
+
+// A 6-connected grid with finite capacities, as in a graph cut.
+void BuildGraph( optnet::xtra::bk_fs_maxflow<long>& solver, const std::vector<long>& s, const std::vector<long>& t )
+{
+  solver.create( s0, s1, s2 );
+  for ( size_t i2 = 0; i2 < s2; i2++ )
+    for ( size_t i1 = 0; i1 < s1; i1++ )
+      for ( size_t i0 = 0; i0 < s0; i0++ )
+      {
+        size_t n = ( i2 * s1 + i1 ) * s0 + i0;
+        long c = 3 + (long)( n % 5 );
+        solver.add_st_arc( s[n], t[n], i0, i1, i2 );
+        if ( i0 + 1 < s0 )
+          solver.add_arc( i0, i1, i2, i0 + 1, i1, i2, c, c );
+        if ( i1 + 1 < s1 )
+          solver.add_arc( i0, i1, i2, i0, i1 + 1, i2, c, c );
+        if ( i2 + 1 < s2 )
+          solver.add_arc( i0, i1, i2, i0, i1, i2 + 1, c, c );
+      }
+}
+
+// Changes the terminal capacities of a few nodes at a time, re-solves
+// with resolve() and compares the flow and the cut with a solver built
+// from scratch with the changed capacities.
+template < typename SolverType >
+int TestResolve( const char* name )
+{
+  const size_t n = s0 * s1 * s2;
+  unsigned int seed = 7;
+  std::vector<long> s( n ), t( n );
+  for ( size_t k = 0; k < n; k++ )
+  {
+    s[k] = NextRandom( seed ) % 40;
+    t[k] = NextRandom( seed ) % 40;
+  }
+
+  SolverType dynamic;
+  BuildGraph( dynamic, s, t );
+  dynamic.solve();
+
+  int errors = 0;
+  for ( int round = 0; round < 6; round++ )
+  {
+    for ( int c = 0; c < 12; c++ )
+    {
+      size_t k = NextRandom( seed ) % n;
+      long ds = (long)( NextRandom( seed ) % 61 ) - 30;
+      long dt = (long)( NextRandom( seed ) % 61 ) - 30;
+      if ( s[k] + ds < 0 )
+        ds = -s[k];
+      if ( t[k] + dt < 0 )
+        dt = -t[k];
+      s[k] += ds;
+      t[k] += dt;
+      dynamic.update_st_arc( ds, dt, k % s0, k / s0 % s1, k / s0 / s1 );
+    }
+    long flow = dynamic.resolve();
+
+    SolverType fresh;
+    BuildGraph( fresh, s, t );
+    long expected = fresh.solve();
+
+    int cutErrors = 0;
+    for ( size_t i2 = 0; i2 < s2; i2++ )
+      for ( size_t i1 = 0; i1 < s1; i1++ )
+        for ( size_t i0 = 0; i0 < s0; i0++ )
+          if ( dynamic.in_source_set( i0, i1, i2 ) != fresh.in_source_set( i0, i1, i2 ) )
+            cutErrors++;
+
+    if ( flow != expected || cutErrors != 0 )
+    {
+      std::cerr << name << ", round " << round << ": flow " << flow << ", expected " << expected
+                << ", " << cutErrors << " nodes on the wrong side of the cut" << std::endl;
+      errors++;
+    }
+  }
+  return errors;
+}
+
+} // namespace
+
+// resolve() reuses the search trees of the previous solve; after any
+// series of update_st_arc() calls it must still find the maximum flow
+// and the cut of the changed graph.
+int optnetResolveTest(int, char* [])
+{
+  int errors = TestResolve< optnet::optnet_fs_maxflow<long> >( "optnet_fs_maxflow" )
+             + TestResolve< optnet::xtra::bk_fs_maxflow<long> >( "bk_fs_maxflow" );
+
+  if ( errors != 0 )
+  {
+    std::cerr << errors << " errors" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "resolve() matches solves from scratch" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// optnet_graphcut is written against the std namespace, as in PETCTCOSEG.cxx.
+using namespace std;
+
+#include "optnet_graphcut/optnet_gs_gt_multi_dir.hxx"
+
+// With one region per voxel, the supervoxel graph is the voxel graph, so
+// solve_supervoxels() must give the labels and the flow of solve_all().
+// Two graph cut surfaces (CT and PET) are coupled by a context cost, as
+// in the CLI.
+int optnetSupervoxelTest(int, char* [])
+{
+  typedef optnet::optnet_gs_gt_multi_dir<int, long, optnet::net_f_xy> OptNet;
+
+  const int s = 12;
+
+  OptNet::cost_array_type cost_ob( s, s, s, 2 ), cost_bg( s, s, s, 2 );
+  OptNet::cost_array_type cost_neigh( s, s, s, 2 ), cost_context( s, s, s, 2 );
+
+  // A noisy ball of radius 4 in the middle of the volume.
+  unsigned int seed = 9;
+  for ( int i2 = 0; i2 < s; i2++ )
+    for ( int i1 = 0; i1 < s; i1++ )
+      for ( int i0 = 0; i0 < s; i0++ )
+      {
+        double d = sqrt( ( i0 - 6.0 ) * ( i0 - 6.0 ) + ( i1 - 6.0 ) * ( i1 - 6.0 ) + ( i2 - 6.0 ) * ( i2 - 6.0 ) );
+        for ( int k = 0; k < 2; k++ )
+        {
+          seed = seed * 1103515245u + 12345u;
+          int v = ( d < 4 ? 50 : 200 ) + (int)( ( seed >> 8 ) % 60 ) - 30;
+          cost_ob( i0, i1, i2, k ) = v < 0 ? 0 : v > 255 ? 255 : v;
+          cost_bg( i0, i1, i2, k ) = 255 - cost_ob( i0, i1, i2, k );
+          cost_neigh( i0, i1, i2, k ) = d < 4 ? 100 : 0;
+          cost_context( i0, i1, i2, k ) = 30;
+        }
+      }
+
+  long neigh_coef[2] = { 10, 10 };
+  OptNet::inter_cutcut_type cutcut;
+  cutcut.k[0] = 0;
+  cutcut.k[1] = 1;
+  cutcut.cost_context_cut = &cost_context;
+
+  optnet::array<int> regions( s, s, s );
+  for ( size_t n = 0; n < regions.size(); n++ )
+    regions[n] = (int)n;
+
+  OptNet supervoxels;
+  supervoxels.set_verbose( false );
+  supervoxels.set_ob_cost( cost_ob );
+  supervoxels.set_bg_cost( cost_bg );
+  supervoxels.set_neigh_cost( cost_neigh );
+  supervoxels.set_neigh_coef( neigh_coef );
+  supervoxels.set_cutcut_relation( cutcut );
+  OptNet::net_type resSupervoxels( s, s, s, 2 );
+  long flowSupervoxels = -1;
+  supervoxels.solve_supervoxels( regions, regions.size(), resSupervoxels, &flowSupervoxels );
+
+  OptNet voxels;
+  voxels.set_verbose( false );
+  voxels.create( s, s, s, 0, 2 );
+  voxels.set_ob_cost( cost_ob );
+  voxels.set_bg_cost( cost_bg );
+  voxels.set_neigh_cost( cost_neigh );
+  voxels.set_neigh_coef( neigh_coef );
+  voxels.set_cutcut_relation( cutcut );
+  OptNet::net_type resVoxels( s, s, s, 2 );
+  long flowVoxels = -1;
+  voxels.solve_all( resVoxels, &flowVoxels );
+
+  int labelErrors = 0, objectVoxels = 0;
+  for ( size_t n = 0; n < resVoxels.size(); n++ )
+  {
+    if ( resSupervoxels[n] != resVoxels[n] )
+      labelErrors++;
+    if ( resVoxels[n] != 0 )
+      objectVoxels++;
+  }
+
+  if ( labelErrors != 0 || flowSupervoxels != flowVoxels || objectVoxels == 0 )
+  {
+    std::cerr << "Flow " << flowSupervoxels << ", expected " << flowVoxels << ", " << labelErrors
+              << " voxels labelled differently, " << objectVoxels << " object voxels" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Supervoxel solve matches the voxel solve, flow " << flowVoxels << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -33,6 +33,8 @@
 #   include <optnet/_base/array_ref.hxx>
 #   include <optnet/_base/array2.hxx>
 #   include <optnet/_base/point3.hxx>
+#   include <optnet/_base/except.hxx>
+#   include <algorithm>
 #   include <vector>
 
 /// @namespace optnet
@@ -210,6 +212,8 @@ public:
         #ifdef __OPTNET_PRAGMA_OMP__
             }
         #endif
+
+        m_precomputed = true;
     }
 
     ///////////////////////////////////////////////////////////////////////
@@ -221,60 +225,35 @@ public:
     ///////////////////////////////////////////////////////////////////////
     void compute(array_base_type& output)
     {
-        int x, y, z;
+        compute_tiles(output, (const array_base<unsigned char, _Tg>*)0);
+    }
 
-        if (output.size_0() != m_sx ||
-            output.size_1() != m_sy ||
-            output.size_2() != m_sz
+    ///////////////////////////////////////////////////////////////////////
+    ///  Computes the displacement at the image voxels inside a mask.
+    ///
+    ///  @param[out] output The output array containing the displacements at
+    ///                     each image voxel. The voxels outside the mask
+    ///                     are left unchanged.
+    ///  @param[in]  mask   The ROI mask (nonzero inside), of the same size
+    ///                     as the image.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Tm>
+    void compute(array_base_type& output, const array_base<_Tm, _Tg>& mask)
+    {
+        if (mask.size_0() != m_sx ||
+            mask.size_1() != m_sy ||
+            mask.size_2() != m_sz
             )
         {
             throw_exception(std::invalid_argument(
                 "cubic_spline_ffd3::compute: "
-                "The size of the output array does not match the value that was given."
+                "The size of the mask does not match that of the image."
                 )
             );
         }
 
-        if (!m_precomputed) precompute();
-
-        #ifdef __OPTNET_PRAGMA_OMP__
-        #   pragma omp parallel \
-                num_threads(__OPTNET_OMP_NUM_THREADS__) private(x, y, z)
-            {
-        #   pragma omp for
-        #endif
-        for (z = 0; z < (int)m_sz; ++z) {
-            size_type k = m_idx2[z];
-            for (y = 0; y < (int)m_sy; ++y) {
-                size_type j = m_idx1[y];
-                for (x = 0; x < (int)m_sx; ++x) {
-                    size_type i = m_idx0[x];
-                    double dx = 0, dy = 0, dz = 0;
-                    for (size_type n = 0; n < 4; ++n) {
-                        size_type kn = k + n;
-                        if (kn > m_qz) kn = m_qz;
-                        for (size_type m = 0; m < 4; ++m) {
-                            size_type jm = j + m;
-                            if (jm > m_qy) jm = m_qy;
-                            for (size_type l = 0; l < 4; ++l) {
-                                size_type il = i + l;
-                                if (il > m_qx) il = m_qx;
-                                double tmp = m_coe0(l, x) * m_coe1(m, y) * m_coe2(n, z);
-                                dx += (*m_pq)(il, jm, kn).v[0] * tmp;
-                                dy += (*m_pq)(il, jm, kn).v[1] * tmp;
-                                dz += (*m_pq)(il, jm, kn).v[2] * tmp;
-                            } // k
-                        } // l
-                    } // m
-                    output(x, y, z).v[0] = (value_type)(dx);
-                    output(x, y, z).v[1] = (value_type)(dy);
-                    output(x, y, z).v[2] = (value_type)(dz);
-                } // x
-            } // y
-        } // z
-        #ifdef __OPTNET_PRAGMA_OMP__
-            }
-        #endif
+        compute_tiles(output, &mask);
     }
 
     ///////////////////////////////////////////////////////////////////////
@@ -366,6 +345,126 @@ private:
     typedef array2<double>          coeff_array_type;
     typedef std::vector<size_type>  index_array_type;
 
+    ///////////////////////////////////////////////////////////////////////
+    // Evaluates the deformation plane by plane. The tensor product is
+    // split by axis: the control points are first summed along z into
+    // a plane of (m_qx + 1) x (m_qy + 1) points, which is computed once
+    // per image plane and shared by all its rows; each row then sums
+    // that plane along y into a line, and each voxel sums four points
+    // of the line. The planes are processed concurrently when OpenMP is
+    // available. Rows (and planes) without mask voxels are skipped.
+    template <typename _Tm>
+    void compute_tiles(array_base_type&                output,
+                       const array_base<_Tm, _Tg>*     pmask
+                       )
+    {
+        const int   nx = (int)m_qx + 1;
+        const int   ny = (int)m_qy + 1;
+        int         z;
+
+        if (output.size_0() != m_sx ||
+            output.size_1() != m_sy ||
+            output.size_2() != m_sz
+            )
+        {
+            throw_exception(std::invalid_argument(
+                "cubic_spline_ffd3::compute: "
+                "The size of the output array does not match the value that was given."
+                )
+            );
+        }
+
+        if (!m_precomputed) precompute();
+
+        #ifdef __OPTNET_PRAGMA_OMP__
+        #   pragma omp parallel \
+                num_threads(__OPTNET_OMP_NUM_THREADS__) private(z)
+            {
+        #endif
+        // The plane and line sums, one array per component; the lines
+        // are padded with three copies of their last point, which
+        // stands for the clamping of the control point indices.
+        std::vector<double> plane(3 * nx * ny), line(3 * (nx + 3));
+
+        #ifdef __OPTNET_PRAGMA_OMP__
+        #   pragma omp for schedule(dynamic)
+        #endif
+        for (z = 0; z < (int)m_sz; ++z) {
+
+            size_type k = m_idx2[z];
+            bool      plane_ready = false;
+
+            for (int y = 0; y < (int)m_sy; ++y) {
+
+                int x, c, l, m, n;
+
+                if (0 != pmask) {
+                    for (x = 0; x < (int)m_sx; ++x) {
+                        if ((*pmask)(x, y, z) != 0) break;
+                    }
+                    if (x == (int)m_sx) continue;
+                }
+
+                // Sum the control points along z.
+                if (!plane_ready) {
+                    double* p = &plane[0];
+                    std::fill(plane.begin(), plane.end(), 0.0);
+                    for (n = 0; n < 4; ++n) {
+                        size_type kn = k + n;
+                        if (kn > m_qz) kn = m_qz;
+                        const double w = m_coe2(n, z);
+                        for (m = 0; m < ny; ++m) {
+                            for (l = 0; l < nx; ++l) {
+                                const point_type& q = (*m_pq)(l, m, kn);
+                                p[(0 * ny + m) * nx + l] += w * q.v[0];
+                                p[(1 * ny + m) * nx + l] += w * q.v[1];
+                                p[(2 * ny + m) * nx + l] += w * q.v[2];
+                            }
+                        }
+                    }
+                    plane_ready = true;
+                }
+
+                // Sum the plane along y.
+                size_type j = m_idx1[y];
+                for (c = 0; c < 3; ++c) {
+                    double* OPTNET_RESTRICT r = &line[c * (nx + 3)];
+                    for (l = 0; l < nx; ++l) r[l] = 0.0;
+                    for (m = 0; m < 4; ++m) {
+                        size_type jm = j + m;
+                        if (jm > m_qy) jm = m_qy;
+                        const double  w = m_coe1(m, y);
+                        const double* OPTNET_RESTRICT p
+                            = &plane[(c * ny + jm) * nx];
+                        for (l = 0; l < nx; ++l) r[l] += w * p[l];
+                    }
+                    r[nx] = r[nx + 1] = r[nx + 2] = r[nx - 1];
+                }
+
+                // Sum the line along x.
+                const double* rx = &line[0];
+                const double* ry = &line[1 * (nx + 3)];
+                const double* rz = &line[2 * (nx + 3)];
+                for (x = 0; x < (int)m_sx; ++x) {
+                    if (0 != pmask && (*pmask)(x, y, z) == 0) continue;
+                    size_type i  = m_idx0[x];
+                    double    b0 = m_coe0(0, x), b1 = m_coe0(1, x);
+                    double    b2 = m_coe0(2, x), b3 = m_coe0(3, x);
+                    point_reference d = output(x, y, z);
+                    d.v[0] = (value_type)(b0 * rx[i] + b1 * rx[i + 1] +
+                                          b2 * rx[i + 2] + b3 * rx[i + 3]);
+                    d.v[1] = (value_type)(b0 * ry[i] + b1 * ry[i + 1] +
+                                          b2 * ry[i + 2] + b3 * ry[i + 3]);
+                    d.v[2] = (value_type)(b0 * rz[i] + b1 * rz[i + 1] +
+                                          b2 * rz[i + 2] + b3 * rz[i + 3]);
+                } // x
+            } // y
+        } // z
+        #ifdef __OPTNET_PRAGMA_OMP__
+            }
+        #endif
+    }
+
     coeff_array_type                m_coe0, m_coe1, m_coe2;
     index_array_type                m_idx0, m_id00, m_id01;
     index_array_type                m_idx1, m_id10, m_id11;
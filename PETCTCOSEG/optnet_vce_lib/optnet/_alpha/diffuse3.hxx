@@ -21,10 +21,13 @@
 #ifndef ___DIFFUSE3_HXX___
 #   define ___DIFFUSE3_HXX___
 
+#   include <optnet/config.h>
 #   include <optnet/_base/array.hxx>
 #   include <optnet/_base/except.hxx>
 #   include <limits>
 #   include <cmath>
+#   include <vector>
+#   include <algorithm>
     
 #   ifdef max
 #       undef max
@@ -38,7 +41,99 @@
 #   define MIRROR_R(i, n) ((i) >= (n)) ? ((n) - ((i) - (n)) - 2) : (i)
     
 namespace optnet {
-    
+
+    namespace detail {
+
+///////////////////////////////////////////////////////////////////////////
+// One red-black Gauss-Seidel half sweep over the voxels of plane z whose
+// parity (x + y + z) & 1 equals color. Returns the sum of the absolute
+// changes.
+template <typename _Real>
+double diffuse3_plane(array<_Real>&       u,
+                      const array<_Real>& f,
+                      const array<_Real>& sw,
+                      int                 z,
+                      int                 color,
+                      const _Real&        beta
+                      )
+{
+    int     x, y, xl, xr, yl, yr, zl, zr;
+    int     sx = (int)u.size_0();
+    int     sy = (int)u.size_1();
+    int     sz = (int)u.size_2();
+    double  change = .0;
+
+    zl = (sz > 1) ? MIRROR_L(z - 1, sz) : z;
+    zr = (sz > 1) ? MIRROR_R(z + 1, sz) : z;
+
+    for (y = 0; y < sy; ++y) {
+
+        yl = (sy > 1) ? MIRROR_L(y - 1, sy) : y;
+        yr = (sy > 1) ? MIRROR_R(y + 1, sy) : y;
+
+        // The rows of u, f and sw around (y, z); all contiguous in x.
+        _Real*       pu  = &u(0, y, z);
+        const _Real* puy0 = &u(0, yl, z), * puy1 = &u(0, yr, z);
+        const _Real* puz0 = &u(0, y, zl), * puz1 = &u(0, y, zr);
+        const _Real* pw  = &sw(0, y, z);
+        const _Real* pwy0 = &sw(0, yl, z), * pwy1 = &sw(0, yr, z);
+        const _Real* pwz0 = &sw(0, y, zl), * pwz1 = &sw(0, y, zr);
+        const _Real* pf  = &f(0, y, z);
+
+        for (x = (y + z + color) & 1; x < sx; x += 2) {
+
+            xl = (sx > 1) ? MIRROR_L(x - 1, sx) : x;
+            xr = (sx > 1) ? MIRROR_R(x + 1, sx) : x;
+
+            /* 6-neighbor system */
+            _Real w   = pw[x];
+            _Real cx0 = w * pw[xl],   cx1 = w * pw[xr];
+            _Real cy0 = w * pwy0[x],  cy1 = w * pwy1[x];
+            _Real cz0 = w * pwz0[x],  cz1 = w * pwz1[x];
+
+            _Real num = cx0 * pu[xl]   + cx1 * pu[xr]
+                      + cy0 * puy0[x]  + cy1 * puy1[x]
+                      + cz0 * puz0[x]  + cz1 * puz1[x]
+                      + beta * pf[x];
+            _Real den = cx0 + cx1 + cy0 + cy1 + cz0 + cz1 + beta;
+            _Real v   = num / den;
+
+            change += fabs((double)(v - pu[x]));
+            pu[x] = v;
+        } // x
+    } // y
+
+    return change;
+}
+
+    } // namespace detail
+
+///////////////////////////////////////////////////////////////////////////
+///  Edge-preserving diffusion of a 3-D image.
+///
+///  @param[in,out] image      The image to be smoothed.
+///  @param         weights    The diffusivity of each voxel; the
+///                            conductance between two neighbors is the
+///                            geometric mean of their weights.
+///  @param         amount     The amount of smoothing; the fidelity to
+///                            the input image is 1 / (amount * amount).
+///  @param         step_size  Unused; kept for compatibility (the
+///                            solver below has no time step).
+///  @param         stop_tol   The stopping tolerance on the mean
+///                            absolute change per sweep.
+///  @param         max_iter   The maximum number of sweeps.
+///
+///  @return true if the iteration converged within max_iter sweeps.
+///
+///  @remarks The steady state of the former explicit scheme,
+///           (beta + sum_n c_n) u = sum_n c_n u_n + beta f, is solved
+///           by red-black Gauss-Seidel in single precision. The volume
+///           is split into slabs of SLAB planes that are updated
+///           concurrently when OpenMP is available. A slab is skipped
+///           as long as neither it nor its neighboring slabs changed by
+///           more than stop_tol (mean absolute change) in the previous
+///           sweep.
+///////////////////////////////////////////////////////////////////////////
 template <typename _VoxelT, typename _weights, typename _Tg>
 bool diffuse3(array_base<_VoxelT, _Tg>&        image,
               const array_base<_weights, _Tg>& weights,
@@ -48,15 +143,16 @@ bool diffuse3(array_base<_VoxelT, _Tg>&        image,
               int                              max_iter
               )
 {
-    typedef double real_type;
-    
-    int     iter, src, dst;
-    int     x, y, z, sx, sy, sz, xx, yy, zz;
-    double  term1, term2, term3, temp, change;
-    double  alpha = step_size / (amount * amount);
-    double  denom = 1.0 / (1.0 + alpha);
-    bool    converged = false;
-    
+    typedef float real_type;
+
+    const int   SLAB = 4;
+
+    int         iter, color, s, x, y, z, sx, sy, sz, nslabs;
+    real_type   beta = (real_type)(1.0 / (amount * amount));
+    bool        converged = false, any;
+
+    (void)step_size;
+
     sx = (int)image.size_0();
     sy = (int)image.size_1();
     sz = (int)image.size_2();
@@ -67,93 +163,68 @@ bool diffuse3(array_base<_VoxelT, _Tg>&        image,
     {
         throw_exception(std::runtime_error("Size mismatch."));
     }
-    
-    double per = 1.0 / (sx * sy * sz);
-    
-    array<real_type> tmp(sx, sy, sz, 2);
-    
+
+    array<real_type> u(sx, sy, sz), f(sx, sy, sz), sw(sx, sy, sz);
+
     for (z = 0; z < sz; ++z) {
         for (y = 0; y < sy; ++y) {
             for (x = 0; x < sx; ++x) {
-                tmp(x, y, z, 0) = image(x, y, z);
+                f(x, y, z) = u(x, y, z) = (real_type)image(x, y, z);
+                sw(x, y, z) = (real_type)sqrt((double)weights(x, y, z));
             } // x
         } // y
     } // z
-    
-    src = 1;
-    dst = 0;
-    
+
+    nslabs = (sz + SLAB - 1) / SLAB;
+
+    std::vector<double> change(nslabs, std::numeric_limits<double>::max());
+    std::vector<double> sum(nslabs, .0);
+    std::vector<char>   active(nslabs, 1);
+
     for (iter = 0; iter < max_iter; ++iter) {
-        
-        change = .0;
-
-        src = !src;
-        dst = !dst;
-            
-        // Loop through all voxels.
-        for (z = 0; z < sz; ++z) {
-            for (y = 0; y < sy; ++y) {
-                for (x = 0; x < sx; ++x) {
-        
-                    term1 = term2 = 0;
-                    
-                    /* 6-neighbor system */
-                    xx = MIRROR_L(x - 1, sx);       
-                    temp = sqrt((double)(weights(xx, y, z) * weights(x, y, z)));
-                    term1 += temp;
-                    term2 += temp * tmp(xx, y, z, src);
-                    /*---*/
-                    xx = MIRROR_R(x + 1, sx);
-                    temp = sqrt((double)(weights(xx, y, z) * weights(x, y, z)));
-                    term1 += temp;
-                    term2 += temp * tmp(xx, y, z, src);
-                    /*---*/
-                    yy = MIRROR_L(y - 1, sy);
-                    temp = sqrt((double)(weights(x, yy, z) * weights(x, y, z)));
-                    term1 += temp;
-                    term2 += temp * tmp(x, yy, z, src);
-                    /*---*/
-                    yy = MIRROR_R(y + 1, sy);
-                    temp = sqrt((double)(weights(x, yy, z) * weights(x, y, z)));
-                    term1 += temp;
-                    term2 += temp * tmp(x, yy, z, src);
-                    /*---*/
-                    zz = MIRROR_L(z - 1, sz);
-                    temp = sqrt((double)(weights(x, y, zz) * weights(x, y, z)));
-                    term1 += temp;
-                    term2 += temp * tmp(x, y, zz, src);
-                    /*---*/
-                    zz = MIRROR_R(z + 1, sz);
-                    temp = sqrt((double)(weights(x, y, zz) * weights(x, y, z)));
-                    term1 += temp;
-                    term2 += temp * tmp(x, y, zz, src);
-                    
-                    term1 = (1 - step_size * term1) * tmp(x, y, z, src);
-                    term2 = step_size * term2;
-                    term3 = alpha * image(x, y, z);
-                    
-                    tmp(x, y, z, dst) = (term1 + term2 + term3) * denom;
-                
-                    change += fabs(tmp(x, y, z, dst) - 
-                                   tmp(x, y, z, src));
-                                                        
-                } // x
-            } // y
-        } // z
-
-        if ((change * per) <= stop_tol) {
+
+        for (s = 0; s < nslabs; ++s) {
+            active[s] = (change[s] > stop_tol) ||
+                (s > 0 && change[s - 1] > stop_tol) ||
+                (s + 1 < nslabs && change[s + 1] > stop_tol);
+            sum[s] = .0;
+        }
+
+        for (color = 0; color < 2; ++color) {
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(s, z) schedule(dynamic) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+            for (s = 0; s < nslabs; ++s) {
+                if (!active[s]) continue;
+                for (z = s * SLAB; z < sz && z < (s + 1) * SLAB; ++z)
+                    sum[s] += detail::diffuse3_plane(u, f, sw, z, color, beta);
+            }
+        } // color
+
+        any = false;
+        for (s = 0; s < nslabs; ++s) {
+            int planes = std::min(sz, (s + 1) * SLAB) - s * SLAB;
+            change[s] = sum[s] / ((double)sx * sy * planes);
+            if (change[s] > stop_tol) any = true;
+        }
+
+        if (!any) {
             converged = true;
             break;
         }
     } // iter
     
-    _VoxelT vmax = std::numeric_limits<_VoxelT>::max();
-    _VoxelT vmin = std::numeric_limits<_VoxelT>::min();
+    // Clamp to the range of _VoxelT (min() is the smallest positive
+    // value for floating-point types).
+    double vmax = (double)std::numeric_limits<_VoxelT>::max();
+    double vmin = std::numeric_limits<_VoxelT>::is_integer ?
+        (double)std::numeric_limits<_VoxelT>::min() : -vmax;
     
     for (z = 0; z < sz; ++z) {
         for (y = 0; y < sy; ++y) {
             for (x = 0; x < sx; ++x) {
-                real_type v = tmp(x, y, z, dst);
+                double v = u(x, y, z);
                 if (v > vmax) v = vmax;
                 else if (v < vmin) v = vmin;
                 image(x, y, z) = static_cast<_VoxelT>(v);
@@ -33,6 +33,7 @@
 #   include <optnet/_base/array_ref.hxx>
 #   include <optnet/_base/debug.hxx>
 #   include <optnet/_base/point3.hxx>
+#   include <algorithm>
 #   include <functional>
 #   include <limits>
 #   include <queue>
@@ -99,16 +100,58 @@ public:
     static const label_type ALIVE;      /// Alive node.
     static const label_type TRIAL;      /// Trial node.
 
+    /// The priority queues that can order the TRIAL nodes.
+    enum queue_type
+    {
+        BINARY_HEAP,    /// Binary heap with lazy deletion (default).
+        INDEXED_HEAP,   /// Index-addressed binary heap with decrease-key.
+        UNTIDY_QUEUE    /// Bucketed (untidy) queue, O(1) amortized.
+    };
+
     ///////////////////////////////////////////////////////////////////////
     /// Constructor.
     ///////////////////////////////////////////////////////////////////////
-    fast_marching3()
+    fast_marching3() :
+        m_p_speed_array(NULL),
+        m_p_time_array(NULL),
+        m_queue(BINARY_HEAP),
+        m_bucket_width(0.0)
     {
         m_large_time = static_cast<time_value_type>
             (std::numeric_limits<time_value_type>::max() / 2.0);
         m_speed_inv = -1.0;
     }
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Selects the priority queue used to order the TRIAL nodes.
+    ///
+    ///  @param type          The queue type.
+    ///  @param bucket_width  The time span of one bucket of the untidy
+    ///                       queue (ignored by the other queues). If not
+    ///                       positive, half of the time needed to cross
+    ///                       one voxel at the maximum speed is used.
+    ///
+    ///  @remarks The two heaps give the exact fast marching solution;
+    ///           the indexed heap keeps one entry per TRIAL node and
+    ///           lowers it in place, so that no stale duplicates are
+    ///           stored. The untidy queue accepts nodes in the order of
+    ///           their buckets only (Yatziv et al., J Comput Phys 2006),
+    ///           so the arrival times are accurate to about the bucket
+    ///           width, in return for O(1) insertion and removal.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void set_queue(queue_type type, double bucket_width = 0.0)
+    {
+        m_queue        = type;
+        m_bucket_width = bucket_width;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the type of the priority queue.
+    ///////////////////////////////////////////////////////////////////////
+    inline queue_type get_queue() const
+                { return m_queue; }
+
     ///////////////////////////////////////////////////////////////////////
     ///  Initialize the fast marching solver.
     ///
@@ -169,6 +212,7 @@ public:
         assert(NULL != m_p_time_array);
 
         time_value_type value;
+        node_type       node;
 
         if (stopping_time < 0)
             stopping_time = m_large_time;
@@ -177,9 +221,7 @@ public:
 
         initialize_heap();
         
-        while (!m_heap.empty()) {
-            node_const_reference node = m_heap.top();
-            m_heap.pop();
+        while (pop_node(node)) {
 
             value = (*m_p_time_array)(node.index);
             
@@ -223,6 +265,7 @@ public:
         assert(NULL != m_p_time_array);
 
         time_value_type value;
+        node_type       node;
 
         if (stopping_time < 0)
             stopping_time = m_large_time;
@@ -239,9 +282,7 @@ public:
 
         initialize_heap();
         
-        while (!m_heap.empty()) {
-            node_const_reference node = m_heap.top();
-            m_heap.pop();
+        while (pop_node(node)) {
 
             value = (*m_p_time_array)(node.index);
             
@@ -309,7 +350,7 @@ private:
         } // for
 
         // Empty the trial heap if it is not.
-        while (!m_heap.empty()) m_heap.pop();
+        clear_queue();
 
         for (it_trial  = m_trial_nodes.begin();
              it_trial != m_trial_nodes.end(); ++it_trial) {
@@ -328,7 +369,7 @@ private:
 
              (*m_p_time_array)(i0, i1, i2) = node.value;
              m_label_array(i0, i1, i2) = TRIAL;
-             m_heap.push(node);
+             push_node(node.value, i0, i1, i2);
         } // for
     }
 
@@ -651,18 +692,77 @@ private:
 
 
         if (solution < (double)m_large_time) {
-            node_type node;
 
             assert(m_label_array(i0, i1, i2) != ALIVE);
 
             time_value_type value
                 = static_cast<time_value_type>(solution);
 
-            if (value < (*m_p_time_array)(i0, i1, i2))
+            // Insert the point into the trail heap. A value that does not
+            // lower the current time would only leave a stale entry.
+            if (value < (*m_p_time_array)(i0, i1, i2)) {
                 (*m_p_time_array)(i0, i1, i2) = value;
+                m_label_array(i0, i1, i2) = TRIAL;
+                push_node(value, i0, i1, i2);
+            }
+        }
+
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Priority queues.
+    ///////////////////////////////////////////////////////////////////////
+
+    // An entry of the indexed heap or of the untidy queue: the time of a
+    // node and its linear index i0 + s0 * (i1 + s1 * i2).
+    struct queue_entry
+    {
+        time_value_type value;
+        size_type       index;
+    };
 
-            // Insert the point into the trail heap.
-            m_label_array(i0, i1, i2) = TRIAL;
+    typedef std::vector<queue_entry>            entry_vector_type;
+    typedef std::vector<entry_vector_type>      bucket_vector_type;
+    typedef std::vector<unsigned int>           position_vector_type;
+
+    static const unsigned int NOT_IN_HEAP;      // Position of a node that
+                                                // is not in the heap.
+    static const size_type    MIN_BUCKETS;      // Initial/maximum number
+    static const size_type    MAX_BUCKETS;      // of untidy buckets.
+
+    ///////////////////////////////////////////////////////////////////////
+    void clear_queue()
+    {
+        m_heap = heap_type();
+        m_entries.clear();
+        m_heap_pos.clear();
+        m_buckets.clear();
+        m_overflow.clear();
+
+        if (INDEXED_HEAP == m_queue) {
+            m_heap_pos.assign(m_label_array.size(), NOT_IN_HEAP);
+        }
+        else if (UNTIDY_QUEUE == m_queue) {
+            double width = m_bucket_width;
+            if (width <= 0.0) width = 0.5 / max_speed();
+
+            m_bucket_inv   = 1.0 / width;
+            m_bucket_cur   = 0;
+            m_bucket_count = 0;
+            m_buckets.resize(MIN_BUCKETS);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    void push_node(time_value_type value,
+                   size_type       i0,
+                   size_type       i1,
+                   size_type       i2
+                   )
+    {
+        if (BINARY_HEAP == m_queue) {
+            node_type node;
 
             node.value    = value;
             node.index[0] = i0;
@@ -670,11 +770,231 @@ private:
             node.index[2] = i2;
 
             m_heap.push(node);
+            return;
+        }
+
+        queue_entry entry;
+
+        entry.value = value;
+        entry.index = i0 + m_label_array.size_0()
+                    * (i1 + m_label_array.size_1() * i2);
+
+        if (INDEXED_HEAP == m_queue) {
+            size_type pos = m_heap_pos[entry.index];
+
+            if (NOT_IN_HEAP == pos) {
+                pos = m_entries.size();
+                m_entries.push_back(entry);
+            }
+            else if (value < m_entries[pos].value) {
+                m_entries[pos].value = value;   // decrease-key
+            }
+            else {
+                return;
+            }
+            sift_up(pos, entry);
+        }
+        else {
+            push_bucket(entry);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    bool pop_node(node_type& node)
+    {
+        queue_entry entry;
+
+        if (BINARY_HEAP == m_queue) {
+            if (m_heap.empty()) return false;
+            node = m_heap.top();
+            m_heap.pop();
+            return true;
+        }
+
+        if (INDEXED_HEAP == m_queue) {
+            if (m_entries.empty()) return false;
+
+            entry = m_entries[0];
+            m_heap_pos[entry.index] = NOT_IN_HEAP;
+
+            if (m_entries.size() > 1) {
+                queue_entry last = m_entries.back();
+                m_entries.pop_back();
+                sift_down(0, last);
+            }
+            else {
+                m_entries.pop_back();
+            }
         }
+        else if (!pop_bucket(entry)) {
+            return false;
+        }
+
+        size_type s0 = m_label_array.size_0();
+        size_type s1 = m_label_array.size_1();
+        size_type i  = entry.index / s0;
+
+        node.value    = entry.value;
+        node.index[0] = entry.index % s0;
+        node.index[1] = i % s1;
+        node.index[2] = i / s1;
 
         return true;
     }
 
+    ///////////////////////////////////////////////////////////////////////
+    // Moves the entry up from the position pos of the indexed heap.
+    void sift_up(size_type pos, const queue_entry& entry)
+    {
+        while (pos > 0) {
+            size_type parent = (pos - 1) / 2;
+            if (!(entry.value < m_entries[parent].value)) break;
+            m_entries[pos] = m_entries[parent];
+            m_heap_pos[m_entries[pos].index] = (unsigned int)pos;
+            pos = parent;
+        }
+        m_entries[pos] = entry;
+        m_heap_pos[entry.index] = (unsigned int)pos;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Moves the entry down from the position pos of the indexed heap.
+    void sift_down(size_type pos, const queue_entry& entry)
+    {
+        size_type n = m_entries.size();
+
+        for (;;) {
+            size_type child = 2 * pos + 1;
+            if (child >= n) break;
+            if (child + 1 < n &&
+                m_entries[child + 1].value < m_entries[child].value) {
+                ++child;
+            }
+            if (!(m_entries[child].value < entry.value)) break;
+            m_entries[pos] = m_entries[child];
+            m_heap_pos[m_entries[pos].index] = (unsigned int)pos;
+            pos = child;
+        }
+        m_entries[pos] = entry;
+        m_heap_pos[entry.index] = (unsigned int)pos;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Returns the untidy bucket of the given time. Times that lie before
+    // the current bucket are kept in it.
+    inline size_type bucket_of(time_value_type value) const
+    {
+        static const double kmax = (double)
+            (std::numeric_limits<size_type>::max() / 2);
+
+        double k = (double)value * m_bucket_inv;
+
+        if (k <= (double)m_bucket_cur) return m_bucket_cur;
+        if (k >= kmax) return (size_type)kmax;
+        return (size_type)k;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Inserts an entry into the circular bucket array, or into the
+    // overflow list if it is further ahead than MAX_BUCKETS buckets.
+    void push_bucket(const queue_entry& entry)
+    {
+        size_type k = bucket_of(entry.value);
+
+        if (k - m_bucket_cur >= m_buckets.size()) {
+            if (k - m_bucket_cur >= MAX_BUCKETS) {
+                if (m_overflow.empty() || k < m_overflow_min)
+                    m_overflow_min = k;
+                m_overflow.push_back(entry);
+                return;
+            }
+            grow_buckets(k - m_bucket_cur + 1);
+        }
+
+        m_buckets[k & (m_buckets.size() - 1)].push_back(entry);
+        ++m_bucket_count;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Removes an entry from the first nonempty bucket.
+    bool pop_bucket(queue_entry& entry)
+    {
+        if (0 == m_bucket_count && m_overflow.empty()) return false;
+
+        for (;;) {
+            if (!m_overflow.empty() &&
+                (0 == m_bucket_count || m_overflow_min <= m_bucket_cur)) {
+                if (m_bucket_cur < m_overflow_min)
+                    m_bucket_cur = m_overflow_min;
+                flush_overflow();
+            }
+
+            entry_vector_type& bucket =
+                m_buckets[m_bucket_cur & (m_buckets.size() - 1)];
+
+            if (!bucket.empty()) {
+                entry = bucket.back();
+                bucket.pop_back();
+                --m_bucket_count;
+                return true;
+            }
+            ++m_bucket_cur;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Enlarges the bucket array (to a power of two) so that it spans at
+    // least the given number of buckets.
+    void grow_buckets(size_type span)
+    {
+        size_type n = m_buckets.size();
+        while (n < span) n *= 2;
+
+        bucket_vector_type buckets(n);
+
+        for (size_type j = 0; j < m_buckets.size(); ++j) {
+            for (size_type k = 0; k < m_buckets[j].size(); ++k) {
+                const queue_entry& entry = m_buckets[j][k];
+                buckets[bucket_of(entry.value) & (n - 1)].push_back(entry);
+            }
+        }
+        m_buckets.swap(buckets);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Moves the overflow entries that fit into the bucket array.
+    void flush_overflow()
+    {
+        entry_vector_type overflow;
+
+        overflow.swap(m_overflow);
+
+        for (size_type j = 0; j < overflow.size(); ++j) {
+            push_bucket(overflow[j]);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Returns the maximum speed (one if it is not positive).
+    double max_speed() const
+    {
+        double fmax = 0.0;
+
+        if (NULL != m_p_speed_array) {
+            const time_value_type* p = m_p_speed_array->data();
+            for (size_type i = 0; i < m_p_speed_array->size(); ++i) {
+                double f = (double)p[i];
+                if (f * f > fmax) fmax = f * f;
+            }
+            fmax = sqrt(fmax);
+        }
+        else {
+            fmax = 1.0 / sqrt(-m_speed_inv);
+        }
+
+        return (fmax > 0.0) ? fmax : 1.0;
+    }
+
 
     ///////////////////////////////////////////////////////////////////////
     time_value_type                 m_large_time;
@@ -688,6 +1008,18 @@ private:
     node_vector_type                m_trial_nodes;
     node_vector_type                m_alive_nodes;
     heap_type                       m_heap;
+
+    // indexed heap and untidy queue
+    queue_type                      m_queue;
+    double                          m_bucket_width;
+    entry_vector_type               m_entries;
+    position_vector_type            m_heap_pos;
+    bucket_vector_type              m_buckets;
+    entry_vector_type               m_overflow;
+    double                          m_bucket_inv;
+    size_type                       m_bucket_cur;
+    size_type                       m_bucket_count;
+    size_type                       m_overflow_min;
 };
 
 // constants
@@ -706,6 +1038,18 @@ const typename fast_marching3<_Time, _Speed, _Tg>::label_type
     fast_marching3<_Time, _Speed, _Tg>::TRIAL = 
         (typename fast_marching3<_Time, _Speed, _Tg>::label_type)(2);
 
+template <typename _Time, typename _Speed, typename _Tg>
+const unsigned int
+    fast_marching3<_Time, _Speed, _Tg>::NOT_IN_HEAP = ~0u;
+
+template <typename _Time, typename _Speed, typename _Tg>
+const typename fast_marching3<_Time, _Speed, _Tg>::size_type
+    fast_marching3<_Time, _Speed, _Tg>::MIN_BUCKETS = 256;
+
+template <typename _Time, typename _Speed, typename _Tg>
+const typename fast_marching3<_Time, _Speed, _Tg>::size_type
+    fast_marching3<_Time, _Speed, _Tg>::MAX_BUCKETS = 65536;
+
 } // namespace
 
 #endif // ___FAST_MARCHING3_HXX___
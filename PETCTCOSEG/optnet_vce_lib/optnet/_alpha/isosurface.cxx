@@ -30,6 +30,9 @@
 #   include <optnet/_alpha/isosurface.hxx>
 #   include <optnet/_base/except.hxx>
 #   include <optnet/_base/secure_s.hxx>
+#   include <algorithm>
+#   include <cmath>
+#   include <cstring>
 
 /// @namespace optnet
 namespace optnet {
@@ -131,6 +134,584 @@ void isosurface<_Ty, _Real, _Tg>::save(std::ostream& os,
     os << "</ons>\n";
 }
 
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+void isosurface<_Ty, _Real, _Tg>::find(const array_base_type& volume,
+                                       const value_type&      isovalue
+                                       )
+{
+    size_type           lo[3], hi[3], i, k, n, total;
+    std::vector<char>   rows;
+    int                 s, num_slabs;
+
+    clear();
+
+    m_isovalue = isovalue;
+
+    if (volume.size_0() < 2 ||
+        volume.size_1() < 2 ||
+        volume.size_2() < 2)
+        return;
+
+    // Only the cubes in the bounding box of the surface are visited.
+    if (!find_bounds(volume, lo, hi, rows))
+        return;
+
+    // Split the cube layers into slabs.
+    n = hi[2] - lo[2] + 1;
+    #ifdef __OPTNET_PRAGMA_OMP__
+    num_slabs = 4 * __OPTNET_OMP_NUM_THREADS__;
+    #else
+    num_slabs = 1;
+    #endif
+    if ((size_type)num_slabs > n)
+        num_slabs = (int)n;
+
+    slab_vector_type slabs(num_slabs);
+
+    for (s = 0; s < num_slabs; ++s) {
+        slabs[s].z0 = lo[2] + n * s / num_slabs;
+        slabs[s].z1 = lo[2] + n * (s + 1) / num_slabs;
+    }
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for schedule(dynamic) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+    for (s = 0; s < num_slabs; ++s) {
+        march_slab(volume, lo, hi, rows, s == 0, slabs[s]);
+    }
+
+    // Stitch the slabs: the owned vertices of each slab are appended,
+    // and the shared ones are mapped to the vertices on the last plane
+    // of the previous slab.
+    std::vector<size_type> vertex_ofs(num_slabs + 1, 0);
+    std::vector<size_type> triangle_ofs(num_slabs + 1, 0);
+
+    for (s = 0; s < num_slabs; ++s) {
+        vertex_ofs  [s + 1] = vertex_ofs  [s] + slabs[s].vertices.size();
+        triangle_ofs[s + 1] = triangle_ofs[s] + slabs[s].triangles.size();
+    }
+
+    m_vertices.resize(vertex_ofs[num_slabs]);
+    m_normals.resize(vertex_ofs[num_slabs]);
+    m_triangles.resize(triangle_ofs[num_slabs]);
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for schedule(dynamic) private(i, k) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+    for (s = 0; s < num_slabs; ++s) {
+        slab_type& slab = slabs[s];
+
+        std::copy(slab.vertices.begin(), slab.vertices.end(),
+                  m_vertices.begin() + vertex_ofs[s]);
+        std::copy(slab.normals.begin(), slab.normals.end(),
+                  m_normals.begin() + vertex_ofs[s]);
+
+        for (i = 0; i < slab.triangles.size(); ++i) {
+            triangle_type& t = slab.triangles[i];
+            for (k = 0; k < 3; ++k) {
+                if (t.v[k] & SHARED_ID) {
+                    size_type code = slab.shared[t.v[k] & ~SHARED_ID];
+                    size_type id   = slabs[s - 1].last[code & 1][code >> 1];
+                    assert(s > 0 && id != NO_VERTEX);
+                    t.v[k] = vertex_ofs[s - 1] + id;
+                }
+                else {
+                    t.v[k] = vertex_ofs[s] + t.v[k];
+                }
+            }
+            m_triangles[triangle_ofs[s] + i] = t;
+
+            // Collect the mesh edges.
+            for (k = 0; k < 3; ++k) {
+                size_type u0 = t.v[k], u1 = t.v[(k + 1) % 3];
+                slab.edges.push_back(u0 < u1 ?
+                    std::make_pair(u0, u1) : std::make_pair(u1, u0));
+            }
+        }
+
+        std::sort(slab.edges.begin(), slab.edges.end());
+        slab.edges.erase(std::unique(slab.edges.begin(), slab.edges.end()),
+                         slab.edges.end());
+    }
+
+    // An edge can only be found by two slabs if it lies on the plane
+    // between them, i.e., if both its vertices belong to the previous
+    // slab.
+    for (total = 0, s = 0; s < num_slabs; ++s)
+        total += slabs[s].edges.size();
+    m_edges.reserve(total);
+
+    for (s = 0; s < num_slabs; ++s) {
+        const slab_type& slab = slabs[s];
+
+        for (i = 0; i < slab.edges.size(); ++i) {
+            const std::pair<size_type, size_type>& e = slab.edges[i];
+
+            if (s > 0 && e.second < vertex_ofs[s] &&
+                std::binary_search(slabs[s - 1].edges.begin(),
+                                   slabs[s - 1].edges.end(), e))
+                continue;
+
+            edge_type edge;
+            edge.v[0] = e.first;
+            edge.v[1] = e.second;
+            m_edges.push_back(edge);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+bool isosurface<_Ty, _Real, _Tg>::find_bounds(const array_base_type& volume,
+                                              size_type*             lo,
+                                              size_type*             hi,
+                                              std::vector<char>&     rows
+                                              ) const
+{
+    const size_type s0 = volume.size_0();
+    const size_type s1 = volume.size_1();
+    const size_type s2 = volume.size_2();
+
+    // Per plane: bounding boxes of the voxels at or below the isovalue
+    // (inside, index 0) and above it (outside, index 1). Per voxel row:
+    // the kinds of voxels found (bit 0: inside, bit 1: outside).
+    std::vector<size_type> plane_lo(s2 * 4), plane_hi(s2 * 4);
+    std::vector<char>      plane_has(s2 * 2, 0);
+    int                    i2;
+    size_type              i1, d, k, z;
+
+    rows.assign(s1 * s2, 0);
+
+    // The voxels of a row are equally spaced in the array buffer.
+    const std::ptrdiff_t step0 = volume.offset(1, 0, 0) - volume.offset(0, 0, 0);
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(i1, k) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+    for (i2 = 0; i2 < (int)s2; ++i2) {
+        size_type* plo = &plane_lo[i2 * 4];
+        size_type* phi = &plane_hi[i2 * 4];
+        char*      has = &plane_has[i2 * 2];
+
+        plo[0] = plo[2] = s0; plo[1] = plo[3] = s1;
+        phi[0] = phi[1] = phi[2] = phi[3] = 0;
+
+        for (i1 = 0; i1 < s1; ++i1) {
+            size_type first[2] = { s0, s0 }, last[2] = { 0, 0 };
+            const value_type* p = volume.data() + volume.offset(0, i1, i2);
+            const bool        in0 = (p[0] <= m_isovalue);
+            const bool        in1 = (p[(s0 - 1) * step0] <= m_isovalue);
+            size_type         f, b;
+
+            // The first voxel that differs from the first one ...
+            for (f = 1; f < s0 && (p[f * step0] <= m_isovalue) == in0; ++f) ;
+
+            k = in0 ? 0 : 1;
+            first[k] = 0;
+            last [k] = s0 - 1;
+
+            if (f < s0) {
+                // ... and the last voxel that differs from the last one
+                // bound both kinds of voxels in a mixed row.
+                for (b = s0 - 1; b > 0 && (p[(b - 1) * step0] <= m_isovalue) == in1; --b) ;
+                --b;
+
+                first[1 - k] = f;
+                last [1 - k] = (in1 != in0) ? s0 - 1 : b;
+                if (in1 != in0) last[k] = b;
+            }
+
+            for (k = 0; k < 2; ++k) {
+                if (first[k] == s0) continue;
+                rows[i2 * s1 + i1] |= (char)(1 << k);
+                has[k] = 1;
+                if (first[k] < plo[k * 2    ]) plo[k * 2    ] = first[k];
+                if (last [k] > phi[k * 2    ]) phi[k * 2    ] = last [k];
+                if (i1       < plo[k * 2 + 1]) plo[k * 2 + 1] = i1;
+                if (i1       > phi[k * 2 + 1]) phi[k * 2 + 1] = i1;
+            }
+        }
+    }
+
+    // Combine the planes.
+    size_type blo[2][3] = { { s0, s1, s2 }, { s0, s1, s2 } };
+    size_type bhi[2][3] = { {  0,  0,  0 }, {  0,  0,  0 } };
+    bool      found[2]  = { false, false };
+
+    for (z = 0; z < s2; ++z) {
+        for (k = 0; k < 2; ++k) {
+            if (!plane_has[z * 2 + k]) continue;
+            found[k] = true;
+            for (d = 0; d < 2; ++d) {
+                blo[k][d] = std::min(blo[k][d], plane_lo[z * 4 + k * 2 + d]);
+                bhi[k][d] = std::max(bhi[k][d], plane_hi[z * 4 + k * 2 + d]);
+            }
+            blo[k][2] = std::min(blo[k][2], z);
+            bhi[k][2] = std::max(bhi[k][2], z);
+        }
+    }
+
+    if (!found[0] || !found[1])
+        return false;
+
+    // A cube (origin c) crossing the surface holds voxels of both kinds,
+    // so c lies in [min - 1, max] of both bounding boxes.
+    const size_type sz[3] = { s0, s1, s2 };
+    for (d = 0; d < 3; ++d) {
+        size_type a = std::max(blo[0][d], blo[1][d]);
+        lo[d] = (a > 0) ? a - 1 : 0;
+        hi[d] = std::min(std::min(bhi[0][d], bhi[1][d]), sz[d] - 2);
+        if (lo[d] > hi[d])
+            return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+void isosurface<_Ty, _Real, _Tg>::march_slab(const array_base_type&   volume,
+                                             const size_type*         lo,
+                                             const size_type*         hi,
+                                             const std::vector<char>& rows,
+                                             bool                     first,
+                                             slab_type&               slab
+                                             ) const
+{
+    // Edge caches hold the ids of the vertices on the x- and y-edges of
+    // the lower (0) and upper (1) plane of the current cube layer, and
+    // on the z-edges between them. They are indexed by the position of
+    // the lower edge end-point in the plane.
+    const size_type w0 = hi[0] - lo[0] + 2;
+    const size_type w1 = hi[1] - lo[1] + 2;
+    const size_type s1 = volume.size_1();
+
+    std::vector<size_type> cache[2][2], cache_z(w0 * w1, NO_VERTEX);
+    std::vector<size_type> touched[2], touched_z;
+
+    cache[0][0].assign(w0 * w1, NO_VERTEX);
+    cache[0][1].assign(w0 * w1, NO_VERTEX);
+    cache[1][0].assign(w0 * w1, NO_VERTEX);
+    cache[1][1].assign(w0 * w1, NO_VERTEX);
+
+    // Axis, and lower and upper corners of each cube edge.
+    size_type edge_axis[12], edge_corner[12][2];
+    int       i, j;
+
+    for (i = 0; i < 12; ++i) {
+        size_type c0 = CUBE_EDGE_LNK[i][0], c1 = CUBE_EDGE_LNK[i][1];
+        edge_axis[i] = (CUBE_VERT_OFS[c0][0] != CUBE_VERT_OFS[c1][0]) ? 0 :
+                       (CUBE_VERT_OFS[c0][1] != CUBE_VERT_OFS[c1][1]) ? 1 : 2;
+        if (CUBE_VERT_OFS[c0][edge_axis[i]] > CUBE_VERT_OFS[c1][edge_axis[i]])
+            std::swap(c0, c1);
+        edge_corner[i][0] = c0;
+        edge_corner[i][1] = c1;
+    }
+
+    for (size_type i2 = slab.z0; i2 < slab.z1; ++i2) {
+
+        for (size_type i1 = lo[1]; i1 <= hi[1]; ++i1) {
+
+            // Skip the cube row if its four voxel rows are uniformly
+            // inside or uniformly outside of the surface.
+            const char* r0 = &rows[i2 * s1 + i1];
+            const char* r1 = r0 + s1;
+
+            if (r0[0] != 3 && r0[0] == r0[1] &&
+                r0[0] == r1[0] && r0[0] == r1[1])
+                continue;
+
+            real_value_type cube_value[8];
+
+            // The x-positive face of a cube is the x-negative face
+            // of the next one.
+            cube_value[1] = volume(lo[0], i1,     i2    );
+            cube_value[2] = volume(lo[0], i1 + 1, i2    );
+            cube_value[5] = volume(lo[0], i1,     i2 + 1);
+            cube_value[6] = volume(lo[0], i1 + 1, i2 + 1);
+
+            for (size_type i0 = lo[0]; i0 <= hi[0]; ++i0) {
+
+                size_type       vertex_id_map[12];
+                int             flag_index = 0, edge_flag;
+
+                cube_value[0] = cube_value[1];
+                cube_value[3] = cube_value[2];
+                cube_value[4] = cube_value[5];
+                cube_value[7] = cube_value[6];
+                cube_value[1] = volume(i0 + 1, i1,     i2    );
+                cube_value[2] = volume(i0 + 1, i1 + 1, i2    );
+                cube_value[5] = volume(i0 + 1, i1,     i2 + 1);
+                cube_value[6] = volume(i0 + 1, i1 + 1, i2 + 1);
+
+                for (i = 0; i < 8; ++i) {
+                    if (cube_value[i] <= m_isovalue) {
+                        flag_index |= 1 << i;
+                    } // if
+                } // i
+
+                edge_flag = CUBE_EDGE_TBL[flag_index];
+
+                // If the cube is entirely inside or outside of the
+                // surface, there will be no intersections.
+                if (edge_flag == 0) continue;
+
+                for (i = 0; i < 12; ++i) {
+                    if (!(edge_flag & (1 << i))) continue;
+
+                    const size_type  axis = edge_axis[i];
+                    const size_type* ofs  = CUBE_VERT_OFS[edge_corner[i][0]];
+                    const size_type  pos  = (i1 + ofs[1] - lo[1]) * w0
+                                          + (i0 + ofs[0] - lo[0]);
+                    size_type&       id   = (axis == 2) ?
+                        cache_z[pos] : cache[ofs[2]][axis][pos];
+
+                    if (id != NO_VERTEX) {
+                        vertex_id_map[i] = id;
+                        continue;
+                    }
+
+                    // The first plane of a slab belongs to the
+                    // previous slab.
+                    if (!first && i2 == slab.z0 && axis != 2 && ofs[2] == 0) {
+                        touched[0].push_back(pos * 2 + axis);
+                        id = SHARED_ID | slab.shared.size();
+                        slab.shared.push_back(pos * 2 + axis);
+                        vertex_id_map[i] = id;
+                        continue;
+                    }
+
+                    size_type p0 = i0 + ofs[0], p1 = i1 + ofs[1], p2 = i2 + ofs[2];
+                    real_value_type offset = get_isosurface_offset(
+                            cube_value[edge_corner[i][0]],
+                            cube_value[edge_corner[i][1]]
+                        );
+
+                    point_type vertex((real_value_type)p0,
+                                      (real_value_type)p1,
+                                      (real_value_type)p2);
+                    vertex[axis] += offset;
+
+                    // Interpolate the gradients of the end-points.
+                    point_type g0 = get_gradient(volume, p0, p1, p2);
+                    point_type g1 = get_gradient(volume,
+                                                 p0 + (axis == 0),
+                                                 p1 + (axis == 1),
+                                                 p2 + (axis == 2));
+                    point_type normal;
+                    for (j = 0; j < 3; ++j)
+                        normal[j] = g0[j] + offset * (g1[j] - g0[j]);
+                    normal.normalize();
+
+                    if (axis == 2)
+                        touched_z.push_back(pos);
+                    else
+                        touched[ofs[2]].push_back(pos * 2 + axis);
+
+                    id = slab.vertices.size();
+                    slab.vertices.push_back(vertex);
+                    slab.normals.push_back(normal);
+                    vertex_id_map[i] = id;
+                } // for i
+
+                for (i = 0; i < 15; i += 3) {
+
+                    if (TRIANGLES_TBL[flag_index][i] < 0) break;
+
+                    triangle_type triangle;
+                    triangle.v[0] = vertex_id_map[TRIANGLES_TBL[flag_index][i    ]];
+                    triangle.v[1] = vertex_id_map[TRIANGLES_TBL[flag_index][i + 1]];
+                    triangle.v[2] = vertex_id_map[TRIANGLES_TBL[flag_index][i + 2]];
+
+                    slab.triangles.push_back(triangle);
+
+                } // for i
+            } // i0
+        } // i1
+
+        // Move on to the next cube layer: the upper plane becomes the
+        // lower one. Only the entries that were written are reset.
+        for (j = 0; j < (int)touched[0].size(); ++j)
+            cache[0][touched[0][j] & 1][touched[0][j] >> 1] = NO_VERTEX;
+        for (j = 0; j < (int)touched_z.size(); ++j)
+            cache_z[touched_z[j]] = NO_VERTEX;
+        touched[0].clear();
+        touched_z.clear();
+
+        cache[0][0].swap(cache[1][0]);
+        cache[0][1].swap(cache[1][1]);
+        touched[0].swap(touched[1]);
+    } // i2
+
+    // Keep the ids of the last plane for the next slab.
+    slab.last[0].swap(cache[0][0]);
+    slab.last[1].swap(cache[0][1]);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Write a 32-bit value in little-endian byte order.
+inline void isosurface_put_le32(std::ostream& os, unsigned long value)
+{
+    char bytes[4];
+    bytes[0] = (char)( value        & 0xFF);
+    bytes[1] = (char)((value >>  8) & 0xFF);
+    bytes[2] = (char)((value >> 16) & 0xFF);
+    bytes[3] = (char)((value >> 24) & 0xFF);
+    os.write(bytes, 4);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Write a 32-bit float in little-endian byte order.
+inline void isosurface_put_float(std::ostream& os, double value)
+{
+    float         f = (float)value;
+    unsigned int  u;
+    memcpy(&u, &f, sizeof(u));
+    isosurface_put_le32(os, u);
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+void isosurface<_Ty, _Real, _Tg>::save_stl(const char* filename,
+                                           double      scale_x,
+                                           double      scale_y,
+                                           double      scale_z
+                                           )
+{
+    std::ofstream fs(filename, std::ios::out | std::ios::binary);
+    if (fs.is_open()) {
+        save_stl(fs, scale_x, scale_y, scale_z);
+        fs.close();
+    }
+    else {
+        char errmsg[1024];
+        secure_sprintf(errmsg, sizeof(errmsg),
+            "isosurface::save_stl: Could not open file: %s.", filename);
+        throw_exception(std::runtime_error(errmsg));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+void isosurface<_Ty, _Real, _Tg>::save_stl(std::ostream& os,
+                                           double        scale_x,
+                                           double        scale_y,
+                                           double        scale_z
+                                           )
+{
+    char      header[80];
+    size_type i;
+    int       k;
+
+    memset(header, 0, sizeof(header));
+    secure_sprintf(header, sizeof(header), "optnet::isosurface");
+    os.write(header, sizeof(header));
+
+    isosurface_put_le32(os, (unsigned long)m_triangles.size());
+
+    for (i = 0; i < m_triangles.size(); ++i) {
+        const triangle_type& t = m_triangles[i];
+        double p[3][3], n[3], e1[3], e2[3], len;
+
+        for (k = 0; k < 3; ++k) {
+            point_const_reference v = m_vertices[t.v[k]];
+            p[k][0] = v.v[0] * scale_x;
+            p[k][1] = v.v[1] * scale_y;
+            p[k][2] = v.v[2] * scale_z;
+        }
+
+        // Facet normal.
+        for (k = 0; k < 3; ++k) {
+            e1[k] = p[1][k] - p[0][k];
+            e2[k] = p[2][k] - p[0][k];
+        }
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        len  = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len > 0) {
+            n[0] /= len; n[1] /= len; n[2] /= len;
+        }
+
+        for (k = 0; k < 3; ++k)
+            isosurface_put_float(os, n[k]);
+        for (k = 0; k < 9; ++k)
+            isosurface_put_float(os, p[k / 3][k % 3]);
+
+        os.write("\0\0", 2); // attribute byte count
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+void isosurface<_Ty, _Real, _Tg>::save_ply(const char* filename,
+                                           double      scale_x,
+                                           double      scale_y,
+                                           double      scale_z
+                                           )
+{
+    std::ofstream fs(filename, std::ios::out | std::ios::binary);
+    if (fs.is_open()) {
+        save_ply(fs, scale_x, scale_y, scale_z);
+        fs.close();
+    }
+    else {
+        char errmsg[1024];
+        secure_sprintf(errmsg, sizeof(errmsg),
+            "isosurface::save_ply: Could not open file: %s.", filename);
+        throw_exception(std::runtime_error(errmsg));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real, typename _Tg>
+void isosurface<_Ty, _Real, _Tg>::save_ply(std::ostream& os,
+                                           double        scale_x,
+                                           double        scale_y,
+                                           double        scale_z
+                                           )
+{
+    size_type i;
+    int       k;
+
+    assert(m_vertices.size() == m_normals.size());
+
+    os << "ply\n";
+    os << "format binary_little_endian 1.0\n";
+    os << "comment optnet::isosurface\n";
+    os << "element vertex " << (unsigned long)m_vertices.size() << "\n";
+    os << "property float x\n";
+    os << "property float y\n";
+    os << "property float z\n";
+    os << "property float nx\n";
+    os << "property float ny\n";
+    os << "property float nz\n";
+    os << "element face " << (unsigned long)m_triangles.size() << "\n";
+    os << "property list uchar int vertex_indices\n";
+    os << "end_header\n";
+
+    for (i = 0; i < m_vertices.size(); ++i) {
+        point_const_reference v = m_vertices[i];
+        point_const_reference n = m_normals [i];
+        isosurface_put_float(os, v.v[0] * scale_x);
+        isosurface_put_float(os, v.v[1] * scale_y);
+        isosurface_put_float(os, v.v[2] * scale_z);
+        for (k = 0; k < 3; ++k)
+            isosurface_put_float(os, n.v[k]);
+    }
+
+    for (i = 0; i < m_triangles.size(); ++i) {
+        const triangle_type& t = m_triangles[i];
+        os.put((char)3);
+        for (k = 0; k < 3; ++k)
+            isosurface_put_le32(os, (unsigned long)t.v[k]);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // constants
 //
@@ -479,6 +1060,16 @@ template <typename _Ty, typename _Real, typename _Tg>
         {0, 3, 7, 6}, {0, 7, 4, 6}, {0, 4, 5, 6},
     };
 
+template <typename _Ty, typename _Real, typename _Tg>
+    const typename
+        isosurface<_Ty, _Real, _Tg>::size_type
+        isosurface<_Ty, _Real, _Tg>::NO_VERTEX = ~(size_type)0;
+
+template <typename _Ty, typename _Real, typename _Tg>
+    const typename
+        isosurface<_Ty, _Real, _Tg>::size_type
+        isosurface<_Ty, _Real, _Tg>::SHARED_ID = ~(~(size_type)0 >> 1);
+
 } // namespace
 
 #endif // ___ISOSURFACE_CXX___
@@ -27,10 +27,12 @@
 #       pragma warning(disable: 4284)
 #   endif
 
+#   include <optnet/config.h>
 #   include <optnet/_base/array.hxx>
 #   include <optnet/_base/array_ref.hxx>
 #   include <optnet/_base/point3.hxx>
 #   include <fstream>
+#   include <utility>
 #   include <vector>
 
 /// @namespace optnet
@@ -119,31 +121,19 @@ public:
     ///                   extracted.
     ///  @param isovalue  The value of the isosurface.
     ///
+    ///  @remarks The volume is split into slabs along the third
+    ///           dimension that are processed concurrently when OpenMP
+    ///           is available. Only the bounding box of the cubes that
+    ///           cross the isosurface is visited, and every vertex is
+    ///           shared by all triangles that meet at its voxel edge.
+    ///           The triangles face the voxels at or below the
+    ///           isovalue, i.e., they point outward for objects that
+    ///           are brighter than the isovalue (segmentation masks).
+    ///
     ///////////////////////////////////////////////////////////////////////
-    void find(array_base_type&  volume,
-              const value_type& isovalue = value_type()
-              )
-    {
-        if (volume.size_0() <= 0 ||
-            volume.size_1() <= 0 ||
-            volume.size_2() <= 0)
-            return;
-
-        clear();
-
-        m_isovalue = isovalue;
-
-        for (size_type i2 = 1; i2 + 1 < volume.size_2(); ++i2) {
-            for (size_type i1 = 1; i1 + 1 < volume.size_1(); ++i1) {
-                for (size_type i0 = 1; i0 + 1 < volume.size_0(); ++i0) {
-
-                    // march over a single cube
-                    march_cube(volume, i0, i1, i2);
-
-                } // i0
-            } // i1
-        } // i2
-    }
+    void find(const array_base_type& volume,
+              const value_type&      isovalue = value_type()
+              );
 
     ///////////////////////////////////////////////////////////////////////
     ///  Save the detected isosurface into an XML file.
@@ -167,6 +157,53 @@ public:
               double        scale_z = 1.0
               );
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Save the detected isosurface into a binary STL file.
+    ///
+    ///  @param filename  The file name.
+    ///////////////////////////////////////////////////////////////////////
+    void save_stl(const char* filename,
+                  double      scale_x = 1.0,
+                  double      scale_y = 1.0,
+                  double      scale_z = 1.0
+                  );
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Save the detected isosurface into an output stream in the binary
+    ///  STL format.
+    ///
+    ///  @param os  The output stream (opened in binary mode).
+    ///////////////////////////////////////////////////////////////////////
+    void save_stl(std::ostream& os,
+                  double        scale_x = 1.0,
+                  double        scale_y = 1.0,
+                  double        scale_z = 1.0
+                  );
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Save the detected isosurface (vertices, normals and triangles)
+    ///  into a binary little-endian PLY file.
+    ///
+    ///  @param filename  The file name.
+    ///////////////////////////////////////////////////////////////////////
+    void save_ply(const char* filename,
+                  double      scale_x = 1.0,
+                  double      scale_y = 1.0,
+                  double      scale_z = 1.0
+                  );
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Save the detected isosurface into an output stream in the binary
+    ///  little-endian PLY format.
+    ///
+    ///  @param os  The output stream (opened in binary mode).
+    ///////////////////////////////////////////////////////////////////////
+    void save_ply(std::ostream& os,
+                  double        scale_x = 1.0,
+                  double        scale_y = 1.0,
+                  double        scale_z = 1.0
+                  );
+
     ///////////////////////////////////////////////////////////////////////
     ///  Clear all stored isosurfaces.
     ///////////////////////////////////////////////////////////////////////
@@ -201,6 +238,25 @@ public:
 
 private:
 
+    ///////////////////////////////////////////////////////////////////////
+    // The part of the surface extracted from one slab of cube layers.
+    // Vertices on the first plane of the slab belong to the previous
+    // slab; they are referred to by "shared" ids (SHARED_ID bit set)
+    // that index the shared vector.
+    struct slab_type
+    {
+        size_type               z0, z1;     // The cube layers [z0, z1).
+        point_vector_type       vertices;   // The vertices owned by the
+        point_vector_type       normals;    // slab and their normals.
+        triangle_vector_type    triangles;  // In slab-local ids.
+        std::vector<size_type>  shared;     // Plane position * 2 + axis.
+        std::vector<size_type>  last[2];    // Ids on the last plane.
+        std::vector<std::pair<size_type, size_type> >
+                                edges;      // Sorted unique mesh edges.
+    };
+
+    typedef std::vector<slab_type>              slab_vector_type;
+
     value_type              m_isovalue;
     point_vector_type       m_vertices, m_normals;
     triangle_vector_type    m_triangles;
@@ -216,10 +272,13 @@ private:
     static const size_type       TETR_EDGE_LNK[ 6][2];
     static const size_type       TETR_CUBE_MAP[ 6][4];
 
+    static const size_type       NO_VERTEX;
+    static const size_type       SHARED_ID;
+
     ///////////////////////////////////////////////////////////////////////
     inline real_value_type get_isosurface_offset(const real_value_type& v1,
                                                  const real_value_type& v2
-                                                 )
+                                                 ) const
     {
         real_value_type delta = v2 - v1;
 
@@ -228,112 +287,57 @@ private:
     }
 
     ///////////////////////////////////////////////////////////////////////
-    inline void march_cube(array_base_type& volume,
-                           size_type        i0,
-                           size_type        i1,
-                           size_type        i2
-                           )
+    // Returns the gradient of the volume at the given voxel (central
+    // differences, one-sided at the volume boundary).
+    inline point_type get_gradient(const array_base_type& volume,
+                                   size_type              i0,
+                                   size_type              i1,
+                                   size_type              i2
+                                   ) const
     {
-        edge_type       edge;
-        point_type      vertex;
-        triangle_type   triangle;
-        real_value_type cube_value[8];
-        size_type       vertex_id_map[12];
-        bool            edge_map[12][12];
-        int             i, flag_index, edge_flag;
-
-        flag_index = 0;
-        for (i = 0; i < 8; ++i) {
-            cube_value[i] = volume(i0 + CUBE_VERT_OFS[i][0],
-                                   i1 + CUBE_VERT_OFS[i][1],
-                                   i2 + CUBE_VERT_OFS[i][2]
-                                   );
-            if (cube_value[i] <= m_isovalue) {
-                flag_index |= 1 << i;
-            } // if
-        } // i
-
-        edge_flag = CUBE_EDGE_TBL[flag_index];
-
-        // If the cube is entirely inside or outside of the surface,
-        // there will be no intersections.
-        if (edge_flag == 0) return;
-
-        memset(edge_map, 0, sizeof(edge_map));
-        
-        for (i = 0; i < 12; ++i) {
-            if (edge_flag & (1 << i)) {
-                
-                real_value_type offset = get_isosurface_offset(
-                        cube_value[CUBE_EDGE_LNK[i][0]],
-                        cube_value[CUBE_EDGE_LNK[i][1]]
-                    );
-                
-                vertex.v[0] = i0 + (CUBE_VERT_OFS[CUBE_EDGE_LNK[i][0]][0]
-                                       + offset * CUBE_EDGE_DIR[i][0]);
-                vertex.v[1] = i1 + (CUBE_VERT_OFS[CUBE_EDGE_LNK[i][0]][1]
-                                       + offset * CUBE_EDGE_DIR[i][1]);
-                vertex.v[2] = i2 + (CUBE_VERT_OFS[CUBE_EDGE_LNK[i][0]][2]
-                                       + offset * CUBE_EDGE_DIR[i][2]);
-
-                m_vertices.push_back(vertex);
-
-                vertex_id_map[i] = m_vertices.size() - 1;
-
-                //
-                // FIXME: Get normals -- there may be a bug here.
-                //
-                point_type normal;
-                normal[0] = volume(i0 + 1, i1, i2) - volume(i0 - 1, i1, i2);
-                normal[1] = volume(i0, i1 + 1, i2) - volume(i0, i1 - 1, i2);
-                normal[2] = volume(i0, i1, i2 + 1) - volume(i0, i1, i2 - 1);
-                normal.normalize();
-
-                m_normals.push_back(normal);
-            } // if
-        } // for i
-
-        for (i = 0; i < 15; i += 3) {
-
-            if (TRIANGLES_TBL[flag_index][i] < 0) break;
-
-            int v0 = TRIANGLES_TBL[flag_index][i    ];
-            int v1 = TRIANGLES_TBL[flag_index][i + 1];
-            int v2 = TRIANGLES_TBL[flag_index][i + 2];
-            int u0 = (int)vertex_id_map[v0];
-            int u1 = (int)vertex_id_map[v1];
-            int u2 = (int)vertex_id_map[v2];
-
-            if (!edge_map[v0][v1]) {
-                edge.v[0] = u0; edge.v[1] = u1;
-                m_edges.push_back(edge);
-                edge_map[v0][v1] =
-                    edge_map[v1][v0] = true;
-            }
-
-            if (!edge_map[v0][v2]) {
-                edge.v[0] = u0; edge.v[1] = u2;
-                m_edges.push_back(edge);
-                edge_map[v0][v2] = 
-                    edge_map[v2][v0] = true;
-            }
-
-            if (!edge_map[v1][v2]) {
-                edge.v[0] = u1; edge.v[1] = u2;
-                m_edges.push_back(edge);
-                edge_map[v1][v2] = 
-                    edge_map[v2][v1] = true;
-            }
-
-            triangle.v[0] = u0;
-            triangle.v[1] = u1;
-            triangle.v[2] = u2;
-
-            m_triangles.push_back(triangle);
-
-        } // for i
+        size_type  lo[3] = { i0, i1, i2 }, hi[3] = { i0, i1, i2 };
+        size_type  sz[3] = { volume.size_0(), volume.size_1(), volume.size_2() };
+        point_type g;
+
+        for (int d = 0; d < 3; ++d) {
+            if (lo[d] > 0) --lo[d];
+            if (hi[d] + 1 < sz[d]) ++hi[d];
+        }
+
+        g[0] = (hi[0] == lo[0]) ? 0 :
+            ((real_value_type)volume(hi[0], i1, i2)
+           - (real_value_type)volume(lo[0], i1, i2)) / (hi[0] - lo[0]);
+        g[1] = (hi[1] == lo[1]) ? 0 :
+            ((real_value_type)volume(i0, hi[1], i2)
+           - (real_value_type)volume(i0, lo[1], i2)) / (hi[1] - lo[1]);
+        g[2] = (hi[2] == lo[2]) ? 0 :
+            ((real_value_type)volume(i0, i1, hi[2])
+           - (real_value_type)volume(i0, i1, lo[2])) / (hi[2] - lo[2]);
+
+        return g;
     }
 
+    ///////////////////////////////////////////////////////////////////////
+    // Extract the surface in the cubes [lo, hi] of one slab.
+    void march_slab(const array_base_type&   volume,
+                    const size_type*         lo,
+                    const size_type*         hi,
+                    const std::vector<char>& rows,
+                    bool                     first,
+                    slab_type&               slab
+                    ) const;
+
+    ///////////////////////////////////////////////////////////////////////
+    // Find the bounding box [lo, hi] of the cubes that cross the
+    // isosurface, and the kinds of voxels in each voxel row
+    // (rows[i2 * size_1 + i1]; bit 0: at or below the isovalue, bit 1:
+    // above it). Returns false if the volume has no such cube.
+    bool find_bounds(const array_base_type& volume,
+                     size_type*             lo,
+                     size_type*             hi,
+                     std::vector<char>&     rows
+                     ) const;
+
 };
 
 } // namespace
@@ -0,0 +1,538 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: levelset3_sparse_field.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+/*
+ ==========================================================================
+  - Purpose:
+
+      Sparse-field (narrow-band) representation of a 3-D level set
+      function. Only the active layer (|phi| <= 0.5) is moved by the
+      caller; the two layers on each side of it are kept at the
+      (city-block) distance to the active layer, and every voxel outside
+      the band is clamped to +/-3. The work per update is proportional
+      to the number of band voxels, i.e., to the surface area.
+
+      The level set function is positive inside the object, as in the
+      other levelset3_* helpers and metamorphs3.
+
+  - Reference(s):
+
+    [1] Ross T. Whitaker
+        A Level-Set Approach to 3D Reconstruction from Range Data
+        International Journal of Computer Vision, 29(3), 1998
+
+    [2] Shawn Lankton
+        Sparse Field Methods - Technical Report
+        Georgia Institute of Technology, 2009
+ ==========================================================================
+ */
+
+#ifndef ___LEVELSET3_SPARSE_FIELD_HXX___
+#   define ___LEVELSET3_SPARSE_FIELD_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#       pragma warning(disable: 4284)
+#   endif
+
+#   include <optnet/config.h>
+#   include <optnet/_base/array.hxx>
+#   include <optnet/_base/array_ref.hxx>
+#   include <optnet/_base/point3.hxx>
+#   include <optnet/_base/except.hxx>
+#   include <algorithm>
+#   include <vector>
+#   include <cmath>
+
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+///  @class levelset3_sparse_field
+///  @brief Sparse-field narrow band of a 3-D level set function.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Tg = net_f_xy>
+class levelset3_sparse_field
+{
+public:
+    
+    typedef _Ty                             value_type;
+    typedef value_type&                     reference;
+    typedef const value_type&               const_reference;
+
+    typedef array_base<value_type, _Tg>     array_base_type;
+    typedef array_ref<value_type, _Tg>      array_ref_type;
+    typedef array<value_type, _Tg>          array_type;
+
+    typedef signed char                     label_type;
+    typedef array<label_type, _Tg>          label_array_type;
+
+    typedef point3<int>                     point_type;
+    typedef std::vector<point_type>         layer_type;
+
+    typedef size_t                          size_type;
+
+    enum
+    {
+        NUM_LAYERS = 5, ///< The active layer and two layers on each side.
+        FAR_LABEL  = 3  ///< The label (and value) of the voxels outside
+                        ///< the band, with the sign of the side.
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Default constructor.
+    ///////////////////////////////////////////////////////////////////////
+    levelset3_sparse_field() :
+        m_plevelset(0)
+    {
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Builds the band from a level set function.
+    ///
+    ///  @param[in,out] levelset  The level set function (positive inside).
+    ///                           It is kept by reference and updated in
+    ///                           place; the values outside the band are
+    ///                           clamped to +/-FAR_LABEL.
+    ///
+    ///  @remarks This is the only step that visits the whole volume.
+    ///////////////////////////////////////////////////////////////////////
+    void create(array_base_type& levelset)
+    {
+        int         i0, i1, i2;
+        layer_type  crossings;
+
+        m_plevelset = &levelset;
+        m_s[0] = (int)levelset.size_0();
+        m_s[1] = (int)levelset.size_1();
+        m_s[2] = (int)levelset.size_2();
+
+        m_label.create(m_s[0], m_s[1], m_s[2]);
+
+        for (i2 = 0; i2 < m_s[2]; ++i2) {
+            for (i1 = 0; i1 < m_s[1]; ++i1) {
+                for (i0 = 0; i0 < m_s[0]; ++i0) {
+                    m_label(i0, i1, i2) = far_label(levelset(i0, i1, i2));
+                }
+            }
+        }
+
+        for (i2 = 0; i2 < m_s[2]; ++i2) {
+            for (i1 = 0; i1 < m_s[1]; ++i1) {
+                for (i0 = 0; i0 < m_s[0]; ++i0) {
+                    point_type p(i0, i1, i2);
+                    if (is_crossing(p)) crossings.push_back(p);
+                }
+            }
+        }
+
+        for (int k = 0; k < NUM_LAYERS; ++k) m_layers[k].clear();
+        build_band(crossings);
+
+        for (i2 = 0; i2 < m_s[2]; ++i2) {
+            for (i1 = 0; i1 < m_s[1]; ++i1) {
+                for (i0 = 0; i0 < m_s[0]; ++i0) {
+                    label_type l = m_label(i0, i1, i2);
+                    if (l == FAR_LABEL || l == -FAR_LABEL)
+                        levelset(i0, i1, i2) = (value_type)l;
+                }
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Rebuilds the band from the zero crossings of the current level
+    ///  set function. Only the voxels of the band are visited.
+    ///////////////////////////////////////////////////////////////////////
+    void reinit()
+    {
+        layer_type  band, crossings;
+        size_type   n;
+        int         k;
+
+        check_created();
+
+        for (k = 0; k < NUM_LAYERS; ++k) {
+            band.insert(band.end(), m_layers[k].begin(), m_layers[k].end());
+            m_layers[k].clear();
+        }
+
+        for (n = 0; n < band.size(); ++n)
+            label(band[n]) = far_label(phi(band[n]));
+
+        for (n = 0; n < band.size(); ++n) {
+            if (is_crossing(band[n])) crossings.push_back(band[n]);
+        }
+
+        build_band(crossings);
+
+        for (n = 0; n < band.size(); ++n) {
+            label_type l = label(band[n]);
+            if (l == FAR_LABEL || l == -FAR_LABEL)
+                phi(band[n]) = (value_type)l;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Moves the active layer and updates the band.
+    ///
+    ///  @param changes  The change of the level set function at each
+    ///                  voxel of the active layer, in the order of
+    ///                  active_layer(). The changes are clamped to
+    ///                  [-0.5, 0.5] (one layer per update).
+    ///////////////////////////////////////////////////////////////////////
+    void update(const std::vector<value_type>& changes)
+    {
+        layer_type  sz, s1[2], s2[2];
+        size_type   n;
+        int         side;
+
+        check_created();
+
+        layer_type& lz = m_layers[2];
+
+        if (changes.size() != lz.size()) {
+            throw_exception(std::invalid_argument(
+                "levelset3_sparse_field::update: "
+                "There must be one change per active voxel."
+                ));
+        }
+
+        // Move the active layer; the voxels that leave it keep label 0
+        // until the status lists are processed.
+        layer_type keep;
+        keep.reserve(lz.size());
+        for (n = 0; n < lz.size(); ++n) {
+            value_type d = changes[n];
+            if (d >  (value_type)0.5) d = (value_type) 0.5;
+            if (d < -(value_type)0.5) d = (value_type)-0.5;
+            value_type& v = phi(lz[n]);
+            v += d;
+            if      (v >  (value_type)0.5) s1[1].push_back(lz[n]);
+            else if (v < -(value_type)0.5) s1[0].push_back(lz[n]);
+            else                           keep.push_back(lz[n]);
+        }
+        lz.swap(keep);
+
+        // Layers +/-1 follow the active layer.
+        for (side = 0; side < 2; ++side) {
+            const int   sigma = side ? 1 : -1;
+            layer_type& l1 = m_layers[2 + sigma];
+            keep.clear();
+            for (n = 0; n < l1.size(); ++n) {
+                const point_type& p = l1[n];
+                value_type psi;
+                if (!has_neighbor_label(p, 0)) {
+                    s2[side].push_back(p);
+                    continue;
+                }
+                psi = min_neighbor_distance(p, sigma, 0) + 1;
+                phi(p) = sigma * psi;
+                if      (psi <= (value_type)0.5) sz.push_back(p);
+                else if (psi >  (value_type)1.5) s2[side].push_back(p);
+                else                             keep.push_back(p);
+            }
+            l1.swap(keep);
+        }
+
+        // Layers +/-2 follow layers +/-1.
+        for (side = 0; side < 2; ++side) {
+            const int   sigma = side ? 1 : -1;
+            layer_type& l2 = m_layers[2 + 2 * sigma];
+            keep.clear();
+            for (n = 0; n < l2.size(); ++n) {
+                const point_type& p = l2[n];
+                value_type psi;
+                if (!has_neighbor_label(p, sigma)) {
+                    set_far(p, sigma);
+                    continue;
+                }
+                psi = min_neighbor_distance(p, sigma, 1) + 1;
+                phi(p) = sigma * psi;
+                if      (psi <= (value_type)1.5) s1[side].push_back(p);
+                else if (psi >  (value_type)2.5) set_far(p, sigma);
+                else                             keep.push_back(p);
+            }
+            l2.swap(keep);
+        }
+
+        // Process the status lists.
+        for (n = 0; n < sz.size(); ++n) {
+            label(sz[n]) = 0;
+            lz.push_back(sz[n]);
+        }
+
+        for (side = 0; side < 2; ++side) {
+            const int   sigma = side ? 1 : -1;
+            for (n = 0; n < s1[side].size(); ++n) {
+                const point_type& p = s1[side][n];
+                label(p) = (label_type)sigma;
+                m_layers[2 + sigma].push_back(p);
+
+                // The far neighbors enter layer 2 behind p.
+                for (int k = 0; k < 6; ++k) {
+                    point_type q;
+                    if (!neighbor(p, k, q)) continue;
+                    if (label(q) == sigma * FAR_LABEL) {
+                        label(q) = (label_type)(2 * sigma);
+                        phi(q) = phi(p) + sigma;
+                        s2[side].push_back(q);
+                    }
+                }
+            }
+        }
+
+        for (side = 0; side < 2; ++side) {
+            const int   sigma = side ? 1 : -1;
+            for (n = 0; n < s2[side].size(); ++n) {
+                label(s2[side][n]) = (label_type)(2 * sigma);
+                m_layers[2 + 2 * sigma].push_back(s2[side][n]);
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Moves the active layer by a speed function and updates the band.
+    ///
+    ///  @param speed  A functor returning the change of the level set
+    ///                function at an active voxel (i0, i1, i2). It is
+    ///                called concurrently when OpenMP is available.
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Speed>
+    void update_by(const _Speed& speed)
+    {
+        const layer_type&       lz = active_layer();
+        std::vector<value_type> changes(lz.size());
+        int                     n;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(n) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (n = 0; n < (int)lz.size(); ++n) {
+            changes[n] = (value_type)speed(lz[n].v[0], lz[n].v[1], lz[n].v[2]);
+        }
+
+        update(changes);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the voxels of layer k (-2..2; 0 is the active layer,
+    ///  positive layers are inside).
+    ///////////////////////////////////////////////////////////////////////
+    inline const layer_type& layer(int k) const
+                { return m_layers[k + 2]; }
+    inline const layer_type& active_layer() const
+                { return m_layers[2]; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the layer of a voxel (+/-FAR_LABEL outside the band).
+    ///////////////////////////////////////////////////////////////////////
+    inline label_type get_label(int i0, int i1, int i2) const
+                { return m_label(i0, i1, i2); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the number of voxels in the band.
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type band_size() const
+    {
+        size_type n = 0;
+        for (int k = 0; k < NUM_LAYERS; ++k) n += m_layers[k].size();
+        return n;
+    }
+
+
+private:
+
+    array_base_type*    m_plevelset;
+    label_array_type    m_label;
+    layer_type          m_layers[NUM_LAYERS];
+    int                 m_s[3];
+
+    ///////////////////////////////////////////////////////////////////////
+    inline value_type& phi(const point_type& p)
+                { return (*m_plevelset)(p.v[0], p.v[1], p.v[2]); }
+    inline label_type& label(const point_type& p)
+                { return m_label(p.v[0], p.v[1], p.v[2]); }
+
+    inline static label_type far_label(const value_type& v)
+                { return (v >= 0) ? (label_type)FAR_LABEL :
+                                    (label_type)-FAR_LABEL; }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Returns the k-th 6-neighbor of p in q, or false if it is outside
+    // the volume.
+    inline bool neighbor(const point_type& p, int k, point_type& q) const
+    {
+        static const int OFS[6][3] = {
+            { -1, 0, 0 }, { 1, 0, 0 },
+            { 0, -1, 0 }, { 0, 1, 0 },
+            { 0, 0, -1 }, { 0, 0, 1 }
+        };
+        for (int d = 0; d < 3; ++d) {
+            q.v[d] = p.v[d] + OFS[k][d];
+            if (q.v[d] < 0 || q.v[d] >= m_s[d]) return false;
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    inline bool has_neighbor_label(const point_type& p, int l)
+    {
+        point_type q;
+        for (int k = 0; k < 6; ++k) {
+            if (neighbor(p, k, q) && label(q) == l) return true;
+        }
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Returns the smallest signed distance, seen from side sigma, of the
+    // neighbors whose layer is at most l on that side.
+    inline value_type min_neighbor_distance(const point_type& p,
+                                            int               sigma,
+                                            int               l
+                                            )
+    {
+        value_type psi = (value_type)FAR_LABEL;
+        point_type q;
+        for (int k = 0; k < 6; ++k) {
+            if (neighbor(p, k, q) && sigma * label(q) <= l) {
+                value_type v = sigma * phi(q);
+                if (v < psi) psi = v;
+            }
+        }
+        return psi;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    inline void set_far(const point_type& p, int sigma)
+    {
+        label(p) = (label_type)(sigma * FAR_LABEL);
+        phi(p) = (value_type)(sigma * FAR_LABEL);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    inline bool is_crossing(const point_type& p)
+    {
+        bool       inside = (phi(p) >= 0);
+        point_type q;
+        for (int k = 0; k < 6; ++k) {
+            if (neighbor(p, k, q) && (phi(q) >= 0) != inside) return true;
+        }
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Returns the distance from p to the front, estimated from the zero
+    // crossings along each axis (see levelset3_extractor).
+    inline value_type crossing_distance(const point_type& p)
+    {
+        double      nb[3], value = phi(p);
+        bool        inside = (value >= 0);
+        point_type  q;
+
+        nb[0] = nb[1] = nb[2] = -1.0;
+
+        for (int k = 0; k < 6; ++k) {
+            if (!neighbor(p, k, q)) continue;
+            double nv = phi(q);
+            if ((nv >= 0) == inside) continue;
+            double d = value / (value - nv);
+            if (nb[k / 2] < 0 || d < nb[k / 2]) nb[k / 2] = d;
+        }
+
+        double sum = 0.0;
+        for (int d = 0; d < 3; ++d) {
+            if (nb[d] == 0.0) return (value_type)0;
+            if (nb[d] > 0.0) sum += 1.0 / (nb[d] * nb[d]);
+        }
+        return (value_type)sqrt(1.0 / sum);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Builds the layers around the given zero-crossing voxels, all of
+    // which must have far labels.
+    void build_band(const layer_type& crossings)
+    {
+        std::vector<value_type> dist(crossings.size());
+        size_type               n;
+        int                     k, l, side;
+        point_type              q;
+
+        for (n = 0; n < crossings.size(); ++n)
+            dist[n] = crossing_distance(crossings[n]);
+
+        // The voxels within half a voxel of the front form the active
+        // layer; the others are in layer +/-1.
+        for (n = 0; n < crossings.size(); ++n) {
+            const point_type& p = crossings[n];
+            const int sigma = (phi(p) >= 0) ? 1 : -1;
+            phi(p) = sigma * dist[n];
+            if (dist[n] <= (value_type)0.5) {
+                label(p) = 0;
+                m_layers[2].push_back(p);
+            }
+            else {
+                label(p) = (label_type)sigma;
+                m_layers[2 + sigma].push_back(p);
+            }
+        }
+
+        // Grow layers +/-1, then +/-2, from the voxels with smaller
+        // labels.
+        for (l = 1; l <= 2; ++l) {
+            layer_type grown;
+            for (side = 0; side < 2; ++side) {
+                const layer_type& inner = m_layers[2 + (side ? 1 : -1) * (l - 1)];
+                for (n = 0; n < inner.size(); ++n) {
+                    for (k = 0; k < 6; ++k) {
+                        if (!neighbor(inner[n], k, q)) continue;
+                        label_type lq = label(q);
+                        if (lq != FAR_LABEL && lq != -FAR_LABEL) continue;
+                        label(q) = (label_type)((lq > 0) ? l : -l);
+                        grown.push_back(q);
+                    }
+                }
+                if (l == 1) break;  // layer 0 is shared by both sides
+            }
+            for (n = 0; n < grown.size(); ++n) {
+                const int sigma = (label(grown[n]) > 0) ? 1 : -1;
+                phi(grown[n]) = sigma *
+                    (min_neighbor_distance(grown[n], sigma, l - 1) + 1);
+                m_layers[2 + sigma * l].push_back(grown[n]);
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    inline void check_created() const
+    {
+        if (0 == m_plevelset) {
+            throw_exception(std::runtime_error(
+                "levelset3_sparse_field: The band has not been created."
+                ));
+        }
+    }
+
+};
+
+} // namespace
+
+#endif // ___LEVELSET3_SPARSE_FIELD_HXX___
@@ -23,6 +23,7 @@
 
 #   include <optnet/define.h>
 #   include <optnet/_alpha/metamorphs3.hxx>
+#   include <algorithm>
 #   include <limits>
 
 #   ifdef max
@@ -102,8 +103,6 @@ void metamorphs3<_Ty, _Real>::solve(const double& lambda,
 {
     using namespace optnet::utils;
 
-    typedef cubic_spline_ffd3<real_value_type> ffd_type;
-
     int                     iter, s0, s1, s2, i0, i1, i2, c0, c1, c2;
     real_value_type         iter_d, rayl_b, rayl_b2, inv_rayl_b2 = 0.0;
 
@@ -169,7 +168,6 @@ void metamorphs3<_Ty, _Real>::solve(const double& lambda,
 
     // Initialize Free-Form Deformation (FFD) engine.
     typename ffd_type::array_type q  (ctrl_0, ctrl_1, ctrl_2);
-    typename ffd_type::array_type dis(s0, s1, s2);
 
     ffd_type ffd(q, s0, s1, s2);
 
@@ -177,6 +175,14 @@ void metamorphs3<_Ty, _Real>::solve(const double& lambda,
         m_dbg.log_printf("Precomputing...\n");
     ffd.precompute();
 
+    if (m_sparse_field) {
+        solve_sparse_field(ffd, q, lambda, inv_rayl_b2, niters, stop_d);
+        m_dbg.log_end();
+        return;
+    }
+
+    typename ffd_type::array_type dis(s0, s1, s2);
+
     for (iter = 0; iter < niters; ++iter) {
     
         // STEP 1: Initialize q to q0.
@@ -420,7 +426,7 @@ void metamorphs3<_Ty, _Real>::solve(const double& lambda,
                                    dis[i0][1] * dis[i0][1] + 
                                    dis[i0][2] * dis[i0][2];
             if (sqrt(diff) > iter_d)
-                iter_d = diff;
+                iter_d = sqrt(diff);
         }
 
         if (m_verbose > 0) {
@@ -443,6 +449,248 @@ void metamorphs3<_Ty, _Real>::solve(const double& lambda,
     m_dbg.log_end();
 }
 
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty, typename _Real>
+void metamorphs3<_Ty, _Real>::solve_sparse_field(
+    ffd_type&                      ffd,
+    typename ffd_type::array_type& q,
+    const double&                  lambda,
+    real_value_type                inv_rayl_b2,
+    int                            niters,
+    const double&                  stop_d
+    )
+{
+    // The per-voxel data term vectors (x, y, z each), and the sums over
+    // the support of each control point.
+    enum { ISDT = 0, BSDT = 3, RIDT = 6, MIDT = 9, NUM_TERMS = 12 };
+
+    // The band is rebuilt from its zero crossings every so often.
+    const int REINIT_INTERVAL = 10;
+
+    typedef typename sparse_field_type::layer_type layer_type;
+
+    real_image_type&        levelset = *m_plevelset;
+    const image_base_type&  image    = *m_pimage;
+
+    int                     ctrl_0 = (int)q.size_0();
+    int                     ctrl_1 = (int)q.size_1();
+    int                     ctrl_2 = (int)q.size_2();
+    int                     iter, k, c, t, n;
+    real_value_type         iter_d;
+
+    sparse_field_type               sf;
+    std::vector<real_value_type>    sums(q.size() * NUM_TERMS);
+    std::vector<int>                vrm(q.size()), vbm(q.size());
+    std::vector<real_value_type>    changes;
+
+    sf.create(levelset);
+
+    for (iter = 0; iter < niters; ++iter) {
+
+        std::fill(sums.begin(), sums.end(), (real_value_type)0);
+        std::fill(vrm.begin(), vrm.end(), 0);
+        std::fill(vbm.begin(), vbm.end(), 0);
+
+        // STEP 2/3: Only the band voxels with -1 < phi carry data
+        // terms; each of them feeds the control points whose B-spline
+        // support covers it.
+        for (k = -1; k <= 2; ++k) {
+
+            const layer_type& lay = sf.layer(k);
+
+            for (n = 0; n < (int)lay.size(); ++n) {
+
+                int             i0 = lay[n].v[0];
+                int             i1 = lay[n].v[1];
+                int             i2 = lay[n].v[2];
+                real_value_type phi = levelset(i0, i1, i2);
+                real_value_type term[NUM_TERMS], tmp1, tmp2;
+                bool            interior = (phi > 0.0);
+
+                if (!interior && !(phi > -1.0)) continue;
+
+                for (t = 0; t < NUM_TERMS; ++t) term[t] = 0;
+
+                if (interior) {
+                    // -- interior shape data term
+                    if (m_para_a != 0) {
+                        tmp1 = (m_shape_image(i0, i1, i2) - phi) * 2;
+                        term[ISDT + 0] = tmp1 * m_dx_shape_image(i0, i1, i2);
+                        term[ISDT + 1] = tmp1 * m_dy_shape_image(i0, i1, i2);
+                        term[ISDT + 2] = tmp1 * m_dz_shape_image(i0, i1, i2);
+                    }
+
+                    // -- region-of-interest intensity data term
+                    if (m_para_c != 0) {
+                        tmp2 = (m_roi_shape_image(i0, i1, i2) - phi) * 2;
+                        term[RIDT + 0] = tmp2 * m_dx_roi_shape_image(i0, i1, i2);
+                        term[RIDT + 1] = tmp2 * m_dy_roi_shape_image(i0, i1, i2);
+                        term[RIDT + 2] = tmp2 * m_dz_roi_shape_image(i0, i1, i2);
+                    }
+                }
+                else {
+                    // -- boundary shape data term
+                    if (m_para_b != 0) {
+                        tmp1 = m_shape_image(i0, i1, i2) * 2;
+                        term[BSDT + 0] = tmp1 * m_dx_shape_image(i0, i1, i2);
+                        term[BSDT + 1] = tmp1 * m_dy_shape_image(i0, i1, i2);
+                        term[BSDT + 2] = tmp1 * m_dz_shape_image(i0, i1, i2);
+                    }
+
+                    // -- maximum likelihood intensity data term
+                    if (m_para_d != 0) {
+                        real_value_type inv_voxel, voxel = (real_value_type)image(i0, i1, i2);
+                        inv_voxel = (voxel == 0) ? 0 : (real_value_type)(1.0 / voxel);
+                        tmp2 = inv_voxel - inv_rayl_b2;
+                        term[MIDT + 0] = tmp2 * m_dx_image(i0, i1, i2);
+                        term[MIDT + 1] = tmp2 * m_dy_image(i0, i1, i2);
+                        term[MIDT + 2] = tmp2 * m_dz_image(i0, i1, i2);
+                    }
+                }
+
+                size_type i = ffd.get_index_0(i0);
+                size_type j = ffd.get_index_1(i1);
+                size_type l = ffd.get_index_2(i2);
+
+                for (size_type dn = 0; dn < 4 && l + dn < (size_type)ctrl_2; ++dn) {
+                    for (size_type dm = 0; dm < 4 && j + dm < (size_type)ctrl_1; ++dm) {
+                        for (size_type dl = 0; dl < 4 && i + dl < (size_type)ctrl_0; ++dl) {
+
+                            real_value_type dev
+                                = ffd.get_derivative(dl, dm, dn, i0, i1, i2);
+
+                            c = (int)(i + dl + ctrl_0 * (j + dm + ctrl_1 * (l + dn)));
+
+                            real_value_type* s = &sums[c * NUM_TERMS];
+                            for (t = 0; t < NUM_TERMS; ++t) s[t] += dev * term[t];
+
+                            if (interior) ++vrm[c];
+                            else          ++vbm[c];
+                        }
+                    }
+                }
+
+            } // n
+        } // k
+
+        for (c = 0; c < (int)q.size(); ++c) {
+            
+            real_value_type* s = &sums[c * NUM_TERMS];
+            real_value_type  inv_vrm = (vrm[c] > 0) ? (real_value_type)(1.0 / vrm[c]) : 0;
+            real_value_type  inv_vbm = (vbm[c] > 0) ? (real_value_type)(1.0 / vbm[c]) : 0;
+
+            for (t = 0; t < 3; ++t) {
+                q[c][t] = lambda * (
+                      m_para_a * s[ISDT + t] * inv_vrm
+                    + m_para_b * s[BSDT + t] * inv_vbm
+                    + m_para_c * s[RIDT + t] * inv_vrm
+                    + m_para_d * s[MIDT + t] * inv_vbm
+                    );
+            }
+        }
+
+        // Pull the active layer back along the displacement field.
+        const layer_type& lz = sf.active_layer();
+
+        changes.resize(lz.size());
+        iter_d = 0.0;
+
+        #ifdef __OPTNET_PRAGMA_OMP__
+        #   pragma omp parallel for private(n) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+        #endif
+        for (n = 0; n < (int)lz.size(); ++n) {
+
+            int       i0 = lz[n].v[0];
+            int       i1 = lz[n].v[1];
+            int       i2 = lz[n].v[2];
+            double    dis[3] = { 0, 0, 0 };
+            size_type i = ffd.get_index_0(i0);
+            size_type j = ffd.get_index_1(i1);
+            size_type l = ffd.get_index_2(i2);
+
+            for (size_type dn = 0; dn < 4; ++dn) {
+                size_type kn = (l + dn < (size_type)ctrl_2) ? l + dn : ctrl_2 - 1;
+                for (size_type dm = 0; dm < 4; ++dm) {
+                    size_type jm = (j + dm < (size_type)ctrl_1) ? j + dm : ctrl_1 - 1;
+                    for (size_type dl = 0; dl < 4; ++dl) {
+                        size_type il = (i + dl < (size_type)ctrl_0) ? i + dl : ctrl_0 - 1;
+                        double    w = ffd.get_derivative(dl, dm, dn, i0, i1, i2);
+                        dis[0] += q(il, jm, kn).v[0] * w;
+                        dis[1] += q(il, jm, kn).v[1] * w;
+                        dis[2] += q(il, jm, kn).v[2] * w;
+                    }
+                }
+            }
+
+            changes[n] = sample_levelset(i0 + dis[0], i1 + dis[1], i2 + dis[2])
+                       - levelset(i0, i1, i2);
+
+            real_value_type d = (real_value_type)sqrt(dis[0] * dis[0] +
+                                                      dis[1] * dis[1] +
+                                                      dis[2] * dis[2]);
+        #ifdef __OPTNET_PRAGMA_OMP__
+        #   pragma omp critical
+        #endif
+            if (d > iter_d) iter_d = d;
+        }
+
+        sf.update(changes);
+        if ((iter + 1) % REINIT_INTERVAL == 0) sf.reinit();
+
+        if (m_verbose > 0) {
+            m_dbg.log_printf("%05d - %e (%d band voxels)\n",
+                             iter + 1, iter_d, (int)sf.band_size());
+        }
+
+        if (m_verbose > 1) {
+            char extbuf[64];
+            secure_sprintf(extbuf, sizeof(extbuf), ".%05d.ons", iter + 1);
+            isosurface_type iso;
+            iso.find(levelset, 0.0);
+            iso.save(std::string(m_task_name + extbuf).c_str());
+        }
+
+        if (iter_d < stop_d)
+            break; // terminate
+
+    } // main loop
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Trilinear interpolation of the level set function, clamped to the
+// volume.
+template <typename _Ty, typename _Real>
+typename metamorphs3<_Ty, _Real>::real_value_type
+metamorphs3<_Ty, _Real>::sample_levelset(double x, double y, double z) const
+{
+    const real_image_type& levelset = *m_plevelset;
+
+    double  p[3] = { x, y, z }, f[3];
+    int     i[3][2], s[3] = {
+        (int)levelset.size_0(),
+        (int)levelset.size_1(),
+        (int)levelset.size_2()
+    };
+
+    for (int d = 0; d < 3; ++d) {
+        if (p[d] < 0) p[d] = 0;
+        if (p[d] > s[d] - 1) p[d] = s[d] - 1;
+        i[d][0] = (int)p[d];
+        i[d][1] = (i[d][0] + 1 < s[d]) ? i[d][0] + 1 : i[d][0];
+        f[d] = p[d] - i[d][0];
+    }
+
+    double v = 0.0;
+    for (int c = 0; c < 8; ++c) {
+        double w = ((c & 1) ? f[0] : 1 - f[0])
+                 * ((c & 2) ? f[1] : 1 - f[1])
+                 * ((c & 4) ? f[2] : 1 - f[2]);
+        v += w * levelset(i[0][c & 1], i[1][(c >> 1) & 1], i[2][(c >> 2) & 1]);
+    }
+    return (real_value_type)v;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Ty, typename _Real>
 void metamorphs3<_Ty, _Real>::create_shape_image(
@@ -453,7 +701,7 @@ void metamorphs3<_Ty, _Real>::create_shape_image(
     int s1 = (int)edge_mask.size_1();
     int s2 = (int)edge_mask.size_2();
 
-    fmm_type::node_type fmm_node;
+    typename fmm_type::node_type fmm_node;
     fmm_type            fmm;
 
     // ================================================================
@@ -525,7 +773,7 @@ void metamorphs3<_Ty, _Real>::create_roi_shape_image(
     int s1 = (int)roi_edge_mask.size_1();
     int s2 = (int)roi_edge_mask.size_2();
 
-    fmm_type::node_type fmm_node;
+    typename fmm_type::node_type fmm_node;
     fmm_type            fmm;
 
     // ================================================================
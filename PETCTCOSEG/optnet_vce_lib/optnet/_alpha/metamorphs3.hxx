@@ -41,6 +41,7 @@
 #   include <optnet/_alpha/isosurface.hxx>
 #   include <optnet/_alpha/cubic_spline_ffd3.hxx>
 #   include <optnet/_alpha/fast_marching3.hxx>
+#   include <optnet/_alpha/levelset3_sparse_field.hxx>
 #   include <optnet/_utils/interp_bspline3.hxx>
 #   include <optnet/_base/debug.hxx>
 
@@ -86,7 +87,7 @@ public:
     metamorphs3() :
         m_verbose(0),
         m_para_a(1.0), m_para_b(1.0), m_para_c(1.0), m_para_d(1.0),
-        m_pimage(0), m_plevelset(0)
+        m_pimage(0), m_plevelset(0), m_sparse_field(false)
     {
     }
 
@@ -99,7 +100,7 @@ public:
     metamorphs3(int verbose) :
         m_verbose(verbose),
         m_para_a(1.0), m_para_b(1.0), m_para_c(1.0), m_para_d(1.0),
-        m_pimage(0), m_plevelset(0)
+        m_pimage(0), m_plevelset(0), m_sparse_field(false)
     {
     }
 
@@ -181,17 +182,43 @@ public:
                const double& stop_d = .1
                );
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Enables or disables the sparse-field (narrow-band) evolution.
+    ///
+    ///  @param enable  If true, solve() keeps the level set in a
+    ///                 levelset3_sparse_field: the data terms are summed
+    ///                 over the band voxels, and only the active layer is
+    ///                 moved by the deformation. The values outside the
+    ///                 band are clamped to +/-3, so the interior shape
+    ///                 terms only see a three-voxel shell inside the
+    ///                 boundary.
+    ///////////////////////////////////////////////////////////////////////
+    inline void set_sparse_field(bool enable) { m_sparse_field = enable; }
+    inline bool get_sparse_field() const      { return m_sparse_field; }
+
 
 private:
     
     typedef fast_marching3<real_value_type,
                            real_value_type>    fmm_type;
 
+    typedef cubic_spline_ffd3<real_value_type> ffd_type;
+    typedef levelset3_sparse_field<real_value_type>
+                                               sparse_field_type;
+
     // Helper functions
     void create_shape_image(const mask_image_base_type& edge_mask);
     void create_roi_shape_image(
         const mask_image_base_type& roi_edge_mask);
     void create_image_gradients(const image_base_type& image);
+    void solve_sparse_field(ffd_type&                      ffd,
+                            typename ffd_type::array_type& q,
+                            const double&                  lambda,
+                            real_value_type                inv_rayl_b2,
+                            int                            niters,
+                            const double&                  stop_d
+                            );
+    real_value_type sample_levelset(double x, double y, double z) const;
 
     ///////////////////////////////////////////////////////////////////////
     int                     m_verbose;
@@ -206,6 +233,7 @@ private:
     real_image_type         m_dx_roi_shape_image, m_dy_roi_shape_image, m_dz_roi_shape_image;
     std::string             m_task_name;
     debug                   m_dbg;
+    bool                    m_sparse_field;
 
 };
 
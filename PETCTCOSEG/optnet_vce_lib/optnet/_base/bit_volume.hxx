@@ -0,0 +1,494 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: bit_volume.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+#ifndef ___BIT_VOLUME_HXX___
+#   define ___BIT_VOLUME_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#   endif
+
+#   include <optnet/config.h>
+#   include <algorithm>
+#   include <cstddef>
+#   include <vector>
+
+
+/// @namespace optnet
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+///  @class bit_volume
+///  @brief A binary 3-D volume with one bit per voxel.
+///
+///  Every image row (i0 = 0 .. size_0() - 1) is stored in whole 64-bit
+///  words, bit i0 % 64 of word i0 / 64, and the unused bits of the last
+///  word are always 0. The morphological operations and the connected
+///  component search work on whole words: a row is shifted along i0 by
+///  shifting its words, and the rows of a neighborhood are combined
+///  word by word.
+///////////////////////////////////////////////////////////////////////////
+class bit_volume
+{
+public:
+
+    typedef size_t              size_type;
+    typedef unsigned long long  word_type;
+
+    enum { word_bits = 64 };
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Default constructor.
+    ///////////////////////////////////////////////////////////////////////
+    bit_volume() : m_s0(0), m_s1(0), m_s2(0), m_nw(0)
+    {
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Constructs an empty (all 0) volume of the given size.
+    ///////////////////////////////////////////////////////////////////////
+    bit_volume(size_type s0, size_type s1, size_type s2)
+    {
+        create(s0, s1, s2);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Resizes the volume and sets all voxels to 0.
+    ///////////////////////////////////////////////////////////////////////
+    void create(size_type s0, size_type s1, size_type s2)
+    {
+        m_s0 = s0;
+        m_s1 = s1;
+        m_s2 = s2;
+        m_nw = (s0 + word_bits - 1) / word_bits;
+        m_words.assign(m_nw * s1 * s2, 0);
+    }
+
+    inline size_type size_0() const { return m_s0; }
+    inline size_type size_1() const { return m_s1; }
+    inline size_type size_2() const { return m_s2; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the number of voxels.
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type size() const { return m_s0 * m_s1 * m_s2; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the number of words of a row.
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type words_per_row() const { return m_nw; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the words of row (i1, i2).
+    ///////////////////////////////////////////////////////////////////////
+    inline word_type* row(size_type i1, size_type i2)
+    {
+        return &m_words[(i2 * m_s1 + i1) * m_nw];
+    }
+
+    inline const word_type* row(size_type i1, size_type i2) const
+    {
+        return &m_words[(i2 * m_s1 + i1) * m_nw];
+    }
+
+    inline bool get(size_type i0, size_type i1, size_type i2) const
+    {
+        return ((row(i1, i2)[i0 / word_bits] >> (i0 % word_bits)) & 1) != 0;
+    }
+
+    inline void set(size_type i0, size_type i1, size_type i2, bool value = true)
+    {
+        word_type& w   = row(i1, i2)[i0 / word_bits];
+        word_type  bit = (word_type)1 << (i0 % word_bits);
+
+        if (value) w |= bit; else w &= ~bit;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Sets all voxels to 0.
+    ///////////////////////////////////////////////////////////////////////
+    void clear()
+    {
+        std::fill(m_words.begin(), m_words.end(), (word_type)0);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the number of voxels that are 1.
+    ///////////////////////////////////////////////////////////////////////
+    size_type count() const
+    {
+        size_type n = 0;
+
+        for (size_type k = 0; k < m_words.size(); ++k) {
+            word_type w = m_words[k];
+            w = w - ((w >> 1) & 0x5555555555555555ULL);
+            w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+            w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            n += (size_type)((w * 0x0101010101010101ULL) >> 56);
+        }
+        return n;
+    }
+
+    void swap(bit_volume& other)
+    {
+        std::swap(m_s0, other.m_s0);
+        std::swap(m_s1, other.m_s1);
+        std::swap(m_s2, other.m_s2);
+        std::swap(m_nw, other.m_nw);
+        m_words.swap(other.m_words);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Sets the voxels from an image.
+    ///
+    ///  @param values  The size() voxel values, i0 fastest (e.g., the
+    ///                 buffer of an ITK image, or a surface of a net).
+    ///
+    ///  @remarks A voxel is set to 1 if its value is not 0.
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Tp>
+    void assign(const _Tp* values)
+    {
+        for (size_type r = 0; r < m_s1 * m_s2; ++r, values += m_s0) {
+            word_type* w = &m_words[r * m_nw];
+            for (size_type k = 0; k < m_nw; ++k) {
+                const _Tp* p = values + k * word_bits;
+                size_type  n = std::min<size_type>(word_bits, m_s0 - k * word_bits);
+                word_type  x = 0;
+                for (size_type b = 0; b < n; ++b)
+                    x |= (word_type)(p[b] != 0) << b;
+                w[k] = x;
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Sets the voxels from an image.
+    ///
+    ///  @param values  The size() voxel values, i0 fastest.
+    ///  @param lower   The smallest value of a 1-voxel.
+    ///  @param upper   The largest value of a 1-voxel.
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Tp>
+    void assign(const _Tp* values, const _Tp& lower, const _Tp& upper)
+    {
+        for (size_type r = 0; r < m_s1 * m_s2; ++r, values += m_s0) {
+            word_type* w = &m_words[r * m_nw];
+            for (size_type k = 0; k < m_nw; ++k) {
+                const _Tp* p = values + k * word_bits;
+                size_type  n = std::min<size_type>(word_bits, m_s0 - k * word_bits);
+                word_type  x = 0;
+                for (size_type b = 0; b < n; ++b)
+                    x |= (word_type)(!(p[b] < lower) && !(upper < p[b])) << b;
+                w[k] = x;
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Writes the voxels to an image.
+    ///
+    ///  @param values  The size() output voxel values, i0 fastest.
+    ///  @param on      The value of the 1-voxels.
+    ///  @param off     The value of the 0-voxels.
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Tp>
+    void copy_to(_Tp* values, const _Tp& on, const _Tp& off = _Tp()) const
+    {
+        for (size_type r = 0; r < m_s1 * m_s2; ++r, values += m_s0) {
+            const word_type* w = &m_words[r * m_nw];
+            for (size_type i0 = 0; i0 < m_s0; ++i0)
+                values[i0] = ((w[i0 / word_bits] >> (i0 % word_bits)) & 1) ? on : off;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Erodes the volume with a ball.
+    ///
+    ///  @param radius  The ball radius, in voxels: the ball contains the
+    ///                 offsets d with |d| <= radius + 0.5, i.e.
+    ///                 |d|^2 <= radius^2 + radius, the same voxels as
+    ///                 itk::BinaryBallStructuringElement (19 for a
+    ///                 radius of 1, 93 for 2). A radius of 0 leaves the
+    ///                 volume unchanged.
+    ///
+    ///  @remarks The voxels outside the volume are treated as 1, so the
+    ///           object is not eroded from the volume boundary (as by
+    ///           itk::BinaryErodeImageFilter).
+    ///////////////////////////////////////////////////////////////////////
+    void erode(int radius)
+    {
+        morph(radius, true);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Dilates the volume with a ball.
+    ///
+    ///  @param radius  The ball radius, in voxels (see erode). The voxels
+    ///                 outside the volume are treated as 0.
+    ///////////////////////////////////////////////////////////////////////
+    void dilate(int radius)
+    {
+        morph(radius, false);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Keeps only the 6-connected component that contains a seed.
+    ///
+    ///  @param i0,i1,i2  The seed.
+    ///
+    ///  @return false if the seed is outside the volume or is 0; the
+    ///          volume is then cleared.
+    ///
+    ///  @remarks The component is grown a row at a time: the seed bits
+    ///           of a row are extended over the runs of 1-voxels they
+    ///           belong to with word-wide shifts, and the filled bits
+    ///           are then the seeds of the four neighboring rows.
+    ///////////////////////////////////////////////////////////////////////
+    bool keep_component(size_type i0, size_type i1, size_type i2)
+    {
+        if (i0 >= m_s0 || i1 >= m_s1 || i2 >= m_s2 || !get(i0, i1, i2)) {
+            clear();
+            return false;
+        }
+
+        const size_type        num_rows = m_s1 * m_s2;
+        std::vector<word_type> comp(m_words.size(), 0);
+        std::vector<word_type> front(m_words.size(), 0);
+        std::vector<word_type> avail(m_nw);
+        std::vector<char>      queued(num_rows, 0);
+        std::vector<size_type> stack;
+
+        size_type r = i2 * m_s1 + i1;
+        front[r * m_nw + i0 / word_bits] = (word_type)1 << (i0 % word_bits);
+        queued[r] = 1;
+        stack.push_back(r);
+
+        while (!stack.empty()) {
+            r = stack.back();
+            stack.pop_back();
+            queued[r] = 0;
+
+            word_type*       f = &front[r * m_nw];
+            word_type*       c = &comp[r * m_nw];
+            const word_type* m = &m_words[r * m_nw];
+            word_type        any = 0;
+            size_type        k;
+
+            for (k = 0; k < m_nw; ++k) {
+                avail[k] = m[k] & ~c[k];
+                f[k]    &= avail[k];
+                any    |= f[k];
+            }
+            if (0 == any) continue;
+
+            fill_runs(&avail[0], f, m_nw);
+            for (k = 0; k < m_nw; ++k) c[k] |= f[k];
+
+            // Seed the neighboring rows.
+            size_type j1 = r % m_s1, j2 = r / m_s1;
+            size_type nb[4];
+            int       n = 0;
+            if (j1 > 0)        nb[n++] = r - 1;
+            if (j1 + 1 < m_s1) nb[n++] = r + 1;
+            if (j2 > 0)        nb[n++] = r - m_s1;
+            if (j2 + 1 < m_s2) nb[n++] = r + m_s1;
+
+            for (int j = 0; j < n; ++j) {
+                word_type*       fn = &front[nb[j] * m_nw];
+                const word_type* cn = &comp[nb[j] * m_nw];
+                const word_type* mn = &m_words[nb[j] * m_nw];
+                word_type        grow = 0;
+                for (k = 0; k < m_nw; ++k) {
+                    word_type w = f[k] & mn[k] & ~cn[k];
+                    fn[k] |= w;
+                    grow  |= w;
+                }
+                if (0 != grow && !queued[nb[j]]) {
+                    queued[nb[j]] = 1;
+                    stack.push_back(nb[j]);
+                }
+            }
+
+            std::fill(f, f + m_nw, (word_type)0);
+        }
+
+        m_words.swap(comp);
+        return true;
+    }
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////
+    // Returns the mask of the used bits of the last word of a row.
+    inline word_type last_mask() const
+    {
+        size_type n = m_s0 - (m_nw - 1) * word_bits;
+        return (n == word_bits) ? ~(word_type)0 : (((word_type)1 << n) - 1);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Erode (or dilate) a row along i0 by one voxel. The bits outside
+    // the row are taken as 1 for erosion and as 0 for dilation.
+    static void morph_row(const word_type* src,
+                          word_type*       dst,
+                          size_type        nw,
+                          word_type        mask,
+                          bool             erode
+                          )
+    {
+        const word_type fill = erode ? ~(word_type)0 : 0;
+        const word_type pad  = erode ? ~mask : 0;
+        word_type       prev = fill;
+        word_type       cur  = src[0] | (nw == 1 ? pad : 0);
+        word_type       next, lo, hi;
+
+        for (size_type k = 0; k < nw; ++k) {
+            next = (k + 1 < nw) ? (src[k + 1] | (k + 2 == nw ? pad : 0)) : fill;
+            lo   = (cur << 1) | (prev >> (word_bits - 1)); // voxel i0 - 1
+            hi   = (cur >> 1) | (next << (word_bits - 1)); // voxel i0 + 1
+            dst[k] = erode ? (cur & lo & hi) : (cur | lo | hi);
+            prev = cur;
+            cur  = next;
+        }
+        dst[nw - 1] &= mask;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Extend the seed bits of a row over the runs of free bits that
+    // contain them (the seeds must be free). Within a word this is a
+    // fill by doubling shifts; the carry bit continues a run into the
+    // next word.
+    static void fill_runs(const word_type* avail, word_type* seeds, size_type nw)
+    {
+        word_type g, p, carry;
+        size_type k;
+
+        // Toward higher i0.
+        for (carry = 0, k = 0; k < nw; ++k) {
+            g = (seeds[k] | carry) & avail[k];
+            p = avail[k];
+            g |= p & (g << 1);  p &= p << 1;
+            g |= p & (g << 2);  p &= p << 2;
+            g |= p & (g << 4);  p &= p << 4;
+            g |= p & (g << 8);  p &= p << 8;
+            g |= p & (g << 16); p &= p << 16;
+            g |= p & (g << 32);
+            seeds[k] = g;
+            carry    = g >> (word_bits - 1);
+        }
+
+        // Toward lower i0.
+        for (carry = 0, k = nw; k-- > 0; ) {
+            g = (seeds[k] | carry) & avail[k];
+            p = avail[k];
+            g |= p & (g >> 1);  p &= p >> 1;
+            g |= p & (g >> 2);  p &= p >> 2;
+            g |= p & (g >> 4);  p &= p >> 4;
+            g |= p & (g >> 8);  p &= p >> 8;
+            g |= p & (g >> 16); p &= p >> 16;
+            g |= p & (g >> 32);
+            seeds[k] = g;
+            carry    = g << (word_bits - 1);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Erode or dilate with a ball. The ball is the union of the rows
+    // (d1, d2) with d1^2 + d2^2 <= radius^2 + radius, each a segment of
+    // half-width w along i0; so the volume is first eroded (dilated)
+    // along i0 by 0 .. radius voxels, and every output row is the AND
+    // (OR) of the rows of these volumes at the offsets of the ball.
+    void morph(int radius, bool erode)
+    {
+        if (radius <= 0 || m_words.empty()) return;
+
+        const size_type        num_words = m_words.size();
+        const size_type        num_rows  = m_s1 * m_s2;
+        const word_type        mask      = last_mask();
+        std::vector<word_type> along(num_words * (radius + 1));
+        std::vector<int>       offset;    // (d1, d2, w) triples
+        int                    d1, d2, w;
+
+        for (d2 = -radius; d2 <= radius; ++d2) {
+            for (d1 = -radius; d1 <= radius; ++d1) {
+                int rest = radius * radius + radius - d1 * d1 - d2 * d2;
+                if (rest < 0) continue;
+                for (w = 0; (w + 1) * (w + 1) <= rest; ++w) ;
+                offset.push_back(d1);
+                offset.push_back(d2);
+                offset.push_back(w);
+            }
+        }
+
+        std::copy(m_words.begin(), m_words.end(), along.begin());
+        for (w = 1; w <= radius; ++w) {
+            const word_type* src = &along[num_words * (w - 1)];
+            word_type*       dst = &along[num_words * w];
+            for (size_type r = 0; r < num_rows; ++r) {
+                morph_row(src + r * m_nw, dst + r * m_nw, m_nw, mask, erode);
+            }
+        }
+
+        const int s1 = (int)m_s1;
+        const int s2 = (int)m_s2;
+        const int nw = (int)m_nw;
+        const int no = (int)offset.size();
+        int       i2;
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+        for (i2 = 0; i2 < s2; ++i2) {
+            for (int i1 = 0; i1 < s1; ++i1) {
+                word_type* out = &m_words[((size_t)i2 * s1 + i1) * nw];
+                int        k;
+
+                for (k = 0; k < nw; ++k) out[k] = erode ? ~(word_type)0 : 0;
+
+                for (int j = 0; j < no; j += 3) {
+                    int j1 = i1 + offset[j];
+                    int j2 = i2 + offset[j + 1];
+
+                    // The outside rows are all 1 (erosion) or all 0
+                    // (dilation), so they do not change the result.
+                    if (j1 < 0 || j1 >= s1 || j2 < 0 || j2 >= s2) continue;
+
+                    const word_type* in = &along[num_words * offset[j + 2] +
+                                                 ((size_t)j2 * s1 + j1) * nw];
+                    if (erode) {
+                        for (k = 0; k < nw; ++k) out[k] &= in[k];
+                    }
+                    else {
+                        for (k = 0; k < nw; ++k) out[k] |= in[k];
+                    }
+                }
+                out[nw - 1] &= mask;
+            }
+        }
+    }
+
+    size_type               m_s0, m_s1, m_s2;
+    size_type               m_nw;       // The number of words per row.
+    std::vector<word_type>  m_words;
+};
+
+} // namespace
+
+#endif
@@ -190,6 +190,65 @@ analyze_load(_Array& a, const char* name)
 
 }
 
+///////////////////////////////////////////////////////////////////////////
+///  Loads an Analyze(TM) 7.5 format image file into an existing array,
+///  without reallocating it.
+///
+///  @param[out] a     The array to receive the image data. It must have
+///                    the size of the image in the file; it may be an
+///                    array_ref over caller-owned (e.g., ITK) memory.
+///  @param[in]  name  The name of the image file.
+///
+///  @exception  optnet::io_error Failed reading image header or data, or
+///                               the data type or the size of a does not
+///                               match that used in the file.
+///
+///  @remarks Voxel sizes are not stored; use analyze_load for that.
+///
+///////////////////////////////////////////////////////////////////////////
+template <typename _Array>
+void
+analyze_load_into(_Array& a, const char* name)
+{
+    using namespace optnet::io::detail;
+
+    analyze_volume  volume;
+    std::string     hdr_name, img_name;
+
+    assert(0 != name);
+
+    analyze_make_filename_pair(name, hdr_name, img_name);
+
+    // Load Analyze image header.
+    if (!analyze_load_info(&volume, hdr_name, img_name)) {
+        throw_exception(io_error(
+            "analyze_load_into: Failed reading image header."
+            ));
+    }
+
+    if (volume.datatype !=
+        analyze_datatype<typename _Array::value_type>::id()) {
+        throw_exception(io_error(
+            "analyze_load_into: Data type does not match."
+            ));
+    }
+
+    if ((size_t)a.size() != volume.image_size) {
+        throw_exception(io_error(
+            "analyze_load_into: Image size does not match."
+            ));
+    }
+
+    volume.data = reinterpret_cast<char*>(a.data());
+
+    // Load image data directly into the array's memory.
+    if (!analyze_load_data(&volume, hdr_name, img_name)) {
+        throw_exception(io_error(
+            "analyze_load_into: Failed reading image."
+            ));
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 ///  Saves an image into an Analyze(TM) 7.5 format image file.
 ///
@@ -48,6 +48,9 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cstring>
+#include <vector>
+#include <optnet/config.h>
 #include <optnet/_utils/endian.hxx>
 #include <optnet/_utils/xstring.hxx>
 #include <optnet/_base/io/detail/zlib.h>
@@ -78,6 +81,19 @@ struct analyze_volume
     char*   data;
 };
 
+///////////////////////////////////////////////////////////////////////////
+//  The compressed bytes read per step by analyze_gz_read, and the raw
+//  bytes compressed into each gzip member by analyze_gz_write.
+///////////////////////////////////////////////////////////////////////////
+const size_t ANALYZE_GZ_READ_BLOCK  = 4 << 20;
+const size_t ANALYZE_GZ_WRITE_BLOCK = 1 << 20;
+
+// The number of gzip members compressed per batch by analyze_gz_write.
+const int    ANALYZE_GZ_WRITE_BATCH = 16;
+
+// zlib counts bytes in uInt; larger buffers are fed in pieces.
+const size_t ANALYZE_GZ_MAX_CHUNK   = 1 << 30;
+
 ///////////////////////////////////////////////////////////////////////////
 inline void
 analyze_make_filename_pair(const std::string& name,
@@ -246,11 +262,25 @@ analyze_load_info(analyze_volume*    volume,
     //
     ret = secure_fopen(&pfile, img_name.c_str(), "rb");
     if (0 != ret) return false;
+#   if defined(_MSC_VER) && (_MSC_VER >= 1400)
+    if (_fseeki64(pfile, 0, SEEK_END) != 0) {
+        fclose(pfile);
+        return false;
+    }
+    file_size = (size_t)::_ftelli64(pfile);
+#   elif defined(_MSC_VER) || defined(__MINGW32__)
     if (fseek(pfile, 0, SEEK_END) != 0) {
         fclose(pfile);
         return false;
     }
-    file_size = (unsigned int)::ftell(pfile);
+    file_size = (size_t)::ftell(pfile);
+#   else
+    if (fseeko(pfile, 0, SEEK_END) != 0) {
+        fclose(pfile);
+        return false;
+    }
+    file_size = (size_t)::ftello(pfile);
+#   endif
     fclose(pfile);
 
     bytes_per_voxel = file_size / volume->image_size;
@@ -265,6 +295,209 @@ analyze_load_info(analyze_volume*    volume,
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+//  Inflates one block of compressed input into data[done, size). The
+//  stream may hold several gzip members (see analyze_gz_write); a new
+//  member is started after each Z_STREAM_END.
+///////////////////////////////////////////////////////////////////////////
+inline bool
+analyze_gz_inflate_block(z_stream*            strm,
+                         bool&                member_end,
+                         const unsigned char* in,
+                         size_t               in_size,
+                         char*                data,
+                         size_t               size,
+                         size_t&              done
+                         )
+{
+    strm->next_in  = const_cast<Bytef*>(in);
+    strm->avail_in = (uInt)in_size;
+
+    while (strm->avail_in > 0 && done < size) {
+
+        if (member_end) {
+            if (Z_OK != inflateReset(strm)) return false;
+            member_end = false;
+        }
+
+        size_t chunk = size - done;
+        if (chunk > ANALYZE_GZ_MAX_CHUNK) chunk = ANALYZE_GZ_MAX_CHUNK;
+
+        strm->next_out  = reinterpret_cast<Bytef*>(data + done);
+        strm->avail_out = (uInt)chunk;
+
+        int ret = inflate(strm, Z_NO_FLUSH);
+        done += chunk - strm->avail_out;
+
+        if (Z_STREAM_END == ret)
+            member_end = true;
+        else if (Z_BUF_ERROR == ret)
+            break;  // needs the next block
+        else if (Z_OK != ret)
+            return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  Reads a gzip file into data[0, size). The file is read in blocks of
+//  ANALYZE_GZ_READ_BLOCK bytes; when OpenMP is available, the next
+//  block is read while the current one is being inflated.
+///////////////////////////////////////////////////////////////////////////
+inline bool
+analyze_gz_read(const std::string& name, char* data, size_t size)
+{
+    std::vector<unsigned char>  buf[2];
+    size_t                      len[2], done = 0;
+    z_stream                    strm;
+    FILE*                       pfile;
+    bool                        ok = true, member_end = false;
+    int                         cur = 0;
+
+    if (0 != secure_fopen(&pfile, name.c_str(), "rb")) return false;
+
+    memset(&strm, 0, sizeof(z_stream));
+    // 15 + 32: detect the zlib or gzip header automatically.
+    if (Z_OK != inflateInit2(&strm, 15 + 32)) {
+        fclose(pfile);
+        return false;
+    }
+
+    buf[0].resize(ANALYZE_GZ_READ_BLOCK);
+    buf[1].resize(ANALYZE_GZ_READ_BLOCK);
+    len[0] = fread(&buf[0][0], 1, ANALYZE_GZ_READ_BLOCK, pfile);
+
+    while (ok && len[cur] > 0 && done < size) {
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel sections num_threads(2)
+        {
+    #   pragma omp section
+    #endif
+        len[!cur] = fread(&buf[!cur][0], 1, ANALYZE_GZ_READ_BLOCK, pfile);
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp section
+    #endif
+        ok = analyze_gz_inflate_block(&strm, member_end,
+                                      &buf[cur][0], len[cur],
+                                      data, size, done);
+    #ifdef __OPTNET_PRAGMA_OMP__
+        }
+    #endif
+        cur = !cur;
+    }
+
+    inflateEnd(&strm);
+    fclose(pfile);
+
+    return ok && done == size;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  Compresses data[0, size) into a complete gzip member.
+///////////////////////////////////////////////////////////////////////////
+inline bool
+analyze_gz_deflate_block(const char*                 data,
+                         size_t                      size,
+                         int                         level,
+                         std::vector<unsigned char>& out
+                         )
+{
+    z_stream strm;
+
+    memset(&strm, 0, sizeof(z_stream));
+    // 15 + 16: write a gzip header and trailer.
+    if (Z_OK != deflateInit2(&strm, level, Z_DEFLATED, 15 + 16, 8,
+                             Z_DEFAULT_STRATEGY)) {
+        return false;
+    }
+
+    // deflateBound does not count the gzip header and trailer.
+    out.resize(deflateBound(&strm, (uLong)size) + 32);
+
+    strm.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    strm.avail_in  = (uInt)size;
+    strm.next_out  = &out[0];
+    strm.avail_out = (uInt)out.size();
+
+    int ret = deflate(&strm, Z_FINISH);
+    out.resize(out.size() - strm.avail_out);
+    deflateEnd(&strm);
+
+    return Z_STREAM_END == ret;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  Writes data[0, size) into a gzip file as a sequence of gzip members
+//  of ANALYZE_GZ_WRITE_BLOCK raw bytes each (a valid gzip file, which
+//  gunzip and gzread read as one stream). When OpenMP is available the
+//  members of a batch are compressed concurrently, while one thread
+//  writes the previous batch. An empty volume is written as one empty
+//  member, since an empty file is not a valid gzip file.
+///////////////////////////////////////////////////////////////////////////
+inline bool
+analyze_gz_write(const std::string& name,
+                 const char*        data,
+                 size_t             size,
+                 int                level
+                 )
+{
+    typedef std::vector<unsigned char> block_type;
+
+    const size_t            BLOCK = ANALYZE_GZ_WRITE_BLOCK;
+    const int               BATCH = ANALYZE_GZ_WRITE_BATCH;
+
+    std::vector<block_type> out[2];
+    size_t                  nblocks = (size + BLOCK - 1) / BLOCK, b0;
+    int                     cur = 0, prev_count = 0, i;
+    bool                    ok = true;
+    FILE*                   pfile;
+
+    if (0 != secure_fopen(&pfile, name.c_str(), "wb")) return false;
+
+    if (0 == nblocks) nblocks = 1;
+
+    out[0].resize(BATCH);
+    out[1].resize(BATCH);
+
+    for (b0 = 0; ok && b0 < nblocks + BATCH; b0 += BATCH) {
+
+        int count = (b0 < nblocks) ?
+            (int)((nblocks - b0 < (size_t)BATCH) ? nblocks - b0 : BATCH) : 0;
+
+        // Iteration 'count' writes the previous batch.
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(i) schedule(dynamic) reduction(&&:ok) num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (i = 0; i <= count; ++i) {
+            if (i < count) {
+                size_t begin = (b0 + i) * BLOCK;
+                size_t n     = (size - begin < BLOCK) ? size - begin : BLOCK;
+                if (!analyze_gz_deflate_block(data + begin, n, level,
+                                              out[cur][i])) {
+                    ok = false;
+                }
+            }
+            else {
+                for (int k = 0; k < prev_count; ++k) {
+                    const block_type& blk = out[!cur][k];
+                    if (fwrite(&blk[0], 1, blk.size(), pfile) != blk.size())
+                        ok = false;
+                }
+            }
+        }
+
+        if (0 == count) break;
+
+        prev_count = count;
+        cur = !cur;
+    }
+
+    if (0 != fclose(pfile)) ok = false;
+
+    return ok;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 inline bool
 analyze_load_data(analyze_volume*      volume,
@@ -298,15 +531,8 @@ analyze_load_data(analyze_volume*      volume,
     }
     else {
         img_gz_name = img_name + ".gz";
-        gzFile pgzfile = gzopen(img_gz_name.c_str(), "rb");
-        if (0 == pgzfile) return false;
-
-        if (gzread(pgzfile, volume->data, (unsigned int)file_size)
-            != (int)file_size) {
-            gzclose(pgzfile);
+        if (!analyze_gz_read(img_gz_name, volume->data, file_size))
             return false;
-        }
-        gzclose(pgzfile);
     }
 
     // Adjust endian of the image data if necessary.
@@ -320,8 +546,8 @@ analyze_load_data(analyze_volume*      volume,
             break;
         }
         case 4: {
-            for (long*  p = (long *)volume->data; 
-                        p < (long *)volume->data + volume->image_size;
+            for (int*   p = (int  *)volume->data; 
+                        p < (int  *)volume->data + volume->image_size;
                         ++p)
                 swap_endian32(p);
             break;
@@ -416,21 +642,12 @@ analyze_save_data(const analyze_volume* volume,
     }
     else {
 
-        char flags[16];
-        secure_sprintf(flags, sizeof(flags), "wb%d", compression);
-
-        // Open a file with a ".img.gz" extension.
+        // Write a file with a ".img.gz" extension.
         img_gz_name = img_name + ".gz";
-        gzFile pgzfile = gzopen(img_gz_name.c_str(), flags);
-        if (0 == pgzfile) return false;
-
-        if (gzwrite(pgzfile, (const voidp)volume->data, (unsigned int)file_size) 
-            != (int)file_size) {
-            // Failed writing the image.
-            gzclose(pgzfile);
-            return false;
+        if (!analyze_gz_write(img_gz_name, volume->data, file_size,
+                              compression)) {
+            return false; // Failed writing the image.
         }
-        gzclose(pgzfile);
     }
 
     return true;
@@ -0,0 +1,539 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: mapped_volume.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+#ifndef ___MAPPED_VOLUME_HXX__
+#   define ___MAPPED_VOLUME_HXX__
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#   endif
+
+#   include <optnet/_base/except.hxx>
+#   include <optnet/_base/array_ref.hxx>
+#   include <optnet/_base/io/analyze.hxx>
+#   include <algorithm>
+#   include <cmath>
+#   include <cstdio>
+#   include <cstdlib>
+#   include <cstring>
+#   include <string>
+#   include <sstream>
+
+#   ifdef _WIN32
+#       ifndef WIN32_LEAN_AND_MEAN
+#           define WIN32_LEAN_AND_MEAN
+#       endif
+#       include <windows.h>
+#   else
+#       include <fcntl.h>
+#       include <unistd.h>
+#       include <sys/mman.h>
+#       include <sys/stat.h>
+#   endif
+
+//
+// namespace optnet::io::detail
+//
+namespace optnet { namespace io { namespace detail {
+
+///////////////////////////////////////////////////////////////////////////
+//  A private (copy-on-write) mapping of the first 'length' bytes of a
+//  file. Pages are read in on first access; writes go to private copies
+//  of the pages and never reach the file.
+///////////////////////////////////////////////////////////////////////////
+class mapped_file
+{
+public:
+
+    mapped_file() : m_addr(0), m_length(0)
+#   ifdef _WIN32
+        , m_mapping(0)
+#   endif
+    {}
+
+    ~mapped_file() { close(); }
+
+    bool open(const std::string& name, size_t length)
+    {
+        close();
+        if (0 == length) return false;
+
+#   ifdef _WIN32
+
+        HANDLE file = ::CreateFileA(name.c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                    FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        if (INVALID_HANDLE_VALUE == file) return false;
+
+        LARGE_INTEGER file_size;
+        if (!::GetFileSizeEx(file, &file_size) ||
+            (unsigned __int64)file_size.QuadPart < length) {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        m_mapping = ::CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+        ::CloseHandle(file); // The mapping keeps the file open.
+        if (0 == m_mapping) return false;
+
+        m_addr = ::MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, length);
+        if (0 == m_addr) {
+            ::CloseHandle(m_mapping);
+            m_mapping = 0;
+            return false;
+        }
+
+#   else
+
+        int fd = ::open(name.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (0 != ::fstat(fd, &st) || (size_t)st.st_size < length) {
+            ::close(fd);
+            return false;
+        }
+
+        void* addr = ::mmap(0, length, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file open.
+        if (MAP_FAILED == addr) return false;
+
+#       ifdef MADV_SEQUENTIAL
+        ::madvise(addr, length, MADV_SEQUENTIAL);
+#       endif
+
+        m_addr = addr;
+
+#   endif
+
+        m_length = length;
+        return true;
+    }
+
+    void close()
+    {
+        if (0 == m_addr) return;
+
+#   ifdef _WIN32
+        ::UnmapViewOfFile(m_addr);
+        ::CloseHandle(m_mapping);
+        m_mapping = 0;
+#   else
+        ::munmap(m_addr, m_length);
+#   endif
+
+        m_addr   = 0;
+        m_length = 0;
+    }
+
+    inline char*  data()   const { return static_cast<char*>(m_addr); }
+    inline size_t length() const { return m_length; }
+
+private:
+
+    void*   m_addr;
+    size_t  m_length;
+#   ifdef _WIN32
+    HANDLE  m_mapping;
+#   endif
+
+    // Not copyable.
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+};
+
+///////////////////////////////////////////////////////////////////////////
+//  Reverses the byte order of n values of the given size in place.
+///////////////////////////////////////////////////////////////////////////
+inline void
+mapped_swap_bytes(char* p, size_t n, size_t bytes)
+{
+    for (size_t i = 0; i < n; ++i, p += bytes) {
+        std::reverse(p, p + bytes);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  Returns true if the host stores multi-byte values big end first.
+///////////////////////////////////////////////////////////////////////////
+inline bool
+mapped_host_is_big_endian()
+{
+    const unsigned short one = 1;
+    return 0 == *reinterpret_cast<const unsigned char*>(&one);
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  Returns the Analyze datatype id and the size of a NRRD type name, or
+//  DT_NONE for types that have no Analyze counterpart.
+///////////////////////////////////////////////////////////////////////////
+inline long
+nrrd_datatype(const std::string& type, size_t& bytes)
+{
+    static const struct { const char* name; long id; size_t bytes; }
+    TYPES[] = {
+        { "uchar",              DT_UNSIGNED_CHAR, 1 },
+        { "unsigned char",      DT_UNSIGNED_CHAR, 1 },
+        { "uint8",              DT_UNSIGNED_CHAR, 1 },
+        { "uint8_t",            DT_UNSIGNED_CHAR, 1 },
+        { "short",              DT_SIGNED_SHORT,  2 },
+        { "short int",          DT_SIGNED_SHORT,  2 },
+        { "signed short",       DT_SIGNED_SHORT,  2 },
+        { "signed short int",   DT_SIGNED_SHORT,  2 },
+        { "int16",              DT_SIGNED_SHORT,  2 },
+        { "int16_t",            DT_SIGNED_SHORT,  2 },
+        { "int",                DT_SIGNED_INT,    4 },
+        { "signed int",         DT_SIGNED_INT,    4 },
+        { "int32",              DT_SIGNED_INT,    4 },
+        { "int32_t",            DT_SIGNED_INT,    4 },
+        { "float",              DT_FLOAT,         4 },
+        { "double",             DT_DOUBLE,        8 }
+    };
+
+    for (size_t i = 0; i < sizeof(TYPES) / sizeof(TYPES[0]); ++i) {
+        if (type == TYPES[i].name) {
+            bytes = TYPES[i].bytes;
+            return TYPES[i].id;
+        }
+    }
+
+    bytes = 0;
+    return DT_NONE;
+}
+
+} } } // namespace
+
+
+/// @namespace optnet
+namespace optnet {
+
+    /// @namespace optnet::io
+    namespace io {
+
+///////////////////////////////////////////////////////////////////////////
+///  @class mapped_volume
+///  @brief A volume whose voxels are memory-mapped from an uncompressed
+///         Analyze(TM) 7.5 (.hdr/.img) or NRRD (.nrrd/.nhdr, raw
+///         encoding) file.
+///
+///  Only the header is read when the volume is opened; voxel pages are
+///  read in by the operating system as they are first touched. The
+///  mapping is private: the voxels may be modified, but the changes are
+///  never written back to the file.
+///
+///  @remarks Volumes stored in the non-native byte order are swapped in
+///           place when opened, which reads the whole file.
+///////////////////////////////////////////////////////////////////////////
+class mapped_volume
+{
+public:
+
+    typedef size_t  size_type;
+
+    mapped_volume() { reset(); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Maps the voxels of a volume file.
+    ///
+    ///  @param name  The name of the file (.hdr, .img, .nrrd or .nhdr).
+    ///
+    ///  @return false if the file cannot be mapped: it does not exist,
+    ///          it is compressed, or it uses a layout or a datatype that
+    ///          is not supported. The caller may then fall back to a
+    ///          regular reader.
+    ///////////////////////////////////////////////////////////////////////
+    bool open(const char* name)
+    {
+        using namespace optnet::utils;
+
+        assert(0 != name);
+
+        close();
+
+        std::string str(name);
+        bool        ok;
+
+        if (str_ends_with_no_case(str, ".nrrd") ||
+            str_ends_with_no_case(str, ".nhdr")) {
+            ok = open_nrrd(str);
+        }
+        else {
+            ok = open_analyze(str);
+        }
+
+        if (!ok) close();
+        return ok;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Unmaps the volume.
+    ///////////////////////////////////////////////////////////////////////
+    void close()
+    {
+        m_file.close();
+        reset();
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the voxels as an array of the given type.
+    ///
+    ///  @exception optnet::io_error The volume is not mapped, or its
+    ///                              datatype is not _Ty.
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Ty>
+    array_ref<_Ty> as_array() const
+    {
+        if (0 == m_data) {
+            throw_exception(io_error(
+                "mapped_volume::as_array: No volume is mapped."
+                ));
+        }
+        if (m_datatype != analyze_datatype<_Ty>::id()) {
+            throw_exception(io_error(
+                "mapped_volume::as_array: Data type does not match."
+                ));
+        }
+
+        return array_ref<_Ty>(reinterpret_cast<_Ty*>(m_data),
+                              m_size[0], m_size[1], m_size[2], m_size[3]);
+    }
+
+    inline bool         is_open()    const { return 0 != m_data;   }
+    inline long         datatype()   const { return m_datatype;    }
+    inline const void*  data()       const { return m_data;        }
+    inline void*        data()             { return m_data;        }
+    inline size_type    size(int i)  const { return m_size[i];     }
+    inline double       voxel_size(int i) const { return m_voxel_size[i]; }
+
+private:
+
+    detail::mapped_file m_file;
+    char*               m_data;
+    long                m_datatype;
+    size_type           m_size[4];
+    double              m_voxel_size[3];
+
+    void reset()
+    {
+        m_data     = 0;
+        m_datatype = DT_NONE;
+        for (int i = 0; i < 4; ++i) m_size[i] = 1;
+        for (int i = 0; i < 3; ++i) m_voxel_size[i] = 1.0;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Maps the data of 'count' voxels of 'bytes' bytes each, starting at
+    // 'offset' in the given file.
+    bool map_data(const std::string& name,
+                  size_t             offset,
+                  size_t             count,
+                  size_t             bytes,
+                  bool               swap
+                  )
+    {
+        if (!m_file.open(name, offset + count * bytes)) return false;
+
+        m_data = m_file.data() + offset;
+        if (swap && bytes > 1) {
+            detail::mapped_swap_bytes(m_data, count, bytes);
+        }
+
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    bool open_analyze(const std::string& name)
+    {
+        using namespace optnet::io::detail;
+
+        analyze_volume  volume;
+        std::string     hdr_name, img_name;
+
+        analyze_make_filename_pair(name, hdr_name, img_name);
+        if (!analyze_load_info(&volume, hdr_name, img_name)) return false;
+
+        m_datatype      = volume.datatype;
+        m_size[0]       = volume.image_size_x;
+        m_size[1]       = volume.image_size_y;
+        m_size[2]       = volume.image_size_z;
+        m_size[3]       = volume.image_size_w;
+        m_voxel_size[0] = volume.voxel_size_x;
+        m_voxel_size[1] = volume.voxel_size_y;
+        m_voxel_size[2] = volume.voxel_size_z;
+
+        // A missing .img (e.g., only .img.gz exists) fails here.
+        return map_data(img_name, 0, volume.image_size,
+                        volume.voxel_bytes, volume.swap_endian);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    bool open_nrrd(const std::string& name)
+    {
+        using namespace optnet::io::detail;
+
+        std::string line, data_name, encoding("raw"), endian;
+        size_t      offset = 0, bytes = 0, count = 1;
+        int         dims = 0;
+        FILE*       pfile;
+        bool        ok = true;
+
+        if (0 != secure_fopen(&pfile, name.c_str(), "rb")) return false;
+
+        // The first line is the magic ("NRRD000X").
+        if (!read_line(pfile, line) || line.compare(0, 4, "NRRD") != 0) {
+            fclose(pfile);
+            return false;
+        }
+
+        // The header ends at the first empty line (or at the end of a
+        // detached header).
+        while (ok && read_line(pfile, line) && !line.empty()) {
+
+            if ('#' == line[0]) continue;
+
+            size_t colon = line.find(": ");
+            if (std::string::npos == colon) continue; // A key/value pair.
+            if (colon > 0 && '=' == line[colon - 1]) continue;
+
+            std::string field = line.substr(0, colon);
+            std::string value = line.substr(colon + 2);
+
+            if ("type" == field) {
+                m_datatype = nrrd_datatype(value, bytes);
+                ok = (DT_NONE != m_datatype);
+            }
+            else if ("dimension" == field) {
+                dims = atoi(value.c_str());
+                ok = (dims >= 1 && dims <= 4);
+            }
+            else if ("sizes" == field) {
+                std::istringstream is(value);
+                for (int i = 0; i < 4 && (is >> m_size[i]); ++i) ;
+            }
+            else if ("spacings" == field) {
+                std::istringstream is(value);
+                for (int i = 0; i < 3 && (is >> m_voxel_size[i]); ++i) ;
+            }
+            else if ("space directions" == field) {
+                parse_directions(value);
+            }
+            else if ("encoding" == field) {
+                encoding = value;
+            }
+            else if ("endian" == field) {
+                endian = value;
+            }
+            else if ("byte skip" == field) {
+                long skip = atol(value.c_str());
+                ok = (skip >= 0);
+                offset = (size_t)skip;
+            }
+            else if ("line skip" == field || "lineskip" == field) {
+                ok = (0 == atol(value.c_str()));
+            }
+            else if ("data file" == field || "datafile" == field) {
+                // A list of files or a file name pattern is not mapped.
+                ok = (value.find(' ') == std::string::npos &&
+                      value.find('%') == std::string::npos);
+                data_name = value;
+            }
+        }
+
+        if (ok && data_name.empty()) {
+            // The data is attached, and follows the header.
+            long pos = ftell(pfile);
+            ok = (pos > 0);
+            offset += (size_t)pos;
+            data_name = name;
+        }
+        else if (ok && data_name[0] != '/' && data_name[0] != '\\' &&
+                 data_name.find(':') == std::string::npos) {
+            // A detached data file is relative to the header.
+            size_t sep = name.find_last_of("/\\");
+            if (std::string::npos != sep) {
+                data_name = name.substr(0, sep + 1) + data_name;
+            }
+        }
+        fclose(pfile);
+
+        if (!ok || 0 == dims || 0 == bytes || "raw" != encoding) {
+            return false;
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            if (i >= dims) m_size[i] = 1;
+            count *= m_size[i];
+        }
+
+        bool swap = (bytes > 1) &&
+            ((endian == "big") != mapped_host_is_big_endian());
+
+        return map_data(data_name, offset, count, bytes, swap);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Reads a header line, without the line terminator.
+    static bool read_line(FILE* pfile, std::string& line)
+    {
+        int c;
+
+        line.clear();
+        while (EOF != (c = fgetc(pfile)) && '\n' != c) {
+            if ('\r' != c) line += (char)c;
+        }
+
+        return !(EOF == c && line.empty());
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Takes the voxel sizes from the lengths of the space directions,
+    // e.g. "(0.9,0,0) (0,0.9,0) (0,0,2.5)".
+    void parse_directions(const std::string& value)
+    {
+        size_t pos = 0;
+
+        for (int i = 0; i < 3; ++i) {
+            size_t open  = value.find('(', pos);
+            size_t close = value.find(')', open);
+            if (std::string::npos == open || std::string::npos == close) {
+                break;
+            }
+
+            std::string vec = value.substr(open + 1, close - open - 1);
+            std::replace(vec.begin(), vec.end(), ',', ' ');
+
+            std::istringstream is(vec);
+            double x, sum = 0;
+            while (is >> x) sum += x * x;
+            m_voxel_size[i] = std::sqrt(sum);
+
+            pos = close + 1;
+        }
+    }
+
+    // Not copyable.
+    mapped_volume(const mapped_volume&);
+    mapped_volume& operator=(const mapped_volume&);
+};
+
+
+    } // namespace
+} // namespace
+
+#endif
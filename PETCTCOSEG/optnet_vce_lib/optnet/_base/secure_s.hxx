@@ -11,6 +11,7 @@
 #   include <stdlib.h>
 #   include <errno.h>
 #   include <stdio.h>
+#   include <string.h>
 
 /// @namespace optnet
 namespace optnet {
@@ -65,6 +65,9 @@ namespace optnet {
 ///  @class optnet_fs_maxflow
 ///  @brief Implementation of the Boykov-Kolmogorov max-flow algorithm on
 ///         a forward-star represented graph.
+///
+///  @remarks optnet_fs_maxflow_soa provides the same algorithm on a
+///           structure-of-arrays node store.
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cap, typename _Tg = net_f_xy>
 class optnet_fs_maxflow
@@ -205,10 +208,10 @@ public:
                            )
     {
 #   ifdef __OPTNET_SUPPORT_ROI__
-        if (in_roi(i0, i1, i2, i3, i4)) { // in ROI?
+        if (this->in_roi(i0, i1, i2, i3, i4)) { // in ROI?
 #   endif
             
-            m_nodes(i0, i1, i2, i3, i4).cap = s - t;
+            this->m_nodes(i0, i1, i2, i3, i4).cap = s - t;
             m_preflow += (s < t) ? s : t;
 
 #   ifdef __OPTNET_SUPPORT_ROI__
@@ -236,10 +239,10 @@ public:
                               size_type i4 = 0
                               ) const
     {
-        return (!(m_nodes(i0, i1, i2, i3, i4).tag & IS_SINK))
-            && (m_nodes(i0, i1, i2, i3, i4).p_parent_arc != 0)
+        return (!(this->m_nodes(i0, i1, i2, i3, i4).tag & IS_SINK))
+            && (this->m_nodes(i0, i1, i2, i3, i4).p_parent_arc != 0)
 #   ifdef __OPTNET_SUPPORT_ROI__
-            && in_roi(i0, i1, i2, i3, i4)
+            && this->in_roi(i0, i1, i2, i3, i4)
 #   endif
             ;
     }
@@ -255,12 +258,78 @@ public:
         m_preflow = flow;
     }
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Change the capacities of the arcs connecting a node to the source
+    ///  and the sink node by the given amounts.
+    ///
+    ///  @param  delta_s  The change of the capacity from the source node.
+    ///  @param  delta_t  The change of the capacity to the sink node.
+    ///  @param  i0       The first  index of the node. 
+    ///  @param  i1       The second index of the node. 
+    ///  @param  i2       The third  index of the node. 
+    ///  @param  i3       The fourth index of the node (default: 0)
+    ///  @param  i4       The fifth  index of the node (default: 0)
+    ///
+    ///  @remarks Either change may be negative. If called after solve(),
+    ///           the change is applied to the residual graph and the node
+    ///           is marked as changed, so that a subsequent resolve()
+    ///           only repairs the search trees around the changed nodes.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void update_st_arc(capacity_type delta_s,
+                              capacity_type delta_t,
+                              size_type     i0,
+                              size_type     i1,
+                              size_type     i2,
+                              size_type     i3 = 0,
+                              size_type     i4 = 0
+                              )
+    {
+#   ifdef __OPTNET_SUPPORT_ROI__
+        if (!this->in_roi(i0, i1, i2, i3, i4)) return;
+#   endif
+
+        node_reference node = this->m_nodes(i0, i1, i2, i3, i4);
+        capacity_type  s    = (node.cap > 0) ?  node.cap : 0;
+        capacity_type  t    = (node.cap < 0) ? -node.cap : 0;
+        
+        s += delta_s;
+        t += delta_t;
+
+        // The common part of the two terminal capacities (which may be
+        // negative) does not affect the cut; move it to the flow value.
+        node.cap = s - t;
+        if (m_solved) m_flow    += (s < t) ? s : t;
+        else          m_preflow += (s < t) ? s : t;
+
+        if (m_solved && !(node.tag & IS_CHANGED)) {
+            node.tag |= IS_CHANGED;
+            m_changed_nodes.push_back(&node);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Re-solve the maximum-flow/minimum s-t cut problem after the
+    ///  terminal capacities have been changed by update_st_arc().
+    ///
+    ///  The search trees and the residual flows of the previous solve()
+    ///  or resolve() call are reused (Kohli-Torr dynamic graph cuts), so
+    ///  the cost is roughly proportional to the size of the change.
+    ///
+    ///  @returns The maximum flow value.
+    ///
+    ///  @remarks Calls solve() if the graph has not been solved yet.
+    ///////////////////////////////////////////////////////////////////////
+    capacity_type resolve();
+
 private:
 
     typedef std::deque<node_pointer> node_queue;
 
 
+    capacity_type maxflow(bool reuse_trees);
     void maxflow_init();
+    void maxflow_reuse_trees_init();
     void maxflow_augment(node_pointer   p_s_start_node,
                          node_pointer   p_t_start_node,
                          capacity_type* p_mid_fwd_cap,
@@ -276,6 +345,14 @@ private:
         }
     }
 
+    inline void set_orphan(node_pointer p_node)
+    {
+        if (p_node->p_parent_arc != ORPHAN) {  // Not an orphan yet.
+            p_node->p_parent_arc = (forward_arc_pointer)ORPHAN;
+            m_orphan_nodes.push_back(p_node);
+        }
+    }
+
     inline node_pointer neighbor_node_fwd(node_pointer    p_node,
                                           difference_type shift)
     {
@@ -293,14 +370,17 @@ private:
     // Constants (Initialized in optnet_fs_maxflow.cxx)
     static const unsigned char       PARENT_REV;// Parent arc is reverse.
     static const unsigned char       IS_ACTIVE; // The node is active.
+    static const unsigned char       IS_CHANGED;// The node is changed
+                                                //   since the last solve.
     static const unsigned char       IS_SINK;   // The node belongs to
                                                 //   the sink tree.
     static forward_arc_const_pointer TERMINAL;  // Parent is terminal node.
     static forward_arc_const_pointer ORPHAN;    // No parent.
 
     size_type     m_dist_id;
-    node_queue    m_active_nodes, m_orphan_nodes;
+    node_queue    m_active_nodes, m_orphan_nodes, m_changed_nodes;
     capacity_type m_preflow, m_flow;
+    bool          m_solved;
 
 };
 
@@ -0,0 +1,588 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: optnet_fs_maxflow_soa.cxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+#ifndef ___OPTNET_FS_MAXFLOW_SOA_CXX___
+#   define ___OPTNET_FS_MAXFLOW_SOA_CXX___
+
+#   include <optnet/_fs/optnet_fs_maxflow_soa.hxx>
+#   include <algorithm>
+
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+optnet_fs_maxflow_soa<_Cap, _Tg>::optnet_fs_maxflow_soa() :
+#   ifdef __OPTNET_SUPPORT_ROI__
+    m_proi(0),
+#   endif // __OPTNET_SUPPORT_ROI__
+    m_prepared(false),
+    m_time(0),
+    m_preflow(0),
+    m_flow(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+optnet_fs_maxflow_soa<_Cap, _Tg>::optnet_fs_maxflow_soa(size_type s0,
+                                                        size_type s1,
+                                                        size_type s2,
+                                                        size_type s3,
+                                                        size_type s4
+                                                        ) :
+#   ifdef __OPTNET_SUPPORT_ROI__
+    m_proi(0),
+#   endif // __OPTNET_SUPPORT_ROI__
+    m_prepared(false),
+    m_time(0),
+    m_preflow(0),
+    m_flow(0)
+{
+    create(s0, s1, s2, s3, s4);
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+bool
+optnet_fs_maxflow_soa<_Cap, _Tg>::create(size_type s0,
+                                         size_type s1,
+                                         size_type s2,
+                                         size_type s3,
+                                         size_type s4
+                                         )
+{
+    // Clear pre-calculated flow.
+    m_preflow = 0;
+
+    // Remove all arcs if any.
+    clear_arcs();
+
+    // The sentinel values occupy the top of the index range.
+    if ((double)s0 * s1 * s2 * s3 * s4 >= (double)FREE) {
+        throw_exception(std::invalid_argument(
+            "optnet_fs_maxflow_soa::create: Graph is too large."
+            ));
+    }
+
+    if (!m_cap.create(s0, s1, s2, s3, s4))
+        return false;
+
+    std::fill(m_cap.begin(), m_cap.end(), capacity_type(0));
+
+    const size_type n = m_cap.size();
+    const size_type w = (n + 31) >> 5;
+
+    m_parent.assign(n, FREE);
+    m_ts.assign(n, 0);
+    m_dist.assign(n, 0);
+    m_sink_bits.assign(w, 0);
+    m_active_bits.assign(w, 0);
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+optnet_fs_maxflow_soa<_Cap, _Tg>::clear_arcs()
+{
+    m_arc_records.clear();
+    m_first_arc.clear();
+    m_head.clear();
+    m_sister.clear();
+    m_rcap.clear();
+
+    // Call prepare() to make the graph usable.
+    m_prepared = false;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Convert the arcs added by 'add_arc()' calls to a compressed-row layout.
+// Every arc record produces two residual slots, one in the row of the
+// tail node and one in the row of the head node, that point to each
+// other through m_sister.
+//
+// Linear time algorithm (counting sort on the tail node).
+//
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+optnet_fs_maxflow_soa<_Cap, _Tg>::prepare()
+{
+    if (m_prepared) return;
+
+    const size_type n = m_cap.size();
+    const size_type m = m_arc_records.size();
+
+    if ((double)m * 2 >= (double)FREE) {
+        throw_exception(std::runtime_error(
+            "optnet_fs_maxflow_soa::prepare: Too many arcs."
+            ));
+    }
+
+    m_first_arc.assign(n + 1, 0);
+    m_head.resize(2 * m);
+    m_sister.resize(2 * m);
+    m_rcap.resize(2 * m);
+
+    typename std::vector<arc_record>::const_iterator it;
+
+    // Count the residual slots of each node.
+    for (it = m_arc_records.begin(); it != m_arc_records.end(); ++it) {
+        ++m_first_arc[it->tail + 1];
+        ++m_first_arc[it->head + 1];
+    }
+    for (size_type i = 0; i < n; ++i)
+        m_first_arc[i + 1] += m_first_arc[i];
+
+    // Scatter the arcs; m_ts temporarily holds the fill position.
+    for (size_type i = 0; i < n; ++i)
+        m_ts[i] = m_first_arc[i];
+
+    for (it = m_arc_records.begin(); it != m_arc_records.end(); ++it) {
+
+        index_type a = m_ts[it->tail]++;
+        index_type b = m_ts[it->head]++;
+
+        m_head[a]   = it->head;
+        m_head[b]   = it->tail;
+        m_sister[a] = b;
+        m_sister[b] = a;
+        m_rcap[a]   = it->cap;
+        m_rcap[b]   = it->rev_cap;
+    }
+
+    // Release the temporary arc records.
+    std::vector<arc_record>().swap(m_arc_records);
+
+    m_prepared = true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+typename optnet_fs_maxflow_soa<_Cap, _Tg>::capacity_type
+optnet_fs_maxflow_soa<_Cap, _Tg>::solve()
+{
+    index_type i, j, a, a_end, mid_arc = 0, cur_node = FREE;
+    bool       found;
+
+    // Initialize the maximum-flow solver.
+    maxflow_init();
+
+    while (true) {
+
+        i = cur_node;
+
+        if (FREE != i) {
+            clear_active(i);
+            if (FREE == m_parent[i]) i = FREE;
+        }
+        if (FREE == i) {
+
+            while (!m_active_nodes.empty()) {
+
+                i = m_active_nodes.front();
+                m_active_nodes.pop_front();
+                clear_active(i);
+
+                if (FREE != m_parent[i]) break;
+                i = FREE;
+            }
+
+            if (FREE == i) break;
+        }
+
+        //
+        // STAGE 1: Growth.
+        //
+        found = false;
+        a_end = m_first_arc[i + 1];
+
+        if (!is_sink(i)) {
+            // Grow source tree.
+            for (a = m_first_arc[i]; a < a_end; ++a) {
+
+                if (0 == m_rcap[a]) continue;
+
+                j = m_head[a];
+
+                if (FREE == m_parent[j]) {
+                    set_source(j);
+                    m_parent[j] = m_sister[a];
+                    m_ts[j]     = m_ts[i];
+                    m_dist[j]   = m_dist[i] + 1;
+                    activate(j);
+                }
+                else if (is_sink(j)) {
+                    mid_arc = a;
+                    found   = true;
+                    break;
+                }
+                else if (m_ts[j] <= m_ts[i] && m_dist[j] > m_dist[i]) {
+                    // Shorten the path to the terminal.
+                    m_parent[j] = m_sister[a];
+                    m_ts[j]     = m_ts[i];
+                    m_dist[j]   = m_dist[i] + 1;
+                }
+            } // for
+        }
+        else {
+            // Grow sink tree.
+            for (a = m_first_arc[i]; a < a_end; ++a) {
+
+                if (0 == m_rcap[m_sister[a]]) continue;
+
+                j = m_head[a];
+
+                if (FREE == m_parent[j]) {
+                    set_sink(j);
+                    m_parent[j] = m_sister[a];
+                    m_ts[j]     = m_ts[i];
+                    m_dist[j]   = m_dist[i] + 1;
+                    activate(j);
+                }
+                else if (!is_sink(j)) {
+                    mid_arc = m_sister[a];
+                    found   = true;
+                    break;
+                }
+                else if (m_ts[j] <= m_ts[i] && m_dist[j] > m_dist[i]) {
+                    // Shorten the path to the terminal.
+                    m_parent[j] = m_sister[a];
+                    m_ts[j]     = m_ts[i];
+                    m_dist[j]   = m_dist[i] + 1;
+                }
+            } // for
+        }
+
+        if (!found) cur_node = FREE;
+        else {
+
+            // Set active flag (prevent reactivation).
+            set_active(i);
+            cur_node = i;
+
+            ++m_time;
+
+            //
+            // STAGE 2: Augmentation.
+            //
+            maxflow_augment(mid_arc);
+
+            //
+            // STAGE 3: Adoption.
+            //
+            while (!m_orphan_nodes.empty()) {
+
+                j = m_orphan_nodes.front();
+                m_orphan_nodes.pop_front();
+
+                if (!is_sink(j))
+                    maxflow_adopt_source_orphan(j);
+                else
+                    maxflow_adopt_sink_orphan(j);
+            }
+        }
+
+    } // while (true)
+
+    return m_flow;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+optnet_fs_maxflow_soa<_Cap, _Tg>::maxflow_init()
+{
+    // Convert the graph to a compressed-row representation.
+    prepare();
+
+    // Initialize data structures.
+    m_active_nodes.clear();
+    m_orphan_nodes.clear();
+    m_flow = m_preflow;
+    m_time = 0;
+
+    std::fill(m_sink_bits.begin(),   m_sink_bits.end(),   0u);
+    std::fill(m_active_bits.begin(), m_active_bits.end(), 0u);
+
+    const index_type n = (index_type)m_cap.size();
+
+    for (index_type i = 0; i < n; ++i) {
+
+        const capacity_type c = m_cap[i];
+
+        m_ts[i] = 0;
+
+        if (c != 0) {
+            // i is connected to the source (c > 0) or the sink (c < 0).
+            if (c < 0) set_sink(i);
+            m_parent[i] = TERMINAL;
+            m_dist[i]   = 1;
+            activate(i);
+        }
+        else {
+            m_parent[i] = FREE;
+            m_dist[i]   = 0;
+        }
+    } // for
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+optnet_fs_maxflow_soa<_Cap, _Tg>::maxflow_augment(index_type mid_arc)
+{
+    capacity_type bottle_neck_cap;
+    index_type    i, a;
+
+    // STEP 1: Find bottleneck capacity.
+    bottle_neck_cap = m_rcap[mid_arc];
+
+    //    1-1: The source tree.
+    for (i = m_head[m_sister[mid_arc]]; TERMINAL != (a = m_parent[i]); ) {
+        if (bottle_neck_cap > m_rcap[m_sister[a]])
+            bottle_neck_cap = m_rcap[m_sister[a]];
+        i = m_head[a];
+    }
+    if (bottle_neck_cap > m_cap[i])
+        bottle_neck_cap = m_cap[i];
+
+    //    1-2: The sink tree.
+    for (i = m_head[mid_arc]; TERMINAL != (a = m_parent[i]); ) {
+        if (bottle_neck_cap > m_rcap[a])
+            bottle_neck_cap = m_rcap[a];
+        i = m_head[a];
+    }
+    if (bottle_neck_cap > -m_cap[i])
+        bottle_neck_cap = -m_cap[i];
+
+    if (bottle_neck_cap == 0) return;
+
+    // STEP 2: Augment.
+    push_flow(mid_arc, bottle_neck_cap);
+
+    //    2-1: The source tree.
+    for (i = m_head[m_sister[mid_arc]]; TERMINAL != (a = m_parent[i]); ) {
+        push_flow(m_sister[a], bottle_neck_cap);
+        if (0 == m_rcap[m_sister[a]])
+            set_orphan(i);
+        i = m_head[a];
+    }
+    m_cap[i] -= bottle_neck_cap;
+    if (0 == m_cap[i])
+        set_orphan(i);
+
+    //    2-2: The sink tree.
+    for (i = m_head[mid_arc]; TERMINAL != (a = m_parent[i]); ) {
+        push_flow(a, bottle_neck_cap);
+        if (0 == m_rcap[a])
+            set_orphan(i);
+        i = m_head[a];
+    }
+    m_cap[i] += bottle_neck_cap;
+    if (0 == m_cap[i])
+        set_orphan(i);
+
+    m_flow += bottle_neck_cap;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+optnet_fs_maxflow_soa<_Cap, _Tg>::maxflow_adopt_source_orphan(
+                                    index_type orphan
+                                    )
+{
+    static const index_type DIST_MAX = std::numeric_limits<index_type>::max();
+
+    const index_type a_begin = m_first_arc[orphan];
+    const index_type a_end   = m_first_arc[orphan + 1];
+    index_type       a, a1, j, dist, min_dist = DIST_MAX, min_arc = FREE;
+
+    // Try to find new parent for the orphan.
+    for (a = a_begin; a < a_end; ++a) {
+
+        if (0 == m_rcap[m_sister[a]]) continue;
+
+        j = m_head[a];
+        if (is_sink(j) || FREE == m_parent[j]) continue;
+
+        // Trace back to the source.
+        for (dist = 0; ; ) {
+            if (m_ts[j] == m_time) {
+                dist += m_dist[j];
+                break;
+            }
+            ++dist;
+            a1 = m_parent[j];
+            if (TERMINAL == a1) {
+                m_ts[j]   = m_time;
+                m_dist[j] = 1;
+                break;
+            }
+            if (ORPHAN == a1) {
+                dist = DIST_MAX;
+                break;
+            }
+            j = m_head[a1];
+        }
+
+        if (dist < DIST_MAX) {
+
+            // Save minimum distance node so far.
+            if (dist < min_dist) {
+                min_arc  = a;
+                min_dist = dist;
+            }
+
+            // Set distance along the path.
+            for (j = m_head[a]; m_ts[j] != m_time; j = m_head[m_parent[j]]) {
+                m_ts[j]   = m_time;
+                m_dist[j] = dist--;
+            }
+        }
+    } // for
+
+    if (FREE != (m_parent[orphan] = min_arc)) { // Found parent.
+        m_ts[orphan]   = m_time;
+        m_dist[orphan] = min_dist + 1;
+    }
+    else { // Parent not found.
+
+        m_ts[orphan] = 0;
+
+        // Process neighbors.
+        for (a = a_begin; a < a_end; ++a) {
+
+            j = m_head[a];
+            if (is_sink(j) || FREE == (a1 = m_parent[j])) continue;
+
+            if (0 != m_rcap[m_sister[a]])
+                activate(j);
+
+            if (TERMINAL != a1 && ORPHAN != a1 && m_head[a1] == orphan)
+                set_orphan(j);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+optnet_fs_maxflow_soa<_Cap, _Tg>::maxflow_adopt_sink_orphan(
+                                    index_type orphan
+                                    )
+{
+    static const index_type DIST_MAX = std::numeric_limits<index_type>::max();
+
+    const index_type a_begin = m_first_arc[orphan];
+    const index_type a_end   = m_first_arc[orphan + 1];
+    index_type       a, a1, j, dist, min_dist = DIST_MAX, min_arc = FREE;
+
+    // Try to find new parent for the orphan.
+    for (a = a_begin; a < a_end; ++a) {
+
+        if (0 == m_rcap[a]) continue;
+
+        j = m_head[a];
+        if (!is_sink(j) || FREE == m_parent[j]) continue;
+
+        // Trace back to the sink.
+        for (dist = 0; ; ) {
+            if (m_ts[j] == m_time) {
+                dist += m_dist[j];
+                break;
+            }
+            ++dist;
+            a1 = m_parent[j];
+            if (TERMINAL == a1) {
+                m_ts[j]   = m_time;
+                m_dist[j] = 1;
+                break;
+            }
+            if (ORPHAN == a1) {
+                dist = DIST_MAX;
+                break;
+            }
+            j = m_head[a1];
+        }
+
+        if (dist < DIST_MAX) {
+
+            // Save minimum distance node so far.
+            if (dist < min_dist) {
+                min_arc  = a;
+                min_dist = dist;
+            }
+
+            // Set distance along the path.
+            for (j = m_head[a]; m_ts[j] != m_time; j = m_head[m_parent[j]]) {
+                m_ts[j]   = m_time;
+                m_dist[j] = dist--;
+            }
+        }
+    } // for
+
+    if (FREE != (m_parent[orphan] = min_arc)) { // Found parent.
+        m_ts[orphan]   = m_time;
+        m_dist[orphan] = min_dist + 1;
+    }
+    else { // Parent not found.
+
+        m_ts[orphan] = 0;
+
+        // Process neighbors.
+        for (a = a_begin; a < a_end; ++a) {
+
+            j = m_head[a];
+            if (!is_sink(j) || FREE == (a1 = m_parent[j])) continue;
+
+            if (0 != m_rcap[a])
+                activate(j);
+
+            if (TERMINAL != a1 && ORPHAN != a1 && m_head[a1] == orphan)
+                set_orphan(j);
+        }
+    }
+}
+
+//
+// Constants
+//
+template<typename _Cap, typename _Tg>
+    const typename optnet_fs_maxflow_soa<_Cap, _Tg>::index_type
+        optnet_fs_maxflow_soa<_Cap, _Tg>::TERMINAL = 0xFFFFFFFFu;
+
+template<typename _Cap, typename _Tg>
+    const typename optnet_fs_maxflow_soa<_Cap, _Tg>::index_type
+        optnet_fs_maxflow_soa<_Cap, _Tg>::ORPHAN   = 0xFFFFFFFEu;
+
+template<typename _Cap, typename _Tg>
+    const typename optnet_fs_maxflow_soa<_Cap, _Tg>::index_type
+        optnet_fs_maxflow_soa<_Cap, _Tg>::FREE     = 0xFFFFFFFDu;
+
+template<typename _Cap, typename _Tg>
+    const typename optnet_fs_maxflow_soa<_Cap, _Tg>::capacity_type
+        optnet_fs_maxflow_soa<_Cap, _Tg>::INFINITE_CAP
+            = std::numeric_limits<_Cap>::max();
+
+} // namespace
+
+#endif
@@ -0,0 +1,592 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: optnet_fs_maxflow_soa.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+/*
+ ==========================================================================
+  - Purpose:
+
+      This file implements Boykov--Kolmogorov's max-flow/min-cut algorithm
+      on a structure-of-arrays (SoA) node store.
+
+      The per-node state used by optnet_fs_maxflow and bk_fs_maxflow is
+      kept in one struct per node (arc pointers, parent pointer, time-
+      stamp, distance, terminal capacity and flags). The growth and the
+      adoption stages only touch a few of these fields at a time, so
+      most of every cache line loaded is wasted. Here each field lives in
+      its own contiguous array:
+
+         * m_cap      : terminal residual capacity (>0 source, <0 sink),
+         * m_parent   : index of the arc leading to the parent node, or
+                        one of the TERMINAL/ORPHAN/FREE sentinels,
+         * m_ts/m_dist: timestamp and distance-to-terminal heuristics,
+         * m_sink_bits, m_active_bits :
+                        packed tree-membership and active-node bitmaps
+                        (one bit per node).
+
+      The arcs are stored in a compressed-row (CSR) layout with 32-bit
+      head/sister indices. Each arc (u,v) added by the user creates two
+      residual slots (u->v and v->u) that refer to each other through
+      m_sister, so a parent is identified by a single arc index and no
+      PARENT_REV flag is needed.
+
+      Both the simplified (infinite forward capacity) arcs used by
+      optnet_fs_maxflow and the finite-capacity arcs used by
+      bk_fs_maxflow are supported; an arc added without a capacity is
+      treated as infinite and its residual capacity is never updated.
+
+  - Reference(s):
+
+    [1] Yuri Boykov and Vladimir Kolmogorov
+        An Experimental Comparison of Min-Cut/Max-Flow Algorithms for
+            Energy Minimization in Vision
+        IEEE Trans. on Pattern Analysis and Machine Intelligence, 2004
+        URL: http://www.csd.uwo.ca/faculty/yuri/Abstracts/pami04-abs.html
+ ==========================================================================
+ */
+
+#ifndef ___OPTNET_FS_MAXFLOW_SOA_HXX___
+#   define ___OPTNET_FS_MAXFLOW_SOA_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#       pragma warning(disable: 4284)
+#       pragma warning(disable: 4127)
+#   endif
+
+#   include <optnet/config.h>
+
+#   ifdef __OPTNET_SUPPORT_ROI__
+#       include <optnet/define.h> // for roi_node definition
+#   endif
+
+#   include <optnet/_base/array.hxx>
+#   include <optnet/_base/array_ref.hxx>
+#   include <optnet/_base/except.hxx>
+#   include <optnet/_base/tags.hxx>
+#   include <deque>
+#   include <limits>
+#   include <vector>
+
+#   ifdef max       // The max macro may interfere with
+#       undef max   //   std::numeric_limits::max().
+#   endif           //
+
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+///  @class optnet_fs_maxflow_soa
+///  @brief Implementation of the Boykov-Kolmogorov max-flow algorithm on
+///         a structure-of-arrays node store with index-based parents.
+///
+///  The class provides the same interface as optnet_fs_maxflow, plus the
+///  finite-capacity add_arc() overloads of bk_fs_maxflow, and can be
+///  used as a drop-in replacement for either solver.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg = net_f_xy>
+class optnet_fs_maxflow_soa
+{
+public:
+
+    typedef _Cap                                capacity_type;
+    typedef size_t                              size_type;
+    typedef ptrdiff_t                           difference_type;
+    typedef unsigned int                        index_type;
+
+    typedef array<capacity_type, _Tg>           capacity_container;
+
+    // ROI definitions.
+#   ifdef __OPTNET_SUPPORT_ROI__
+    typedef roi_node_t                          roi_node_type;
+    typedef array_base<roi_node_t>              roi_base_type;
+    typedef array_ref<roi_node_t>               roi_ref_type;
+    typedef array<roi_node_t>                   roi_type;
+#   endif
+
+
+    ///////////////////////////////////////////////////////////////////////
+    /// Default constructor.
+    ///////////////////////////////////////////////////////////////////////
+    optnet_fs_maxflow_soa();
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Construct a optnet_fs_maxflow_soa object with the underlying graph
+    ///  being created according to the given size information.
+    ///
+    ///  @param  s0   The size of the first  dimension of the graph.
+    ///  @param  s1   The size of the second dimension of the graph.
+    ///  @param  s2   The size of the third  dimension of the graph.
+    ///  @param  s3   The size of the fourth dimension of the graph
+    ///               (default: 1).
+    ///  @param  s4   The size of the fifth  dimension of the graph
+    ///               (default: 1).
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    optnet_fs_maxflow_soa(size_type s0,
+                          size_type s1,
+                          size_type s2,
+                          size_type s3 = 1,
+                          size_type s4 = 1
+                          );
+
+    ///////////////////////////////////////////////////////////////////////
+    /// Default destructor.
+    ///////////////////////////////////////////////////////////////////////
+    virtual ~optnet_fs_maxflow_soa() {}
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Create the underlying graph of the given size.
+    ///
+    ///  @param  s0   The size of the first  dimension of the graph.
+    ///  @param  s1   The size of the second dimension of the graph.
+    ///  @param  s2   The size of the third  dimension of the graph.
+    ///  @param  s3   The size of the fourth dimension of the graph
+    ///               (default: 1).
+    ///  @param  s4   The size of the fifth  dimension of the graph
+    ///               (default: 1).
+    ///
+    ///  @returns Returns true if the graph is successfully created,
+    ///           false otherwise.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    virtual bool create(size_type s0,
+                        size_type s1,
+                        size_type s2,
+                        size_type s3 = 1,
+                        size_type s4 = 1
+                        );
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the total number of nodes in the graph.
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type size()   const { return m_cap.size();   }
+    inline size_type size_0() const { return m_cap.size_0(); }
+    inline size_type size_1() const { return m_cap.size_1(); }
+    inline size_type size_2() const { return m_cap.size_2(); }
+    inline size_type size_3() const { return m_cap.size_3(); }
+    inline size_type size_4() const { return m_cap.size_4(); }
+
+#   ifdef __OPTNET_SUPPORT_ROI__
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Set the region of interest.
+    ///
+    ///  @param roi The region-of-interest mask array.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline bool set_roi(const roi_base_type& roi)
+    {
+        //FIXME: Only considered up to 4-D.
+        if (roi.size_0() != size_0() ||
+            roi.size_1() != size_1() ||
+            roi.size_2() != size_3()
+            )
+            return false;
+
+        m_proi = &roi;
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns whether an ROI has been specified.
+    ///////////////////////////////////////////////////////////////////////
+    inline bool has_roi() const { return (m_proi != 0); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns whether the given position is in the ROI.
+    ///////////////////////////////////////////////////////////////////////
+    inline bool in_roi(size_type i0,
+                       size_type i1,
+                       size_type i2,
+                       size_type i3 = 0,
+                       size_type /*i4*/ = 0 // <-- not used
+                       ) const
+    {
+        //FIXME: Only considered up to 4-D.
+        return (
+                !has_roi() || (
+                    i2 >= (*m_proi)(i0, i1, i3).lower &&
+                    i2 <  (*m_proi)(i0, i1, i3).upper
+                )
+            );
+    }
+
+#   endif // __OPTNET_SUPPORT_ROI__
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add an arc of infinite capacity connecting from the specified
+    ///  tail node to the specified head node (optnet_fs_maxflow style).
+    ///
+    ///  @param  tail_i0 The first  index of the tail node.
+    ///  @param  tail_i1 The second index of the tail node.
+    ///  @param  tail_i2 The third  index of the tail node.
+    ///  @param  head_i0 The first  index of the head node.
+    ///  @param  head_i1 The second index of the head node.
+    ///  @param  head_i2 The third  index of the head node.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void add_arc(size_type tail_i0,
+                        size_type tail_i1,
+                        size_type tail_i2,
+                        size_type head_i0,
+                        size_type head_i1,
+                        size_type head_i2
+                        )
+    {
+#   ifdef __OPTNET_SUPPORT_ROI__
+        if (!in_roi(tail_i0, tail_i1, tail_i2) ||
+            !in_roi(head_i0, head_i1, head_i2)
+            ) {
+            return;
+        }
+#   endif
+        add_arc_helper(m_cap.offset(tail_i0, tail_i1, tail_i2),
+                       m_cap.offset(head_i0, head_i1, head_i2),
+                       INFINITE_CAP,
+                       0
+                       );
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add an arc of infinite capacity connecting from the specified
+    ///  tail node to the specified head node (optnet_fs_maxflow style).
+    ///
+    ///  @param  tail_i0 The first  index of the tail node.
+    ///  @param  tail_i1 The second index of the tail node.
+    ///  @param  tail_i2 The third  index of the tail node.
+    ///  @param  tail_i3 The fourth index of the tail node.
+    ///  @param  head_i0 The first  index of the head node.
+    ///  @param  head_i1 The second index of the head node.
+    ///  @param  head_i2 The third  index of the head node.
+    ///  @param  head_i3 The fourth index of the head node.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void add_arc(size_type tail_i0,
+                        size_type tail_i1,
+                        size_type tail_i2,
+                        size_type tail_i3,
+                        size_type head_i0,
+                        size_type head_i1,
+                        size_type head_i2,
+                        size_type head_i3
+                        )
+    {
+#   ifdef __OPTNET_SUPPORT_ROI__
+        if (!in_roi(tail_i0, tail_i1, tail_i2, tail_i3) ||
+            !in_roi(head_i0, head_i1, head_i2, head_i3)
+            ) {
+            return;
+        }
+#   endif
+        add_arc_helper(m_cap.offset(tail_i0, tail_i1, tail_i2, tail_i3),
+                       m_cap.offset(head_i0, head_i1, head_i2, head_i3),
+                       INFINITE_CAP,
+                       0
+                       );
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add an arc of finite capacity connecting from the specified tail
+    ///  node to the specified head node (bk_fs_maxflow style).
+    ///
+    ///  @param  tail_i0 The first  index of the tail node.
+    ///  @param  tail_i1 The second index of the tail node.
+    ///  @param  tail_i2 The third  index of the tail node.
+    ///  @param  head_i0 The first  index of the head node.
+    ///  @param  head_i1 The second index of the head node.
+    ///  @param  head_i2 The third  index of the head node.
+    ///  @param  cap     Capacity of the arc.
+    ///  @param  rev_cap Reverse capacity of the arc.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void add_arc(size_type     tail_i0,
+                        size_type     tail_i1,
+                        size_type     tail_i2,
+                        size_type     head_i0,
+                        size_type     head_i1,
+                        size_type     head_i2,
+                        capacity_type cap,
+                        capacity_type rev_cap
+                        )
+    {
+#   ifdef __OPTNET_SUPPORT_ROI__
+        if (!in_roi(tail_i0, tail_i1, tail_i2) ||
+            !in_roi(head_i0, head_i1, head_i2)
+            ) {
+            return;
+        }
+#   endif
+        add_arc_helper(m_cap.offset(tail_i0, tail_i1, tail_i2),
+                       m_cap.offset(head_i0, head_i1, head_i2),
+                       cap,
+                       rev_cap
+                       );
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add an arc of finite capacity connecting from the specified tail
+    ///  node to the specified head node (bk_fs_maxflow style).
+    ///
+    ///  @param  tail_i0 The first  index of the tail node.
+    ///  @param  tail_i1 The second index of the tail node.
+    ///  @param  tail_i2 The third  index of the tail node.
+    ///  @param  tail_i3 The fourth index of the tail node.
+    ///  @param  head_i0 The first  index of the head node.
+    ///  @param  head_i1 The second index of the head node.
+    ///  @param  head_i2 The third  index of the head node.
+    ///  @param  head_i3 The fourth index of the head node.
+    ///  @param  cap     Capacity of the arc.
+    ///  @param  rev_cap Reverse capacity of the arc.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void add_arc(size_type     tail_i0,
+                        size_type     tail_i1,
+                        size_type     tail_i2,
+                        size_type     tail_i3,
+                        size_type     head_i0,
+                        size_type     head_i1,
+                        size_type     head_i2,
+                        size_type     head_i3,
+                        capacity_type cap,
+                        capacity_type rev_cap
+                        )
+    {
+#   ifdef __OPTNET_SUPPORT_ROI__
+        if (!in_roi(tail_i0, tail_i1, tail_i2, tail_i3) ||
+            !in_roi(head_i0, head_i1, head_i2, head_i3)
+            ) {
+            return;
+        }
+#   endif
+        add_arc_helper(m_cap.offset(tail_i0, tail_i1, tail_i2, tail_i3),
+                       m_cap.offset(head_i0, head_i1, head_i2, head_i3),
+                       cap,
+                       rev_cap
+                       );
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add arc(s) connecting a node to the source and/or the sink node.
+    ///
+    ///  @param  s    The capacity of the arc from the source node.
+    ///  @param  t    The capacity of the arc to the sink node.
+    ///  @param  i0   The first  index of the node.
+    ///  @param  i1   The second index of the node.
+    ///  @param  i2   The third  index of the node.
+    ///  @param  i3   The fourth index of the node (default: 0)
+    ///  @param  i4   The fifth  index of the node (default: 0)
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void add_st_arc(capacity_type s,
+                           capacity_type t,
+                           size_type     i0,
+                           size_type     i1,
+                           size_type     i2,
+                           size_type     i3 = 0,
+                           size_type     i4 = 0
+                           )
+    {
+#   ifdef __OPTNET_SUPPORT_ROI__
+        if (in_roi(i0, i1, i2, i3, i4)) { // in ROI?
+#   endif
+
+            m_cap(i0, i1, i2, i3, i4) = s - t;
+            m_preflow += (s < t) ? s : t;
+
+#   ifdef __OPTNET_SUPPORT_ROI__
+        }
+#   endif
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Remove all arcs that were added.
+    ///////////////////////////////////////////////////////////////////////
+    void clear_arcs();
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Converts the arcs added by 'add_arc()' calls to the compressed-
+    ///  row representation used by the solver.
+    ///
+    ///  @remarks Called by solve(). After calling this function, one
+    ///           cannot call the function 'add_arc()' any more.
+    ///////////////////////////////////////////////////////////////////////
+    void prepare();
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Solve the maximum-flow/minimum s-t cut problem.
+    ///
+    ///  @returns The maximum flow value.
+    ///////////////////////////////////////////////////////////////////////
+    capacity_type solve();
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Determines if the given node is in the source set of the cut.
+    ///
+    ///  @param  i0   The first  index of the node.
+    ///  @param  i1   The second index of the node.
+    ///  @param  i2   The third  index of the node.
+    ///  @param  i3   The fourth index of the node (default: 0).
+    ///  @param  i4   The fifth  index of the node (default: 0).
+    ///
+    ///  @return Returns true if the given node is the source set,
+    ///          false otherwise.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline bool in_source_set(size_type i0,
+                              size_type i1,
+                              size_type i2,
+                              size_type i3 = 0,
+                              size_type i4 = 0
+                              ) const
+    {
+        index_type i = (index_type)m_cap.offset(i0, i1, i2, i3, i4);
+        return (!is_sink(i)) && (m_parent[i] != FREE)
+#   ifdef __OPTNET_SUPPORT_ROI__
+            && in_roi(i0, i1, i2, i3, i4)
+#   endif
+            ;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Set the initial flow value.
+    ///
+    ///  @param flow The initial flow value.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    inline void set_initial_flow(const capacity_type& flow)
+    {
+        m_preflow = flow;
+    }
+
+private:
+
+    typedef std::deque<index_type>  node_queue;
+
+    // Temporary arc record kept until prepare() is called.
+    struct arc_record
+    {
+        index_type      tail, head;
+        capacity_type   cap, rev_cap;
+    };
+
+    void maxflow_init();
+    void maxflow_augment(index_type mid_arc);
+    void maxflow_adopt_source_orphan(index_type orphan);
+    void maxflow_adopt_sink_orphan(index_type orphan);
+
+    inline void add_arc_helper(difference_type tail,
+                               difference_type head,
+                               capacity_type   cap,
+                               capacity_type   rev_cap
+                               )
+    {
+        arc_record rec;
+        rec.tail    = (index_type)tail;
+        rec.head    = (index_type)head;
+        rec.cap     = cap;
+        rec.rev_cap = rev_cap;
+        m_arc_records.push_back(rec);
+        m_prepared  = false;
+    }
+
+    // Packed bitmap access.
+    inline bool is_sink(index_type i) const
+    {
+        return 0 != (m_sink_bits[i >> 5] & (1u << (i & 31)));
+    }
+    inline void set_sink(index_type i)
+    {
+        m_sink_bits[i >> 5] |=  (1u << (i & 31));
+    }
+    inline void set_source(index_type i)
+    {
+        m_sink_bits[i >> 5] &= ~(1u << (i & 31));
+    }
+    inline bool is_active(index_type i) const
+    {
+        return 0 != (m_active_bits[i >> 5] & (1u << (i & 31)));
+    }
+    inline void set_active(index_type i)
+    {
+        m_active_bits[i >> 5] |=  (1u << (i & 31));
+    }
+    inline void clear_active(index_type i)
+    {
+        m_active_bits[i >> 5] &= ~(1u << (i & 31));
+    }
+
+    inline void activate(index_type i)
+    {
+        if (!is_active(i)) {  // Not active yet.
+            m_active_nodes.push_back(i);
+            set_active(i);
+        }
+    }
+
+    inline void set_orphan(index_type i)
+    {
+        m_parent[i] = ORPHAN;
+        m_orphan_nodes.push_back(i);
+    }
+
+    // Residual updates; infinite residual capacities are left unchanged.
+    inline void push_flow(index_type a, capacity_type f)
+    {
+        if (m_rcap[a] != INFINITE_CAP)              m_rcap[a]            -= f;
+        if (m_rcap[m_sister[a]] != INFINITE_CAP)    m_rcap[m_sister[a]]  += f;
+    }
+
+    // Constants (Initialized in optnet_fs_maxflow_soa.cxx)
+    static const index_type     TERMINAL;   // Parent is terminal node.
+    static const index_type     ORPHAN;     // No parent (orphan).
+    static const index_type     FREE;       // Not in any tree.
+    static const capacity_type  INFINITE_CAP;
+
+#   ifdef __OPTNET_SUPPORT_ROI__
+    const roi_base_type*        m_proi;
+#   endif // __OPTNET_SUPPORT_ROI__
+
+    bool                        m_prepared;
+
+    // Node store (one array per field).
+    capacity_container          m_cap;
+    std::vector<index_type>     m_parent;
+    std::vector<index_type>     m_ts;
+    std::vector<index_type>     m_dist;
+    std::vector<unsigned int>   m_sink_bits;
+    std::vector<unsigned int>   m_active_bits;
+
+    // Arc store (compressed rows indexed by the tail node).
+    std::vector<index_type>     m_first_arc;
+    std::vector<index_type>     m_head;
+    std::vector<index_type>     m_sister;
+    std::vector<capacity_type>  m_rcap;
+    std::vector<arc_record>     m_arc_records;
+
+    index_type                  m_time;
+    node_queue                  m_active_nodes, m_orphan_nodes;
+    capacity_type               m_preflow, m_flow;
+};
+
+} // namespace
+
+#   ifndef __OPTNET_SEPARATION_MODEL__
+#       include <optnet/_fs/optnet_fs_maxflow_soa.cxx>
+#   endif
+
+#endif
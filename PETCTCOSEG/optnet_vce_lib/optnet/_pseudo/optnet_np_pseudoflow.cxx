@@ -48,6 +48,7 @@ optnet_pseudoflow<_Cap>::optnet_pseudoflow()
      numGaps = 0;
      numArc1Scans = 0;
 	 m_lambda=1;
+	 m_verbose=true;
 
 }
 
@@ -344,6 +345,90 @@ void optnet_pseudoflow<_Cap>::add_arc_cost(capacity_type edge_cost,size_type tai
 	++ ac->to->numAdjacent;
 	Arc1List.push_back(ac);
 }
+///////////////////////////////////
+template <typename _Cap>
+void optnet_pseudoflow<_Cap>::add_arc_chain(const capacity_type* edge_costs, size_type count, size_type tail_x, size_type tail_y, size_type tail_z, size_type tail_s, size_type head_x, size_type head_y, size_type head_z, size_type head_s, int axis)
+{
+	size_type from, to, step, i, n;
+
+	from= (m_x*m_y*m_z)*tail_s+(tail_x*m_y+tail_y)*m_z+tail_z+3;
+	to=(m_x*m_y*m_z)*head_s+(head_x*m_y+head_y)*m_z+head_z+3;
+
+	if (axis == 0)
+		step = m_y*m_z;
+	else if (axis == 1)
+		step = m_z;
+	else
+		step = 1;
+
+	// Count the arcs that can carry flow.
+	for (i=0, n=0; i<count; ++i)
+	{
+		if (edge_costs[i] != 0) ++n;
+	}
+	if (n == 0) return;
+
+	// One block for the whole chain; the arcs are never freed
+	//   individually (see freeMemory).
+	Arc1 *ac=new Arc1 [n];
+
+	for (i=0; i<count; ++i, to-=step)
+	{
+		if (edge_costs[i] == 0) continue;
+
+		initializeArc1 (ac);
+		ac->from = &adjacencyList[from-1];
+		ac->to = &adjacencyList[to-1];
+		ac->capacity= edge_costs[i];
+		++ arcIndex;
+		++ ac->from->numAdjacent;
+		++ ac->to->numAdjacent;
+		Arc1List.push_back(ac);
+		++ ac;
+	}
+}
+/////////////////////////////////
+template <typename _Cap>
+void optnet_pseudoflow<_Cap>::add_st_arcs(const capacity_type* caps, size_type count, size_type index_x, size_type index_y, size_type index_z, size_type index_s)
+{
+	size_type node, i, n;
+
+	node= m_x*m_y*m_z*index_s+(index_x*m_y+index_y)*m_z+index_z+3;
+
+	// Count the arcs that can carry flow.
+	for (i=0, n=0; i<count; ++i)
+	{
+		if (caps[i] != 0) ++n;
+	}
+	if (n == 0) return;
+
+	// One block for all arcs, as in add_arc_chain.
+	Arc1 *ac=new Arc1 [n];
+
+	for (i=0; i<count; ++i, ++node)
+	{
+		if (caps[i] == 0) continue;
+
+		initializeArc1 (ac);
+		if (caps[i] < 0)
+		{
+			ac->from = &adjacencyList[source-1];
+			ac->to = &adjacencyList[node-1];
+			ac->capacity= -caps[i];
+		}
+		else
+		{
+			ac->from = &adjacencyList[node-1];
+			ac->to = &adjacencyList[sink-1];
+			ac->capacity= caps[i];
+		}
+		++ arcIndex;
+		++ ac->from->numAdjacent;
+		++ ac->to->numAdjacent;
+		Arc1List.push_back(ac);
+		++ ac;
+	}
+}
 /////////////////////////////////
 template <typename _Cap>
 void optnet_pseudoflow<_Cap>::prepareList()
@@ -406,6 +491,53 @@ template <typename _Cap>
 	 else
 		 return false;
  }
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap>
+typename optnet_pseudoflow<_Cap>::size_type
+optnet_pseudoflow<_Cap>::find_sink_node(size_type index_x, size_type index_y, size_type index_z, size_type index_s, int axis) const
+{
+	const size_type* p = labelList + m_x*m_y*m_z*index_s + (index_x*m_y+index_y)*m_z + index_z + 2;
+	size_type        h, n, stride;
+
+	switch (axis) {
+	case 0:  h = index_x; n = m_x; stride = m_y*m_z; break;
+	case 1:  h = index_y; n = m_y; stride = m_z;     break;
+	default: h = index_z; n = m_z; stride = 1;       break;
+	}
+
+	for (; h < n && *p == 1; ++h, p += stride) ;
+
+	return h;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap>
+template <typename _Tp>
+void
+optnet_pseudoflow<_Cap>::get_labels(_Tp* labels, size_type index_s, size_type z_begin, size_type z_end) const
+{
+	const size_type  tile = 16;
+	const size_type  sxy  = m_x*m_y;
+	const size_type* base = labelList + m_x*m_y*m_z*index_s + 2;
+	size_type        x, y, z, x0, x1, z0, z1;
+
+	// Transpose the (x, z) plane of every y in tiles, reading each
+	// column of the graph and writing each image row contiguously.
+	for (y = 0; y < m_y; ++y)
+		for (z0 = z_begin; z0 < z_end; z0 = z1) {
+			z1 = (z0 + tile < z_end) ? z0 + tile : z_end;
+			for (x0 = 0; x0 < m_x; x0 = x1) {
+				x1 = (x0 + tile < m_x) ? x0 + tile : m_x;
+				for (x = x0; x < x1; ++x) {
+					const size_type* src = base + (x*m_y+y)*m_z;
+					_Tp*             dst = labels + ((z0 - z_begin)*m_y + y)*m_x + x;
+					for (z = z0; z < z1; ++z, dst += sxy)
+						*dst = (_Tp)(src[z] == 1);
+				}
+			}
+		}
+}
+
  ///////////////////////////////////////////////////////////////////////////
 template <typename _Cap>
 void
@@ -427,16 +559,16 @@ template <typename _Cap>
 typename optnet_pseudoflow<_Cap>::capacity_type
 optnet_pseudoflow<_Cap>::solve()
 {
-    printf ("c Pseudoflow algorithm for parametric min cut (version 1.0)\n");
+    if (m_verbose) printf ("c Pseudoflow algorithm for parametric min cut (version 1.0)\n");
 	//readDimacsFileCreateList ();
 	prepareList();    
-	printf ("c Finished list preparing.\n");//set as public
+	if (m_verbose) printf ("c Finished list preparing.\n");//set as public
 	simpleInitialization ();             //set as public
 
-	printf ("c Finished initialization.\n");
+	if (m_verbose) printf ("c Finished initialization.\n");
 	pseudoflowPhase1 ();
 
-	printf ("c Finished phase 1.\n"); fflush (stdout);
+	if (m_verbose) { printf ("c Finished phase 1.\n"); fflush (stdout); }
 
 //-----------------------------------------------
 	/*BySq
@@ -444,14 +576,17 @@ optnet_pseudoflow<_Cap>::solve()
 	checkOptimality ();
 	*/
 
-	printf ("c Number of nodes     : %d\n", numNodes);
-	printf ("c Number of Arc1s      : %ld\n", numArc1s);
-
-	printf ("c Number of Arc1 scans : %lld\n", numArc1Scans);
-	printf ("c Number of mergers   : %d\n", numMergers);
-	printf ("c Number of pushes    : %lld\n", numPushes);
-	printf ("c Number of relabels  : %d\n", numRelabels);
-	printf ("c Number of gaps      : %d\n", numGaps);
+	if (m_verbose)
+	{
+		printf ("c Number of nodes     : %d\n", numNodes);
+		printf ("c Number of Arc1s      : %ld\n", numArc1s);
+
+		printf ("c Number of Arc1 scans : %lld\n", numArc1Scans);
+		printf ("c Number of mergers   : %d\n", numMergers);
+		printf ("c Number of pushes    : %lld\n", numPushes);
+		printf ("c Number of relabels  : %d\n", numRelabels);
+		printf ("c Number of gaps      : %d\n", numGaps);
+	}
 
 
 
@@ -984,7 +1119,8 @@ void optnet_pseudoflow<_Cap>::pseudoflowPhase1 (void)
 		processRoot (strongRoot);
 	}
 	m_flow=computeMinCut();
-	printf ("c Finished solving parameter %d\nc Flow: %ld\nc \n", 
+	if (m_verbose)
+		printf ("c Finished solving parameter %d\nc Flow: %ld\nc \n", 
 		(theparam+1),
 		m_flow);
 	//std::cout<<"m_flow: "<<m_flow<<endl;
@@ -73,22 +73,22 @@ public:
 	///////////////////////////////////////////////////////////////////////
     ///  Return size information of x,y,z 
     ///////////////////////////////////////////////////////////////////////
-	size_type size_0()
+	size_type size_0() const
 	{
 		return m_x;
 	}
 
-	size_type size_1()
+	size_type size_1() const
 	{
 		return m_y; 
 	}
 
-	size_type size_2()
+	size_type size_2() const
 	{
 		return m_z;
 
 	}
-	size_type size_3()
+	size_type size_3() const
 	{
 		return m_s;
 	}
@@ -107,6 +107,14 @@ public:
     ///  @returns The maximum flow value.
     ///////////////////////////////////////////////////////////////////////
     capacity_type solve();
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Enable/disable the progress output of solve().
+    ///
+    ///  @param verbose  If true (default), solve() prints its progress
+    ///                  and statistics to stdout.
+    ///////////////////////////////////////////////////////////////////////
+    void set_verbose(bool verbose) { m_verbose = verbose; }
 	
 
     ///////////////////////////////////////////////////////////////////////
@@ -123,6 +131,23 @@ public:
 
    void add_st_arc(capacity_type s, capacity_type t, size_type index_npc, size_type index_col);
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add the terminal arcs of a run of consecutive nodes.
+    ///
+    ///  @param  caps     The signed terminal capacities of the nodes: a
+    ///                   positive value c adds an arc of capacity c to
+    ///                   the sink, a negative one an arc of capacity -c
+    ///                   from the source, and 0 no arc.
+    ///  @param  count    The number of nodes.
+    ///  @param  index_x,index_y,index_z,index_s  The first node; the
+    ///                   following nodes are in node order (z fastest,
+    ///                   then y, x and s).
+    ///
+    ///  @remarks The arcs are stored in one block, as in add_arc_chain.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+   void add_st_arcs(const capacity_type* caps, size_type count, size_type index_x, size_type index_y, size_type index_z, size_type index_s = 0);
+
    ///////////////////////////////////////////////////////////////////////
     ///  Add arc(s) connecting two nodes
     ///
@@ -163,6 +188,31 @@ public:
 
    void add_arc_cost(capacity_type edge_cost,size_type tail_x, size_type tail_y, size_type tail_z, size_type tail_s, size_type head_x, size_type head_y, size_type head_z, size_type head_s);
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Add a chain of arcs with edge costs from one node to consecutive
+    ///  nodes of another column.
+    ///
+    ///  @param  edge_costs   The capacities of the arcs.
+    ///  @param  count        The number of arcs in the chain.
+    ///  @param  tail_x       start node
+    ///  @param  tail_y       
+    ///  @param  tail_z 
+    ///  @param  tail_s
+    ///  @param  head_x       end node of the first arc
+    ///  @param  head_y       
+    ///  @param  head_z  
+    ///  @param  head_s
+    ///  @param  axis         The k-th arc ends at the node that is k steps
+    ///                       below the first head node along this axis
+    ///                       (0 = x, 1 = y, 2 = z).
+    ///
+    ///  @remarks Used for the convex (VCE) pairwise terms. Zero-cost arcs
+    ///           are skipped and the remaining arcs are stored in one
+    ///           block instead of being allocated one by one.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+   void add_arc_chain(const capacity_type* edge_costs, size_type count, size_type tail_x, size_type tail_y, size_type tail_z, size_type tail_s, size_type head_x, size_type head_y, size_type head_z, size_type head_s, int axis = 2);
+
 
     ///////////////////////////////////////////////////////////////////////
     ///  Determines if the given node is in the source set of the cut.
@@ -179,6 +229,36 @@ public:
 
 	bool in_source_set(size_type index_npc, size_type index_col);
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Find the first node of a column that is not in the source set.
+    ///
+    ///  @param  index_x,index_y,index_z,index_s  The node to start from.
+    ///  @param  axis  The column axis (0 = x, 1 = y, 2 = z).
+    ///
+    ///  @return The index along the axis of the first node at or above
+    ///          the given node that is in the sink set, or the size of
+    ///          the graph along the axis if there is none.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    size_type find_sink_node(size_type index_x, size_type index_y, size_type index_z, size_type index_s = 0, int axis = 2) const;
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Copy the labels of the nodes in a range of z-slices of a surface.
+    ///
+    ///  @param  labels   The output, (z_end - z_begin) * size_0() *
+    ///                   size_1() labels in image order (x fastest):
+    ///                   1 if the node is in the source set, 0 otherwise.
+    ///  @param  index_s  The surface.
+    ///  @param  z_begin,z_end  The range of slices.
+    ///
+    ///  @remarks The nodes are numbered with z fastest, so the labels
+    ///           are transposed in small tiles; this is much faster
+    ///           than calling in_source_set for every voxel.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Tp>
+    void get_labels(_Tp* labels, size_type index_s, size_type z_begin, size_type z_end) const;
+
 	/////////////////////////////////////////////////////////////////////////////
 	void initialize(void);
 	void freeMemory (void);
@@ -199,6 +279,7 @@ private:
 	size_type m_s;
 
 	float m_lambda;
+	bool m_verbose;
 
 	typedef long long int llint;
 
@@ -0,0 +1,205 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: fast_marching_bench.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+/*
+ ==========================================================================
+  - Purpose:
+
+      Micro-benchmark for the priority queues of fast_marching3. A
+      synthetic speed map (piecewise-constant blocks with multiplicative
+      noise) is marched from its center with the binary heap, the
+      indexed heap with decrease-key and the untidy (bucketed) queue,
+      and the arrival times are compared with those of the binary heap.
+
+      Usage:
+
+        optnet::utils::compare_fast_marching_queues(std::cout, 256, 256, 256);
+
+ ==========================================================================
+ */
+
+#ifndef ___FAST_MARCHING_BENCH_HXX___
+#   define ___FAST_MARCHING_BENCH_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#   endif
+
+#   include <optnet/_alpha/fast_marching3.hxx>
+#   include <optnet/_utils/timer.hxx>
+#   include <ostream>
+
+/// @namespace optnet
+namespace optnet {
+    /// @namespace optnet::utils
+    namespace utils {
+
+///////////////////////////////////////////////////////////////////////////
+///  Builds the synthetic benchmark speed map.
+///
+///  @param  speed  The speed array.
+///  @param  s0     The size of the first  dimension of the map.
+///  @param  s1     The size of the second dimension of the map.
+///  @param  s2     The size of the third  dimension of the map.
+///  @param  seed   The seed of the pseudo-random noise.
+///
+///////////////////////////////////////////////////////////////////////////
+template <typename _Speed>
+void build_fast_marching_bench_speed(array<_Speed>& speed,
+                                     size_t         s0,
+                                     size_t         s1,
+                                     size_t         s2,
+                                     unsigned int   seed = 1
+                                     )
+{
+    speed.create(s0, s1, s2);
+
+    for (size_t i2 = 0; i2 < s2; ++i2) {
+        for (size_t i1 = 0; i1 < s1; ++i1) {
+            for (size_t i0 = 0; i0 < s0; ++i0) {
+
+                // Linear congruential generator (portable and repeatable).
+                seed = seed * 1103515245u + 12345u;
+
+                // Blocks of speed 0.25, 0.75 or 1.25, with +/-10% noise.
+                double f = 0.25 + 0.5 * ((i0 / 16 + i1 / 16 + i2 / 16) % 3);
+                double e = (double)((seed >> 16) & 0xFF) / 255.0 - 0.5;
+
+                speed(i0, i1, i2) = (_Speed)(f * (1.0 + 0.2 * e));
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+///  Times one priority queue of fast_marching3 on a speed map.
+///
+///  @param  time     The output arrival time array.
+///  @param  speed    The speed array.
+///  @param  queue    The queue type.
+///  @param  repeats  Number of solve rounds (default: 1).
+///
+///  @return The average solve time in seconds.
+///
+///////////////////////////////////////////////////////////////////////////
+template <typename _Time>
+double benchmark_fast_marching(
+    array<_Time>&                                   time,
+    const array<_Time>&                             speed,
+    typename fast_marching3<_Time, _Time>::queue_type
+                                                    queue,
+    unsigned int                                    repeats = 1
+    )
+{
+    typedef fast_marching3<_Time, _Time>    solver_type;
+    typedef typename solver_type::node_type node_type;
+
+    double total = 0;
+
+    if (repeats == 0) repeats = 1;
+
+    for (unsigned int r = 0; r < repeats; ++r) {
+        solver_type solver;
+        node_type   node;
+
+        solver.set_queue(queue);
+        solver.create(time, &speed);
+
+        node.value    = 0;
+        node.index[0] = speed.size_0() / 2;
+        node.index[1] = speed.size_1() / 2;
+        node.index[2] = speed.size_2() / 2;
+        solver.trial_nodes().push_back(node);
+
+        timer t;
+        solver.solve();
+        total += t.elapsed();
+    }
+
+    return total / repeats;
+}
+
+///////////////////////////////////////////////////////////////////////////
+///  Compares the binary heap, the indexed heap and the untidy queue of
+///  fast_marching3 on the synthetic speed map and prints the results.
+///
+///  @param  os       The output stream.
+///  @param  s0       The size of the first  dimension of the map.
+///  @param  s1       The size of the second dimension of the map.
+///  @param  s2       The size of the third  dimension of the map.
+///  @param  repeats  Number of solve rounds (default: 1).
+///
+///  @return Returns true if the two heaps produced the same times (up to
+///          a relative rounding error of 1e-3).
+///
+///////////////////////////////////////////////////////////////////////////
+inline bool compare_fast_marching_queues(std::ostream& os,
+                                         size_t        s0,
+                                         size_t        s1,
+                                         size_t        s2,
+                                         unsigned int  repeats = 1
+                                         )
+{
+    typedef fast_marching3<float, float>    solver_type;
+
+    array<float> speed, t_ref, t_cmp;
+    double       err_heap = 0, err_untidy = 0, sum_untidy = 0, t_max = 0;
+
+    build_fast_marching_bench_speed(speed, s0, s1, s2);
+    t_ref.create(s0, s1, s2);
+    t_cmp.create(s0, s1, s2);
+
+    double t_binary = benchmark_fast_marching(t_ref, speed,
+        solver_type::BINARY_HEAP, repeats);
+
+    double t_indexed = benchmark_fast_marching(t_cmp, speed,
+        solver_type::INDEXED_HEAP, repeats);
+
+    for (size_t i = 0; i < t_ref.size(); ++i) {
+        double d = (double)t_cmp.data()[i] - (double)t_ref.data()[i];
+        if (d < 0) d = -d;
+        if (d > err_heap) err_heap = d;
+        if (t_ref.data()[i] > t_max) t_max = t_ref.data()[i];
+    }
+
+    double t_untidy = benchmark_fast_marching(t_cmp, speed,
+        solver_type::UNTIDY_QUEUE, repeats);
+
+    for (size_t i = 0; i < t_ref.size(); ++i) {
+        double d = (double)t_cmp.data()[i] - (double)t_ref.data()[i];
+        if (d < 0) d = -d;
+        if (d > err_untidy) err_untidy = d;
+        sum_untidy += d;
+    }
+
+    os << "fast marching benchmark " << s0 << "x" << s1 << "x" << s2 << "\n"
+       << "  binary heap : " << t_binary  << " s\n"
+       << "  indexed heap: " << t_indexed << " s, max |dt| "
+       << err_heap << "\n"
+       << "  untidy queue: " << t_untidy  << " s, max |dt| "
+       << err_untidy << ", mean |dt| " << sum_untidy / t_ref.size() << "\n"
+       << "  max time    : " << t_max << "\n";
+
+    // The heaps differ only by the rounding of ties.
+    return err_heap <= 1e-3 * t_max;
+}
+
+    } // namespace
+} // namespace
+
+#endif
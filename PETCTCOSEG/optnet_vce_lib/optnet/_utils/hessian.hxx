@@ -32,7 +32,10 @@
 #   include <optnet/_base/array_ref.hxx>
 #   include <optnet/_utils/gaussian.hxx>
 #   include <optnet/_utils/index.hxx>
+#   include <algorithm>
 #   include <cassert>
+#   include <cstring>
+#   include <vector>
 
 /// @namespace optnet
 namespace optnet {
@@ -60,6 +63,8 @@ public:
     typedef _Tx                             input_value_type;
     typedef _Ty                             output_value_type;
 
+    typedef optnet::array<_Ty, _Tg>         output_array_type;
+
     /// Flags selecting which output values be computed.
     enum   output_flag
     {
@@ -399,8 +404,12 @@ public:
 
         if (flags & COMPUTE_EIGEN) {
 
-            // Compute eigen values/vectors of hessian matrix.
-            jacobi(info.hessian_matrix,
+            // Compute eigen values/vectors of hessian matrix (on a copy,
+            // as jacobi() overwrites its input).
+            output_value_type a[_HESSIAN_SIZE][_HESSIAN_SIZE];
+            memcpy(a, info.hessian_matrix, sizeof(a));
+
+            jacobi(a,
                 info.eigen_vectors,
                 info.eigen_values
                 );
@@ -422,10 +431,298 @@ public:
     ///
     //////////////////////////////////////////////////////////////////////////
     inline const output_value_type& scale() const { return m_scale; }
-    
+
+    //////////////////////////////////////////////////////////////////////////
+    ///  Computes the gradients, the hessian matrices and/or their eigen
+    ///  values at every point of the input image.
+    ///
+    ///  @param[out] p_gradients     If not NULL, receives the gradients
+    ///                              (size_0 x size_1 x size_2 x 3).
+    ///  @param[out] p_hessian       If not NULL, receives the hessian
+    ///                              matrices as (d00, d11, d22, d01, d02,
+    ///                              d12) along the fourth dimension.
+    ///  @param[out] p_eigen_values  If not NULL, receives the eigen values
+    ///                              in nonascending order (x 3).
+    ///
+    ///  @remarks The values are those of compute_at (same kernels and
+    ///           boundary conditions), but the derivatives are obtained
+    ///           with separable 1-D passes over cache-sized tiles, which
+    ///           are processed concurrently when OpenMP is available. The
+    ///           eigen values are computed in closed form; use compute_at
+    ///           if the eigen vectors are needed.
+    //////////////////////////////////////////////////////////////////////////
+    void compute(output_array_type* p_gradients,
+                 output_array_type* p_hessian,
+                 output_array_type* p_eigen_values = 0
+                 ) const
+    {
+        assert(0 != m_input);
+        assert(0 != m_gsize);
+
+        size_type s0 = m_input->size_0();
+        size_type s1 = m_input->size_1();
+        size_type s2 = m_input->size_2();
+
+        if (static_cast<size_type>(m_gsize) > s0 ||
+            static_cast<size_type>(m_gsize) > s1 ||
+            static_cast<size_type>(m_gsize) > s2)
+        {
+            throw_exception(std::range_error(
+                "hessian::compute: Index out of range."
+                ));
+        }
+
+        if (0 != p_gradients)    p_gradients->create(s0, s1, s2, 3);
+        if (0 != p_hessian)      p_hessian->create(s0, s1, s2, 6);
+        if (0 != p_eigen_values) p_eigen_values->create(s0, s1, s2, 3);
+
+        if (0 == p_gradients && 0 == p_hessian && 0 == p_eigen_values)
+            return;
+
+        int n0 = (int)((s0 + TILE_0 - 1) / TILE_0);
+        int n1 = (int)((s1 + TILE_1 - 1) / TILE_1);
+        int n2 = (int)((s2 + TILE_2 - 1) / TILE_2);
+        int nt = n0 * n1 * n2;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        {
+            tile_buffer buf;
+            int         t;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp for schedule(dynamic)
+    #endif
+            for (t = 0; t < nt; ++t) {
+                size_type b[3];
+                b[0] = (size_type)(t % n0) * TILE_0;
+                b[1] = (size_type)((t / n0) % n1) * TILE_1;
+                b[2] = (size_type)(t / (n0 * n1)) * TILE_2;
+                compute_tile(b, buf, p_gradients, p_hessian, p_eigen_values);
+            }
+        }
+    }
+
 
 private:
-    
+
+    // Tile sizes of compute().
+    enum { TILE_0 = 64, TILE_1 = 32, TILE_2 = 32 };
+
+    // Per-thread scratch buffers of compute().
+    struct tile_buffer
+    {
+        std::vector<output_value_type> in;      // Padded input tile.
+        std::vector<output_value_type> z[3];    // After the i2 pass.
+        std::vector<output_value_type> y[6];    // After the i1 pass.
+        std::vector<output_value_type> row[9];  // After the i0 pass.
+        std::vector<int>               idx[3];  // Mirrored indices.
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    // out[x] = sum_k g[k] * in[x + k * stride], x in [0, n).
+    // The loop is unrolled by four so that it is vectorized at -O2 too.
+    static inline void correlate(output_value_type* OPTNET_RESTRICT       out,
+                                 const output_value_type* OPTNET_RESTRICT in,
+                                 const output_value_type*                 g,
+                                 int                                      gsize,
+                                 size_type                                stride,
+                                 size_type                                n
+                                 )
+    {
+        size_type x, n4 = n & ~(size_type)3;
+        for (x = 0; x < n; ++x) out[x] = 0;
+        for (int k = 0; k < gsize; ++k, in += stride) {
+            const output_value_type w = g[k];
+            for (x = 0; x < n4; x += 4) {
+                out[x    ] += w * in[x    ];
+                out[x + 1] += w * in[x + 1];
+                out[x + 2] += w * in[x + 2];
+                out[x + 3] += w * in[x + 3];
+            }
+            for (; x < n; ++x) out[x] += w * in[x];
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Computes the outputs of compute() in the tile starting at b.
+    void compute_tile(const size_type*   b,
+                      tile_buffer&       buf,
+                      output_array_type* p_gradients,
+                      output_array_type* p_hessian,
+                      output_array_type* p_eigen_values
+                      ) const
+    {
+        const array_base_type& input = *m_input;
+        const size_type        sz[3] = {
+            input.size_0(), input.size_1(), input.size_2()
+        };
+        const size_type        tile[3] = { TILE_0, TILE_1, TILE_2 };
+        const size_type        h  = (size_type)m_ghalf;
+        const bool             dh = (0 != p_hessian || 0 != p_eigen_values);
+        const bool             dg = (0 != p_gradients);
+
+        size_type t[3], p[3], d, x, y, z;
+
+        for (d = 0; d < 3; ++d) {
+            t[d] = (b[d] + tile[d] > sz[d]) ? sz[d] - b[d] : tile[d];
+            p[d] = t[d] + 2 * h;
+            buf.idx[d].resize(p[d]);
+            for (x = 0; x < p[d]; ++x) {
+                buf.idx[d][x] = index_symmetric(
+                    (int)(b[d] + x) - (int)h, (int)sz[d]);
+            }
+        }
+
+        // Gather the padded input tile (mirrored at the image boundary).
+        const size_type step0 = input.offset(1, 0, 0) - input.offset(0, 0, 0);
+        const size_type plane = p[0] * p[1], zrows = p[0] * p[1] * t[2];
+        const size_type yrows = p[0] * t[1] * t[2];
+
+        buf.in.resize(plane * p[2]);
+        for (z = 0; z < p[2]; ++z) {
+            for (y = 0; y < p[1]; ++y) {
+                const input_value_type* src = input.data()
+                    + input.offset(0, buf.idx[1][y], buf.idx[2][z]);
+                output_value_type* dst = &buf.in[(z * p[1] + y) * p[0]];
+                for (x = 0; x < p[0]; ++x) {
+                    dst[x] = (output_value_type)src[buf.idx[0][x] * step0];
+                }
+            }
+        }
+
+        // Pass along i2: z[c] = g_c (*) in, for the kernels c in use.
+        const int nz = dh ? 3 : 2;
+        for (int c = 0; c < nz; ++c) {
+            buf.z[c].resize(zrows);
+            for (z = 0; z < t[2]; ++z) {
+                correlate(&buf.z[c][z * plane], &buf.in[z * plane],
+                          m_gauss[c], m_gsize, plane, plane);
+            }
+        }
+
+        // Pass along i1. The i2/i1 kernel orders of the y buffers are:
+        //   y[0] = (0, 0), y[1] = (0, 1), y[2] = (0, 2),
+        //   y[3] = (1, 0), y[4] = (1, 1), y[5] = (2, 0).
+        static const int YZ[6] = { 0, 0, 0, 1, 1, 2 };
+        static const int YY[6] = { 0, 1, 2, 0, 1, 0 };
+        for (int c = 0; c < 6; ++c) {
+            if (!dh && (c == 2 || c == 4 || c == 5)) continue;
+            buf.y[c].resize(yrows);
+            for (z = 0; z < t[2]; ++z) {
+                for (y = 0; y < t[1]; ++y) {
+                    correlate(&buf.y[c][(z * t[1] + y) * p[0]],
+                              &buf.z[YZ[c]][z * plane + y * p[0]],
+                              m_gauss[YY[c]], m_gsize, p[0], p[0]);
+                }
+            }
+        }
+
+        // Pass along i0. The outputs are rows of
+        //   0: d0, 1: d1, 2: d2, 3: d00, 4: d11, 5: d22,
+        //   6: d01, 7: d02, 8: d12,
+        // as (y buffer, i0 kernel) pairs.
+        static const int RY[9] = { 0, 1, 3, 0, 2, 5, 1, 3, 4 };
+        static const int RX[9] = { 1, 0, 0, 2, 0, 0, 1, 1, 0 };
+        for (int c = 0; c < 9; ++c) buf.row[c].resize(t[0]);
+
+        for (z = 0; z < t[2]; ++z) {
+            for (y = 0; y < t[1]; ++y) {
+                size_type r = (z * t[1] + y) * p[0];
+
+                for (int c = (dg ? 0 : 3); c < (dh ? 9 : 3); ++c) {
+                    correlate(&buf.row[c][0], &buf.y[RY[c]][r],
+                              m_gauss[RX[c]], m_gsize, 1, t[0]);
+                }
+
+                size_type i1 = b[1] + y, i2 = b[2] + z;
+
+                if (dg) {
+                    for (int k = 0; k < 3; ++k) {
+                        store_row(*p_gradients, b[0], i1, i2, k,
+                                  &buf.row[k][0], t[0]);
+                    }
+                }
+                if (0 != p_hessian) {
+                    for (int k = 0; k < 6; ++k) {
+                        store_row(*p_hessian, b[0], i1, i2, k,
+                                  &buf.row[k + 3][0], t[0]);
+                    }
+                }
+                if (0 != p_eigen_values) {
+                    output_value_type* e0 = &(*p_eigen_values)(b[0], i1, i2, 0);
+                    output_value_type* e1 = &(*p_eigen_values)(b[0], i1, i2, 1);
+                    output_value_type* e2 = &(*p_eigen_values)(b[0], i1, i2, 2);
+                    size_type step = p_eigen_values->offset(1, 0, 0, 0)
+                                   - p_eigen_values->offset(0, 0, 0, 0);
+                    double    a[6], e[3];
+
+                    for (x = 0; x < t[0]; ++x) {
+                        for (int k = 0; k < 6; ++k) a[k] = buf.row[k + 3][x];
+                        eigen_values_sym3(a, e);
+                        e0[x * step] = (output_value_type)e[0];
+                        e1[x * step] = (output_value_type)e[1];
+                        e2[x * step] = (output_value_type)e[2];
+                    }
+                }
+            } // for y
+        } // for z
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Copies n values to the row of out starting at (i0, i1, i2, i3).
+    static inline void store_row(output_array_type&       out,
+                                 size_type                i0,
+                                 size_type                i1,
+                                 size_type                i2,
+                                 size_type                i3,
+                                 const output_value_type* src,
+                                 size_type                n
+                                 )
+    {
+        output_value_type* dst  = &out(i0, i1, i2, i3);
+        size_type          step = out.offset(1, 0, 0, 0) - out.offset(0, 0, 0, 0);
+
+        for (size_type x = 0; x < n; ++x) dst[x * step] = src[x];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Eigen values (in nonascending order) of the symmetric 3x3 matrix
+    // (a00, a11, a22, a01, a02, a12), by the trigonometric solution of the
+    // characteristic equation (Smith, Commun ACM 1961).
+    static void eigen_values_sym3(const double* a, double* e)
+    {
+        double p1 = a[3] * a[3] + a[4] * a[4] + a[5] * a[5];
+        double q  = (a[0] + a[1] + a[2]) / 3.0;
+
+        if (p1 == 0.0) {
+            // Diagonal matrix.
+            e[0] = a[0]; e[1] = a[1]; e[2] = a[2];
+            if (e[0] < e[1]) std::swap(e[0], e[1]);
+            if (e[1] < e[2]) std::swap(e[1], e[2]);
+            if (e[0] < e[1]) std::swap(e[0], e[1]);
+            return;
+        }
+
+        double b0 = a[0] - q, b1 = a[1] - q, b2 = a[2] - q;
+        double p  = sqrt((b0 * b0 + b1 * b1 + b2 * b2 + 2.0 * p1) / 6.0);
+
+        // r = det((A - qI) / p) / 2
+        double r  = (b0 * (b1 * b2 - a[5] * a[5])
+                   - a[3] * (a[3] * b2 - a[5] * a[4])
+                   + a[4] * (a[3] * a[5] - b1 * a[4])) / (2.0 * p * p * p);
+
+        double phi;
+        if (r <= -1.0)     phi = 3.14159265358979323846 / 3.0;
+        else if (r >= 1.0) phi = 0.0;
+        else               phi = acos(r) / 3.0;
+
+        e[0] = q + 2.0 * p * cos(phi);
+        e[2] = q + 2.0 * p * cos(phi + 2.0 * 3.14159265358979323846 / 3.0);
+        e[1] = 3.0 * q - e[0] - e[2];
+    }
+
     //////////////////////////////////////////////////////////////////////////
     void init()
     {
@@ -33,6 +33,7 @@
 #   include <optnet/_base/array.hxx>
 #   include <limits>
 #   include <cmath>
+#   include <vector>
 
 /// @namespace optnet
 namespace optnet {
@@ -92,8 +93,7 @@ public:
     {
         int                 npole = 0;
         double              poles[2];
-        size_type           i0, i1, i2;
-        real_value_type*    pline;
+        int                 s0, s1, s2, i1, i2, l;
         
         // recover the poles from a lookup table
         switch (order) {
@@ -130,43 +130,71 @@ public:
         
         // allocate coefficient array
         m_coeff.create(a.size_0(), a.size_1(), a.size_2());
-        
-        // convert the image samples into interpolation coefficients
+
+        s0 = (int)a.size_0();
+        s1 = (int)a.size_1();
+        s2 = (int)a.size_2();
+
+        // convert the image samples into interpolation coefficients;
+        // the lines along i2 and i1 are filtered in blocks of BLOCK
+        // neighboring lines, stored interleaved (one block row per
+        // sample), so that they are read and written row by row
         // -- i2
-        pline = new real_value_type[a.size_2()];
-        for (i1 = 0; i1 < a.size_1(); ++i1) {
-            for (i0 = 0; i0 < a.size_0(); ++i0) {
-                for (i2 = 0; i2 < a.size_2(); ++i2)
-                    pline[i2] = a(i0, i1, i2);
-                convert_to_coeff(pline, (int)a.size_2(), poles, npole);
-                for (i2 = 0; i2 < a.size_2(); ++i2)
-                    m_coeff(i0, i1, i2) = pline[i2];
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(i1) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (i1 = 0; i1 < s1; ++i1) {
+            std::vector<real_value_type> block(s2 * BLOCK);
+            for (int b0 = 0; b0 < s0; b0 += BLOCK) {
+                int nb = (s0 - b0 < BLOCK) ? s0 - b0 : BLOCK;
+                for (int n = 0; n < s2; ++n) {
+                    for (int b = 0; b < nb; ++b)
+                        block[n * BLOCK + b] = (real_value_type)a(b0 + b, i1, n);
+                }
+                convert_to_coeff_block(&block[0], s2, nb, poles, npole);
+                for (int n = 0; n < s2; ++n) {
+                    real_value_type* pline = &(m_coeff(b0, i1, n));
+                    for (int b = 0; b < nb; ++b)
+                        pline[b] = block[n * BLOCK + b];
+                }
             }
         }
-        delete [] pline;
-
-       // -- i1
-        pline = new real_value_type[a.size_1()];
-        for (i2 = 0; i2 < a.size_2(); ++i2) {
-            for (i0 = 0; i0 < a.size_0(); ++i0) {
-                for (i1 = 0; i1 < a.size_1(); ++i1)
-                    pline[i1] = m_coeff(i0, i1, i2);
-                convert_to_coeff(pline, (int)a.size_1(), poles, npole);
-                for (i1 = 0; i1 < a.size_1(); ++i1)
-                    m_coeff(i0, i1, i2) = pline[i1];
+
+        // -- i1
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(i2) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (i2 = 0; i2 < s2; ++i2) {
+            std::vector<real_value_type> block(s1 * BLOCK);
+            for (int b0 = 0; b0 < s0; b0 += BLOCK) {
+                int nb = (s0 - b0 < BLOCK) ? s0 - b0 : BLOCK;
+                for (int n = 0; n < s1; ++n) {
+                    const real_value_type* pline = &(m_coeff(b0, n, i2));
+                    for (int b = 0; b < nb; ++b)
+                        block[n * BLOCK + b] = pline[b];
+                }
+                convert_to_coeff_block(&block[0], s1, nb, poles, npole);
+                for (int n = 0; n < s1; ++n) {
+                    real_value_type* pline = &(m_coeff(b0, n, i2));
+                    for (int b = 0; b < nb; ++b)
+                        pline[b] = block[n * BLOCK + b];
+                }
             }
         }
-        delete [] pline;
 
         // --i0
-        for (i2 = 0; i2 < a.size_2(); ++i2) {
-            for (i1 = 0; i1 < a.size_1(); ++i1) {
-                convert_to_coeff(
-                    &(m_coeff(0, i1, i2)), 
-                    (int)a.size_0(), 
-                    poles, npole
-                );
-            }
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for private(l) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (l = 0; l < s1 * s2; ++l) {
+            convert_to_coeff(
+                &(m_coeff(0, l % s1, l / s1)), 
+                s0, 
+                poles, npole
+            );
         }
 
         m_order = order;
@@ -186,204 +214,225 @@ public:
                            const real_value_type& i2
                            )
     {
-        double  w, w2, w4, t, t0, t1;
+        double  w, w2;
         double  weights[3][6];
         int     indices[3][6];
-        int     ss0, ss1, ss2, s0, s1, s2;
-        int     n, i, j, k;
+        int     i, j, k;
         double  ans;
 
-        s0  = (int)m_coeff.size_0();
-        s1  = (int)m_coeff.size_1();
-        s2  = (int)m_coeff.size_2();
-        ss1 = s1 * 2 - 2;
-        ss0 = s0 * 2 - 2;
-        ss2 = s2 * 2 - 2;
+        get_weights(i0, (int)m_coeff.size_0(), indices[0], weights[0]);
+        get_weights(i1, (int)m_coeff.size_1(), indices[1], weights[1]);
+        get_weights(i2, (int)m_coeff.size_2(), indices[2], weights[2]);
 
-        // compute the interpolation indexes
-        if (m_order & 1)  { // odd
-            i = (int)floor(i0) - m_order / 2;
-            j = (int)floor(i1) - m_order / 2;
-            k = (int)floor(i2) - m_order / 2;
-            for (n = 0; n <= m_order; ++n) {
-                indices[0][n] = i++;
-                indices[1][n] = j++;
-                indices[2][n] = k++;
+        // perform interpolation
+        ans = 0.0;
+
+        for (k = 0; k <= m_order; ++k) {
+            w2 = 0.0;
+            for (j = 0; j <= m_order; ++j) {
+                w = 0.0;
+                for (i = 0; i <= m_order; ++i)
+                    w += weights[0][i] * m_coeff(indices[0][i],
+                                                 indices[1][j],
+                                                 indices[2][k]
+                                                 );
+                w2 += weights[1][j] * w;
+            }
+            ans += weights[2][k] * w2;
+        }
+        return (real_value_type)ans;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Performs the interpolation at all points of a regular grid.
+    ///
+    ///  @param[out] out     The output array; its sizes define the grid.
+    ///  @param      origin  The coordinates of the grid point (0, 0, 0)
+    ///                      in the input image.
+    ///  @param      step    The spacing of the grid along each axis, in
+    ///                      input samples.
+    ///
+    ///  @remarks The grid is aligned with the input axes, so the weights
+    ///           along each axis are computed once per grid index. For
+    ///           each output row (fixed j1 and j2), the coefficients are
+    ///           first summed along i2 and i1 into a line that is then
+    ///           interpolated along i0. The rows are processed
+    ///           concurrently when OpenMP is available.
+    ///////////////////////////////////////////////////////////////////////
+    template <typename _Tout, typename _Tgo>
+    void interpolate_grid(optnet::array_base<_Tout, _Tgo>& out,
+                          const double*                    origin,
+                          const double*                    step
+                          ) const
+    {
+        const int           n = m_order + 1;
+        const int           s[3] = {
+            (int)m_coeff.size_0(),
+            (int)m_coeff.size_1(),
+            (int)m_coeff.size_2()
+        };
+        const int           sz[3] = {
+            (int)out.size_0(), (int)out.size_1(), (int)out.size_2()
+        };
+        std::vector<int>    indices[3];
+        std::vector<double> weights[3];
+        int                 d, j, lo = s[0], hi = 0, r;
+
+        if (0 == m_coeff.size()) {
+            throw_exception(
+                std::runtime_error(
+                    "interp_bspline3::interpolate_grid: Not created.")
+                );
+        }
+
+        for (d = 0; d < 3; ++d) {
+            indices[d].resize(sz[d] * n);
+            weights[d].resize(sz[d] * n);
+            for (j = 0; j < sz[d]; ++j) {
+                get_weights(origin[d] + j * step[d], s[d],
+                            &indices[d][j * n], &weights[d][j * n]);
             }
         }
-        else {              // even
-            i = (int)floor(i0 + 0.5) - m_order / 2;
-            j = (int)floor(i1 + 0.5) - m_order / 2;
-            k = (int)floor(i2 + 0.5) - m_order / 2;
-            for (n = 0; n <= m_order; ++n) {
-                indices[0][n] = i++;
-                indices[1][n] = j++;
-                indices[2][n] = k++;
+
+        // the range of i0 used by the grid
+        for (j = 0; j < sz[0] * n; ++j) {
+            if (indices[0][j] < lo) lo = indices[0][j];
+            if (indices[0][j] > hi) hi = indices[0][j];
+        }
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel private(r) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        {
+            std::vector<double> line(s[0]);
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp for
+    #endif
+            for (r = 0; r < sz[1] * sz[2]; ++r) {
+                int           j1 = r % sz[1], j2 = r / sz[1];
+                const int*    k1 = &indices[1][j1 * n];
+                const int*    k2 = &indices[2][j2 * n];
+                const double* w1 = &weights[1][j1 * n];
+                const double* w2 = &weights[2][j2 * n];
+                int           i, j0, k, l;
+
+                // sum the coefficients along i2 and i1
+                for (i = lo; i <= hi; ++i) line[i] = 0.0;
+                for (k = 0; k < n; ++k) {
+                    for (l = 0; l < n; ++l) {
+                        const double           w = w2[k] * w1[l];
+                        const real_value_type* c = &(m_coeff(0, k1[l], k2[k]));
+                        for (i = lo; i <= hi; ++i) line[i] += w * c[i];
+                    }
+                }
+
+                // interpolate along i0
+                for (j0 = 0; j0 < sz[0]; ++j0) {
+                    const int*    k0 = &indices[0][j0 * n];
+                    const double* w0 = &weights[0][j0 * n];
+                    double        ans = 0.0;
+                    for (i = 0; i < n; ++i) ans += w0[i] * line[k0[i]];
+                    out(j0, j1, j2) = (_Tout)ans;
+                }
             }
         }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    ///  Free the lookup table and set the order to zero.
+    //////////////////////////////////////////////////////////////////////////
+    void release()
+    {
+        m_coeff.release();
+        m_order = 0;
+    }
+
+protected:
+
+    // Number of lines filtered together along i1 and i2 in create().
+    enum { BLOCK = 16 };
+
+    //////////////////////////////////////////////////////////////////////////
+    // Computes the m_order + 1 interpolation weights and the (mirrored)
+    // coefficient indices of the coordinate x along an axis of size s.
+    void get_weights(double x, int s, int* indices, double* weights) const
+    {
+        double  w, w2, w4, t, t0, t1;
+        int     n, i, ss = s * 2 - 2;
+
+        // compute the interpolation indexes
+        if (m_order & 1)    // odd
+            i = (int)floor(x) - m_order / 2;
+        else                // even
+            i = (int)floor(x + 0.5) - m_order / 2;
+        for (n = 0; n <= m_order; ++n)
+            indices[n] = i++;
+
         switch (m_order) {
         case 3:
-            w = i0 - (double) indices[0][1];
-            weights[0][3] = (1.0 / 6.0) * w * w * w;
-            weights[0][0] = (1.0 / 6.0) + 0.5 * w * (w - 1.0) - weights[0][3];
-            weights[0][2] = w + weights[0][0] - 2.0 * weights[0][3];
-            weights[0][1] = 1.0 - weights[0][0] - weights[0][2] - weights[0][3];
-
-            w = i1 - (double) indices[1][1];
-            weights[1][3] = (1.0 / 6.0) * w * w * w;
-            weights[1][0] = (1.0 / 6.0) + 0.5 * w * (w - 1.0) - weights[1][3];
-            weights[1][2] = w + weights[1][0] - 2.0 * weights[1][3];
-            weights[1][1] = 1.0 - weights[1][0] - weights[1][2] - weights[1][3];
-
-            w = i2 - (double) indices[2][1];
-            weights[2][3] = (1.0 / 6.0) * w * w * w;
-            weights[2][0] = (1.0 / 6.0) + 0.5 * w * (w - 1.0) - weights[2][3];
-            weights[2][2] = w + weights[2][0] - 2.0 * weights[2][3];
-            weights[2][1] = 1.0 - weights[2][0] - weights[2][2] - weights[2][3];
+            w = x - (double) indices[1];
+            weights[3] = (1.0 / 6.0) * w * w * w;
+            weights[0] = (1.0 / 6.0) + 0.5 * w * (w - 1.0) - weights[3];
+            weights[2] = w + weights[0] - 2.0 * weights[3];
+            weights[1] = 1.0 - weights[0] - weights[2] - weights[3];
             break;
 
         case 0:
             // implements nearest neighbor
-            weights[0][0] = 1;
-            weights[1][0] = 1;
-            weights[2][0] = 1;
+            weights[0] = 1;
             break;
 
         case 1:
-            w = i0 - (double) indices[0][0];
-            weights[0][1] = w;
-            weights[0][0] = 1.0 - w;
-
-            w = i1 - (double) indices[1][0];
-            weights[1][1] = w;
-            weights[1][0] = 1.0 - w;
-
-            w = i2 - (double) indices[2][0];
-            weights[2][1] = w;
-            weights[2][0] = 1.0 - w;
+            w = x - (double) indices[0];
+            weights[1] = w;
+            weights[0] = 1.0 - w;
             break;
 
         case 2:
-            w = i0 - (double) indices[0][1];
-            weights[0][1] = 0.75 - w * w;
-            weights[0][2] = 0.5 * (w - weights[0][1] + 1.0);
-            weights[0][0] = 1.0 - weights[0][1] - weights[0][2];
-
-            w = i1 - (double) indices[1][1];
-            weights[1][1] = 0.75 - w * w;
-            weights[1][2] = 0.5 * (w - weights[1][1] + 1.0);
-            weights[1][0] = 1.0 - weights[1][1] - weights[1][2];
-
-            w = i2 - (double) indices[2][1];
-            weights[2][1] = 0.75 - w * w;
-            weights[2][2] = 0.5 * (w - weights[2][1] + 1.0);
-            weights[2][0] = 1.0 - weights[2][1] - weights[2][2];
+            w = x - (double) indices[1];
+            weights[1] = 0.75 - w * w;
+            weights[2] = 0.5 * (w - weights[1] + 1.0);
+            weights[0] = 1.0 - weights[1] - weights[2];
             break;
 
         case 4:
-            w = i0 - (double) indices[0][2];
-            w2 = w * w;
-            t = (1.0 / 6.0) * w2;
-            weights[0][0] = 0.5 - w;
-            weights[0][0] *= weights[0][0];
-            weights[0][0] *= (1.0 / 24.0) * weights[0][0];
-            t0 = w * (t - 11.0 / 24.0);
-            t1 = 19.0 / 96.0 + w2 * (0.25 - t);
-            weights[0][1] = t1 + t0;
-            weights[0][3] = t1 - t0;
-            weights[0][4] = weights[0][0] + t0 + 0.5 * w;
-            weights[0][2] = 1.0 -
-                weights[0][0] -
-                weights[0][1] -
-                weights[0][3] -
-                weights[0][4];
-
-            w = i1 - (double) indices[1][2];
+            w = x - (double) indices[2];
             w2 = w * w;
             t = (1.0 / 6.0) * w2;
-            weights[1][0] = 0.5 - w;
-            weights[1][0] *= weights[1][0];
-            weights[1][0] *= (1.0 / 24.0) * weights[1][0];
+            weights[0] = 0.5 - w;
+            weights[0] *= weights[0];
+            weights[0] *= (1.0 / 24.0) * weights[0];
             t0 = w * (t - 11.0 / 24.0);
             t1 = 19.0 / 96.0 + w2 * (0.25 - t);
-            weights[1][1] = t1 + t0;
-            weights[1][3] = t1 - t0;
-            weights[1][4] = weights[1][0] + t0 + 0.5 * w;
-            weights[1][2] = 1.0 -
-                weights[1][0] -
-                weights[1][1] -
-                weights[1][3] -
-                weights[1][4];
-
-            w = i2 - (double) indices[2][2];
-            w2 = w * w;
-            t = (1.0 / 6.0) * w2;
-            weights[2][0] = 0.5 - w;
-            weights[2][0] *= weights[2][0];
-            weights[2][0] *= (1.0 / 24.0) * weights[2][0];
-            t0 = w * (t - 11.0 / 24.0);
-            t1 = 19.0 / 96.0 + w2 * (0.25 - t);
-            weights[2][1] = t1 + t0;
-            weights[2][3] = t1 - t0;
-            weights[2][4] = weights[2][0] + t0 + 0.5 * w;
-            weights[2][2] = 1.0 -
-                weights[2][0] -
-                weights[2][1] -
-                weights[2][3] -
-                weights[2][4];
+            weights[1] = t1 + t0;
+            weights[3] = t1 - t0;
+            weights[4] = weights[0] + t0 + 0.5 * w;
+            weights[2] = 1.0 -
+                weights[0] -
+                weights[1] -
+                weights[3] -
+                weights[4];
             break;
 
         case 5:
-            w = i0 - (double) indices[0][2];
+            w = x - (double) indices[2];
             w2 = w * w;
-            weights[0][5] = (1.0 / 120.0) * w * w2 * w2;
+            weights[5] = (1.0 / 120.0) * w * w2 * w2;
             w2 -= w;
             w4 = w2 * w2;
             w -= 0.5;
             t = w2 * (w2 - 3.0);
-            weights[0][0] = (1.0 / 24.0) * (1.0 / 5.0 + w2 + w4) - weights[0][5];
+            weights[0] = (1.0 / 24.0) * (1.0 / 5.0 + w2 + w4) - weights[5];
             t0 = (1.0 / 24.0) * (w2 * (w2 - 5.0) + 46.0 / 5.0);
             t1 = (-1.0 / 12.0) * w * (t + 4.0);
-            weights[0][2] = t0 + t1;
-            weights[0][3] = t0 - t1;
+            weights[2] = t0 + t1;
+            weights[3] = t0 - t1;
             t0 = (1.0 / 16.0) * (9.0 / 5.0 - t);
             t1 = (1.0 / 24.0) * w * (w4 - w2 - 5.0);
-            weights[0][1] = t0 + t1;
-            weights[0][4] = t0 - t1;
-
-            w = i1 - (double) indices[1][2];
-            w2 = w * w;
-            weights[1][5] = (1.0 / 120.0) * w * w2 * w2;
-            w2 -= w;
-            w4 = w2 * w2;
-            w -= 0.5;
-            t = w2 * (w2 - 3.0);
-            weights[1][0] = (1.0 / 24.0) * (1.0 / 5.0 + w2 + w4) - weights[1][5];
-            t0 = (1.0 / 24.0) * (w2 * (w2 - 5.0) + 46.0 / 5.0);
-            t1 = (-1.0 / 12.0) * w * (t + 4.0);
-            weights[1][2] = t0 + t1;
-            weights[1][3] = t0 - t1;
-            t0 = (1.0 / 16.0) * (9.0 / 5.0 - t);
-            t1 = (1.0 / 24.0) * w * (w4 - w2 - 5.0);
-            weights[1][1] = t0 + t1;
-            weights[1][4] = t0 - t1;
-
-            w = i2 - (double) indices[2][2];
-            w2 = w * w;
-            weights[2][5] = (1.0 / 120.0) * w * w2 * w2;
-            w2 -= w;
-            w4 = w2 * w2;
-            w -= 0.5;
-            t = w2 * (w2 - 3.0);
-            weights[2][0] = (1.0 / 24.0) * (1.0 / 5.0 + w2 + w4) - weights[2][5];
-            t0 = (1.0 / 24.0) * (w2 * (w2 - 5.0) + 46.0 / 5.0);
-            t1 = (-1.0 / 12.0) * w * (t + 4.0);
-            weights[2][2] = t0 + t1;
-            weights[2][3] = t0 - t1;
-            t0 = (1.0 / 16.0) * (9.0 / 5.0 - t);
-            t1 = (1.0 / 24.0) * w * (w4 - w2 - 5.0);
-            weights[2][1] = t0 + t1;
-            weights[2][4] = t0 - t1;
+            weights[1] = t0 + t1;
+            weights[4] = t0 - t1;
             break;
 
         default:
@@ -391,61 +440,99 @@ public:
         }
 
         // apply the mirror boundary conditions
-        for (k = 0; k <= m_order; ++k) {
-            indices[0][k] = (s0 == 1) ? (0) :
+        for (n = 0; n <= m_order; ++n) {
+            indices[n] = (s == 1) ? (0) :
                 (
-                    (indices[0][k] < 0) ?
-                        (-indices[0][k] - ss0 * ((-indices[0][k]) / ss0)) :
-                            (indices[0][k] - ss0 * (indices[0][k] / ss0))
+                    (indices[n] < 0) ?
+                        (-indices[n] - ss * ((-indices[n]) / ss)) :
+                            (indices[n] - ss * (indices[n] / ss))
                 );
-            if (s0 <= indices[0][k]) indices[0][k] = ss0 - indices[0][k];
+            if (s <= indices[n]) indices[n] = ss - indices[n];
+        }
+    }
 
-            indices[1][k] = (s1 == 1) ? (0) :
-                (
-                    (indices[1][k] < 0) ?
-                        (-indices[1][k] - ss1 * ((-indices[1][k]) / ss1)) :
-                            (indices[1][k] - ss1 * (indices[1][k] / ss1))
-                );
-            if (s1 <= indices[1][k]) indices[1][k] = ss1 - indices[1][k];
+    //////////////////////////////////////////////////////////////////////////
+    // Same as convert_to_coeff, for nb (<= BLOCK) interleaved lines: the
+    // n-th sample of the b-th line is pblock[n * BLOCK + b].
+    void convert_to_coeff_block(real_value_type* pblock,
+                                int              count,
+                                int              nb,
+                                double*          poles,
+                                int              npole) const
+    {
+        double  lambda = 1.0;
+        double  sum[BLOCK];
+        int     n, k, b;
 
-            indices[2][k] = (s2 == 1) ? (0) :
-                (
-                    (indices[2][k] < 0) ?
-                        (-indices[2][k] - ss2 * ((-indices[2][k]) / ss2)) :
-                            (indices[2][k] - ss2 * (indices[2][k] / ss2))
-                );
-            if (s2 <= indices[2][k]) indices[2][k] = ss2 - indices[2][k];
-        }
+        // special case required by mirror boundaries
+        if (count == 1) return;
 
-        // perform interpolation
-        ans = 0.0;
+        if (npole > 0) {
+            for (k = 0; k < npole; ++k) {
+                // compute the overall gain
+                lambda = lambda * (1.0 - poles[k]) * (1.0 - 1.0 / poles[k]);
+            }
 
-        for (k = 0; k <= m_order; ++k) {
-            w2 = 0.0;
-            for (j = 0; j <= m_order; ++j) {
-                w = 0.0;
-                for (i = 0; i <= m_order; ++i)
-                    w += weights[0][i] * m_coeff(indices[0][i],
-                                                 indices[1][j],
-                                                 indices[2][k]
-                                                 );
-                w2 += weights[1][j] * w;
+            // apply the gain
+            for (n = 0; n < count; ++n) {
+                real_value_type* p = pblock + n * BLOCK;
+                for (b = 0; b < nb; ++b) p[b] *= (real_value_type)lambda;
             }
-            ans += weights[2][k] * w2;
         }
-        return (real_value_type)ans;
-    }
 
-    //////////////////////////////////////////////////////////////////////////
-    ///  Free the lookup table and set the order to zero.
-    //////////////////////////////////////////////////////////////////////////
-    void release()
-    {
-        m_coeff.release();
-        m_order = 0;
-    }
+        // loop over all poles
+        for (k = 0; k < npole; ++k) {
+            const double          dpole = poles[k];
+            const real_value_type z     = (real_value_type)dpole;
+            double const          TOL   = std::numeric_limits<double>::epsilon();
+            int                   horizon = (int)ceil(log(TOL) / log(fabs(dpole)));
+
+            // causal initialization (see get_initial_causal_coeff)
+            if (horizon < count) {
+                double zn = dpole;
+                for (b = 0; b < nb; ++b) sum[b] = pblock[b];
+                for (n = 1; n < horizon; ++n) {
+                    const real_value_type* p = pblock + n * BLOCK;
+                    for (b = 0; b < nb; ++b) sum[b] += zn * p[b];
+                    zn *= dpole;
+                }
+            }
+            else {
+                double zn = dpole, iz = 1.0 / dpole;
+                double z2n = pow(dpole, (double)(count - 1));
+                const real_value_type* pl = pblock + (count - 1) * BLOCK;
+                for (b = 0; b < nb; ++b) sum[b] = pblock[b] + z2n * pl[b];
+                z2n *= z2n * iz;
+                for (n = 1; n <= count - 2; ++n) {
+                    const real_value_type* p = pblock + n * BLOCK;
+                    for (b = 0; b < nb; ++b) sum[b] += (zn + z2n) * p[b];
+                    zn *= dpole;
+                    z2n *= iz;
+                }
+                for (b = 0; b < nb; ++b) sum[b] /= (1.0 - zn * zn);
+            }
+            for (b = 0; b < nb; ++b) pblock[b] = (real_value_type)sum[b];
 
-protected:
+            // causal recursion
+            for (n = 1; n < count; ++n) {
+                real_value_type*       p = pblock + n * BLOCK;
+                const real_value_type* q = p - BLOCK;
+                for (b = 0; b < nb; ++b) p[b] += z * q[b];
+            }
+
+            // anticausal initialization & recursion
+            real_value_type* pl = pblock + (count - 1) * BLOCK;
+            for (b = 0; b < nb; ++b) {
+                pl[b] = (real_value_type)((dpole / (dpole * dpole - 1.0)) *
+                        (dpole * pl[b - BLOCK] + pl[b]));
+            }
+            for (n = count - 2; 0 <= n; --n) {
+                real_value_type*       p = pblock + n * BLOCK;
+                const real_value_type* q = p + BLOCK;
+                for (b = 0; b < nb; ++b) p[b] = z * (q[b] - p[b]);
+            }
+        }
+    }
 
     //////////////////////////////////////////////////////////////////////////
     void convert_to_coeff(real_value_type* pline,
@@ -0,0 +1,190 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: maxflow_bench.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+/*
+ ==========================================================================
+  - Purpose:
+
+      Micro-benchmark for the Boykov--Kolmogorov solvers. A synthetic
+      graph-search style problem (infinite intra-column arcs, smoothness
+      arcs between neighboring columns and s-t links from a noisy,
+      piecewise-flat surface) is built once per solver and solved, so
+      that the array-of-structures solver (optnet_fs_maxflow) and the
+      structure-of-arrays solver (optnet_fs_maxflow_soa) can be compared
+      on the same input.
+
+      Usage:
+
+        optnet::utils::compare_maxflow_layouts(std::cout, 64, 64, 32);
+
+ ==========================================================================
+ */
+
+#ifndef ___MAXFLOW_BENCH_HXX___
+#   define ___MAXFLOW_BENCH_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#   endif
+
+#   include <optnet/_fs/optnet_fs_maxflow.hxx>
+#   include <optnet/_fs/optnet_fs_maxflow_soa.hxx>
+#   include <optnet/_utils/timer.hxx>
+#   include <ostream>
+
+/// @namespace optnet
+namespace optnet {
+    /// @namespace optnet::utils
+    namespace utils {
+
+///////////////////////////////////////////////////////////////////////////
+///  Builds the synthetic benchmark graph into the given solver.
+///
+///  @param  solver  The max-flow solver (optnet_fs_maxflow interface).
+///  @param  s0      The size of the first  dimension of the graph.
+///  @param  s1      The size of the second dimension of the graph.
+///  @param  s2      The size of the third  dimension (column height).
+///  @param  seed    The seed of the pseudo-random s-t capacities.
+///
+///////////////////////////////////////////////////////////////////////////
+template <typename _Solver>
+void build_maxflow_bench_graph(_Solver&     solver,
+                               size_t       s0,
+                               size_t       s1,
+                               size_t       s2,
+                               unsigned int seed = 1
+                               )
+{
+    typedef typename _Solver::capacity_type capacity_type;
+
+    solver.create(s0, s1, s2);
+
+    for (size_t i0 = 0; i0 < s0; ++i0) {
+        for (size_t i1 = 0; i1 < s1; ++i1) {
+            for (size_t i2 = 0; i2 < s2; ++i2) {
+
+                // Linear congruential generator (portable and repeatable).
+                seed = seed * 1103515245u + 12345u;
+
+                // A smooth surface with additive noise: the cost is
+                // negative below the surface and positive above it.
+                // The height is clamped to [0, s2] for short columns.
+                long   t = (long)(s2 / 2) + (long)((i0 / 8 + i1 / 8) % 5) - 2;
+                size_t h = (t < 0) ? 0 : ((size_t)t > s2) ? s2 : (size_t)t;
+                capacity_type c = (capacity_type)((seed >> 16) & 0x3F)
+                                - (capacity_type)((i2 < h) ? 40 : 24);
+
+                solver.add_st_arc(c > 0 ? c : 0, c < 0 ? -c : 0, i0, i1, i2);
+
+                // Intra-column arcs.
+                if (i2 > 0) solver.add_arc(i0, i1, i2, i0, i1, i2 - 1);
+
+                // Inter-column arcs (smoothness 1).
+                if (i2 > 0 && i0 + 1 < s0) {
+                    solver.add_arc(i0, i1, i2, i0 + 1, i1, i2 - 1);
+                    solver.add_arc(i0 + 1, i1, i2, i0, i1, i2 - 1);
+                }
+                if (i2 > 0 && i1 + 1 < s1) {
+                    solver.add_arc(i0, i1, i2, i0, i1 + 1, i2 - 1);
+                    solver.add_arc(i0, i1 + 1, i2, i0, i1, i2 - 1);
+                }
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+///  Times one solver on the synthetic benchmark graph.
+///
+///  @param  solver   The max-flow solver (optnet_fs_maxflow interface).
+///  @param  s0       The size of the first  dimension of the graph.
+///  @param  s1       The size of the second dimension of the graph.
+///  @param  s2       The size of the third  dimension (column height).
+///  @param  flow     Receives the maximum flow value.
+///  @param  repeats  Number of build/solve rounds (default: 3).
+///
+///  @return The average solve time in seconds (graph building excluded).
+///
+///////////////////////////////////////////////////////////////////////////
+template <typename _Solver>
+double benchmark_maxflow(_Solver&                           solver,
+                         size_t                             s0,
+                         size_t                             s1,
+                         size_t                             s2,
+                         typename _Solver::capacity_type&   flow,
+                         unsigned int                       repeats = 3
+                         )
+{
+    double total = 0;
+
+    if (repeats == 0) repeats = 1;
+
+    for (unsigned int r = 0; r < repeats; ++r) {
+        build_maxflow_bench_graph(solver, s0, s1, s2);
+        timer t;
+        flow   = solver.solve();
+        total += t.elapsed();
+    }
+
+    return total / repeats;
+}
+
+///////////////////////////////////////////////////////////////////////////
+///  Compares the array-of-structures (optnet_fs_maxflow) and the
+///  structure-of-arrays (optnet_fs_maxflow_soa) node layouts on the
+///  synthetic benchmark graph and prints the results.
+///
+///  @param  os       The output stream.
+///  @param  s0       The size of the first  dimension of the graph.
+///  @param  s1       The size of the second dimension of the graph.
+///  @param  s2       The size of the third  dimension (column height).
+///  @param  repeats  Number of build/solve rounds (default: 3).
+///
+///  @return Returns true if both solvers produced the same flow value.
+///
+///////////////////////////////////////////////////////////////////////////
+inline bool compare_maxflow_layouts(std::ostream& os,
+                                    size_t        s0,
+                                    size_t        s1,
+                                    size_t        s2,
+                                    unsigned int  repeats = 3
+                                    )
+{
+    optnet_fs_maxflow<long>     aos;
+    optnet_fs_maxflow_soa<long> soa;
+    long                        flow_aos = 0, flow_soa = 0;
+
+    double t_aos = benchmark_maxflow(aos, s0, s1, s2, flow_aos, repeats);
+    double t_soa = benchmark_maxflow(soa, s0, s1, s2, flow_soa, repeats);
+
+    os << "maxflow benchmark " << s0 << "x" << s1 << "x" << s2 << "\n"
+       << "  AoS (optnet_fs_maxflow)    : " << t_aos << " s, flow "
+       << flow_aos << "\n"
+       << "  SoA (optnet_fs_maxflow_soa): " << t_soa << " s, flow "
+       << flow_soa << "\n";
+
+    if (t_soa > 0)
+        os << "  speed-up                   : " << t_aos / t_soa << "x\n";
+
+    return flow_aos == flow_soa;
+}
+
+    } // namespace
+} // namespace
+
+#endif
@@ -26,7 +26,9 @@
 #      pragma warning(disable : 4786)
 #   endif
 
+#   include <algorithm>
 #   include <queue>
+#   include <vector>
 #   include <optnet/config.h>
 #   include <optnet/_base/array.hxx>
 #   include <optnet/_base/array_ref.hxx>
@@ -51,6 +53,10 @@ struct regiongrow_3d_ongrow
 
 ///////////////////////////////////////////////////////////////////////////
 ///  3-D region-grow algorithm framework (6-neighbor configuration).
+///
+///  @remarks The ongrow functor is called for every visited voxel and
+///           must mark the voxels it accepts. See regiongrow_3d for the
+///           faster scanline version with a templated predicate.
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Tp, typename _Tg>
 void
@@ -147,6 +153,401 @@ regiongrow_3d_6neighbor(optnet::array_base<_Tp, _Tg>&   a,
 
     } // while
 }
+
+//
+// The maximum number of slabs (along the third dimension) that
+// label_components_3d labels concurrently.
+//
+#   ifndef OPTNET_LABEL_MAX_SLABS
+#       define OPTNET_LABEL_MAX_SLABS 32
+#   endif
+
+///////////////////////////////////////////////////////////////////////////
+///  @class regiongrow_range
+///  @brief A region-grow predicate accepting the values in [lower, upper].
+///////////////////////////////////////////////////////////////////////////
+template <typename _Tp>
+struct regiongrow_range
+{
+    regiongrow_range(const _Tp& lower, const _Tp& upper) :
+        lo(lower), hi(upper)
+    {
+    }
+
+    inline bool operator()(const _Tp& v) const
+    {
+        return !(v < lo) && !(hi < v);
+    }
+
+    _Tp lo, hi;
+};
+
+        namespace detail {
+
+///////////////////////////////////////////////////////////////////////////
+// A row adjacent to a row of voxels: the offsets along the second and
+// third dimensions, and how far a run of the row reaches along the first
+// dimension into it (1 if the diagonal neighbors are connected).
+struct regiongrow_row
+{
+    int d1, d2, ext;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Get the adjacent rows for 6-, 18- or 26-connectivity. Returns the
+// number of rows (at most 8). The rows are ordered so that the ones
+// preceding a row in raster order come first.
+inline int regiongrow_rows(int connectivity, regiongrow_row* rows)
+{
+    int n = 0;
+
+    for (int d2 = -1; d2 <= 1; ++d2) {
+        for (int d1 = -1; d1 <= 1; ++d1) {
+            bool diagonal = (d1 != 0 && d2 != 0);
+            if (d1 == 0 && d2 == 0) continue;
+            if (diagonal && connectivity < 18) continue;
+
+            rows[n].d1  = d1;
+            rows[n].d2  = d2;
+            rows[n].ext = (connectivity >= 26 ||
+                           (connectivity >= 18 && !diagonal)) ? 1 : 0;
+            ++n;
+        }
+    }
+
+    return n;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Union-find root with path halving.
+inline size_t regiongrow_find(std::vector<size_t>& parent, size_t x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Unite two sets; the smaller index becomes the root, so the root of a
+// component is its first run in raster order.
+inline void regiongrow_unite(std::vector<size_t>& parent, size_t a, size_t b)
+{
+    a = regiongrow_find(parent, a);
+    b = regiongrow_find(parent, b);
+    if (a < b)      parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// The runs of foreground voxels of a slab, in raster order.
+struct regiongrow_runs
+{
+    std::vector<size_t> first;  // The first run of every row (+ end).
+    std::vector<int>    begin;  // The first voxel of every run.
+    std::vector<int>    end;    // One past the last voxel of every run.
+    std::vector<size_t> parent; // The union-find forest.
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Unite the runs [r0, r1) of a row with the overlapping runs [n0, n1) of
+// an adjacent row. The runs are indexed by run ids minus offset0 and
+// offset1, respectively.
+inline void regiongrow_unite_rows(const regiongrow_runs& row_runs,
+                                  size_t                 r0,
+                                  size_t                 r1,
+                                  size_t                 offset0,
+                                  const regiongrow_runs& adj_runs,
+                                  size_t                 n0,
+                                  size_t                 n1,
+                                  size_t                 offset1,
+                                  int                    ext,
+                                  std::vector<size_t>&   parent
+                                  )
+{
+    size_t n = n0;
+
+    for (size_t r = r0; r < r1; ++r) {
+        const int b = row_runs.begin[r], e = row_runs.end[r];
+
+        // Skip the adjacent runs that end before this run (these cannot
+        // overlap the later runs either).
+        while (n < n1 && adj_runs.end[n] + ext <= b) ++n;
+
+        for (size_t m = n; m < n1 && adj_runs.begin[m] < e + ext; ++m) {
+            regiongrow_unite(parent, r + offset0, m + offset1);
+        }
+    }
+}
+
+        } // namespace detail
+
+///////////////////////////////////////////////////////////////////////////
+///  3-D region-grow by scanline filling.
+///
+///  Fills the voxels that are connected to the seed, satisfy pred and are
+///  not yet labeled in out. Every dequeued seed is extended to its whole
+///  run along the first dimension, and one new seed is queued per run of
+///  fillable voxels in the adjacent rows. The queue therefore holds
+///  linear indices of runs, not of voxels.
+///
+///  @param  a             The input image.
+///  @param  seed_x        The seed voxel.
+///  @param  seed_y        The seed voxel.
+///  @param  seed_z        The seed voxel.
+///  @param  pred          The grow condition, called as pred(value); e.g.,
+///                        regiongrow_range.
+///  @param  out           The output image (may be a). The filled voxels
+///                        are set to label; voxels already equal to label
+///                        are not entered.
+///  @param  label         The label of the filled voxels.
+///  @param  connectivity  6, 18 or 26.
+///
+///  @return The number of filled voxels.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Tp, typename _Tg, typename _Pred,
+          typename _Tl, typename _Tg2>
+size_t
+regiongrow_3d(const optnet::array_base<_Tp, _Tg>&  a,
+              size_t                               seed_x,
+              size_t                               seed_y,
+              size_t                               seed_z,
+              _Pred                                pred,
+              optnet::array_base<_Tl, _Tg2>&       out,
+              const _Tl&                           label,
+              int                                  connectivity = 6
+              )
+{
+    const size_t                s0 = a.size_0();
+    const size_t                s1 = a.size_1();
+    const size_t                s2 = a.size_2();
+    const _Tp*                  p  = a.data();
+    _Tl*                        q  = out.data();
+    detail::regiongrow_row      rows[8];
+    const int                   nrows = detail::regiongrow_rows(connectivity, rows);
+    std::vector<size_t>         stack;
+    size_t                      count = 0;
+
+    assert(s0 > 0 && s1 > 0 && s2 > 0);
+    assert(seed_x < s0 && seed_y < s1 && seed_z < s2);
+    assert(out.size_0() == s0 && out.size_1() == s1 && out.size_2() == s2);
+
+    stack.push_back((seed_z * s1 + seed_y) * s0 + seed_x);
+
+    while (!stack.empty())
+    {
+        const size_t i = stack.back();
+        stack.pop_back();
+
+        if (q[i] == label || !pred(p[i])) continue;
+
+        // Fill the run of voxel i.
+        const size_t row  = i / s0;
+        const size_t base = row * s0;
+        size_t       l    = i - base, r = l;
+
+        while (l > 0 && q[base + l - 1] != label && pred(p[base + l - 1])) --l;
+        while (r + 1 < s0 && q[base + r + 1] != label && pred(p[base + r + 1])) ++r;
+
+        for (size_t k = l; k <= r; ++k) q[base + k] = label;
+        count += r - l + 1;
+
+        // Queue one seed per fillable run in the adjacent rows.
+        const size_t i1 = row % s1, i2 = row / s1;
+
+        for (int n = 0; n < nrows; ++n) {
+            if ((rows[n].d1 < 0 && i1 == 0) || (rows[n].d1 > 0 && i1 + 1 == s1) ||
+                (rows[n].d2 < 0 && i2 == 0) || (rows[n].d2 > 0 && i2 + 1 == s2))
+                continue;
+
+            const size_t nb = ((i2 + rows[n].d2) * s1 + (i1 + rows[n].d1)) * s0;
+            const size_t lo = (l >= (size_t)rows[n].ext) ? l - rows[n].ext : 0;
+            const size_t hi = std::min(r + rows[n].ext, s0 - 1);
+            bool         in = false;
+
+            for (size_t k = lo; k <= hi; ++k) {
+                bool fillable = (q[nb + k] != label && pred(p[nb + k]));
+                if (fillable && !in) stack.push_back(nb + k);
+                in = fillable;
+            }
+        }
+    } // while
+
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////
+///  3-D connected-component labeling.
+///
+///  Labels all components of the voxels satisfying pred in one pass:
+///  the foreground runs along the first dimension are united with the
+///  overlapping runs of the adjacent rows by union-find. Slabs along the
+///  third dimension are labeled concurrently when OpenMP is available,
+///  then joined across their boundaries.
+///
+///  @param  a             The input image.
+///  @param  pred          The foreground condition, called as pred(value).
+///  @param  labels        The output labels: 0 for the background, 1 to n
+///                        for the components, numbered in raster order of
+///                        their first voxel.
+///  @param  sizes         If not NULL, the output component sizes; sizes[l]
+///                        is the number of voxels of component l, and
+///                        sizes[0] that of the background.
+///  @param  connectivity  6, 18 or 26.
+///
+///  @return The number of components n.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Tp, typename _Tg, typename _Pred,
+          typename _Tl, typename _Tg2>
+size_t
+label_components_3d(const optnet::array_base<_Tp, _Tg>& a,
+                    _Pred                               pred,
+                    optnet::array_base<_Tl, _Tg2>&      labels,
+                    std::vector<size_t>*                sizes = 0,
+                    int                                 connectivity = 6
+                    )
+{
+    typedef detail::regiongrow_runs runs_type;
+
+    const int                   s0 = (int)a.size_0();
+    const size_t                s1 = a.size_1();
+    const size_t                s2 = a.size_2();
+    const int                   ns = (int)std::max<size_t>(1,
+                                        std::min<size_t>(s2, OPTNET_LABEL_MAX_SLABS));
+    const _Tp*                  p  = a.data();
+    _Tl*                        q  = labels.data();
+    detail::regiongrow_row      rows[8];
+    const int                   nrows = detail::regiongrow_rows(connectivity, rows);
+    std::vector<runs_type>      slabs(ns);
+    std::vector<size_t>         offsets(ns + 1, 0), parent, label;
+    size_t                      n = 0, g;
+    int                         s;
+
+    assert(labels.size_0() == a.size_0() &&
+           labels.size_1() == a.size_1() &&
+           labels.size_2() == a.size_2());
+
+    // Find and unite the runs of every slab.
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for schedule(dynamic) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (s = 0; s < ns; ++s) {
+        runs_type&   runs = slabs[s];
+        const size_t z0   = s2 * s / ns, z1 = s2 * (s + 1) / ns;
+        const size_t nr   = (z1 - z0) * s1;
+
+        runs.first.resize(nr + 1);
+        for (size_t row = 0; row < nr; ++row) {
+            const _Tp* v = p + (z0 * s1 + row) * s0;
+
+            runs.first[row] = runs.begin.size();
+            for (int x = 0; x < s0; ) {
+                if (!pred(v[x])) { ++x; continue; }
+                int b = x;
+                while (x < s0 && pred(v[x])) ++x;
+                runs.begin.push_back(b);
+                runs.end.push_back(x);
+                runs.parent.push_back(runs.parent.size());
+            }
+            runs.first[row + 1] = runs.begin.size();
+
+            const size_t i1 = row % s1, i2 = row / s1;
+            for (int k = 0; k < nrows; ++k) {
+                // The preceding rows of this slab only.
+                if (rows[k].d2 > 0 || (rows[k].d2 == 0 && rows[k].d1 > 0)) continue;
+                if ((rows[k].d1 < 0 && i1 == 0) || (rows[k].d1 > 0 && i1 + 1 == s1) ||
+                    (rows[k].d2 < 0 && i2 == 0))
+                    continue;
+
+                const size_t adj = row + rows[k].d2 * s1 + rows[k].d1;
+                detail::regiongrow_unite_rows(
+                    runs, runs.first[row], runs.first[row + 1], 0,
+                    runs, runs.first[adj], runs.first[adj + 1], 0,
+                    rows[k].ext, runs.parent);
+            }
+        }
+    }
+
+    // Join the slabs into one forest of global run ids.
+    for (s = 0; s < ns; ++s) {
+        offsets[s + 1] = offsets[s] + slabs[s].begin.size();
+    }
+    parent.resize(offsets[ns]);
+    for (s = 0; s < ns; ++s) {
+        for (size_t r = 0; r < slabs[s].parent.size(); ++r) {
+            parent[offsets[s] + r] = offsets[s] + slabs[s].parent[r];
+        }
+        std::vector<size_t>().swap(slabs[s].parent);
+    }
+
+    for (s = 1; s < ns; ++s) {
+        const runs_type& cur  = slabs[s];
+        const runs_type& prev = slabs[s - 1];
+        const size_t     last = prev.first.size() - 1 - s1; // first row of the last plane
+
+        for (size_t i1 = 0; i1 < s1; ++i1) {
+            for (int k = 0; k < nrows; ++k) {
+                if (rows[k].d2 >= 0) continue;
+                if ((rows[k].d1 < 0 && i1 == 0) || (rows[k].d1 > 0 && i1 + 1 == s1))
+                    continue;
+
+                const size_t adj = last + i1 + rows[k].d1;
+                detail::regiongrow_unite_rows(
+                    cur,  cur.first[i1],   cur.first[i1 + 1],   offsets[s],
+                    prev, prev.first[adj], prev.first[adj + 1], offsets[s - 1],
+                    rows[k].ext, parent);
+            }
+        }
+    }
+
+    // Number the components in raster order.
+    label.resize(parent.size());
+    if (0 != sizes) sizes->assign(1, a.size());
+
+    for (s = 0; s < ns; ++s) {
+        for (size_t r = 0; r < slabs[s].begin.size(); ++r) {
+            g = offsets[s] + r;
+            size_t root = detail::regiongrow_find(parent, g);
+            if (root == g) {
+                label[g] = ++n;
+                if (0 != sizes) sizes->push_back(0);
+            }
+            else {
+                label[g] = label[root];
+            }
+            if (0 != sizes) {
+                size_t len = slabs[s].end[r] - slabs[s].begin[r];
+                (*sizes)[label[g]] += len;
+                (*sizes)[0]        -= len;
+            }
+        }
+    }
+
+    // Write the labels.
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for schedule(dynamic) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (s = 0; s < ns; ++s) {
+        const runs_type& runs = slabs[s];
+        const size_t     z0   = s2 * s / ns;
+        const size_t     nr   = runs.first.size() - 1;
+
+        for (size_t row = 0; row < nr; ++row) {
+            _Tl* v = q + (z0 * s1 + row) * s0;
+            std::fill(v, v + s0, _Tl(0));
+            for (size_t r = runs.first[row]; r < runs.first[row + 1]; ++r) {
+                std::fill(v + runs.begin[r], v + runs.end[r],
+                          (_Tl)label[offsets[s] + r]);
+            }
+        }
+    }
+
+    return n;
+}
+
     
     
     } // namespace
@@ -33,7 +33,7 @@ namespace optnet { namespace xtra {
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cap, typename _Tg>
 bk_fs_maxflow<_Cap, _Tg>::bk_fs_maxflow() :
-    m_preflow(0)
+    m_preflow(0), m_flow(0), m_solved(false)
 {
 }
 
@@ -45,7 +45,7 @@ bk_fs_maxflow<_Cap, _Tg>::bk_fs_maxflow(size_type s0,
                                         size_type s3,
                                         size_type s4
                                         ) :
-    _Base(s0, s1, s2, s3, s4), m_preflow(0)
+    _Base(s0, s1, s2, s3, s4), m_preflow(0), m_flow(0), m_solved(false)
 {
 }
 
@@ -62,6 +62,10 @@ bk_fs_maxflow<_Cap, _Tg>::create(size_type s0,
     // Clear pre-calculated flow.
     m_preflow = 0;
 
+    // Discard the state of the previous solve.
+    m_solved  = false;
+    m_changed_nodes.clear();
+
     // Create and initialize the graph.
     return _Base::create(s0, s1, s2, s3, s4);
 }
@@ -70,6 +74,22 @@ bk_fs_maxflow<_Cap, _Tg>::create(size_type s0,
 template <typename _Cap, typename _Tg>
 typename bk_fs_maxflow<_Cap, _Tg>::capacity_type
 bk_fs_maxflow<_Cap, _Tg>::solve()
+{
+    return maxflow(false);
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+typename bk_fs_maxflow<_Cap, _Tg>::capacity_type
+bk_fs_maxflow<_Cap, _Tg>::resolve()
+{
+    return maxflow(m_solved);
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+typename bk_fs_maxflow<_Cap, _Tg>::capacity_type
+bk_fs_maxflow<_Cap, _Tg>::maxflow(bool reuse_trees)
 {
     forward_arc_pointer p_fwd_arc, p_first_out_arc, p_last_out_arc;
     reverse_arc_pointer p_rev_arc, p_first_in_arc, p_last_in_arc;
@@ -80,7 +100,10 @@ bk_fs_maxflow<_Cap, _Tg>::solve()
     
 
     // Initialize the maximum-flow solver.
-    maxflow_init();
+    if (reuse_trees)
+        maxflow_reuse_trees_init();
+    else
+        maxflow_init();
 
     while (true) {
 
@@ -100,9 +123,11 @@ bk_fs_maxflow<_Cap, _Tg>::solve()
 
                 if (p_node->p_parent_arc)
                     break;
+
+                p_node = 0;
             }
 
-            if (m_active_nodes.empty())
+            if (!p_node)
                 break;
         }
 
@@ -346,6 +371,8 @@ bk_fs_maxflow<_Cap, _Tg>::solve()
 
     } // while (true)
 
+    m_solved = true;
+
     return m_flow;
 }
 
@@ -395,6 +422,131 @@ bk_fs_maxflow<_Cap, _Tg>::maxflow_init()
     m_dist_id = 2;
 }
 
+///////////////////////////////////////////////////////////////////////////
+//
+// Re-initialize the solver from the search trees of the previous run.
+// Only the nodes whose terminal capacities were changed by update_st_arc()
+// are visited; they become terminal children (or orphans if they lost
+// their terminal capacity), and the neighbors whose tree paths pass
+// through them are orphaned or re-activated.
+//
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cap, typename _Tg>
+void
+bk_fs_maxflow<_Cap, _Tg>::maxflow_reuse_trees_init()
+{
+    forward_arc_pointer p_fwd_arc, p_first_out_arc, p_last_out_arc;
+    reverse_arc_pointer p_rev_arc, p_first_in_arc, p_last_in_arc;
+    node_pointer        p_node, p_node1;
+    bool                to_sink;
+
+    m_active_nodes.clear();
+    m_orphan_nodes.clear();
+
+    ++m_dist_id;
+
+    while (!m_changed_nodes.empty()) {
+
+        p_node = m_changed_nodes.front();
+        m_changed_nodes.pop_front();
+
+        p_node->tag &= ~IS_CHANGED;
+        activate(p_node);
+
+        if (0 == p_node->cap) {
+            // Lost its terminal capacity.
+            if (p_node->p_parent_arc) set_orphan(p_node);
+            continue;
+        }
+
+        to_sink = (p_node->cap < 0);
+
+        // The node either joins a tree or switches to the other tree.
+        if (!p_node->p_parent_arc
+        || (0 != (p_node->tag & IS_SINK)) != to_sink) {
+
+            if (to_sink) p_node->tag |=  IS_SINK;
+            else         p_node->tag &= ~IS_SINK;
+
+            if (p_node->tag & _Base::SPECIAL_OUT) {
+                p_first_out_arc = p_node->p_first_out_arc + 1;
+                p_last_out_arc
+                    = (forward_arc_pointer)(p_node->p_first_out_arc->shift);
+            }
+            else {
+                p_first_out_arc = p_node->p_first_out_arc;
+                p_last_out_arc  = (p_node + 1)->p_first_out_arc;
+            }
+
+            if (p_node->tag & _Base::SPECIAL_IN) {
+                p_first_in_arc  = p_node->p_first_in_arc + 1;
+                p_last_in_arc
+                    = (reverse_arc_pointer)(p_node->p_first_in_arc->p_fwd);
+            }
+            else {
+                p_first_in_arc  = p_node->p_first_in_arc;
+                p_last_in_arc   = (p_node + 1)->p_first_in_arc;
+            }
+
+            // Children of p_node lose their parent; neighbors of the
+            // other tree that can now reach p_node become active.
+            for (p_fwd_arc = p_first_out_arc;
+                 p_fwd_arc < p_last_out_arc;
+                 ++p_fwd_arc) {
+
+                p_node1 = neighbor_node_fwd(p_node, p_fwd_arc->shift);
+                if (p_node1->tag & IS_CHANGED) continue;
+
+                if (p_node1->p_parent_arc == p_fwd_arc
+                && (p_node1->tag & PARENT_REV))
+                    set_orphan(p_node1);
+
+                if (p_node1->p_parent_arc
+                && (0 != (p_node1->tag & IS_SINK)) != to_sink
+                && 0 != (to_sink ? p_fwd_arc->rev_cap : p_fwd_arc->cap))
+                    activate(p_node1);
+            }
+
+            for (p_rev_arc = p_first_in_arc;
+                 p_rev_arc < p_last_in_arc;
+                 ++p_rev_arc) {
+
+                p_fwd_arc = p_rev_arc->p_fwd;
+                p_node1   = neighbor_node_rev(p_node, p_fwd_arc->shift);
+                if (p_node1->tag & IS_CHANGED) continue;
+
+                if (p_node1->p_parent_arc == p_fwd_arc
+                && !(p_node1->tag & PARENT_REV))
+                    set_orphan(p_node1);
+
+                if (p_node1->p_parent_arc
+                && (0 != (p_node1->tag & IS_SINK)) != to_sink
+                && 0 != (to_sink ? p_fwd_arc->cap : p_fwd_arc->rev_cap))
+                    activate(p_node1);
+            }
+        }
+
+        p_node->p_parent_arc = (forward_arc_pointer)TERMINAL;
+        p_node->dist_id      = m_dist_id;
+        p_node->dist         = 1;
+    } // while
+
+    // Adopt the orphans created above.
+    while (!m_orphan_nodes.empty()) {
+
+        p_node = m_orphan_nodes.front();
+
+        if (!(p_node->tag & IS_SINK))
+            maxflow_adopt_source_orphan(p_node);
+        else
+            maxflow_adopt_sink_orphan(p_node);
+
+        m_orphan_nodes.pop_front();
+    }
+
+    ++m_dist_id;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cap, typename _Tg>
 void
@@ -1043,6 +1195,9 @@ template<typename _Cap, typename _Tg>
 template<typename _Cap, typename _Tg>
     const unsigned char bk_fs_maxflow<_Cap, _Tg>::IS_ACTIVE  = 0x04;
 
+template<typename _Cap, typename _Tg>
+    const unsigned char bk_fs_maxflow<_Cap, _Tg>::IS_CHANGED = 0x08;
+
 template<typename _Cap, typename _Tg>
     const unsigned char bk_fs_maxflow<_Cap, _Tg>::IS_SINK    = 0x01;
 
@@ -0,0 +1,586 @@
+/*
+ ==========================================================================
+ |
+ |   $Id: sphere_mesh.hxx $
+ |
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ |   This file is a part of the OptimalNet library.
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ |
+ | This software is supplied under the terms of a license agreement or
+ | nondisclosure agreement  with the author  and may not be copied  or
+ | disclosed except in accordance with the terms of that agreement.
+ ==========================================================================
+ */
+
+#ifndef ___SPHERE_MESH_HXX___
+#   define ___SPHERE_MESH_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#   endif
+
+#   include <optnet/config.h>
+#   include <optnet/_base/point3.hxx>
+#   include <optnet/_base/secure_s.hxx>
+#   include <optnet/_base/io/mapped_volume.hxx>
+#   include <optnet/_xtra/graphics/sphere_tessellation.hxx>
+#   include <cstdio>
+#   include <cstring>
+#   include <map>
+#   include <sstream>
+#   include <string>
+#   include <utility>
+#   include <vector>
+
+
+/// @namespace optnet
+namespace optnet {
+    /// @namespace xtra
+    namespace xtra {
+        /// @namespace graphics
+        namespace graphics {
+
+///////////////////////////////////////////////////////////////////////////
+///  @class sphere_mesh
+///  @brief A compact, read-only sphere tessellation.
+///
+///  The vertices, edges and triangles of a tessellation are stored as
+///  index-based records in flat arrays, all in one arena: the header,
+///  the vertex coordinates (x, y, z), the edge records, the triangle
+///  records, and the incident edges of every vertex (a start offset per
+///  vertex, then the edge indices). The arena is either owned by the
+///  mesh or mapped from a mesh file, whose contents are the arena
+///  itself, so loading a mesh does no parsing or pointer fix-ups.
+///
+///  A mesh holds no pointers into itself other than the section bases,
+///  and it is never modified after it is built or mapped; it can be
+///  shared by any number of threads.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Real>
+class sphere_mesh
+{
+public:
+
+    typedef _Real               value_type;
+    typedef size_t              size_type;
+    typedef int                 index_type;
+    typedef point3<_Real>       point_type;
+
+    ///////////////////////////////////////////////////////////////////////
+    struct edge_type        /// An edge record.
+    {
+        index_type          v[2];   /// Adjacent vertices.
+        index_type          t[2];   /// Adjacent triangles.
+    };
+
+    ///////////////////////////////////////////////////////////////////////
+    struct triangle_type    /// A triangle record.
+    {
+        index_type          e[3];   /// Triangle edges.
+        index_type          v[3];   /// Triangle vertices.
+        index_type          a[3];   /// Neighboring triangles.
+    };
+
+    ///////////////////////////////////////////////////////////////////////
+    /// Default constructor.
+    ///////////////////////////////////////////////////////////////////////
+    sphere_mesh() { reset(); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Builds the tessellation of a polyhedron (see create).
+    ///////////////////////////////////////////////////////////////////////
+    sphere_mesh(int shape, int level) { reset(); create(shape, level); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Tessellates a polyhedron once and stores the result.
+    ///
+    ///  @param shape  The initial polyhedron: 4, 8 or 20 faces.
+    ///  @param level  The number of subdivisions.
+    ///////////////////////////////////////////////////////////////////////
+    void create(int shape, int level)
+    {
+        sphere_tessellation<_Real> tess;
+        tess.initialize(shape);
+        tess.tessellate(level);
+        assign(tess, shape, level);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Stores an existing tessellation.
+    ///
+    ///  @param tess   The tessellation.
+    ///  @param shape  The initial polyhedron tess was built from.
+    ///  @param level  The number of subdivisions of tess.
+    ///////////////////////////////////////////////////////////////////////
+    void assign(const sphere_tessellation<_Real>& tess, int shape, int level)
+    {
+        typedef sphere_tessellation<_Real> tess_type;
+
+        size_type i, k;
+        header_type head;
+
+        clear();
+
+        memset(&head, 0, sizeof(head));
+        memcpy(head.tag, magic(), 4);
+        head.version   = VERSION;
+        head.real_size = (int)sizeof(_Real);
+        head.shape     = shape;
+        head.level     = level;
+        head.n         = (int)tess.num_vertices();
+        head.m         = (int)tess.num_edges();
+        head.r         = (int)tess.num_triangles();
+
+        // The incident edges of the vertices.
+        head.num_incident = 0;
+        for (i = 0; i < (size_type)head.n; ++i) {
+            head.num_incident += (int)tess.vertex_begin()[i].m;
+        }
+
+        m_storage.assign(arena_size(head), 0);
+        memcpy(&m_storage[0], &head, sizeof(head));
+        bind(&m_storage[0]);
+
+        point_type c;
+        for (i = 0; i < num_vertices(); ++i) {
+            const typename tess_type::vertex_type& v = tess.vertex_begin()[i];
+
+            m_points[3 * i    ] = v.p->v[0];
+            m_points[3 * i + 1] = v.p->v[1];
+            m_points[3 * i + 2] = v.p->v[2];
+            c += *(v.p);
+
+            m_first[i + 1] = m_first[i] + (index_type)v.m;
+            for (k = 0; k < v.m; ++k) {
+                m_incident[m_first[i] + k] =
+                    (index_type)tess.edge_offset(v.e[k]);
+            }
+        }
+
+        for (i = 0; i < num_edges(); ++i) {
+            const typename tess_type::edge_type& e = tess.edge_begin()[i];
+            for (k = 0; k < 2; ++k) {
+                m_edges[i].v[k] = (index_type)tess.vertex_offset(e.v[k]);
+                m_edges[i].t[k] = (index_type)tess.triangle_offset(e.t[k]);
+            }
+        }
+
+        for (i = 0; i < num_triangles(); ++i) {
+            const typename tess_type::triangle_type& t = tess.triangle_begin()[i];
+            for (k = 0; k < 3; ++k) {
+                m_triangles[i].e[k] = (index_type)tess.edge_offset(t.e[k]);
+                m_triangles[i].v[k] = (index_type)tess.vertex_offset(t.v[k]);
+                m_triangles[i].a[k] = (index_type)tess.triangle_offset(t.a[k]);
+            }
+        }
+
+        if (num_vertices() > 0) c *= value_type(1.0 / num_vertices());
+        header()->centroid[0] = c.v[0];
+        header()->centroid[1] = c.v[1];
+        header()->centroid[2] = c.v[2];
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Maps a mesh file written by save. The file stays mapped until
+    ///  the mesh is cleared.
+    ///
+    ///  @return false if the file cannot be mapped, is not a mesh file,
+    ///          or was written for another value type or byte order.
+    ///////////////////////////////////////////////////////////////////////
+    bool map(const char* name)
+    {
+        header_type head;
+
+        clear();
+        if (!read_header(name, head)) return false;
+        if (!m_file.open(name, arena_size(head))) return false;
+
+        bind(m_file.data());
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Reads a mesh file written by save into memory.
+    ///
+    ///  @return false as for map, or on a read error.
+    ///////////////////////////////////////////////////////////////////////
+    bool load(const char* name)
+    {
+        header_type head;
+        FILE*       pfile;
+
+        clear();
+        if (!read_header(name, head)) return false;
+        if (0 != secure_fopen(&pfile, name, "rb")) return false;
+
+        m_storage.resize(arena_size(head));
+        bool ok = (fread(&m_storage[0], 1, m_storage.size(), pfile)
+                   == m_storage.size());
+        fclose(pfile);
+
+        if (!ok) {
+            clear();
+            return false;
+        }
+
+        bind(&m_storage[0]);
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Writes the arena into a mesh file. The arena is written to a
+    ///  temporary file that then replaces the file, so the file is never
+    ///  truncated under a process that has it mapped.
+    ///
+    ///  @return false if the mesh is empty or on a write error.
+    ///////////////////////////////////////////////////////////////////////
+    bool save(const char* name) const
+    {
+        FILE*              pfile;
+        std::ostringstream temp;
+
+        if (0 == m_base) return false;
+
+    #ifdef _WIN32
+        temp << name << "." << ::GetCurrentProcessId() << ".tmp";
+    #else
+        temp << name << "." << ::getpid() << ".tmp";
+    #endif
+        if (0 != secure_fopen(&pfile, temp.str().c_str(), "wb")) return false;
+
+        size_type size = arena_size(*header());
+        bool      ok   = (fwrite(m_base, 1, size, pfile) == size);
+        if (0 != fclose(pfile)) ok = false;
+
+    #ifdef _WIN32
+        // rename() does not replace an existing file on Windows (nor can
+        // a mapped file be removed there, in which case saving fails).
+        if (ok) remove(name);
+    #endif
+        if (!ok || 0 != rename(temp.str().c_str(), name)) {
+            remove(temp.str().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Releases the arena.
+    ///////////////////////////////////////////////////////////////////////
+    void clear()
+    {
+        m_file.close();
+        std::vector<char>().swap(m_storage);
+        reset();
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns true if the mesh is empty.
+    inline bool         empty()         const { return 0 == m_base; }
+
+    ///  Returns true if the arena is mapped from a file.
+    inline bool         is_mapped()     const { return 0 != m_file.data(); }
+
+    ///  Returns the initial polyhedron (4, 8 or 20).
+    inline int          shape()         const { return m_base ? header()->shape : 0; }
+
+    ///  Returns the number of subdivisions.
+    inline int          level()         const { return m_base ? header()->level : 0; }
+
+    ///  Returns the number of vertices.
+    inline size_type    num_vertices()  const { return m_base ? header()->n : 0; }
+
+    ///  Returns the number of edges.
+    inline size_type    num_edges()     const { return m_base ? header()->m : 0; }
+
+    ///  Returns the number of triangles.
+    inline size_type    num_triangles() const { return m_base ? header()->r : 0; }
+
+    ///  Returns the size of the arena in bytes.
+    inline size_type    size_in_bytes() const { return m_base ? arena_size(*header()) : 0; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the coordinates (x, y, z) of vertex i; the vertices of a
+    ///  unit sphere are the sampling directions.
+    inline const value_type*    direction(size_type i) const
+                                { return m_points + 3 * i; }
+
+    ///  Returns vertex i as a point.
+    inline point_type           vertex(size_type i) const
+                                {
+                                    const value_type* p = m_points + 3 * i;
+                                    return point_type(p[0], p[1], p[2]);
+                                }
+
+    ///  Returns the coordinates of all vertices (3 per vertex).
+    inline const value_type*    points()    const { return m_points;    }
+
+    ///  Returns edge i.
+    inline const edge_type&     edge(size_type i)     const { return m_edges[i];     }
+
+    ///  Returns triangle i.
+    inline const triangle_type& triangle(size_type i) const { return m_triangles[i]; }
+
+    ///  Returns the number of edges incident to vertex i.
+    inline size_type            degree(size_type i) const
+                                { return m_first[i + 1] - m_first[i]; }
+
+    ///  Returns the edges incident to vertex i.
+    inline const index_type*    incident_edges(size_type i) const
+                                { return m_incident + m_first[i]; }
+
+    ///  Returns the vertex at the other end of edge e from vertex i.
+    inline index_type           opposite(index_type e, size_type i) const
+                                {
+                                    return m_edges[e].v[0] == (index_type)i ?
+                                        m_edges[e].v[1] : m_edges[e].v[0];
+                                }
+
+    ///  Returns the centroid of the vertices.
+    inline point_type           centroid() const
+                                {
+                                    if (0 == m_base) return point_type();
+                                    const double* c = header()->centroid;
+                                    return point_type((value_type)c[0],
+                                                      (value_type)c[1],
+                                                      (value_type)c[2]);
+                                }
+
+private:
+
+    enum { VERSION = 1 };
+
+    // The tag of a mesh file.
+    static const char* magic() { return "OSMS"; }
+
+    // The arena header (64 bytes).
+    struct header_type
+    {
+        char    tag[4];
+        int     version;
+        int     real_size;
+        int     shape;
+        int     level;
+        int     n, m, r;
+        int     num_incident;
+        int     reserved;
+        double  centroid[3];
+    };
+
+    static size_type align8(size_type n) { return (n + 7) & ~(size_type)7; }
+
+    // The section offsets and the total size of the arena of a mesh.
+    static void layout(const header_type& head, size_type* offsets)
+    {
+        offsets[0] = align8(sizeof(header_type));
+        offsets[1] = offsets[0] + align8(3 * sizeof(_Real) * head.n);
+        offsets[2] = offsets[1] + align8(sizeof(edge_type) * head.m);
+        offsets[3] = offsets[2] + align8(sizeof(triangle_type) * head.r);
+        offsets[4] = offsets[3] + align8(sizeof(index_type) * (head.n + 1));
+        offsets[5] = offsets[4] + align8(sizeof(index_type) * head.num_incident);
+    }
+
+    static size_type arena_size(const header_type& head)
+    {
+        size_type offsets[6];
+        layout(head, offsets);
+        return offsets[5];
+    }
+
+    // Reads and checks the header of a mesh file.
+    static bool read_header(const char* name, header_type& head)
+    {
+        FILE* pfile;
+
+        if (0 != secure_fopen(&pfile, name, "rb")) return false;
+        bool ok = (fread(&head, sizeof(head), 1, pfile) == 1);
+        fclose(pfile);
+
+        return ok &&
+               0 == memcmp(head.tag, magic(), 4) &&
+               VERSION == head.version &&
+               (int)sizeof(_Real) == head.real_size &&
+               head.n >= 0 && head.m >= 0 && head.r >= 0 &&
+               head.num_incident >= 0;
+    }
+
+    inline header_type* header() const
+    {
+        return reinterpret_cast<header_type*>(m_base);
+    }
+
+    // Sets the section bases for an arena.
+    void bind(char* base)
+    {
+        size_type offsets[6];
+
+        m_base = base;
+        layout(*header(), offsets);
+        m_points    = reinterpret_cast<value_type*>   (base + offsets[0]);
+        m_edges     = reinterpret_cast<edge_type*>    (base + offsets[1]);
+        m_triangles = reinterpret_cast<triangle_type*>(base + offsets[2]);
+        m_first     = reinterpret_cast<index_type*>   (base + offsets[3]);
+        m_incident  = reinterpret_cast<index_type*>   (base + offsets[4]);
+    }
+
+    void reset()
+    {
+        m_base      = 0;
+        m_points    = 0;
+        m_edges     = 0;
+        m_triangles = 0;
+        m_first     = 0;
+        m_incident  = 0;
+    }
+
+    char*                   m_base;
+    value_type*             m_points;
+    edge_type*              m_edges;
+    triangle_type*          m_triangles;
+    index_type*             m_first;
+    index_type*             m_incident;
+
+    std::vector<char>       m_storage;  // The arena, if owned.
+    io::detail::mapped_file m_file;     // The arena, if mapped.
+
+    // Not copyable.
+    sphere_mesh(const sphere_mesh&);
+    sphere_mesh& operator=(const sphere_mesh&);
+};
+
+
+///////////////////////////////////////////////////////////////////////////
+///  @class sphere_mesh_cache
+///  @brief A process-wide cache of sphere meshes, keyed by the initial
+///         polyhedron and the subdivision level.
+///
+///  Every level is tessellated once per process. If a directory is set,
+///  the meshes are mapped from the mesh files in it, and the meshes the
+///  cache had to build are written there for later processes. Meshes
+///  returned by the cache stay valid until clear() is called.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Real>
+class sphere_mesh_cache
+{
+public:
+
+    typedef sphere_mesh<_Real>  mesh_type;
+    typedef size_t              size_type;
+
+    ~sphere_mesh_cache() { clear(); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the process-wide cache.
+    ///////////////////////////////////////////////////////////////////////
+    static sphere_mesh_cache& global()
+    {
+        static sphere_mesh_cache cache;
+        return cache;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Sets the directory of the mesh files (empty for none).
+    ///////////////////////////////////////////////////////////////////////
+    void set_directory(const std::string& dir)
+    {
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp critical(optnet_sphere_mesh_cache)
+    #endif
+        m_dir = dir;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the name of the mesh file of a level in a directory.
+    ///////////////////////////////////////////////////////////////////////
+    static std::string file_name(const std::string& dir, int shape, int level)
+    {
+        std::ostringstream name;
+        name << dir;
+        if (!dir.empty() && dir[dir.size() - 1] != '/' &&
+            dir[dir.size() - 1] != '\\') {
+            name << '/';
+        }
+        name << "sphere_" << shape << "_" << level << "_"
+             << (sizeof(_Real) * 8) << ".osm";
+        return name.str();
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the mesh of a polyhedron subdivided level times, mapping
+    ///  or building it on first use.
+    ///
+    ///  @param shape  The initial polyhedron: 4, 8 or 20 faces.
+    ///  @param level  The number of subdivisions.
+    ///////////////////////////////////////////////////////////////////////
+    const mesh_type& get(int shape, int level)
+    {
+        mesh_type* mesh = 0;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp critical(optnet_sphere_mesh_cache)
+    #endif
+        {
+            typename mesh_map::iterator it =
+                m_meshes.find(std::make_pair(shape, level));
+
+            if (it != m_meshes.end()) {
+                mesh = it->second;
+            }
+            else {
+                mesh = new mesh_type;
+
+                std::string name;
+                if (!m_dir.empty()) name = file_name(m_dir, shape, level);
+
+                if (name.empty() || !mesh->map(name.c_str()) ||
+                    mesh->shape() != shape || mesh->level() != level) {
+                    mesh->create(shape, level);
+                    if (!name.empty()) mesh->save(name.c_str());
+                }
+
+                m_meshes[std::make_pair(shape, level)] = mesh;
+            }
+        }
+
+        return *mesh;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type size() const { return m_meshes.size(); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Removes all cached meshes.
+    ///////////////////////////////////////////////////////////////////////
+    void clear()
+    {
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp critical(optnet_sphere_mesh_cache)
+    #endif
+        {
+            typename mesh_map::iterator it;
+            for (it = m_meshes.begin(); it != m_meshes.end(); ++it) {
+                delete it->second;
+            }
+            m_meshes.clear();
+        }
+    }
+
+private:
+
+    typedef std::map<std::pair<int, int>, mesh_type*> mesh_map;
+
+    mesh_map        m_meshes;
+    std::string     m_dir;
+};
+
+        } // namespace
+    } // namespace
+} // namespace
+
+#endif // ___SPHERE_MESH_HXX___
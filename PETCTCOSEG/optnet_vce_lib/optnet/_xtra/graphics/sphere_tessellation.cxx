@@ -1355,7 +1355,7 @@ void sphere_tessellation<_Real>::expand(int level)
 
         for (l = 0; l < 2; ++l) {
             ep.v[l] = &m_poly.v[vertex_offset(seed, es.v[l])];
-            ep.t[l] = &m_poly.t[triangle_offset(seed, es.t[im])];
+            ep.t[l] = &m_poly.t[triangle_offset(seed, es.t[l])];
         }
     }
 
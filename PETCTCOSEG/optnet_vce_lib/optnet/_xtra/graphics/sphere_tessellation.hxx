@@ -128,6 +128,11 @@ public:
     ///////////////////////////////////////////////////////////////////////
     sphere_tessellation();
 
+    ///////////////////////////////////////////////////////////////////////
+    /// Destructor.
+    ///////////////////////////////////////////////////////////////////////
+    ~sphere_tessellation() { clear(); }
+
     ///////////////////////////////////////////////////////////////////////
     /// Create initial polyhedron.
     ///
@@ -267,6 +272,10 @@ protected:
     void update_centroid(size_type n);
     void expand(int level);
 
+    // Not copyable.
+    sphere_tessellation(const sphere_tessellation&);
+    sphere_tessellation& operator=(const sphere_tessellation&);
+
 };
 
         } // namespace
@@ -34,7 +34,8 @@ template <typename _Voxel, typename _RealVoxel, typename _Cap, typename _Tg>
 igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::igc_bk() :
     m_pimage(0), m_lambda(50), m_beta(0.5),
     m_fg_num_clusters(0), m_bg_num_clusters(0),
-    m_inf(std::numeric_limits<capacity_type>::max())
+    m_inf(std::numeric_limits<capacity_type>::max()),
+    m_nh(6), m_solved(false)
 {
 }
 
@@ -54,6 +55,8 @@ void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::create(
     }
     // Save a pointer to the input image.
     m_pimage = &image;
+    m_solved = false;
+    m_new_seeds.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -78,6 +81,7 @@ void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::set_trimap(
     // Clear all seed points.
     m_fg_seeds.clear();
     m_bg_seeds.clear();
+    m_solved = false;
 
     for (size_type i = 0; i < trimap.size(); ++i) {
         if (trimap[i] == FOREGROUND) { // foreground voxel
@@ -116,6 +120,11 @@ void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::solve(
     //   voxel is foreground or background.
     flow = m_graph.solve();
 
+    // Remember the state for subsequent resolve() calls.
+    m_nh     = nh;
+    m_solved = true;
+    m_new_seeds.clear();
+
     // Return the maximum-flow value (optional).
     if (0 != pflow)
         *pflow = flow;
@@ -128,6 +137,99 @@ void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::solve(
     int             nh,
     capacity_type*  pflow
     )
+{
+    // Perform segmentation.
+    solve(nh, pflow);
+
+    // Generate image mask that indicates foreground and background.
+    extract_mask(mask);
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Voxel, typename _RealVoxel, typename _Cap, typename _Tg>
+void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::resolve(
+    capacity_type* pflow
+    )
+{
+    if (!m_solved) {
+        // Nothing to reuse, perform a full segmentation.
+        solve(m_nh, pflow);
+        return;
+    }
+
+    assert(0 != m_pimage);
+
+    // The hard t-link capacity used for new seeds. Half of the maximum
+    //   is used so that the reparametrized t-link of a voxel (which may
+    //   carry a finite residual) can never overflow.
+    const capacity_type hard = m_inf / 2;
+
+    typename std::vector<seed_change>::const_iterator it;
+
+    for (it = m_new_seeds.begin(); it != m_new_seeds.end(); ++it) {
+
+        size_type index = m_pimage->offset(it->i0, it->i1, it->i2);
+
+        if (m_fg_seeds.find(index) != m_fg_seeds.end() &&
+            m_bg_seeds.find(index) != m_bg_seeds.end()) {
+            // The voxel is marked as both foreground
+            // and background. Throw an exception.
+            throw_exception(std::runtime_error(
+                "igc_bk::resolve: Ambiguous seed."
+            ));
+        }
+
+        // The voxel was not a seed when the graph was built, so its
+        //   t-link was the likelihood energy (clusters are kept fixed).
+        capacity_type fg_energy, bg_energy;
+
+        energy_likelihood(
+            (*m_pimage)(it->i0, it->i1, it->i2),
+            fg_energy,
+            bg_energy
+        );
+
+        if (it->fg) {
+            // foreground seed: (bg, fg) -> (hard, 0)
+            m_graph.update_st_arc(hard - bg_energy, -fg_energy,
+                                  it->i0, it->i1, it->i2);
+        }
+        else {
+            // background seed: (bg, fg) -> (0, hard)
+            m_graph.update_st_arc(-bg_energy, hard - fg_energy,
+                                  it->i0, it->i1, it->i2);
+        }
+    } // for
+
+    m_new_seeds.clear();
+
+    // Reuse the search trees and flows of the previous run.
+    capacity_type flow = m_graph.resolve();
+
+    // Return the maximum-flow value (optional).
+    if (0 != pflow)
+        *pflow = flow;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Voxel, typename _RealVoxel, typename _Cap, typename _Tg>
+void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::resolve(
+    mask_base_type& mask,
+    capacity_type*  pflow
+    )
+{
+    // Update segmentation.
+    resolve(pflow);
+
+    // Generate image mask that indicates foreground and background.
+    extract_mask(mask);
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Voxel, typename _RealVoxel, typename _Cap, typename _Tg>
+void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::extract_mask(
+    mask_base_type& mask
+    )
 {
     size_type i0, i1, i2;
 
@@ -147,9 +249,6 @@ void igc_bk<_Voxel, _RealVoxel, _Cap, _Tg>::solve(
         throw_exception(std::invalid_argument(errmsg));
     }
 
-    // Perform segmentation.
-    solve(nh, pflow);
-
     // Generate image mask that indicates foreground and background.
     for (i2 = 0; i2 < m_graph.size_2(); ++i2) {
         for (i1 = 0; i1 < m_graph.size_1(); ++i1) {
@@ -61,6 +61,7 @@
 #   include <cmath>
 #   include <limits>
 #   include <map>
+#   include <vector>
 
 #   ifdef max       // The max macro may interfere with
 #       undef max   //   std::numeric_limits::max().
@@ -148,7 +149,11 @@ public:
         assert(i2 < m_pimage->size_2());
         size_type index = m_pimage->offset(i0, i1, i2);
         // insert foreground seed
-        m_fg_seeds.insert(index_voxel_pair(index, (*m_pimage)[index]));
+        if (m_fg_seeds.insert(index_voxel_pair(index, (*m_pimage)[index])).second
+            && m_solved) {
+            // remember the new seed for resolve()
+            m_new_seeds.push_back(seed_change(i0, i1, i2, true));
+        }
     }
 
     ///////////////////////////////////////////////////////////////////////
@@ -157,6 +162,7 @@ public:
     inline void clear_foreground_seeds()
     {
         m_fg_seeds.clear();
+        m_solved = false; // removing seeds requires a full solve
     }
 
     ///////////////////////////////////////////////////////////////////////
@@ -178,7 +184,11 @@ public:
         assert(i2 < m_pimage->size_2());
         size_type index = m_pimage->offset(i0, i1, i2);
         // insert background seed
-        m_bg_seeds.insert(index_voxel_pair(index, (*m_pimage)[index]));
+        if (m_bg_seeds.insert(index_voxel_pair(index, (*m_pimage)[index])).second
+            && m_solved) {
+            // remember the new seed for resolve()
+            m_new_seeds.push_back(seed_change(i0, i1, i2, false));
+        }
     }
 
     ///////////////////////////////////////////////////////////////////////
@@ -187,6 +197,7 @@ public:
     inline void clear_background()
     {
         m_bg_seeds.clear();
+        m_solved = false; // removing seeds requires a full solve
     }
 
     ///////////////////////////////////////////////////////////////////////
@@ -248,6 +259,36 @@ public:
                capacity_type*  pflow = 0 // [OUT]
                );
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Update the segmentation after new seeds were added.
+    ///
+    ///  @param pflow  The output maximum flow value.
+    ///
+    ///  @remarks Only the t-links of the seeds added since the last
+    ///           solve() or resolve() call are changed; the seed
+    ///           clusters, the n-links, the search trees and the
+    ///           residual flows of the previous run are reused, so the
+    ///           cost is roughly proportional to the size of the stroke.
+    ///           Falls back to solve() if the graph has not been solved
+    ///           yet or if seeds were cleared.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    void resolve(capacity_type* pflow = 0);
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Update the segmentation after new seeds were added.
+    ///
+    ///  @param mask   The output mask that indicates foreground and
+    ///                background.
+    ///  @param pflow  The output maximum flow value.
+    ///
+    ///  @see   resolve(capacity_type*)
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    void resolve(mask_base_type& mask,     // [OUT]
+                 capacity_type*  pflow = 0 // [OUT]
+                 );
+
     ///////////////////////////////////////////////////////////////////////
     ///  Determines if the given voxel is a foreground voxel.
     ///
@@ -269,6 +310,19 @@ public:
 
 private:
 
+    // A seed added after the graph has been solved.
+    struct seed_change
+    {
+        seed_change(size_type _i0, size_type _i1, size_type _i2, bool _fg)
+            : i0(_i0), i1(_i1), i2(_i2), fg(_fg) {}
+
+        size_type   i0, i1, i2;
+        bool        fg;
+    };
+
+    // Check the mask size and fill it from the current cut.
+    void    extract_mask(mask_base_type& mask);
+
     // Cluster foreground and background seeds respectively to
     //   BK_CLUSTERS bins using K-means.
     void    cluster_seeds();
@@ -375,6 +429,9 @@ private:
     int             m_bg_num_clusters;
     capacity_type   m_inf;
     graph_type      m_graph;
+    int             m_nh;           // neighborhood of the last solve
+    bool            m_solved;       // true if m_graph holds a solution
+    std::vector<seed_change> m_new_seeds; // seeds added since then
 };
 
     } // namespace
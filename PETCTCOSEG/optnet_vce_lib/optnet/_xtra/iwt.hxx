@@ -45,7 +45,25 @@
  ==========================================================================
  */
 
-#   include <optnet/_xtra/array_sorter.hxx>
+#   include <optnet/config.h>
+#   include <optnet/_base/array.hxx>
+#   include <optnet/_base/array_ref.hxx>
+#   include <algorithm>
+#   include <utility>
+#   include <vector>
+
+//
+// The maximum number of slabs (along i2) that are flooded concurrently,
+// and the minimum number of planes per slab. The slab partition depends
+// only on the image size, so the result does not depend on the number
+// of threads.
+//
+#   ifndef OPTNET_IWT_MAX_SLABS
+#       define OPTNET_IWT_MAX_SLABS 32
+#   endif
+#   ifndef OPTNET_IWT_MIN_PLANES
+#       define OPTNET_IWT_MIN_PLANES 16
+#   endif
 
 /// @namespace optnet
 namespace optnet {
@@ -55,6 +73,23 @@ namespace optnet {
 ///////////////////////////////////////////////////////////////////////////
 /// @class iwt
 /// @brief A class that performs the interactive watershed transform.
+///
+/// The relief image (e.g., a gradient magnitude) is flooded from its
+/// regional minima by a priority flood: the voxels are visited in
+/// ascending order, and every voxel joins the basin of its lowest visited
+/// 6-neighbor. The first contact between two basins is their saddle.
+///
+/// The basins are then merged hierarchically, in ascending order of their
+/// saddles ("preflooding", [1]). A basin is merged into its neighbor
+/// if its depth below the saddle is at most the preflood height, or if
+/// either basin is smaller than the minimum region size. The resulting
+/// regions partition the image without watershed lines. They can serve as
+/// supervoxels.
+///
+/// The flooding runs on independent slabs along i2, concurrently when
+/// OpenMP is available. Basins split by a slab boundary meet at a saddle
+/// of depth 0 and are merged again; only the voxel assignment near the
+/// slab boundaries may differ from a flood of the whole image.
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Tx,
           typename _Tg = net_f_xy>
@@ -67,18 +102,311 @@ class iwt
     typedef _Tx                             value_type; 
     typedef size_t                          size_type;
 
+    // The lowest contact (saddle) of a basin with a neighboring basin.
+    typedef std::pair<int, value_type>      _Contact;
+
+    struct _Basin {
+        value_type              minimum;    // The height of the minimum.
+        size_type               size;       // The number of voxels.
+        std::vector<_Contact>   contacts;   // The basins with larger IDs.
+    };
+
+    struct _Saddle {
+        value_type  height;
+        int         basin[2];
+
+        bool operator<(const _Saddle& rhs) const
+        {
+            if (height != rhs.height) return height < rhs.height;
+            if (basin[0] != rhs.basin[0]) return basin[0] < rhs.basin[0];
+            return basin[1] < rhs.basin[1];
+        }
+    };
+
+    typedef std::vector<_Basin>             basin_vector;
+
+    // Orders the voxels of a slab by height, then by position.
+    struct _Ascending {
+        const _Tx* p;
+        _Ascending(const _Tx* p_) : p(p_) {}
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            return (p[a] < p[b]) || (!(p[b] < p[a]) && a < b);
+        }
+    };
+
 public:
 
-    iwt(const array_base_type& rarray)
+    typedef optnet::array<int, _Tg>         label_array_type;
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Constructor.
+    ///
+    ///  @param  rarray  The relief image. It must stay valid until
+    ///                  compute() returns.
+    ///////////////////////////////////////////////////////////////////////
+    iwt(const array_base_type& rarray) :
+        m_parray(&rarray), m_preflood(0), m_min_size(1), m_num_regions(0)
     {
-        //TODO: Implement this.
     }
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Sets the preflood height: basins that are at most this deep are
+    ///  merged into a neighbor (default 0, which only merges the flat
+    ///  basins of plateaus and slab boundaries).
+    ///////////////////////////////////////////////////////////////////////
+    inline void set_preflood_height(const value_type& h) { m_preflood = h; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Sets the minimum region size in voxels (default 1).
+    ///////////////////////////////////////////////////////////////////////
+    inline void set_min_size(size_type n) { m_min_size = n; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Computes the watershed regions.
+    ///////////////////////////////////////////////////////////////////////
     void compute()
     {
-        //TODO: Implement this.
+        const int       s0 = (int)m_parray->size_0();
+        const int       s1 = (int)m_parray->size_1();
+        const int       s2 = (int)m_parray->size_2();
+        const size_type ps = (size_type)s0 * s1;
+        const int       ns = std::max(1, std::min(s2 / OPTNET_IWT_MIN_PLANES,
+                                              OPTNET_IWT_MAX_SLABS));
+        const _Tx*      p  = m_parray->data();
+
+        std::vector<basin_vector>   slab_basins(ns);
+        std::vector<int>            offsets(ns + 1, 0);
+        basin_vector                basins;
+        int                         s, b;
+
+        m_labels.create(s0, s1, s2);
+        m_num_regions = 0;
+        if (0 == m_labels.size()) return;
+
+        int* lab = m_labels.data();
+
+        // Flood the slabs.
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for schedule(dynamic) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (s = 0; s < ns; ++s) {
+            flood(s0, s1, s2 * s / ns, s2 * (s + 1) / ns, slab_basins[s]);
+        }
+
+        // Give the basins global IDs.
+        for (s = 0; s < ns; ++s) {
+            offsets[s + 1] = offsets[s] + (int)slab_basins[s].size();
+        }
+
+        basins.resize(offsets[ns]);
+        for (s = 0; s < ns; ++s) {
+            for (b = 0; b < (int)slab_basins[s].size(); ++b) {
+                _Basin& src = slab_basins[s][b];
+                _Basin& dst = basins[offsets[s] + b];
+                dst.minimum = src.minimum;
+                dst.size    = src.size;
+                dst.contacts.swap(src.contacts);
+                for (size_type c = 0; c < dst.contacts.size(); ++c) {
+                    dst.contacts[c].first += offsets[s];
+                }
+            }
+            basin_vector().swap(slab_basins[s]);
+        }
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (s = 1; s < ns; ++s) {
+            int* q   = lab + ps * (s2 * s / ns);
+            int* end = lab + ps * (s2 * (s + 1) / ns);
+            for (; q < end; ++q) *q += offsets[s];
+        }
+
+        // The saddles across the slab boundaries.
+        for (s = 1; s < ns; ++s) {
+            size_type i = ps * (s2 * s / ns);
+            for (size_type j = i; j < i + ps; ++j) {
+                if (lab[j - ps] != lab[j]) {
+                    add_contact(basins, lab[j - ps], lab[j],
+                                std::max(p[j - ps], p[j]));
+                }
+            }
+        }
+
+        merge(basins, lab, m_labels.size());
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the number of regions found by compute().
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type num_regions() const { return m_num_regions; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the region ID (0 to num_regions() - 1) of every voxel.
+    ///////////////////////////////////////////////////////////////////////
+    inline const label_array_type& labels() const { return m_labels; }
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////
+    // Record a contact of basins a and b at height h, keeping the lowest
+    // one per pair.
+    static void add_contact(basin_vector&      basins,
+                            int                a,
+                            int                b,
+                            const value_type&  h
+                            )
+    {
+        if (a > b) std::swap(a, b);
+
+        std::vector<_Contact>& contacts = basins[a].contacts;
+        for (size_type c = 0; c < contacts.size(); ++c) {
+            if (contacts[c].first == b) {
+                if (h < contacts[c].second) contacts[c].second = h;
+                return;
+            }
+        }
+        contacts.push_back(_Contact(b, h));
     }
-    
+
+    ///////////////////////////////////////////////////////////////////////
+    // Flood the planes [z0, z1) by a priority flood. Writes slab-local
+    // basin IDs to the labels.
+    void flood(int s0, int s1, int z0, int z1, basin_vector& basins)
+    {
+        const size_type ps   = (size_type)s0 * s1;
+        const size_type base = ps * z0;
+        const size_type n    = ps * (z1 - z0);
+        const _Tx*      p    = m_parray->data() + base;
+        int*            lab  = m_labels.data() + base;
+
+        std::vector<unsigned int> order(n);
+        size_type i;
+
+        for (i = 0; i < n; ++i) {
+            order[i] = (unsigned int)i;
+            lab[i]   = -1;
+        }
+        std::sort(order.begin(), order.end(), _Ascending(p));
+
+        for (i = 0; i < n; ++i) {
+            const size_type v  = order[i];
+            const int       i0 = (int)(v % s0);
+            const int       i1 = (int)((v / s0) % s1);
+            const int       i2 = (int)(v / ps);
+            size_type       nb[6];
+            int             nn = 0, best = -1, k;
+
+            if (i0 > 0)           nb[nn++] = v - 1;
+            if (i0 + 1 < s0)      nb[nn++] = v + 1;
+            if (i1 > 0)           nb[nn++] = v - s0;
+            if (i1 + 1 < s1)      nb[nn++] = v + s0;
+            if (i2 > 0)           nb[nn++] = v - ps;
+            if (i2 + 1 < z1 - z0) nb[nn++] = v + ps;
+
+            // Join the basin of the lowest visited neighbor.
+            for (k = 0; k < nn; ++k) {
+                if (lab[nb[k]] >= 0 && (best < 0 || p[nb[k]] < p[nb[best]]))
+                    best = k;
+            }
+
+            if (best < 0) {
+                _Basin basin;
+                basin.minimum = p[v];
+                basin.size    = 0;
+                basins.push_back(basin);
+                lab[v] = (int)basins.size() - 1;
+            }
+            else {
+                lab[v] = lab[nb[best]];
+            }
+            ++basins[lab[v]].size;
+
+            for (k = 0; k < nn; ++k) {
+                if (lab[nb[k]] >= 0 && lab[nb[k]] != lab[v])
+                    add_contact(basins, lab[v], lab[nb[k]], p[v]);
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Merge the basins in ascending order of their saddles, and relabel
+    // the voxels with consecutive region IDs.
+    void merge(basin_vector& basins, int* lab, size_type n)
+    {
+        std::vector<_Saddle>    saddles;
+        std::vector<int>        parent(basins.size()), region(basins.size());
+        int                     b;
+
+        for (b = 0; b < (int)basins.size(); ++b) {
+            parent[b] = b;
+            for (size_type c = 0; c < basins[b].contacts.size(); ++c) {
+                _Saddle saddle;
+                saddle.height   = basins[b].contacts[c].second;
+                saddle.basin[0] = b;
+                saddle.basin[1] = basins[b].contacts[c].first;
+                saddles.push_back(saddle);
+            }
+            std::vector<_Contact>().swap(basins[b].contacts);
+        }
+
+        std::sort(saddles.begin(), saddles.end());
+
+        for (size_type i = 0; i < saddles.size(); ++i) {
+            int r0 = find(parent, saddles[i].basin[0]);
+            int r1 = find(parent, saddles[i].basin[1]);
+            if (r0 == r1) continue;
+
+            // r0 is the deeper basin, and survives.
+            if (basins[r1].minimum < basins[r0].minimum) std::swap(r0, r1);
+
+            const value_type& h = saddles[i].height;
+            if (!(m_preflood < h - basins[r1].minimum) ||
+                basins[r0].size < m_min_size ||
+                basins[r1].size < m_min_size) {
+                parent[r1] = r0;
+                basins[r0].size += basins[r1].size;
+            }
+        }
+
+        m_num_regions = 0;
+        for (b = 0; b < (int)basins.size(); ++b) {
+            if (parent[b] == b) region[b] = (int)m_num_regions++;
+        }
+        for (b = 0; b < (int)basins.size(); ++b) {
+            region[b] = region[find(parent, b)];
+        }
+
+        const int nc = OPTNET_IWT_MAX_SLABS;
+        int       c;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+        for (c = 0; c < nc; ++c) {
+            size_type end = n * (c + 1) / nc;
+            for (size_type i = n * c / nc; i < end; ++i) lab[i] = region[lab[i]];
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Union-find root with path halving.
+    static int find(std::vector<int>& parent, int b)
+    {
+        while (parent[b] != b) {
+            parent[b] = parent[parent[b]];
+            b = parent[b];
+        }
+        return b;
+    }
+
+    const array_base_type*  m_parray;
+    value_type              m_preflood;
+    size_type               m_min_size;
+    size_type               m_num_regions;
+    label_array_type        m_labels;
 };
 
     }   // namespace
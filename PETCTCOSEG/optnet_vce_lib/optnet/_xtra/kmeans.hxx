@@ -42,10 +42,16 @@
 #       pragma warning(disable: 4284)
 #   endif
 
-#   include <cstdlib>
+#   include <optnet/config.h>
 #   include <optnet/_base/iterator.hxx>
 #   include <optnet/_base/memory.hxx>
 #   include <optnet/_base/deref.hxx>
+#   include <algorithm>
+#   include <cassert>
+#   include <cmath>
+#   include <cstdlib>
+#   include <limits>
+#   include <vector>
 
 
 /// @namespace optnet
@@ -83,7 +89,6 @@ int kmeans(_IIt     input_begin,
            _Deref   deref
            )
 {
-    using optnet::xtra::detail;
     typedef typename _OIt::value_type ovalue_type;
     typedef typename _IIt::value_type ivalue_type;
 
@@ -171,6 +176,655 @@ int kmeans(_IIt     input_begin,
 } // kmeans
 
 
+///////////////////////////////////////////////////////////////////////////
+//  Volume k-means.
+//
+//  kmeans_scalar clusters the voxel values of a volume, and kmeans_vector
+//  the voxel features of a multi-channel volume (e.g., PET and CT) with
+//  a small, fixed number of channels. Both are seeded with k-means++.
+//  Both stop when no center moves by more than tol times the data range.
+//
+//  8- and 16-bit integer data is clustered exactly on its histogram.
+//  Any other scalar data is first clustered on a fine quantized histogram.
+//  A few exact passes over the voxels then refine the result. All voxel
+//  passes run over independent chunks, in parallel when OpenMP is on.
+///////////////////////////////////////////////////////////////////////////
+
+#   define OPTNET_KMEANS_MIN_CHUNK      65536
+#   define OPTNET_KMEANS_MAX_CHUNKS     16
+#   define OPTNET_KMEANS_QUANT_BINS     4096
+#   define OPTNET_KMEANS_SEED_SAMPLES   65536
+
+        namespace detail {
+
+///////////////////////////////////////////////////////////////////////////
+// The number of chunks to split n items into: at least min_chunk items per
+// chunk, and at most max_chunks chunks (0 means no limit). Chunk c holds
+// the items [n * c / nc, n * (c + 1) / nc).
+inline int kmeans_num_chunks(size_t n, size_t max_chunks)
+{
+    size_t nc = (n + OPTNET_KMEANS_MIN_CHUNK - 1) / OPTNET_KMEANS_MIN_CHUNK;
+    if (max_chunks > 0 && nc > max_chunks) nc = max_chunks;
+    return (nc > 0) ? (int)nc : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// A small linear congruential generator, so the seeding is reproducible
+// and does not touch the state of rand(). Returns a value in [0, 1).
+inline double kmeans_random(unsigned& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0 / 16777216.0);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Picks the item whose cumulative weight first reaches r.
+inline size_t kmeans_pick(const double* w, size_t n, double r)
+{
+    size_t i;
+    for (i = 0; i + 1 < n; ++i) {
+        r -= w[i];
+        if (r < 0) break;
+    }
+    return i;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// k-means++ seeding of weighted 1-D samples. If there are fewer distinct
+// values than k, the remaining centers repeat the last one.
+inline void kmeans_seed_1d(const double*   x,
+                           const double*   w,
+                           size_t          n,
+                           int             k,
+                           double*         means,
+                           unsigned        seed
+                           )
+{
+    std::vector<double> d2(n), p(n);
+    unsigned            state = seed;
+    double              total = 0;
+    size_t              i;
+    int                 j;
+
+    for (i = 0; i < n; ++i) total += w[i];
+    means[0] = x[kmeans_pick(w, n, kmeans_random(state) * total)];
+
+    for (i = 0; i < n; ++i) d2[i] = (x[i] - means[0]) * (x[i] - means[0]);
+
+    for (j = 1; j < k; ++j) {
+        total = 0;
+        for (i = 0; i < n; ++i) total += (p[i] = w[i] * d2[i]);
+        if (total <= 0) {
+            means[j] = means[j - 1];
+            continue;
+        }
+
+        means[j] = x[kmeans_pick(&p[0], n, kmeans_random(state) * total)];
+        for (i = 0; i < n; ++i) {
+            double d = (x[i] - means[j]) * (x[i] - means[j]);
+            if (d < d2[i]) d2[i] = d;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Lloyd iterations on weighted 1-D samples sorted in ascending order.
+// With sorted means, the clusters are the intervals between the midpoints
+// of adjacent means, so each iteration is one merge-like pass over the
+// samples. Returns the number of iterations; the means are sorted.
+inline int kmeans_lloyd_1d(const double*   x,
+                           const double*   w,
+                           size_t          n,
+                           int             k,
+                           double*         means,
+                           int             max_iter,
+                           double          tol
+                           )
+{
+    std::vector<double> sum(k), cnt(k);
+    int                 it = 0, j;
+
+    std::sort(means, means + k);
+
+    while (it < max_iter) {
+        double shift = 0;
+        size_t i;
+
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(cnt.begin(), cnt.end(), 0.0);
+
+        for (i = 0, j = 0; i < n; ++i) {
+            while (j < k - 1 && x[i] > 0.5 * (means[j] + means[j + 1])) ++j;
+            sum[j] += w[i] * x[i];
+            cnt[j] += w[i];
+        }
+
+        for (j = 0; j < k; ++j) {
+            if (cnt[j] > 0) {
+                double m = sum[j] / cnt[j];
+                if (fabs(m - means[j]) > shift) shift = fabs(m - means[j]);
+                means[j] = m;
+            }
+        }
+
+        std::sort(means, means + k);
+        ++it;
+
+        if (shift <= tol) break;
+    }
+
+    return it;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// The cluster of a scalar value given the k - 1 sorted boundaries between
+// the clusters. Branch-free, so the compiler can vectorize it.
+template <typename _Ty>
+inline int kmeans_cluster_1d(const _Ty& v, const double* bounds, int nb)
+{
+    int c = 0;
+    for (int j = 0; j < nb; ++j) c += ((double)v > bounds[j]);
+    return c;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// The boundaries between the clusters of sorted 1-D means.
+inline void kmeans_bounds_1d(const double* means, int k, double* bounds)
+{
+    for (int j = 0; j + 1 < k; ++j) {
+        bounds[j] = 0.5 * (means[j] + means[j + 1]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// The number of distinct sorted means.
+inline int kmeans_used_1d(const double* means, int k)
+{
+    int kused = 1;
+    for (int j = 1; j < k; ++j) {
+        if (means[j] > means[j - 1]) ++kused;
+    }
+    return kused;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Scalar k-means of 8- and 16-bit integer data, exactly on the histogram.
+template <typename _Ty>
+int kmeans_scalar_hist(const _Ty*      data,
+                       size_t          n,
+                       int             k,
+                       double*         means,
+                       int             max_iter,
+                       double          tol,
+                       unsigned        seed
+                       )
+{
+    const size_t        nbins = size_t(1) << (8 * sizeof(_Ty));
+    const int           vmin  = (int)std::numeric_limits<_Ty>::min();
+    const int           nc    = kmeans_num_chunks(n, OPTNET_KMEANS_MAX_CHUNKS);
+    std::vector<size_t> hist(nc * nbins, 0);
+    std::vector<double> x, w;
+    int                 c;
+    size_t              b;
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (c = 0; c < nc; ++c) {
+        size_t* h  = &hist[c * nbins];
+        size_t  lo = n * c / nc, hi = n * (c + 1) / nc;
+        for (size_t i = lo; i < hi; ++i) ++h[(int)data[i] - vmin];
+    }
+
+    for (c = 1; c < nc; ++c) {
+        for (b = 0; b < nbins; ++b) hist[b] += hist[c * nbins + b];
+    }
+
+    for (b = 0; b < nbins; ++b) {
+        if (hist[b] > 0) {
+            x.push_back((double)((int)b + vmin));
+            w.push_back((double)hist[b]);
+        }
+    }
+
+    kmeans_seed_1d(&x[0], &w[0], x.size(), k, means, seed);
+    kmeans_lloyd_1d(&x[0], &w[0], x.size(), k, means, max_iter,
+                    tol * (x.back() - x.front()));
+
+    return kmeans_used_1d(means, k);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Scalar k-means of arbitrary data: clusters a quantized histogram whose
+// bins are represented by the means of their values, then refines the
+// centers by exact Lloyd passes over the data.
+template <typename _Ty>
+int kmeans_scalar_quant(const _Ty*     data,
+                        size_t         n,
+                        int            k,
+                        double*        means,
+                        int            max_iter,
+                        double         tol,
+                        unsigned       seed
+                        )
+{
+    const size_t        nbins = OPTNET_KMEANS_QUANT_BINS;
+    const int           nc    = kmeans_num_chunks(n, OPTNET_KMEANS_MAX_CHUNKS);
+    std::vector<double> lo(nc), hi(nc);
+    std::vector<double> bsum(nc * nbins, 0.0), bcnt(nc * nbins, 0.0);
+    std::vector<double> x, w, bounds(k), sum(nc * k), cnt(nc * k);
+    double              vmin, vmax, scale;
+    int                 c, j, it;
+    size_t              b;
+
+    // the value range
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (c = 0; c < nc; ++c) {
+        size_t i = n * c / nc, end = n * (c + 1) / nc;
+        double l = (double)data[i], h = l;
+        for (++i; i < end; ++i) {
+            double v = (double)data[i];
+            if (v < l) l = v;
+            if (v > h) h = v;
+        }
+        lo[c] = l;
+        hi[c] = h;
+    }
+
+    vmin = *std::min_element(lo.begin(), lo.end());
+    vmax = *std::max_element(hi.begin(), hi.end());
+
+    if (vmax <= vmin) {
+        for (j = 0; j < k; ++j) means[j] = vmin;
+        return 1;
+    }
+
+    // the quantized histogram
+    scale = nbins / (vmax - vmin);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (c = 0; c < nc; ++c) {
+        double* s   = &bsum[c * nbins];
+        double* m   = &bcnt[c * nbins];
+        size_t  end = n * (c + 1) / nc;
+        for (size_t i = n * c / nc; i < end; ++i) {
+            double v = (double)data[i];
+            size_t q = (size_t)((v - vmin) * scale);
+            if (q >= nbins) q = nbins - 1;
+            s[q] += v;
+            m[q] += 1;
+        }
+    }
+
+    for (c = 1; c < nc; ++c) {
+        for (b = 0; b < nbins; ++b) {
+            bsum[b] += bsum[c * nbins + b];
+            bcnt[b] += bcnt[c * nbins + b];
+        }
+    }
+
+    for (b = 0; b < nbins; ++b) {
+        if (bcnt[b] > 0) {
+            x.push_back(bsum[b] / bcnt[b]);
+            w.push_back(bcnt[b]);
+        }
+    }
+
+    tol *= vmax - vmin;
+    kmeans_seed_1d(&x[0], &w[0], x.size(), k, means, seed);
+    kmeans_lloyd_1d(&x[0], &w[0], x.size(), k, means, max_iter, tol);
+
+    // exact refinement
+    for (it = 0; it < max_iter; ++it) {
+        double shift = 0;
+
+        kmeans_bounds_1d(means, k, &bounds[0]);
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(cnt.begin(), cnt.end(), 0.0);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+        for (c = 0; c < nc; ++c) {
+            double* s   = &sum[c * k];
+            double* m   = &cnt[c * k];
+            size_t  end = n * (c + 1) / nc;
+            for (size_t i = n * c / nc; i < end; ++i) {
+                int q = kmeans_cluster_1d(data[i], &bounds[0], k - 1);
+                s[q] += (double)data[i];
+                m[q] += 1;
+            }
+        }
+
+        for (j = 0; j < k; ++j) {
+            for (c = 1; c < nc; ++c) {
+                sum[j] += sum[c * k + j];
+                cnt[j] += cnt[c * k + j];
+            }
+            if (cnt[j] > 0) {
+                double mj = sum[j] / cnt[j];
+                if (fabs(mj - means[j]) > shift) shift = fabs(mj - means[j]);
+                means[j] = mj;
+            }
+        }
+
+        std::sort(means, means + k);
+        if (shift <= tol) break;
+    }
+
+    return kmeans_used_1d(means, k);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Selects the scalar k-means at compile time: the exact histogram one for
+// 8- and 16-bit integer data, the quantized one otherwise. So the
+// histogram version is never instantiated for wider types.
+template <bool _Hist>
+struct kmeans_scalar_select
+{
+    template <typename _Ty>
+    static int run(const _Ty* data, size_t n, int k, double* means,
+                   int max_iter, double tol, unsigned seed)
+    {
+        return kmeans_scalar_quant(data, n, k, means, max_iter, tol, seed);
+    }
+};
+
+template <>
+struct kmeans_scalar_select<true>
+{
+    template <typename _Ty>
+    static int run(const _Ty* data, size_t n, int k, double* means,
+                   int max_iter, double tol, unsigned seed)
+    {
+        return kmeans_scalar_hist(data, n, k, means, max_iter, tol, seed);
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////
+// The nearest of k centers to a feature vector. The centers are stored by
+// channel (c[d * k + j] is channel d of center j), so the distances to all
+// centers are accumulated in one vectorizable loop per channel.
+template <int _Dim, typename _Ty>
+inline int kmeans_nearest(const _Ty* x, const float* c, int k, float* dist)
+{
+    int j, best = 0;
+
+    for (j = 0; j < k; ++j) dist[j] = 0;
+
+    for (int d = 0; d < _Dim; ++d) {
+        const float  xd = (float)x[d];
+        const float* cd = c + d * k;
+        for (j = 0; j < k; ++j) {
+            float t = xd - cd[j];
+            dist[j] += t * t;
+        }
+    }
+
+    for (j = 1; j < k; ++j) {
+        if (dist[j] < dist[best]) best = j;
+    }
+
+    return best;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Copies interleaved centers (means[j * _Dim + d]) to the channel-major
+// layout used by kmeans_nearest.
+template <int _Dim>
+inline void kmeans_transpose(const double* means, int k, float* c)
+{
+    for (int j = 0; j < k; ++j) {
+        for (int d = 0; d < _Dim; ++d) c[d * k + j] = (float)means[j * _Dim + d];
+    }
+}
+
+        } // namespace detail
+
+
+///////////////////////////////////////////////////////////////////////////
+///  K-means clustering of scalar volume data.
+///
+///  @param  data      The voxel values (finite).
+///  @param  n         The number of voxels.
+///  @param  k         The number of clusters.
+///  @param  means     The output cluster centers (k values), in
+///                    ascending order.
+///  @param  max_iter  The maximum number of Lloyd iterations.
+///  @param  tol       Iterations stop when no center moves more than
+///                    tol times the data range.
+///  @param  seed      The seed of the k-means++ initialization.
+///
+///  @return The number of distinct centers; less than k if the data has
+///          fewer than k distinct values.
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty>
+int kmeans_scalar(const _Ty*   data,
+                  size_t       n,
+                  int          k,
+                  double*      means,
+                  int          max_iter = 100,
+                  double       tol = 1e-4,
+                  unsigned     seed = 1
+                  )
+{
+    assert(n > 0 && k > 0);
+
+    return detail::kmeans_scalar_select<
+        std::numeric_limits<_Ty>::is_integer && sizeof(_Ty) <= 2
+        >::run(data, n, k, means, max_iter, tol, seed);
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+///  Labels scalar voxels with their nearest cluster.
+///
+///  @param  data    The voxel values.
+///  @param  n       The number of voxels.
+///  @param  k       The number of clusters (at most 256).
+///  @param  means   The cluster centers, in ascending order.
+///  @param  labels  The output labels (n values, 0 to k - 1).
+///////////////////////////////////////////////////////////////////////////
+template <typename _Ty>
+void kmeans_scalar_classify(const _Ty*      data,
+                            size_t          n,
+                            int             k,
+                            const double*   means,
+                            unsigned char*  labels
+                            )
+{
+    std::vector<double> bounds(k);
+    const int           nc = detail::kmeans_num_chunks(n, 0);
+    int                 c;
+
+    detail::kmeans_bounds_1d(means, k, &bounds[0]);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (c = 0; c < nc; ++c) {
+        size_t end = n * (c + 1) / nc;
+        for (size_t i = n * c / nc; i < end; ++i) {
+            labels[i] = (unsigned char)
+                detail::kmeans_cluster_1d(data[i], &bounds[0], k - 1);
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+///  K-means clustering of low-dimensional volume features.
+///
+///  @param  data      The voxel features, interleaved: channel d of voxel
+///                    i is data[i * _Dim + d].
+///  @param  n         The number of voxels.
+///  @param  k         The number of clusters.
+///  @param  means     The output cluster centers (k * _Dim values,
+///                    interleaved as the data).
+///  @param  max_iter  The maximum number of Lloyd iterations.
+///  @param  tol       Iterations stop when no center moves more than
+///                    tol times the largest channel range.
+///  @param  seed      The seed of the k-means++ initialization, which
+///                    runs on an evenly strided subsample.
+///
+///  @return The number of iterations.
+///////////////////////////////////////////////////////////////////////////
+template <int _Dim, typename _Ty>
+int kmeans_vector(const _Ty*   data,
+                  size_t       n,
+                  int          k,
+                  double*      means,
+                  int          max_iter = 100,
+                  double       tol = 1e-4,
+                  unsigned     seed = 1
+                  )
+{
+    const size_t        stride = (n > OPTNET_KMEANS_SEED_SAMPLES)
+                               ? n / OPTNET_KMEANS_SEED_SAMPLES : 1;
+    const size_t        m  = (n + stride - 1) / stride;
+    const int           nc = detail::kmeans_num_chunks(n, 0);
+    std::vector<double> d2(m), p(m), sum(nc * k * _Dim), cnt(nc * k);
+    std::vector<float>  centers(_Dim * k);
+    unsigned            state = seed;
+    double              range = 0, total;
+    size_t              i;
+    int                 c, d, j, it;
+
+    assert(n > 0 && k > 0);
+
+    // k-means++ seeding on the subsample
+    for (d = 0; d < _Dim; ++d) {
+        double l = (double)data[d], h = l;
+        for (i = 0; i < m; ++i) {
+            double v = (double)data[i * stride * _Dim + d];
+            if (v < l) l = v;
+            if (v > h) h = v;
+        }
+        if (h - l > range) range = h - l;
+    }
+
+    i = (size_t)(detail::kmeans_random(state) * m);
+    for (d = 0; d < _Dim; ++d) means[d] = (double)data[i * stride * _Dim + d];
+    std::fill(d2.begin(), d2.end(), std::numeric_limits<double>::max());
+
+    for (j = 0; j < k; ++j) {
+        if (j > 0) {
+            total = 0;
+            for (i = 0; i < m; ++i) total += (p[i] = d2[i]);
+            if (total <= 0) {
+                for (d = 0; d < _Dim; ++d) {
+                    means[j * _Dim + d] = means[(j - 1) * _Dim + d];
+                }
+                continue;
+            }
+            i = detail::kmeans_pick(&p[0], m, detail::kmeans_random(state) * total);
+            for (d = 0; d < _Dim; ++d) {
+                means[j * _Dim + d] = (double)data[i * stride * _Dim + d];
+            }
+        }
+        for (i = 0; i < m; ++i) {
+            const _Ty* x = data + i * stride * _Dim;
+            double     e = 0;
+            for (d = 0; d < _Dim; ++d) {
+                double t = (double)x[d] - means[j * _Dim + d];
+                e += t * t;
+            }
+            if (e < d2[i]) d2[i] = e;
+        }
+    }
+
+    // Lloyd iterations
+    tol *= range;
+    for (it = 0; it < max_iter; ) {
+        double shift = 0;
+
+        detail::kmeans_transpose<_Dim>(means, k, &centers[0]);
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(cnt.begin(), cnt.end(), 0.0);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+        for (c = 0; c < nc; ++c) {
+            std::vector<float> dist(k);
+            double*            s   = &sum[c * k * _Dim];
+            double*            q   = &cnt[c * k];
+            size_t             end = n * (c + 1) / nc;
+            for (size_t i = n * c / nc; i < end; ++i) {
+                const _Ty* x = data + i * _Dim;
+                int        b = detail::kmeans_nearest<_Dim>(x, &centers[0], k, &dist[0]);
+                for (int d = 0; d < _Dim; ++d) s[b * _Dim + d] += (double)x[d];
+                q[b] += 1;
+            }
+        }
+
+        for (j = 0; j < k; ++j) {
+            double e = 0;
+            for (c = 1; c < nc; ++c) {
+                cnt[j] += cnt[c * k + j];
+                for (d = 0; d < _Dim; ++d) {
+                    sum[j * _Dim + d] += sum[(c * k + j) * _Dim + d];
+                }
+            }
+            if (cnt[j] > 0) {
+                for (d = 0; d < _Dim; ++d) {
+                    double t = sum[j * _Dim + d] / cnt[j];
+                    e += (t - means[j * _Dim + d]) * (t - means[j * _Dim + d]);
+                    means[j * _Dim + d] = t;
+                }
+            }
+            if (e > shift) shift = e;
+        }
+
+        ++it;
+        if (shift <= tol * tol) break;
+    }
+
+    return it;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+///  Labels voxel features with their nearest cluster.
+///
+///  @param  data    The voxel features, interleaved as in kmeans_vector.
+///  @param  n       The number of voxels.
+///  @param  k       The number of clusters (at most 256).
+///  @param  means   The cluster centers, interleaved.
+///  @param  labels  The output labels (n values, 0 to k - 1).
+///////////////////////////////////////////////////////////////////////////
+template <int _Dim, typename _Ty>
+void kmeans_vector_classify(const _Ty*      data,
+                            size_t          n,
+                            int             k,
+                            const double*   means,
+                            unsigned char*  labels
+                            )
+{
+    std::vector<float>  centers(_Dim * k);
+    const int           nc = detail::kmeans_num_chunks(n, 0);
+    int                 c;
+
+    detail::kmeans_transpose<_Dim>(means, k, &centers[0]);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (c = 0; c < nc; ++c) {
+        std::vector<float> dist(k);
+        size_t             end = n * (c + 1) / nc;
+        for (size_t i = n * c / nc; i < end; ++i) {
+            labels[i] = (unsigned char)detail::kmeans_nearest<_Dim>(
+                data + i * _Dim, &centers[0], k, &dist[0]);
+        }
+    }
+}
+
+
     } // namespace
 } // namespace
 
@@ -88,6 +88,11 @@
 #       endif
 #   endif
 
+#   if defined(__GNUC__) && defined(_OPENMP)
+#       define __OPTNET_PRAGMA_OMP__
+#       define __OPTNET_OMP_NUM_THREADS__ 4
+#   endif
+
 #   ifndef OPTNET_IMPEXP
 #      ifdef OPTNET_EXPORTS
 #         define OPTNET_IMPEXP __declspec(dllexport)
@@ -120,6 +125,14 @@
 #       define __OPTNET_REMOVE_UNUSED_ARG__
 #   endif
 
+/* pointer aliasing hint */
+#   if defined(__OPTNET_CC_GNUC__) || defined(__OPTNET_CC_INTEL__) \
+        || (defined(__OPTNET_CC_MSC__) && (__OPTNET_CC_MSC_VER__ >= 1400))
+#       define OPTNET_RESTRICT __restrict
+#   else
+#       define OPTNET_RESTRICT
+#   endif
+
 #   if defined(__OPTNET_REMOVE_UNUSED_ARG__)
 #       define OPTNET_UNUSED(arg) /* arg */
 #   else  // stupid, broken compiler
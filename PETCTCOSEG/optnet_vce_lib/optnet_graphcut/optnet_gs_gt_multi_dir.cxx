@@ -10,6 +10,7 @@
 #ifndef ___OPTNET_GS_GT_MULTI_DIR_CXX___
 #   define ___OPTNET_GS_GT_MULTI_DIR_CXX___
 
+#   include <optnet/config.h>
 #   include <optnet/_base/except.hxx>
 #   include <optnet_graphcut/optnet_gs_gt_multi_dir.hxx>
 
@@ -17,14 +18,20 @@
 #       pragma warning(disable: 4018)
 #       pragma warning(disable: 4146)
 #   endif
+#   include <algorithm>
+#   include <cmath>
 #   include <deque>
+#   ifndef ___OPTNET_NO_EXCEPTIONS__
+#       include <exception>
+#   endif
 
 namespace optnet {
 
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cost, typename _Cap, typename _Tg>
 optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::optnet_gs_gt_multi_dir() :
-    m_pcost_gs(0)
+    m_pcost_gs(0), m_pcost_ob(0), m_pcost_bg(0), m_pcost_neigh(0),
+    m_neigh_coef(0), m_column_pruning(true), m_verbose(true), m_arc_weight_pow(0)
 {}
 
 ///////////////////////////////////////////////////////////////////////////
@@ -58,16 +65,47 @@ int
 optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::arc_weight(int k)
                                           
 {
-   int weight;
-   if ( k == 0 )
-   weight = 1;
-   else
-   weight = pow( double(k+1), double(pow_vce) )-2 * pow( double(k), double(pow_vce)) + pow( double(k-1), double(pow_vce)) ;
+   // The weights only depend on k and pow_vce, so they are computed
+   // once and looked up afterwards.
+   if ( m_arc_weight_pow != pow_vce )
+   {
+      m_arc_weights.clear();
+      m_arc_weight_pow = pow_vce;
+   }
+
+   while ( (int)m_arc_weights.size() <= k )
+   {
+      int j = (int)m_arc_weights.size();
+      int weight;
+      if ( j == 0 )
+      weight = 1;
+      else
+      weight = pow( double(j+1), double(pow_vce) )-2 * pow( double(j), double(pow_vce)) + pow( double(j-1), double(pow_vce)) ;
+
+      m_arc_weights.push_back( weight );
+   }
    
-   return weight;
+   return m_arc_weights[k];
    
 }
 
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::fill_arc_chain(std::vector<capacity_type>& chain,
+                                                        float                       cof,
+                                                        int                         count
+                                                        )
+{
+   if ( count <= 0 ) return;
+
+   chain.resize( count );
+   arc_weight( count - 1 ); // make sure the table is large enough
+
+   for (int k = 0; k < count; k++)
+      chain[k] = (capacity_type)( cof * m_arc_weights[k] );
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////
@@ -99,6 +137,323 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::set_shape_prior(const shape_vce_type&
     m_shape_prior.push_back( shape_vce );
 }
 
+///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::set_shape_model(const shape_model& model)
+{
+    if (model.geometry(0) != m_graph.size_0() ||
+        model.geometry(1) != m_graph.size_1() ||
+        model.geometry(2) != m_graph.size_2()) {
+        throw_exception(std::invalid_argument(
+            "optnet_gs_gt_multi_dir::set_shape_model: The shape model was built for another graph size."
+            ));
+    }
+
+    m_shape_prior.assign( model.priors().begin(),
+                          model.priors().end() );
+}
+
+///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::get_bounds_of_subgraphs()
+{
+	size_type num_pruned = 0, num_nodes = 0;
+
+	m_bounds.clear();
+	m_bounds.resize( m_graph.size_3() );
+
+	for (size_type is = 0; is < m_shape_prior.size(); ++is)
+	{
+		const shape_vce_type& shape_vce = m_shape_prior[is];
+		_Column_bounds&       bounds    = m_bounds[shape_vce.k];
+		int                   s0, s1, s2, c, i0, i1;
+
+		if ( shape_vce.dir == 0 || shape_vce.dir == 1 )
+		{
+			bounds.axis = 0;
+			s0 = (int)m_graph.size_1();
+			s1 = (int)m_graph.size_2();
+			s2 = (int)m_graph.size_0();
+		}
+		else if ( shape_vce.dir == 2 || shape_vce.dir == 3 )
+		{
+			bounds.axis = 1;
+			s0 = (int)m_graph.size_0();
+			s1 = (int)m_graph.size_2();
+			s2 = (int)m_graph.size_1();
+		}
+		else
+		{
+			bounds.axis = 2;
+			s0 = (int)m_graph.size_0();
+			s1 = (int)m_graph.size_1();
+			s2 = (int)m_graph.size_2();
+		}
+
+		if ( shape_vce.size_0() != (size_type)s0 ||
+			 shape_vce.size_1() != (size_type)s1 )
+		{
+			throw_exception(std::invalid_argument(
+				"optnet_gs_gt_multi_dir::solve: The shape prior size must match the graph size."
+				));
+		}
+
+		bounds.s0 = s0;
+		bounds.lo.assign( s0 * s1, 0 );
+		bounds.hi.assign( s0 * s1, s2 - 1 );
+		num_nodes += (size_type)(s0 * s1 * s2);
+
+		if ( !m_column_pruning ) continue;
+
+		// Propagate the height intervals through the hard shape
+		// constraints until nothing changes. A column is re-examined
+		// whenever one of its bounds has been tightened.
+		std::deque<int>   queue;
+		std::vector<char> queued( s0 * s1, 1 );
+		bool              feasible = true;
+
+		for (c = 0; c < s0 * s1; ++c) queue.push_back( c );
+
+		while ( feasible && !queue.empty() )
+		{
+			c = queue.front();
+			queue.pop_front();
+			queued[c] = 0;
+
+			i0 = c % s0;
+			i1 = c / s0;
+
+			// (dir-0)
+			if ( i0 > 0 )
+				feasible = relax_column_bounds( bounds, s2, c - 1, c,
+					shape_vce(i0 - 1, i1).mean[0] - shape_vce(i0 - 1, i1).low[0],
+					-shape_vce(i0 - 1, i1).mean[0] - shape_vce(i0 - 1, i1).up[0],
+					queue, queued ) && feasible;
+			if ( i0 + 1 < s0 )
+				feasible = relax_column_bounds( bounds, s2, c, c + 1,
+					shape_vce(i0, i1).mean[0] - shape_vce(i0, i1).low[0],
+					-shape_vce(i0, i1).mean[0] - shape_vce(i0, i1).up[0],
+					queue, queued ) && feasible;
+			// (dir-1)
+			if ( i1 > 0 )
+				feasible = relax_column_bounds( bounds, s2, c - s0, c,
+					shape_vce(i0, i1 - 1).mean[1] - shape_vce(i0, i1 - 1).low[1],
+					-shape_vce(i0, i1 - 1).mean[1] - shape_vce(i0, i1 - 1).up[1],
+					queue, queued ) && feasible;
+			if ( i1 + 1 < s1 )
+				feasible = relax_column_bounds( bounds, s2, c, c + s0,
+					shape_vce(i0, i1).mean[1] - shape_vce(i0, i1).low[1],
+					-shape_vce(i0, i1).mean[1] - shape_vce(i0, i1).up[1],
+					queue, queued ) && feasible;
+		}
+
+		if ( !feasible )
+		{
+			// The hard constraints contradict each other; keep the
+			// whole graph and let the max-flow solver sort it out.
+			if (m_verbose)
+				cout << "Column pruning skipped for surface " << shape_vce.k << endl;
+			bounds.lo.assign( s0 * s1, 0 );
+			bounds.hi.assign( s0 * s1, s2 - 1 );
+			continue;
+		}
+
+		for (c = 0; c < s0 * s1; ++c)
+			num_pruned += (size_type)(bounds.lo[c] + (s2 - 1 - bounds.hi[c]));
+	}
+
+	if ( m_verbose && num_nodes > 0 )
+		cout << "Pruned " << num_pruned << " of " << num_nodes
+		     << " graph search nodes" << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+bool
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::relax_column_bounds(
+	_Column_bounds&    bounds,
+	int                s2,
+	int                c0,
+	int                c1,
+	int                d01,
+	int                d10,
+	std::deque<int>&   queue,
+	std::vector<char>& queued
+	)
+{
+	// Every node of column c0 at height h is linked to the node of
+	// column c1 at height min(max(h + d01, 0), s2 - 1) by a hard
+	// constraint, i.e. h(c1) >= h(c0) + d01 (clamped), and likewise
+	// h(c0) >= h(c1) + d10 (clamped).
+	const int a[2] = { c0, c1 };
+	const int b[2] = { c1, c0 };
+	const int d[2] = { d01, d10 };
+
+	for (int e = 0; e < 2; ++e)
+	{
+		int v = bounds.lo[a[e]] + d[e];
+		if ( v < 0 ) v = 0;
+		if ( v > s2 - 1 ) v = s2 - 1;
+
+		// Raise the lower bound of the head column.
+		if ( v > bounds.lo[b[e]] )
+		{
+			bounds.lo[b[e]] = v;
+			if ( v > bounds.hi[b[e]] ) return false;
+			if ( !queued[b[e]] ) { queued[b[e]] = 1; queue.push_back( b[e] ); }
+		}
+
+		// Lower the upper bound of the tail column. The top node of
+		// the head column is always reachable, so only a lowered head
+		// bound can restrict the tail.
+		if ( bounds.hi[b[e]] < s2 - 1 )
+		{
+			v = bounds.hi[b[e]] - d[e];
+			if ( v < bounds.hi[a[e]] )
+			{
+				bounds.hi[a[e]] = v;
+				if ( v < bounds.lo[a[e]] ) return false;
+				if ( !queued[a[e]] ) { queued[a[e]] = 1; queue.push_back( a[e] ); }
+			}
+		}
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::add_gs_arc(
+	size_type tail_0, size_type tail_1, size_type tail_2, size_type tail_3,
+	size_type head_0, size_type head_1, size_type head_2, size_type head_3
+	)
+{
+	int tail_state = column_state( tail_0, tail_1, tail_2, tail_3 );
+	int head_state = column_state( head_0, head_1, head_2, head_3 );
+
+	// The constraint can never be violated.
+	if ( tail_state == PRUNED_ABOVE || head_state == PRUNED_BELOW )
+		return;
+
+	if ( tail_state == PRUNED_BELOW )
+	{
+		// The tail is always on the source side: so must be the head.
+		m_graph.add_st_arc( MAX_VALUE, 0, head_0, head_1, head_2, head_3 );
+	}
+	else if ( head_state == PRUNED_ABOVE )
+	{
+		// The head is always on the sink side: so must be the tail.
+		m_graph.add_st_arc( 0, MAX_VALUE, tail_0, tail_1, tail_2, tail_3 );
+	}
+	else
+	{
+		m_graph.add_arc( tail_0, tail_1, tail_2, tail_3,
+		                 head_0, head_1, head_2, head_3 );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::add_gs_arc_chain(
+	const std::vector<capacity_type>& chain,
+	int       count,
+	size_type tail_0, size_type tail_1, size_type tail_2, size_type tail_3,
+	size_type head_0, size_type head_1, size_type head_2, size_type head_3
+	)
+{
+	if ( count <= 0 ) return;
+
+	int tail_state = column_state( tail_0, tail_1, tail_2, tail_3 );
+
+	// The arcs can never be cut.
+	if ( tail_state == PRUNED_ABOVE ) return;
+
+	// The k-th arc ends k nodes below the first head node.
+	const int axis    = m_bounds[head_3].axis;
+	size_type head[3] = { head_0, head_1, head_2 };
+	size_type top     = head[axis];
+	int       first   = 0, last = count, k;
+
+	// Skip the heads above the feasible range (they come first) and
+	// below it (they come last).
+	for (k = 0; k < count; ++k)
+	{
+		head[axis] = top - k;
+		int head_state = column_state( head[0], head[1], head[2], head_3 );
+		if ( head_state == PRUNED_ABOVE ) first = k + 1;
+		else if ( head_state == PRUNED_BELOW ) { last = k; break; }
+	}
+
+	if ( tail_state == PRUNED_BELOW )
+	{
+		// The cost of each arc is paid whenever its head is on the
+		// sink side.
+		for (k = first; k < last; ++k)
+		{
+			head[axis] = top - k;
+			if ( chain[k] != 0 )
+				m_graph.add_st_arc( chain[k], 0, head[0], head[1], head[2], head_3 );
+		}
+		return;
+	}
+
+	// The arcs into the pruned heads are always cut when the tail is on
+	// the source side.
+	capacity_type to_sink = 0;
+	for (k = 0; k < first; ++k) to_sink += chain[k];
+	if ( to_sink != 0 )
+		m_graph.add_st_arc( 0, to_sink, tail_0, tail_1, tail_2, tail_3 );
+
+	if ( first < last )
+	{
+		head[axis] = top - first;
+		m_graph.add_arc_chain( &chain[first], last - first,
+		                       tail_0, tail_1, tail_2, tail_3,
+		                       head[0], head[1], head[2], head_3, axis );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::add_gs_arc_cost(
+	capacity_type cost,
+	size_type tail_0, size_type tail_1, size_type tail_2, size_type tail_3,
+	size_type head_0, size_type head_1, size_type head_2, size_type head_3
+	)
+{
+	int tail_state = column_state( tail_0, tail_1, tail_2, tail_3 );
+	int head_state = column_state( head_0, head_1, head_2, head_3 );
+
+	// The arc can never be cut.
+	if ( tail_state == PRUNED_ABOVE || head_state == PRUNED_BELOW )
+		return;
+
+	if ( tail_state == PRUNED_BELOW )
+	{
+		// The cost is paid whenever the head is on the sink side
+		// (or always, if the head is pruned as well).
+		if ( head_state != PRUNED_ABOVE )
+			m_graph.add_st_arc( cost, 0, head_0, head_1, head_2, head_3 );
+	}
+	else if ( head_state == PRUNED_ABOVE )
+	{
+		// The cost is paid whenever the tail is on the source side.
+		m_graph.add_st_arc( 0, cost, tail_0, tail_1, tail_2, tail_3 );
+	}
+	else
+	{
+		m_graph.add_arc_cost( cost, tail_0, tail_1, tail_2, tail_3,
+		                            head_0, head_1, head_2, head_3 );
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cost, typename _Cap, typename _Tg>
@@ -107,8 +462,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::solve_all(net_base_type& net,
                                             capacity_type* pflow
                                             )
 {
-    size_type       i0, i1, i2, i3;
-	int 			s0, s1, s2;
+    size_type       i3;
     capacity_type   flow;
 
     if (net.size_0() != m_graph.size_0() || 
@@ -124,275 +478,1137 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::solve_all(net_base_type& net,
     }
 
 	m_graph.set_initial_flow(0);
+
+	// Find the feasible height range of every column so that the
+	// unreachable column segments are left out of the graph.
+	get_bounds_of_subgraphs();
+
 	// Assign the cost of graph nodes based on the input cost
     // vector. We also perform the "translation operation"
     // here to guaranttee a non-empty solution.
    
     //Build the graph for graph search.
+	transform_costs();
     for (i3 = 0; i3 < m_shape_prior.size(); i3++)
 	{
 		if ( m_shape_prior[i3].dir == 0 || m_shape_prior[i3].dir == 1 )
-		{
-			transform_costs_x( m_shape_prior[i3] );
 			build_vce_arcs_x( m_shape_prior[i3] );
-		}
 		else if ( m_shape_prior[i3].dir == 2 || m_shape_prior[i3].dir == 3 )
-		{
-			transform_costs_y( m_shape_prior[i3] );
 			build_vce_arcs_y( m_shape_prior[i3] );
-		}
 		else if ( m_shape_prior[i3].dir == 4 || m_shape_prior[i3].dir == 5 )
-		{
-			transform_costs_z( m_shape_prior[i3] );
 			build_vce_arcs_z( m_shape_prior[i3] );
-		}
-		
 	}
-	//transform_costs();
     //cout<<"Finish cost transform"<<endl;
 
     // Build the arcs of the graphs.
 	//build_vce_arcs();
-	cout << "Build graph cut arcs" << endl;
+	if (m_verbose) cout << "Build graph cut arcs" << endl;
     build_graphcut_arcs();
-	cout << "Build gs gc arcs" << endl;
+	if (m_verbose) cout << "Build gs gc arcs" << endl;
 	build_gs_gc_arcs();
-	cout << "Build gc gc arcs" << endl;
+	if (m_verbose) cout << "Build gc gc arcs" << endl;
 	build_gc_gc_arcs();
-	cout << "Finish build arcs" << endl;
+	if (m_verbose) cout << "Finish build arcs" << endl;
 
     // Calculate max-flow/min-cut.
     flow = m_graph.solve();
-	
+
+	extract_labels(net);
+    
+    if (0 != pflow)
+        *pflow = flow;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::extract_labels(net_base_type& net) const
+{
+	size_type       i0, i1, i3, p;
+	size_type       s0, s1;
+	const size_type slice = m_graph.size_0() * m_graph.size_1() * m_graph.size_2();
+	const size_type geometry[3] = { m_graph.size_0(), m_graph.size_1(), m_graph.size_2() };
+
+	if (net.size_0() != m_graph.size_0() || 
+		net.size_1() != m_graph.size_1() ||
+		net.size_2() != m_graph.size_2() ||
+		net.size_3() != m_graph.size_3()
+		) {
+		// Throw an invalid_argument exception.
+		throw_exception(
+			std::invalid_argument(
+			"optnet_gs_gt_multi_dir::extract_labels: The output image size must match the graph size."
+		));
+	}
+
 	//Get the labeled image for graph search.
-    for (i3 = 0; i3 < m_shape_prior.size(); i3++)
+	for (p = 0; p < m_shape_prior.size(); p++)
 	{
+		size_type* surf = net.data() + m_shape_prior[p].k * slice;
 
-		
-		if ( m_shape_prior[i3].dir == 0 || m_shape_prior[i3].dir == 1 )
-		{
-			int graph_id = m_shape_prior[i3].k;
-			s0 = (int)m_graph.size_1();
-			s1 = (int)m_graph.size_2();
-			s2 = (int)m_graph.size_0();
-			for (i1 = 0; i1 < s1; ++i1)
-                for (i0 = 0; i0 < s0; ++i0) 
-				{
-					for ( i2 = 0; i2 < s2; ++i2) 
-					{
-                        // Find upper envelope.
-                        if (!m_graph.in_source_set(i2, i0, i1, graph_id))
-                             break;
-                    }
-					if ( m_shape_prior[i3].dir == 0)
-						net( i2, i0, i1, graph_id ) = 1;
-					else 
-						net( s2 - i2 - 1, i0, i1, graph_id ) = 1;		
-				}
-		}
-		else if ( m_shape_prior[i3].dir == 2 || m_shape_prior[i3].dir == 3 )
-		{
-			int graph_id = m_shape_prior[i3].k;
-			s0 = (int)m_graph.size_0();
-			s1 = (int)m_graph.size_2();
-			s2 = (int)m_graph.size_1();
-			for (i1 = 0; i1 < s1; ++i1)
-                for (i0 = 0; i0 < s0; ++i0) 
-				{
-					for ( i2 = 0; i2 < s2; ++i2) 
-					{
-                        // Find upper envelope.
-                        if (!m_graph.in_source_set(i0, i2, i1, graph_id))
-                             break;
-                    }
-					if ( m_shape_prior[i3].dir == 2)
-						net( i0, i2, i1, graph_id ) = 1;
-					else 
-						net( i0, s2 - i2 - 1, i1, graph_id ) = 1;		
-				}
-		}
-		else if ( m_shape_prior[i3].dir == 4 || m_shape_prior[i3].dir == 5 )
+		std::fill(surf, surf + slice, (size_type)0);
+		shape_model::plane_size(m_shape_prior[p].dir, geometry, s0, s1);
+		for (i1 = 0; i1 < s1; ++i1)
+			for (i0 = 0; i0 < s0; ++i0)
+				net[find_surface_voxel(p, i0, i1)] = 1;
+	}
+
+	//Get the labeled image for graph cut.
+	for (i3 = m_num_surf_graphsearch; i3 < m_graph.size_3(); ++i3)
+		m_graph.get_labels(net.data() + i3 * slice, i3, 0, m_graph.size_2());
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::extract_label_bits(std::vector<unsigned char>& bits) const
+{
+	size_type                  i0, i1, i2, i3, p, n;
+	size_type                  s0, s1;
+	const size_type            plane = m_graph.size_0() * m_graph.size_1();
+	const size_type            slice = plane * m_graph.size_2();
+	const size_type            geometry[3] = { m_graph.size_0(), m_graph.size_1(), m_graph.size_2() };
+	std::vector<unsigned char> labels;
+
+	bits.assign((slice * m_graph.size_3() + 7) / 8, 0);
+
+	//Get the surfaces of graph search.
+	for (p = 0; p < m_shape_prior.size(); p++)
+	{
+		shape_model::plane_size(m_shape_prior[p].dir, geometry, s0, s1);
+		for (i1 = 0; i1 < s1; ++i1)
+			for (i0 = 0; i0 < s0; ++i0)
+			{
+				size_type v = find_surface_voxel(p, i0, i1);
+				bits[v >> 3] |= (unsigned char)(1 << (v & 7));
+			}
+	}
+
+	//Get the regions of graph cut, a few slices at a time.
+	n = (65536 + plane - 1) / plane;
+	if (n > m_graph.size_2())
+		n = m_graph.size_2();
+	labels.resize(n * plane);
+	for (i3 = m_num_surf_graphsearch; i3 < m_graph.size_3(); ++i3)
+		for (i2 = 0; i2 < m_graph.size_2(); i2 += n)
 		{
-			int graph_id = m_shape_prior[i3].k;
-			s0 = (int)m_graph.size_0();
-			s1 = (int)m_graph.size_1();
-			s2 = (int)m_graph.size_2();
-			for (i1 = 0; i1 < s1; ++i1)
-                for (i0 = 0; i0 < s0; ++i0) 
-				{
-					for ( i2 = 0; i2 < s2; ++i2) 
-					{
-                        // Find upper envelope.
-                        if (!m_graph.in_source_set(i0, i1, i2, graph_id))
-                             break;
-                    }
-					if ( m_shape_prior[i3].dir == 4)
-						net( i0, i1, i2, graph_id ) = 1;
-					else 
-						net( i0, i1, s2 - i2 - 1, graph_id ) = 1;		
-				}
-			std::cout << "Compute the resulted image" << std::endl;
+			size_type i2_end = (i2 + n < m_graph.size_2()) ? i2 + n : m_graph.size_2();
+
+			m_graph.get_labels(&labels[0], i3, i2, i2_end);
+			pack_label_bits(&labels[0], (i2_end - i2) * plane, &bits[0], i3 * slice + i2 * plane);
 		}
-		
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+typename optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::size_type
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::find_surface_voxel(size_type p,
+                                                              size_type i0,
+                                                              size_type i1
+                                                              ) const
+{
+	const int       dir      = m_shape_prior[p].dir;
+	const size_type graph_id = m_shape_prior[p].k;
+	const size_type g0       = m_graph.size_0();
+	const size_type g1       = m_graph.size_1();
+	const size_type g2       = m_graph.size_2();
+	const size_type floor    = column_floor(i0, i1, graph_id);
+	size_type       i2, s2;
+
+	// Find upper envelope.
+	if ( dir == 0 || dir == 1 )
+	{
+		s2 = g0;
+		i2 = m_graph.find_sink_node(floor, i0, i1, graph_id, 0);
 	}
-	
-	//Get the labeled image for graph cut.
-	for ( i3 = m_num_surf_graphsearch; i3 < m_graph.size_3(); ++i3)
+	else if ( dir == 2 || dir == 3 )
 	{
-		for (i1 = 0; i1 < m_graph.size_1(); ++i1) 
-            for (i0 = 0; i0 < m_graph.size_0(); ++i0) 
-				for (i2 = 0; i2 < m_graph.size_2(); ++i2)
-				{
-                    if ( m_graph.in_source_set( i0, i1, i2, i3 ) )
-						net( i0, i1, i2, i3 ) = 1;
-					else
-						net( i0, i1, i2, i3 ) = 0;	
-				}					
+		s2 = g1;
+		i2 = m_graph.find_sink_node(i0, floor, i1, graph_id, 1);
 	}
-    
+	else
+	{
+		s2 = g2;
+		i2 = m_graph.find_sink_node(i0, i1, floor, graph_id, 2);
+	}
+
+	if ( i2 >= s2 ) // The surface is at the top.
+		i2 = s2 - 1;
+	if ( dir % 2 == 1 )
+		i2 = s2 - i2 - 1;
+
+	if ( dir == 0 || dir == 1 )
+		return ((graph_id * g2 + i1) * g1 + i0) * g0 + i2;
+	else if ( dir == 2 || dir == 3 )
+		return ((graph_id * g2 + i1) * g1 + i2) * g0 + i0;
+	else
+		return ((graph_id * g2 + i2) * g1 + i1) * g0 + i0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::pack_label_bits(const unsigned char* labels,
+                                                           size_type            count,
+                                                           unsigned char*       bits,
+                                                           size_type            offset
+                                                           )
+{
+	// The bits before the first byte boundary.
+	for (; count > 0 && (offset & 7) != 0; --count, ++offset, ++labels)
+		bits[offset >> 3] |= (unsigned char)(*labels << (offset & 7));
+
+	// Eight labels at a time. Label j of the word is at bit 8j, and
+	// the multiplication moves it to bit 56 + j; the sums of the other
+	// products never carry into the top byte.
+	unsigned char* out = bits + (offset >> 3);
+	for (; count >= 8; count -= 8, offset += 8, labels += 8)
+	{
+		unsigned long long w =
+			 (unsigned long long)labels[0]        | ((unsigned long long)labels[1] << 8)  |
+			((unsigned long long)labels[2] << 16) | ((unsigned long long)labels[3] << 24) |
+			((unsigned long long)labels[4] << 32) | ((unsigned long long)labels[5] << 40) |
+			((unsigned long long)labels[6] << 48) | ((unsigned long long)labels[7] << 56);
+		*out++ = (unsigned char)((w * 0x0102040810204080ULL) >> 56);
+	}
+
+	// The remaining bits.
+	for (; count > 0; --count, ++offset, ++labels)
+		bits[offset >> 3] |= (unsigned char)(*labels << (offset & 7));
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::find_lesion_rois(
+    const label_base_type& seeds,
+    const label_base_type& region,
+    lesion_roi_vector&     rois
+    )
+{
+    size_type       i0, i1, i2, j0, j1, j2, d, i, j;
+    size_type       s0, s1, s2;
+    std::deque<size_type> queue;
+    lesion_roi_vector     boxes;
+
+    s0 = seeds.size_0();
+    s1 = seeds.size_1();
+    s2 = seeds.size_2();
+
+    if (region.size_0() != s0 ||
+        region.size_1() != s1 ||
+        region.size_2() != s2
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::find_lesion_rois: The seed and region images must have the same size."
+        ));
+    }
+
+    rois.clear();
+
+    // Label the 6-connected components of the region. The seed voxels
+    // always belong to the region.
+    std::vector<char> visited(s0 * s1 * s2, 0);
+
+    for (i2 = 0; i2 < s2; ++i2)
+        for (i1 = 0; i1 < s1; ++i1)
+            for (i0 = 0; i0 < s0; ++i0)
+            {
+                size_type v = (i2 * s1 + i1) * s0 + i0;
+
+                if (visited[v] ||
+                    (region(i0, i1, i2) == 0 && seeds(i0, i1, i2) == 0))
+                    continue;
+
+                lesion_roi_type box;
+                box.begin[0] = i0; box.end[0] = i0 + 1;
+                box.begin[1] = i1; box.end[1] = i1 + 1;
+                box.begin[2] = i2; box.end[2] = i2 + 1;
+
+                visited[v] = 1;
+                queue.push_back(v);
+
+                while (!queue.empty()) {
+                    v  = queue.front();
+                    queue.pop_front();
+                    j0 = v % s0;
+                    j1 = (v / s0) % s1;
+                    j2 = v / (s0 * s1);
+
+                    box.begin[0] = std::min(box.begin[0], j0);
+                    box.begin[1] = std::min(box.begin[1], j1);
+                    box.begin[2] = std::min(box.begin[2], j2);
+                    box.end[0]   = std::max(box.end[0], j0 + 1);
+                    box.end[1]   = std::max(box.end[1], j1 + 1);
+                    box.end[2]   = std::max(box.end[2], j2 + 1);
+
+                    if (seeds(j0, j1, j2) != 0 &&
+                        std::find(box.labels.begin(), box.labels.end(),
+                                  (size_type)seeds(j0, j1, j2)) == box.labels.end())
+                        box.labels.push_back(seeds(j0, j1, j2));
+
+                    for (d = 0; d < 6; ++d) {
+                        size_type n0 = j0, n1 = j1, n2 = j2;
+                        switch (d) {
+                        case 0: if (j0 == 0)      continue; --n0; break;
+                        case 1: if (j0 + 1 == s0) continue; ++n0; break;
+                        case 2: if (j1 == 0)      continue; --n1; break;
+                        case 3: if (j1 + 1 == s1) continue; ++n1; break;
+                        case 4: if (j2 == 0)      continue; --n2; break;
+                        default:if (j2 + 1 == s2) continue; ++n2; break;
+                        }
+                        size_type n = (n2 * s1 + n1) * s0 + n0;
+                        if (visited[n] ||
+                            (region(n0, n1, n2) == 0 && seeds(n0, n1, n2) == 0))
+                            continue;
+                        visited[n] = 1;
+                        queue.push_back(n);
+                    }
+                }
+
+                // Components without seeds are left to the background.
+                if (box.labels.empty())
+                    continue;
+
+                // Add a one-voxel margin (definite background).
+                for (d = 0; d < 3; ++d) {
+                    if (box.begin[d] > 0) --box.begin[d];
+                }
+                if (box.end[0] < s0) ++box.end[0];
+                if (box.end[1] < s1) ++box.end[1];
+                if (box.end[2] < s2) ++box.end[2];
+
+                boxes.push_back(box);
+            }
+
+    // Merge the boxes that overlap or share a lesion, so that the
+    // resulting subgraphs are disjoint.
+    for (i = 0; i < boxes.size(); ) {
+        bool merged = false;
+
+        for (j = i + 1; j < boxes.size(); ++j) {
+            bool overlap = true, shared = false;
+
+            for (d = 0; d < 3; ++d) {
+                if (boxes[i].end[d] <= boxes[j].begin[d] ||
+                    boxes[j].end[d] <= boxes[i].begin[d])
+                    overlap = false;
+            }
+            for (d = 0; d < boxes[j].labels.size(); ++d) {
+                if (std::find(boxes[i].labels.begin(), boxes[i].labels.end(),
+                              boxes[j].labels[d]) != boxes[i].labels.end())
+                    shared = true;
+            }
+            if (!overlap && !shared)
+                continue;
+
+            for (d = 0; d < 3; ++d) {
+                boxes[i].begin[d] = std::min(boxes[i].begin[d], boxes[j].begin[d]);
+                boxes[i].end[d]   = std::max(boxes[i].end[d], boxes[j].end[d]);
+            }
+            for (d = 0; d < boxes[j].labels.size(); ++d) {
+                if (std::find(boxes[i].labels.begin(), boxes[i].labels.end(),
+                              boxes[j].labels[d]) == boxes[i].labels.end())
+                    boxes[i].labels.push_back(boxes[j].labels[d]);
+            }
+            boxes.erase(boxes.begin() + j);
+            merged = true;
+            break;
+        }
+
+        // The grown box may now overlap a box that was already checked.
+        if (merged)
+            i = 0;
+        else
+            ++i;
+    }
+
+    for (i = 0; i < boxes.size(); ++i) {
+        std::sort(boxes[i].labels.begin(), boxes[i].labels.end());
+        rois.push_back(boxes[i]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::solve_lesions(
+    const label_base_type&   seeds,
+    const lesion_roi_vector& rois,
+    net_base_type&           net,
+    capacity_type*           pflow
+    )
+{
+    int             r;
+    capacity_type   flow = 0;
+#   ifndef ___OPTNET_NO_EXCEPTIONS__
+    std::exception_ptr error;
+#   endif
+
+    if (0 == m_pcost_ob || 0 == m_pcost_bg || 0 == m_pcost_neigh ||
+        0 == m_neigh_coef
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_lesions: The graph cut costs must be set."
+        ));
+    }
+
+    if (!m_shape_prior.empty() || !m_inter_cutsearch.empty()) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_lesions: Only graph cut surfaces are supported."
+        ));
+    }
+
+    if (net.size_0() != m_pcost_ob->size_0() ||
+        net.size_1() != m_pcost_ob->size_1() ||
+        net.size_2() != m_pcost_ob->size_2() ||
+        net.size_3() != m_pcost_ob->size_3() ||
+        seeds.size_0() != m_pcost_ob->size_0() ||
+        seeds.size_1() != m_pcost_ob->size_1() ||
+        seeds.size_2() != m_pcost_ob->size_2()
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_lesions: The seed and output image sizes must match the cost size."
+        ));
+    }
+
+    net.fill(0);
+
+    // The boxes are disjoint, so every subgraph writes its own part of
+    // the output image. An exception must not leave the parallel region,
+    // so the first one is kept and rethrown after the loop.
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp parallel for schedule(dynamic) reduction(+:flow) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+    #endif
+    for (r = 0; r < (int)rois.size(); ++r) {
+#   ifndef ___OPTNET_NO_EXCEPTIONS__
+        try {
+            flow += solve_lesion(seeds, rois[r], net);
+        }
+        catch (...) {
+            #ifdef __OPTNET_PRAGMA_OMP__
+            #   pragma omp critical (optnet_solve_lesions_error)
+            #endif
+            if (!error) error = std::current_exception();
+        }
+#   else
+        flow += solve_lesion(seeds, rois[r], net);
+#   endif
+    }
+
+#   ifndef ___OPTNET_NO_EXCEPTIONS__
+    if (error) std::rethrow_exception(error);
+#   endif
+
     if (0 != pflow)
         *pflow = flow;
 }
 
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+typename optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::capacity_type
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::solve_lesion(
+    const label_base_type& seeds,
+    const lesion_roi_type& roi,
+    net_base_type&         net
+    )
+{
+    size_type       i0, i1, i2, i3, k, d;
+    size_type       n0, n1, n2, ns;
+    const size_type* o = roi.begin;
+    capacity_type   flow = 0;
+
+    n0 = roi.end[0] - roi.begin[0];
+    n1 = roi.end[1] - roi.begin[1];
+    n2 = roi.end[2] - roi.begin[2];
+    ns = m_pcost_ob->size_3();
+
+    // Crop the shared costs to the box.
+    cost_array_type cost_ob(n0, n1, n2, ns);
+    cost_array_type cost_bg(n0, n1, n2, ns);
+    cost_array_type cost_neigh(n0, n1, n2, ns);
+    std::vector<cost_array_type> cost_context(m_inter_cutcut.size());
+
+    for (i3 = 0; i3 < ns; ++i3)
+        for (i2 = 0; i2 < n2; ++i2)
+            for (i1 = 0; i1 < n1; ++i1)
+                for (i0 = 0; i0 < n0; ++i0)
+                {
+                    cost_ob(i0, i1, i2, i3)    = (*m_pcost_ob)(o[0] + i0, o[1] + i1, o[2] + i2, i3);
+                    cost_bg(i0, i1, i2, i3)    = (*m_pcost_bg)(o[0] + i0, o[1] + i1, o[2] + i2, i3);
+                    cost_neigh(i0, i1, i2, i3) = (*m_pcost_neigh)(o[0] + i0, o[1] + i1, o[2] + i2, i3);
+                }
+
+    for (k = 0; k < m_inter_cutcut.size(); ++k) {
+        const cost_array_type& context = *m_inter_cutcut[k].cost_context_cut;
+
+        cost_context[k].create(n0, n1, n2, context.size_3());
+        for (i3 = 0; i3 < context.size_3(); ++i3)
+            for (i2 = 0; i2 < n2; ++i2)
+                for (i1 = 0; i1 < n1; ++i1)
+                    for (i0 = 0; i0 < n0; ++i0)
+                        cost_context[k](i0, i1, i2, i3) = context(o[0] + i0, o[1] + i1, o[2] + i2, i3);
+    }
+
+    // Solve the subgraph. The boxes are solved concurrently, so the
+    // sub-solvers do not print their progress.
+    optnet_gs_gt_multi_dir sub;
+    net_type               sub_net(n0, n1, n2, ns);
+
+    sub.create(n0, n1, n2, 0, ns);
+    sub.set_verbose(false);
+    sub.set_ob_cost(cost_ob);
+    sub.set_bg_cost(cost_bg);
+    sub.set_neigh_cost(cost_neigh);
+    sub.set_neigh_coef(m_neigh_coef);
+    for (k = 0; k < m_inter_cutcut.size(); ++k) {
+        inter_cutcut_type relation = m_inter_cutcut[k];
+        relation.cost_context_cut = &cost_context[k];
+        sub.set_cutcut_relation(relation);
+    }
+    sub.solve_all(sub_net, &flow);
+
+    // Label the object voxels. Every object voxel takes the ID of the
+    // nearest seed it is connected to; the object components without a
+    // seed are background, as they are outside the boxes.
+    for (i3 = 0; i3 < ns; ++i3)
+    {
+        std::vector<size_type> label(n0 * n1 * n2, 0);
+        std::deque<size_type>  queue;
+
+        for (i2 = 0; i2 < n2; ++i2)
+            for (i1 = 0; i1 < n1; ++i1)
+                for (i0 = 0; i0 < n0; ++i0)
+                {
+                    size_type id = seeds(o[0] + i0, o[1] + i1, o[2] + i2);
+                    if (id != 0 && sub_net(i0, i1, i2, i3) != 0) {
+                        label[(i2 * n1 + i1) * n0 + i0] = id;
+                        queue.push_back((i2 * n1 + i1) * n0 + i0);
+                    }
+                }
+
+        while (!queue.empty()) {
+            size_type v = queue.front();
+            queue.pop_front();
+            i0 = v % n0;
+            i1 = (v / n0) % n1;
+            i2 = v / (n0 * n1);
+
+            for (d = 0; d < 6; ++d) {
+                size_type j0 = i0, j1 = i1, j2 = i2;
+                switch (d) {
+                case 0: if (i0 == 0)      continue; --j0; break;
+                case 1: if (i0 + 1 == n0) continue; ++j0; break;
+                case 2: if (i1 == 0)      continue; --j1; break;
+                case 3: if (i1 + 1 == n1) continue; ++j1; break;
+                case 4: if (i2 == 0)      continue; --j2; break;
+                default:if (i2 + 1 == n2) continue; ++j2; break;
+                }
+                size_type n = (j2 * n1 + j1) * n0 + j0;
+                if (label[n] != 0 || sub_net(j0, j1, j2, i3) == 0)
+                    continue;
+                label[n] = label[v];
+                queue.push_back(n);
+            }
+        }
+
+        for (i2 = 0; i2 < n2; ++i2)
+            for (i1 = 0; i1 < n1; ++i1)
+                for (i0 = 0; i0 < n0; ++i0)
+                    net(o[0] + i0, o[1] + i1, o[2] + i2, i3) =
+                        label[(i2 * n1 + i1) * n0 + i0];
+    }
+
+    return flow;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cost, typename _Cap, typename _Tg>
 void
-optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::transform_costs_z(const shape_vce_type& shape_vce)
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::solve_supervoxels(
+    const region_base_type& regions,
+    size_type               num_regions,
+    net_base_type&          net,
+    capacity_type*          pflow
+    )
 {
-    assert(m_pcost_gs != 0);
-    size_type            i0, i1, i2, i3, s0, s1, s2, s3;
+    size_type       i, i0, i1, i2, k, d;
+    size_type       s0, s1, s2, ns, r;
+    const float     theta = 1;
+    graph_type      graph;
+    capacity_type   flow;
 
-    s0 = m_pcost_gs->size_0();
-    s1 = m_pcost_gs->size_1();
-    s2 = m_pcost_gs->size_2();
-    //s3 = m_pcost_gs->size_3();
-	i3 = shape_vce.k;
-    //m_graph.set_initial_flow(0);
-    // Construct the s-t graph "G_st".
+    if (0 == m_pcost_ob || 0 == m_pcost_bg || 0 == m_pcost_neigh ||
+        0 == m_neigh_coef
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_supervoxels: The graph cut costs must be set."
+        ));
+    }
 
-    for (i2 = 1;	i2 < s2;	++i2) 
-	{
-        for (i1 = 0; i1 < s1; ++i1) 
-		{
-            for (i0 = 0; i0 < s0; ++i0) 
-			{
-				capacity_type cap;
-                   
-				if ( shape_vce.dir == 4 )
-                    cap = (capacity_type)(*m_pcost_gs)(i0, i1, i2, i3) - (capacity_type)(*m_pcost_gs)(i0, i1, i2 - 1, i3);
-				else     //Reverse the image. 
-					cap = (capacity_type)(*m_pcost_gs)(i0, i1, s2 - i2 - 1, i3) - (capacity_type)(*m_pcost_gs)(i0, i1, s2 - i2, i3);
-
-                if (cap >= 0) // non-negative -> connect to t
-                    m_graph.add_st_arc(0, +cap, i0, i1, i2, i3);
-                else          // negative     -> connect to s
-                    m_graph.add_st_arc(-cap, 0, i0, i1, i2, i3);
-
-            } // for i0
-        } // for i1
-    } // for i2
- 
-	for (i1 = 0; i1 < s1; ++i1) 
-	{
-        for (i0 = 0; i0 < s0; ++i0)
-		{                    
-            m_graph.add_st_arc(100000, 0, i0, i1, 0, i3);
-        } // for i0
-    } // for i1
+    if (!m_shape_prior.empty() || !m_inter_cutsearch.empty()) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_supervoxels: Only graph cut surfaces are supported."
+        ));
+    }
+
+    s0 = m_pcost_ob->size_0();
+    s1 = m_pcost_ob->size_1();
+    s2 = m_pcost_ob->size_2();
+    ns = m_pcost_ob->size_3();
+
+    if (net.size_0() != s0 || net.size_1() != s1 ||
+        net.size_2() != s2 || net.size_3() != ns ||
+        regions.size_0() != s0 || regions.size_1() != s1 ||
+        regions.size_2() != s2
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_supervoxels: The region and output image sizes must match the cost size."
+        ));
+    }
+
+    // Regional terms: the sums over the voxels of every region.
+    std::vector<capacity_type> cap_ob(num_regions * ns, 0);
+    std::vector<capacity_type> cap_bg(num_regions * ns, 0);
+
+    for (k = 0; k < ns; ++k)
+        for (i2 = 0; i2 < s2; ++i2)
+            for (i1 = 0; i1 < s1; ++i1)
+                for (i0 = 0; i0 < s0; ++i0)
+                {
+                    r = (size_type)regions(i0, i1, i2);
+                    cap_ob[r * ns + k] += (capacity_type)(*m_pcost_ob)(i0, i1, i2, k);
+                    cap_bg[r * ns + k] += (capacity_type)(*m_pcost_bg)(i0, i1, i2, k);
+                }
+
+    // Boundary terms: the voxel arc weights of build_graphcut_arcs(),
+    // summed over the faces between every pair of adjacent regions.
+    std::vector<std::vector<_Region_adjacency> > adjacency(num_regions);
+    std::vector<capacity_type>            weights;
+
+    for (i2 = 0; i2 < s2; ++i2)
+        for (i1 = 0; i1 < s1; ++i1)
+            for (i0 = 0; i0 < s0; ++i0)
+                for (d = 0; d < 3; ++d)
+                {
+                    size_type j0 = i0, j1 = i1, j2 = i2;
+                    switch (d) {
+                    case 0: if (++j0 == s0) continue; break;
+                    case 1: if (++j1 == s1) continue; break;
+                    default:if (++j2 == s2) continue; break;
+                    }
+
+                    int a = regions(i0, i1, i2);
+                    int b = regions(j0, j1, j2);
+                    if (a == b)
+                        continue;
+                    if (a > b)
+                        std::swap(a, b);
+
+                    std::vector<_Region_adjacency>& adj = adjacency[a];
+                    for (i = 0; i < adj.size() && adj[i].region != b; ++i)
+                        ;
+                    if (i == adj.size()) {
+                        _Region_adjacency e;
+                        e.region = b;
+                        e.index  = weights.size();
+                        adj.push_back(e);
+                        weights.resize(weights.size() + ns, 0);
+                    }
+
+                    for (k = 0; k < ns; ++k) {
+                        capacity_type c0 = (capacity_type)(*m_pcost_neigh)(i0, i1, i2, k);
+                        capacity_type c1 = (capacity_type)(*m_pcost_neigh)(j0, j1, j2, k);
+                        weights[adj[i].index + k] += (capacity_type)(m_neigh_coef[k] *
+                            exp(-1 * 0.5 * (c0 - c1) * (c0 - c1) / (theta * theta)));
+                    }
+                }
+
+    // Context terms: the sums over the voxels of every region.
+    std::vector<capacity_type> cap_context(m_inter_cutcut.size() * num_regions * 2, 0);
+
+    for (k = 0; k < m_inter_cutcut.size(); ++k) {
+        const cost_array_type& context = *m_inter_cutcut[k].cost_context_cut;
+        capacity_type*         sums    = &cap_context[k * num_regions * 2];
+
+        for (i2 = 0; i2 < s2; ++i2)
+            for (i1 = 0; i1 < s1; ++i1)
+                for (i0 = 0; i0 < s0; ++i0)
+                {
+                    r = (size_type)regions(i0, i1, i2);
+                    sums[r * 2]     += (capacity_type)context(i0, i1, i2, 0);
+                    sums[r * 2 + 1] += (capacity_type)context(i0, i1, i2, 1);
+                }
+    }
+
+    // Build and solve the region graph: node (r, 0, 0, k) is region r of
+    // surface k.
+    if (!graph.create(num_regions, 1, 1, ns)) {
+        throw_exception(std::runtime_error(
+            "optnet_gs_gt_multi_dir::solve_supervoxels: Could not create graph."
+        ));
+    }
+    graph.set_initial_flow(0);
+
+    for (k = 0; k < ns; ++k)
+        for (r = 0; r < num_regions; ++r)
+            graph.add_st_arc(cap_ob[r * ns + k], cap_bg[r * ns + k], r, 0, 0, k);
+
+    for (r = 0; r < num_regions; ++r)
+        for (i = 0; i < adjacency[r].size(); ++i)
+        {
+            const _Region_adjacency& e = adjacency[r][i];
+            for (k = 0; k < ns; ++k) {
+                graph.add_arc_cost(weights[e.index + k], r, 0, 0, k, e.region, 0, 0, k);
+                graph.add_arc_cost(weights[e.index + k], e.region, 0, 0, k, r, 0, 0, k);
+            }
+        }
+
+    for (k = 0; k < m_inter_cutcut.size(); ++k) {
+        const size_type& k0   = m_inter_cutcut[k].k[0];
+        const size_type& k1   = m_inter_cutcut[k].k[1];
+        capacity_type*   sums = &cap_context[k * num_regions * 2];
+
+        for (r = 0; r < num_regions; ++r) {
+            graph.add_arc_cost(sums[r * 2],     r, 0, 0, k0, r, 0, 0, k1);
+            graph.add_arc_cost(sums[r * 2 + 1], r, 0, 0, k1, r, 0, 0, k0);
+        }
+    }
+
+    flow = graph.solve();
+
+    for (k = 0; k < ns; ++k)
+        for (i2 = 0; i2 < s2; ++i2)
+            for (i1 = 0; i1 < s1; ++i1)
+                for (i0 = 0; i0 < s0; ++i0)
+                {
+                    r = (size_type)regions(i0, i1, i2);
+                    net(i0, i1, i2, k) = graph.in_source_set(r, 0, 0, k) ? 1 : 0;
+                }
+
+    if (0 != pflow)
+        *pflow = flow;
 }
+
 ///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+double
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::sample_cost(
+    const cost_array_type&  cost,
+    double                  x0,
+    double                  x1,
+    double                  x2,
+    size_type               k
+    )
+{
+    const double    x[3] = { x0, x1, x2 };
+    const size_type s[3] = { cost.size_0(), cost.size_1(), cost.size_2() };
+    size_type       i[3], j[3];
+    double          w[3];
+
+    // Replicate the border outside the image.
+    for (int d = 0; d < 3; ++d) {
+        double c = std::min(std::max(x[d], 0.0), (double)(s[d] - 1));
+        i[d] = (size_type)c;
+        j[d] = std::min(i[d] + 1, s[d] - 1);
+        w[d] = c - i[d];
+    }
+
+    double c00 = cost(i[0], i[1], i[2], k) * (1 - w[0]) + cost(j[0], i[1], i[2], k) * w[0];
+    double c10 = cost(i[0], j[1], i[2], k) * (1 - w[0]) + cost(j[0], j[1], i[2], k) * w[0];
+    double c01 = cost(i[0], i[1], j[2], k) * (1 - w[0]) + cost(j[0], i[1], j[2], k) * w[0];
+    double c11 = cost(i[0], j[1], j[2], k) * (1 - w[0]) + cost(j[0], j[1], j[2], k) * w[0];
+
+    return ((c00 * (1 - w[1]) + c10 * w[1]) * (1 - w[2]) +
+            (c01 * (1 - w[1]) + c11 * w[1]) * w[2]);
+}
+
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cost, typename _Cap, typename _Tg>
 void
-optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::transform_costs_x(const shape_vce_type& shape_vce)
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::solve_star(
+    const double*           center,
+    const sphere_mesh_type& directions,
+    size_type               num_samples,
+    double                  step,
+    int                     smoothness,
+    net_base_type&          net,
+    capacity_type*          pflow
+    )
 {
-    assert(m_pcost_gs != 0);
-    size_type            i0, i1, i2, i3, s0, s1, s2, s3;
+    typedef typename sphere_mesh_type::edge_type mesh_edge_type;
 
-    s0 = m_pcost_gs->size_1();
-    s1 = m_pcost_gs->size_2();
-    s2 = m_pcost_gs->size_0();
-    
-	i3 = shape_vce.k;
-    //m_graph.set_initial_flow(0);
-    // Construct the s-t graph "G_st".
+    size_type       j, e, k, c, s0, s1, s2, ns, nd, nj, nc;
+    int             u;
+    const float     theta = 1;
+    const double    pi = 3.14159265358979323846;
+    graph_type      graph;
+    capacity_type   flow;
 
-    for (i2 = 1;	i2 < s2;	++i2) 
-	{
-        for (i1 = 0; i1 < s1; ++i1) 
-		{
-            for (i0 = 0; i0 < s0; ++i0) 
-			{
-				capacity_type cap;
-                   
-				if ( shape_vce.dir == 0 )
-                    cap = (capacity_type)(*m_pcost_gs)(i2, i0, i1, i3) - (capacity_type)(*m_pcost_gs)(i2 - 1, i0, i1, i3);
-				else     //Reverse the image. 
-					cap = (capacity_type)(*m_pcost_gs)(s2 - i2 - 1, i0, i1,  i3) - (capacity_type)(*m_pcost_gs)(s2 - i2, i0, i1,  i3);
-
-                if (cap >= 0) // non-negative -> connect to t
-                    m_graph.add_st_arc(0, +cap, i2, i0, i1, i3);
-                else          // negative     -> connect to s
-                    m_graph.add_st_arc(-cap, 0, i2, i0, i1, i3);
-
-            } // for i0
-        } // for i1
-    } // for i2
- 
-	for (i1 = 0; i1 < s1; ++i1) 
-	{
-        for (i0 = 0; i0 < s0; ++i0)
-		{                    
-            m_graph.add_st_arc(100000, 0, 0, i0, i1, i3);
-        } // for i0
-    } // for i1
+    if (0 == m_pcost_ob || 0 == m_pcost_bg || 0 == m_pcost_neigh ||
+        0 == m_neigh_coef
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_star: The graph cut costs must be set."
+        ));
+    }
+
+    if (!m_shape_prior.empty() || !m_inter_cutsearch.empty()) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_star: Only graph cut surfaces are supported."
+        ));
+    }
+
+    s0 = m_pcost_ob->size_0();
+    s1 = m_pcost_ob->size_1();
+    s2 = m_pcost_ob->size_2();
+    ns = m_pcost_ob->size_3();
+    nd = directions.num_vertices();
+    nj = num_samples;
+    nc = m_inter_cutcut.size();
+
+    if (net.size_0() != s0 || net.size_1() != s1 ||
+        net.size_2() != s2 || net.size_3() != ns
+        ) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_star: The output image size must match the cost size."
+        ));
+    }
+
+    if (nd == 0 || nj < 2 || step <= 0 || smoothness < 0) {
+        throw_exception(
+            std::invalid_argument(
+            "optnet_gs_gt_multi_dir::solve_star: Invalid column parameters."
+        ));
+    }
+
+    // Sample the costs along the rays: sample j of column u is at
+    // center + j * step * direction(u), and is stored at (k * nd + u) * nj + j.
+    std::vector<double> col_ob(ns * nd * nj), col_bg(ns * nd * nj);
+    std::vector<double> col_neigh(ns * nd * nj), col_context(nc * 2 * nd * nj);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for private(j, k, c) \
+                num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (u = 0; u < (int)nd; ++u) {
+        const double* dir = directions.direction(u);
+
+        for (j = 0; j < nj; ++j) {
+            double x0 = center[0] + j * step * dir[0];
+            double x1 = center[1] + j * step * dir[1];
+            double x2 = center[2] + j * step * dir[2];
+
+            for (k = 0; k < ns; ++k) {
+                size_type n = (k * nd + u) * nj + j;
+                col_ob[n]    = sample_cost(*m_pcost_ob,    x0, x1, x2, k);
+                col_bg[n]    = sample_cost(*m_pcost_bg,    x0, x1, x2, k);
+                col_neigh[n] = sample_cost(*m_pcost_neigh, x0, x1, x2, k);
+            }
+            for (c = 0; c < nc; ++c) {
+                const cost_array_type& context = *m_inter_cutcut[c].cost_context_cut;
+                col_context[((c * 2    ) * nd + u) * nj + j] = sample_cost(context, x0, x1, x2, 0);
+                col_context[((c * 2 + 1) * nd + u) * nj + j] = sample_cost(context, x0, x1, x2, 1);
+            }
+        }
+    }
+
+    // The cell of sample j is the part of the shell between the radii
+    // (j - 1/2) * step and (j + 1/2) * step in the solid angle 4 pi / nd
+    // of its column. Its volume weights the regional and context terms;
+    // the area of its outer face, and of its faces with the cells of the
+    // adjacent columns, weight the boundary terms. On a regular
+    // triangular mesh, the face between two columns whose directions are
+    // a radians apart has the width r * a / sqrt(3).
+    std::vector<double> volume(nj), outer_area(nj);
+
+    for (j = 0; j < nj; ++j) {
+        double r0 = (j == 0) ? 0.0 : (j - 0.5) * step;
+        double r1 = (j + 0.5) * step;
+        volume[j]     = 4 * pi * (r1 * r1 * r1 - r0 * r0 * r0) / (3 * nd);
+        outer_area[j] = 4 * pi * r1 * r1 / nd;
+    }
+
+    std::vector<double> side_width(directions.num_edges());
+
+    for (e = 0; e < directions.num_edges(); ++e) {
+        const mesh_edge_type& edge = directions.edge(e);
+        const double*         p    = directions.direction(edge.v[0]);
+        const double*         q    = directions.direction(edge.v[1]);
+        double                dot  = p[0] * q[0] + p[1] * q[1] + p[2] * q[2];
+        side_width[e] = acos(std::min(std::max(dot, -1.0), 1.0)) / sqrt(3.0);
+    }
+
+    // Build and solve the column graph: node (j, u, 0, k) is sample j of
+    // column u of surface k.
+    if (!graph.create(nj, nd, 1, ns)) {
+        throw_exception(std::runtime_error(
+            "optnet_gs_gt_multi_dir::solve_star: Could not create graph."
+        ));
+    }
+    graph.set_initial_flow(0);
+
+    for (k = 0; k < ns; ++k) {
+        const double coef = (double)m_neigh_coef[k];
+
+        for (u = 0; u < (int)nd; ++u) {
+            const size_type n = (k * nd + u) * nj;
+
+            // The center is always inside.
+            graph.add_st_arc(MAX_VALUE, 0, 0, u, 0, k);
+
+            for (j = 0; j < nj; ++j) {
+                graph.add_st_arc((capacity_type)(col_ob[n + j] * volume[j]),
+                                 (capacity_type)(col_bg[n + j] * volume[j]),
+                                 j, u, 0, k);
+
+                // Every column is an interval starting at the center.
+                if (j > 0)
+                    graph.add_arc(j, u, 0, k, j - 1, u, 0, k);
+
+                // The boundary term of the outer face.
+                if (j + 1 < nj) {
+                    double d = col_neigh[n + j] - col_neigh[n + j + 1];
+                    graph.add_arc_cost((capacity_type)(coef * outer_area[j] *
+                        exp(-1 * 0.5 * d * d / (theta * theta))),
+                        j, u, 0, k, j + 1, u, 0, k);
+                }
+            }
+        }
+
+        for (e = 0; e < directions.num_edges(); ++e) {
+            const size_type u0 = directions.edge(e).v[0];
+            const size_type u1 = directions.edge(e).v[1];
+            const size_type n0 = (k * nd + u0) * nj;
+            const size_type n1 = (k * nd + u1) * nj;
+
+            // Hard smoothness between adjacent columns.
+            for (j = std::max(smoothness, 1); j < nj; ++j) {
+                graph.add_arc(j, u0, 0, k, j - smoothness, u1, 0, k);
+                graph.add_arc(j, u1, 0, k, j - smoothness, u0, 0, k);
+            }
+
+            // The boundary terms of the side faces.
+            for (j = 1; j < nj; ++j) {
+                double d = col_neigh[n0 + j] - col_neigh[n1 + j];
+                capacity_type w = (capacity_type)(coef * j * step * side_width[e] * step *
+                    exp(-1 * 0.5 * d * d / (theta * theta)));
+                graph.add_arc_cost(w, j, u0, 0, k, j, u1, 0, k);
+                graph.add_arc_cost(w, j, u1, 0, k, j, u0, 0, k);
+            }
+        }
+    }
+
+    for (c = 0; c < nc; ++c) {
+        const size_type& k0 = m_inter_cutcut[c].k[0];
+        const size_type& k1 = m_inter_cutcut[c].k[1];
+
+        for (u = 0; u < (int)nd; ++u)
+            for (j = 0; j < nj; ++j)
+            {
+                double w0 = col_context[((c * 2    ) * nd + u) * nj + j] * volume[j];
+                double w1 = col_context[((c * 2 + 1) * nd + u) * nj + j] * volume[j];
+                graph.add_arc_cost((capacity_type)w0, j, u, 0, k0, j, u, 0, k1);
+                graph.add_arc_cost((capacity_type)w1, j, u, 0, k1, j, u, 0, k0);
+            }
+    }
+
+    flow = graph.solve();
+
+    // The surface heights: the number of samples of every column that
+    // are inside.
+    std::vector<size_type> height(ns * nd, 0);
+
+    for (k = 0; k < ns; ++k)
+        for (u = 0; u < (int)nd; ++u)
+        {
+            size_type& h = height[k * nd + u];
+            while (h < nj && graph.in_source_set(h, u, 0, k)) ++h;
+        }
+
+    // Map the surfaces back to the voxels: a voxel is inside if it is
+    // closer to the center than the surface along the column of the
+    // nearest direction.
+    const double rmax  = (nj - 0.5) * step;
+    const int    sz[3] = { (int)s0, (int)s1, (int)s2 };
+    int          lo[3], hi[3], i2;
+
+    for (int d = 0; d < 3; ++d) {
+        lo[d] = std::max(0,         (int)floor(center[d] - rmax));
+        hi[d] = std::min(sz[d] - 1, (int)ceil (center[d] + rmax));
+    }
+
+    net.fill(0);
+
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (i2 = lo[2]; i2 <= hi[2]; ++i2) {
+        size_type nearest = 0;
+
+        for (int i1 = lo[1]; i1 <= hi[1]; ++i1)
+            for (int i0 = lo[0]; i0 <= hi[0]; ++i0)
+            {
+                double x[3] = { i0 - center[0], i1 - center[1], i2 - center[2] };
+                double r    = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+
+                if (r >= rmax)
+                    continue;
+
+                // Walk the mesh from the direction of the last voxel to
+                // the direction nearest to x.
+                if (r > 0) {
+                    const double* p    = directions.direction(nearest);
+                    double        best = p[0] * x[0] + p[1] * x[1] + p[2] * x[2];
+                    bool          moved;
+
+                    do {
+                        moved = false;
+                        const typename sphere_mesh_type::index_type* inc =
+                            directions.incident_edges(nearest);
+                        size_type deg = directions.degree(nearest);
+
+                        for (size_type m = 0; m < deg; ++m) {
+                            size_type     v   = directions.opposite(inc[m], nearest);
+                            const double* q   = directions.direction(v);
+                            double        dot = q[0] * x[0] + q[1] * x[1] + q[2] * x[2];
+                            if (dot > best) {
+                                best    = dot;
+                                nearest = v;
+                                moved   = true;
+                                break;
+                            }
+                        }
+                    } while (moved);
+                }
+
+                for (size_type i3 = 0; i3 < ns; ++i3) {
+                    if (r < (height[i3 * nd + nearest] - 0.5) * step)
+                        net(i0, i1, i2, i3) = 1;
+                }
+            }
+    }
+
+    if (0 != pflow)
+        *pflow = flow;
 }
-///////////////////////////////////////////////////////////////////////////
+
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cost, typename _Cap, typename _Tg>
 void
-optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::transform_costs_y(const shape_vce_type& shape_vce)
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::transform_costs()
 {
+    // A graph-cut-only problem has no graph search surface and
+    // needs no graph search cost.
+    if (m_shape_prior.empty())
+        return;
+
     assert(m_pcost_gs != 0);
-    size_type            i0, i1, i2, i3, s0, s1, s2, s3;
 
-    s0 = m_pcost_gs->size_0();
-    s1 = m_pcost_gs->size_2();
-    s2 = m_pcost_gs->size_1();
-    
-	i3 = shape_vce.k;
-    //m_graph.set_initial_flow(0);
-    // Construct the s-t graph "G_st".
+    const size_type            s0 = m_graph.size_0();
+    const size_type            slice = s0 * m_graph.size_1() * m_graph.size_2();
+    const int                  num_priors = (int)m_shape_prior.size();
+    const int                  n = num_priors * (int)s0;
+    std::vector<capacity_type> caps(slice * num_priors);
+    int                        j;
 
-    for (i2 = 1;	i2 < s2;	++i2) 
-	{
-        for (i1 = 0; i1 < s1; ++i1) 
-		{
-            for (i0 = 0; i0 < s0; ++i0) 
-			{
-				capacity_type cap;
-                   
-				if ( shape_vce.dir == 2 )
-                    cap = (capacity_type)(*m_pcost_gs)(i0, i2, i1, i3) - (capacity_type)(*m_pcost_gs)(i0, i2 - 1, i1, i3);
-				else     //Reverse the image. 
-					cap = (capacity_type)(*m_pcost_gs)(i0, s2 - i2 - 1, i1,  i3) - (capacity_type)(*m_pcost_gs)(i0, s2 - i2, i1,  i3);
-
-                if (cap >= 0) // non-negative -> connect to t
-                    m_graph.add_st_arc(0, +cap, i0, i2, i1, i3);
-                else          // negative     -> connect to s
-                    m_graph.add_st_arc(-cap, 0, i0, i2, i1, i3);
-
-            } // for i0
-        } // for i1
-    } // for i2
- 
-	for (i1 = 0; i1 < s1; ++i1) 
-	{
-        for (i0 = 0; i0 < s0; ++i0)
-		{                    
-            m_graph.add_st_arc(100000, 0, i0, 0, i1, i3);
-        } // for i0
-    } // for i1
+    // The capacities of all surfaces, one graph plane i0 at a time.
+#   ifdef __OPTNET_PRAGMA_OMP__
+#       pragma omp parallel for num_threads(__OPTNET_OMP_NUM_THREADS__)
+#   endif
+    for (j = 0; j < n; ++j) {
+        size_type p  = j / s0;
+        size_type i0 = j % s0;
+        transform_column_costs(m_shape_prior[p], i0,
+                               &caps[p * slice + i0 * (slice / s0)]);
+    }
+
+    // Construct the s-t graph "G_st", one block of arcs per surface.
+    for (j = 0; j < num_priors; ++j) {
+        m_graph.add_st_arcs(&caps[j * slice], slice, 0, 0, 0, m_shape_prior[j].k);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+template <typename _Cost, typename _Cap, typename _Tg>
+void
+optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::transform_column_costs(
+    const shape_vce_type& shape_vce,
+    size_type             i0,
+    capacity_type*        caps
+    ) const
+{
+    const cost_array_base_type& cost = *m_pcost_gs;
+    const size_type             i3   = shape_vce.k;
+    const int                   axis = shape_vce.dir / 2;
+    const bool                  rev  = (shape_vce.dir % 2 == 1); // Reverse the image.
+    const size_type             s1   = m_graph.size_1();
+    const size_type             s2   = m_graph.size_2();
+    const int                   sa   = (int)(axis == 0 ? m_graph.size_0() : axis == 1 ? s1 : s2);
+    const ptrdiff_t             step = (axis == 0) ? 1 : (axis == 1) ? (ptrdiff_t)cost.size_0()
+                                                     : (ptrdiff_t)(cost.size_0() * cost.size_1());
+    const _Column_bounds*       bounds = ( i3 < m_bounds.size() && !m_bounds[i3].lo.empty() )
+                                       ? &m_bounds[i3] : 0;
+    size_type                   i1, i2;
+    int                         h, lo, hi;
+
+    // The node at height h of a column gets the cost difference of
+    // heights h and h - 1 (of sa - h - 1 and sa - h in a reversed
+    // image), non-negative ones as sink arcs and negative ones as
+    // source arcs. The column base gets the source arc 100000
+    // (cost = -1), and the column base and the pruned nodes no other.
+    for (i1 = 0; i1 < s1; ++i1, caps += s2) {
+        if (axis == 2) {
+            // One column, contiguous in the graph.
+            lo = bounds ? bounds->lo[i1 * bounds->s0 + i0] : 0;
+            hi = bounds ? bounds->hi[i1 * bounds->s0 + i0] : sa - 1;
+
+            const cost_type* c = &cost(i0, i1, 0, i3);
+            std::fill(caps, caps + s2, (capacity_type)0);
+            if (!rev) {
+                for (h = lo + 1; h <= hi; ++h)
+                    caps[h] = (capacity_type)c[h * step] - (capacity_type)c[(h - 1) * step];
+            }
+            else {
+                for (h = lo + 1; h <= hi; ++h)
+                    caps[h] = (capacity_type)c[(sa - h - 1) * step] - (capacity_type)c[(sa - h) * step];
+            }
+            caps[lo] = -100000;
+        }
+        else {
+            // A node of each of s2 columns, all at height i0 or i1.
+            h = (int)(axis == 0 ? i0 : i1);
+
+            const int        ih = rev ? sa - h - 1 : h;
+            const cost_type* c  = (axis == 0) ? &cost(ih, i1, 0, i3) : &cost(i0, ih, 0, i3);
+            const ptrdiff_t  d  = rev ? step : -step;
+            const ptrdiff_t  st = (ptrdiff_t)(cost.size_0() * cost.size_1());
+
+            for (i2 = 0; i2 < s2; ++i2, c += st) {
+                size_type col = i2 * (bounds ? bounds->s0 : 0) + (axis == 0 ? i1 : i0);
+                lo = bounds ? bounds->lo[col] : 0;
+                hi = bounds ? bounds->hi[col] : sa - 1;
+
+                if (h == lo)
+                    caps[i2] = -100000;
+                else if (lo < h && h <= hi)
+                    caps[i2] = (capacity_type)c[0] - (capacity_type)c[d];
+                else
+                    caps[i2] = 0;
+            }
+        }
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -404,6 +1620,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_z(const shape_vce_type&
 	cout<<"Begin vce arcs building"<<endl;
     int i0, i1, i2, i3, s0, s1, s2, s3, ii;
     int convexPower;
+	std::vector<capacity_type> chain;
 	//int graph_id;
 	
 	i3 = shape_vce.k;
@@ -424,7 +1641,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_z(const shape_vce_type&
              --i2) {
         for (i1 = 0; i1 < s1; ++i1) {
             for (i0 = 0; i0 < s0; ++i0) {
-                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0,          i1,          i2 - 1,          i3);
+                    add_gs_arc(i0,          i1,          i2,          i3,          i0,          i1,          i2 - 1,          i3);
             } // for i0 
         } // for i1
     } // for i2
@@ -437,70 +1654,73 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_z(const shape_vce_type&
             for (i0 = 0; i0 < s0 - 1; ++i0) {
 				
 				int upBound = 0, lowBound = 0; 
+				const shape_column_type& col = shape_vce(i0, i1);
 				//Forward
-                if ( shape_vce.meanDir0[i0][i1] > 0 )
-				upBound = shape_vce.meanDir0[i0][i1];
+                if ( col.mean[0] > 0 )
+				upBound = col.mean[0];
 				//cout<<"The upBound is: "<<upBound<<endl;
 
-				if ( (shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) < 0 )
-				lowBound = - ( shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]);
+				if ( (col.mean[0] - col.low[0]) < 0 )
+				lowBound = - ( col.mean[0] - col.low[0]);
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.fwd_cof[0], col.low[0]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.lowDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.fwdCofDir0[i0][i1] * arc_weight(k),     i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + shape_vce.meanDir0[i0][i1] - k,		i3 );
+					add_gs_arc_chain(chain, col.low[0],     i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + col.mean[0],		i3 );
 					
-					m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],		i3 );//Hard constraint
+					add_gs_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + col.mean[0] - col.low[0],		i3 );//Hard constraint
 				
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + col.mean[0] - col.low[0]) <= (s2 - 1) )
+						add_gs_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + col.mean[0] - col.low[0],		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          s2 - 1,		i3 );//Hard constraint
+						add_gs_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          s2 - 1,		i3 );//Hard constraint
 				
 					
 				
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) >= 0 )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + col.mean[0] - col.low[0]) >= 0 )
+						add_gs_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + col.mean[0] - col.low[0],		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          0,		i3 );//Hard constraint
+						add_gs_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          0,		i3 );//Hard constraint
 				}
 				//End boundary condition
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( shape_vce.meanDir0[i0][i1] < 0 )
-				upBound = -shape_vce.meanDir0[i0][i1];
+				if ( col.mean[0] < 0 )
+				upBound = -col.mean[0];
 
-				if ( (shape_vce.meanDir0[i0][i1] + shape_vce.upDir0[i0][i1]) > 0 )
-				lowBound = shape_vce.meanDir0[i0][i1] + shape_vce.upDir0[i0][i1];
+				if ( (col.mean[0] + col.up[0]) > 0 )
+				lowBound = col.mean[0] + col.up[0];
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.back_cof[0], col.up[0]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.upDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.backCofDir0[i0][i1] * arc_weight(k),     i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir0[i0][i1] - k,		i3 );
+					add_gs_arc_chain(chain, col.up[0],     i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - col.mean[0],		i3 );
 
-					m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],		i3 );//Hard constraints
+					add_gs_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - col.mean[0] - col.up[0],		i3 );//Hard constraints
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - col.mean[0] - col.up[0]) <= (s2 - 1) )
+						add_gs_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - col.mean[0] - col.up[0],		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          s2 - 1,		i3 );//Hard constraints
+						add_gs_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          s2 - 1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1]) >= 0 )
-						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - col.mean[0] - col.up[0]) >= 0 )
+						add_gs_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - col.mean[0] - col.up[0],		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          0,		i3 );//Hard constraints
+						add_gs_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          0,		i3 );//Hard constraints
 				}
 				//End boundary condition		
 			} //for i0
@@ -514,66 +1734,69 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_z(const shape_vce_type&
             for (i0 = 0; i0 < s0; ++i0) {
 				
 				int upBound = 0, lowBound = 0; 
+				const shape_column_type& col = shape_vce(i0, i1);
 				//Forward
-                if ( shape_vce.meanDir1[i0][i1] > 0 )
-				upBound = shape_vce.meanDir1[i0][i1];
+                if ( col.mean[1] > 0 )
+				upBound = col.mean[1];
 
-				if ( (shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) < 0 )
-				lowBound = - ( shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]);
+				if ( (col.mean[1] - col.low[1]) < 0 )
+				lowBound = - ( col.mean[1] - col.low[1]);
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.fwd_cof[1], col.low[1]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.lowDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.fwdCofDir1[i0][i1] * arc_weight(k),     i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + shape_vce.meanDir1[i0][i1] - k,		i3 );
+					add_gs_arc_chain(chain, col.low[1],     i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + col.mean[1],		i3 );
 					
-					m_graph.add_arc( i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],		i3 );//Hard constraint
+					add_gs_arc( i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + col.mean[1] - col.low[1],		i3 );//Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + col.mean[1] - col.low[1]) <= (s2 - 1) )
+						add_gs_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + col.mean[1] - col.low[1],		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          s2 - 1,		i3 );//Hard constraint
+						add_gs_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          s2 - 1,		i3 );//Hard constraint
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) >= 0 )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + col.mean[1] - col.low[1]) >= 0 )
+						add_gs_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + col.mean[1] - col.low[1],		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          0,		i3 );//Hard constraint
+						add_gs_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          0,		i3 );//Hard constraint
 				}
 				//End boundary condition
 
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( shape_vce.meanDir1[i0][i1] < 0 )
-				upBound = -shape_vce.meanDir1[i0][i1];
+				if ( col.mean[1] < 0 )
+				upBound = -col.mean[1];
 
-				if ( (shape_vce.meanDir1[i0][i1] + shape_vce.upDir1[i0][i1]) > 0 )
-				lowBound = shape_vce.meanDir1[i0][i1] + shape_vce.upDir1[i0][i1];
+				if ( (col.mean[1] + col.up[1]) > 0 )
+				lowBound = col.mean[1] + col.up[1];
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.back_cof[1], col.up[1]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.upDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.backCofDir1[i0][i1] * arc_weight(k),     i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir1[i0][i1] - k,		i3 );
+					add_gs_arc_chain(chain, col.up[1],     i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - col.mean[1],		i3 );
 				    
-					m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],		i3 ); //Hard constraint
+					add_gs_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - col.mean[1] - col.up[1],		i3 ); //Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - col.mean[1] - col.up[1]) <= (s2 - 1) )
+						add_gs_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - col.mean[1] - col.up[1],		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          s2 - 1,		i3 );//Hard constraints
+						add_gs_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          s2 - 1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1]) >= 0 )
-						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - col.mean[1] - col.up[1]) >= 0 )
+						add_gs_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - col.mean[1] - col.up[1],		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          0,		i3 );//Hard constraints
+						add_gs_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          0,		i3 );//Hard constraints
 				}
 				//End boundary condition		
 			} //for i0
@@ -596,6 +1819,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_x(const shape_vce_type&
 	cout<<"Begin vce arcs building"<<endl;
     int i0, i1, i2, i3, s0, s1, s2, s3, ii;
     int convexPower;
+	std::vector<capacity_type> chain;
 	int dir;
 	
 	i3 = shape_vce.k;
@@ -617,7 +1841,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_x(const shape_vce_type&
              --i2) {
         for (i1 = 0; i1 < s1; ++i1) {
             for (i0 = 0; i0 < s0; ++i0) {
-						m_graph.add_arc(i2,          i0,          i1,          i3,          i2 - 1,          i0,          i1,          i3);
+						add_gs_arc(i2,          i0,          i1,          i3,          i2 - 1,          i0,          i1,          i3);
             } // for i0 
         } // for i1
     } // for i2
@@ -628,68 +1852,69 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_x(const shape_vce_type&
         for (i1 = 0; i1 < s1; ++i1) {
             for (i0 = 0; i0 < s0 - 1; ++i0) {
 				int upBound = 0, lowBound = 0; 
+				const shape_column_type& col = shape_vce(i0, i1);
 				//Forward
-                if ( shape_vce.meanDir0[i0][i1] > 0 )
-				upBound = shape_vce.meanDir0[i0][i1];
+                if ( col.mean[0] > 0 )
+				upBound = col.mean[0];
 				
-				if ( (shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) < 0 )
-				lowBound = - ( shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]);
+				if ( (col.mean[0] - col.low[0]) < 0 )
+				lowBound = - ( col.mean[0] - col.low[0]);
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.fwd_cof[0], col.low[0]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.lowDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.fwdCofDir0[i0][i1] * arc_weight(k),     i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir0[i0][i1] - k,      i0 + 1,          i2,		i3 );
+					add_gs_arc_chain(chain, col.low[0],     i2,          i0,          i1,          i3,		i2 + col.mean[0],      i0 + 1,          i1,		i3 );
 						
-					m_graph.add_arc(i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],      i0 + 1,          i1,		i3 );//Hard constraint
+					add_gs_arc(i2,          i0,          i1,          i3,		i2 + col.mean[0] - col.low[0],      i0 + 1,          i1,		i3 );//Hard constraint
 				
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],      i0 + 1,          i1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[0] - col.low[0]) <= (s2 - 1) )
+						add_gs_arc(i2,          i0,          i1,          i3,		i2 + col.mean[0] - col.low[0],      i0 + 1,          i1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i2,          i0,          i1,          i3,		s2 - 1,      i0 + 1,     i1,		i3 );//Hard constraint
+						add_gs_arc(i2,          i0,          i1,          i3,		s2 - 1,      i0 + 1,     i1,		i3 );//Hard constraint
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) >= 0 )
-						m_graph.add_arc(i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],      i0 + 1,          i1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[0] - col.low[0]) >= 0 )
+						add_gs_arc(i2,          i0,          i1,          i3,		i2 + col.mean[0] - col.low[0],      i0 + 1,          i1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i2,          i0,          i1,          i3,		0,      i0 + 1,     i1,		i3 );//Hard constraint
+						add_gs_arc(i2,          i0,          i1,          i3,		0,      i0 + 1,     i1,		i3 );//Hard constraint
 				}
 				//End boundary condition
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( shape_vce.meanDir0[i0][i1] < 0 )
-				upBound = -shape_vce.meanDir0[i0][i1];
+				if ( col.mean[0] < 0 )
+				upBound = -col.mean[0];
 
-				if ( (shape_vce.meanDir0[i0][i1] + shape_vce.upDir0[i0][i1]) > 0 )
-				lowBound = shape_vce.meanDir0[i0][i1] + shape_vce.upDir0[i0][i1];
+				if ( (col.mean[0] + col.up[0]) > 0 )
+				lowBound = col.mean[0] + col.up[0];
                 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.back_cof[0], col.up[0]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.upDir0[i0][i1]; k++)
-				    {m_graph.add_arc_cost(shape_vce.backCofDir0[i0][i1] * arc_weight(k),     i2,          i0 + 1,          i1,          i3,		i2 - shape_vce.meanDir0[i0][i1] - k,      i0,          i1,		i3 );
-					//cout << "Wrong detected!" << endl;
-					}
+					add_gs_arc_chain(chain, col.up[0],     i2,          i0 + 1,          i1,          i3,		i2 - col.mean[0],      i0,          i1,		i3 );
 
-					m_graph.add_arc( i2,          i0 + 1,          i1,          i3,		i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],      i0,          i1,		i3 );//Hard constraints
+					add_gs_arc( i2,          i0 + 1,          i1,          i3,		i2 - col.mean[0] - col.up[0],      i0,          i1,		i3 );//Hard constraints
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i2,          i0 + 1,          i1,          i3,		i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],      i0,          i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[0] - col.up[0]) <= (s2 - 1) )
+						add_gs_arc( i2,          i0 + 1,          i1,          i3,		i2 - col.mean[0] - col.up[0],      i0,          i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i2,          i0 + 1,          i1,          i3,		s2 - 1,      i0,          i1,		i3 );//Hard constraints
+						add_gs_arc( i2,          i0 + 1,          i1,          i3,		s2 - 1,      i0,          i1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1]) >= 0 )
-						m_graph.add_arc( i2,          i0 + 1,          i1,          i3,		i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],      i0,          i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[0] - col.up[0]) >= 0 )
+						add_gs_arc( i2,          i0 + 1,          i1,          i3,		i2 - col.mean[0] - col.up[0],      i0,          i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i2,          i0 + 1,          i1,          i3,		0,      i0,     i1,		i3 );//Hard constraints
+						add_gs_arc( i2,          i0 + 1,          i1,          i3,		0,      i0,     i1,		i3 );//Hard constraints
 				}
 				//End boundary condition		
 			} //for i0
@@ -703,66 +1928,69 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_x(const shape_vce_type&
             for (i0 = 0; i0 < s0; ++i0) {
 				
 				int upBound = 0, lowBound = 0; 
+				const shape_column_type& col = shape_vce(i0, i1);
 				//Forward
-                if ( shape_vce.meanDir1[i0][i1] > 0 )
-				upBound = shape_vce.meanDir1[i0][i1];
+                if ( col.mean[1] > 0 )
+				upBound = col.mean[1];
 
-				if ( (shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) < 0 )
-				lowBound = - ( shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]);
+				if ( (col.mean[1] - col.low[1]) < 0 )
+				lowBound = - ( col.mean[1] - col.low[1]);
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.fwd_cof[1], col.low[1]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.lowDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.fwdCofDir1[i0][i1] * arc_weight(k),     i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir1[i0][i1] - k,      i0,          i1 + 1,		i3 );
+					add_gs_arc_chain(chain, col.low[1],     i2,          i0,          i1,          i3,		i2 + col.mean[1],      i0,          i1 + 1,		i3 );
 					
-					m_graph.add_arc( i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],      i0,          i1 + 1,		i3 );//Hard constraint
+					add_gs_arc( i2,          i0,          i1,          i3,		i2 + col.mean[1] - col.low[1],      i0,          i1 + 1,		i3 );//Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],      i0,          i1 + 1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[1] - col.low[1]) <= (s2 - 1) )
+						add_gs_arc(i2,          i0,          i1,          i3,		i2 + col.mean[1] - col.low[1],      i0,          i1 + 1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i2,          i0,          i1,          i3,		s2 - 1,      i0,          i1 + 1,		i3 );//Hard constraint
+						add_gs_arc(i2,          i0,          i1,          i3,		s2 - 1,      i0,          i1 + 1,		i3 );//Hard constraint
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) >= 0 )
-						m_graph.add_arc(i2,          i0,          i1,          i3,		i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],      i0,          i1 + 1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[1] - col.low[1]) >= 0 )
+						add_gs_arc(i2,          i0,          i1,          i3,		i2 + col.mean[1] - col.low[1],      i0,          i1 + 1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i2,          i0,          i1,          i3,		0,      i0,          i1 + 1,		i3 );//Hard constraint
+						add_gs_arc(i2,          i0,          i1,          i3,		0,      i0,          i1 + 1,		i3 );//Hard constraint
 				}
 				//End boundary condition
 
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( shape_vce.meanDir1[i0][i1] < 0 )
-				upBound = -shape_vce.meanDir1[i0][i1];
+				if ( col.mean[1] < 0 )
+				upBound = -col.mean[1];
 
-				if ( (shape_vce.meanDir1[i0][i1] + shape_vce.upDir1[i0][i1]) > 0 )
-				lowBound = shape_vce.meanDir1[i0][i1] + shape_vce.upDir1[i0][i1];
+				if ( (col.mean[1] + col.up[1]) > 0 )
+				lowBound = col.mean[1] + col.up[1];
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.back_cof[1], col.up[1]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.upDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.backCofDir1[i0][i1] * arc_weight(k),     i2,          i0,          i1 + 1,          i3,		i2 - shape_vce.meanDir1[i0][i1] - k,      i0,          i1,		i3 );
+					add_gs_arc_chain(chain, col.up[1],     i2,          i0,          i1 + 1,          i3,		i2 - col.mean[1],      i0,          i1,		i3 );
 				    
-					m_graph.add_arc( i2,          i0,          i1 + 1,          i3,		i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],      i0,          i1,		i3); //Hard constraint
+					add_gs_arc( i2,          i0,          i1 + 1,          i3,		i2 - col.mean[1] - col.up[1],      i0,          i1,		i3); //Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i2,          i0,          i1 + 1,          i3,		i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],      i0,          i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[1] - col.up[1]) <= (s2 - 1) )
+						add_gs_arc( i2,          i0,          i1 + 1,          i3,		i2 - col.mean[1] - col.up[1],      i0,          i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i2,          i0,          i1 + 1,          i3,		s2 - 1,      i0,          i1,		i3 );//Hard constraints
+						add_gs_arc( i2,          i0,          i1 + 1,          i3,		s2 - 1,      i0,          i1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1]) >= 0 )
-						m_graph.add_arc( i2,          i0,          i1 + 1,          i3,		i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],      i0,          i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[1] - col.up[1]) >= 0 )
+						add_gs_arc( i2,          i0,          i1 + 1,          i3,		i2 - col.mean[1] - col.up[1],      i0,          i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i2,          i0,          i1 + 1,          i3,		0,      i0,     i1,		i3 );//Hard constraints
+						add_gs_arc( i2,          i0,          i1 + 1,          i3,		0,      i0,     i1,		i3 );//Hard constraints
 				}
 				//End boundary condition		
 			} //for i0
@@ -784,6 +2012,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_y(const shape_vce_type&
 	cout<<"Begin vce arcs building"<<endl;
     int i0, i1, i2, i3, s0, s1, s2, s3, ii;
     int convexPower;
+	std::vector<capacity_type> chain;
 	//int graph_id;
 	
 	i3 = shape_vce.k;
@@ -803,7 +2032,7 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_y(const shape_vce_type&
              --i2) {
         for (i1 = 0; i1 < s1; ++i1) {
             for (i0 = 0; i0 < s0; ++i0) {
-                    m_graph.add_arc(i0,          i2,          i1,          i3,          i0,          i2 - 1,          i1,          i3);
+                    add_gs_arc(i0,          i2,          i1,          i3,          i0,          i2 - 1,          i1,          i3);
             } // for i0 
         } // for i1
     } // for i2
@@ -816,70 +2045,73 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_y(const shape_vce_type&
             for (i0 = 0; i0 < s0 - 1; ++i0) {
 				
 				int upBound = 0, lowBound = 0; 
+				const shape_column_type& col = shape_vce(i0, i1);
 				//Forward
-                if ( shape_vce.meanDir0[i0][i1] > 0 )
-				upBound = shape_vce.meanDir0[i0][i1];
+                if ( col.mean[0] > 0 )
+				upBound = col.mean[0];
 				//cout<<"The upBound is: "<<upBound<<endl;
 
-				if ( (shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) < 0 )
-				lowBound = - ( shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]);
+				if ( (col.mean[0] - col.low[0]) < 0 )
+				lowBound = - ( col.mean[0] - col.low[0]);
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.fwd_cof[0], col.low[0]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.lowDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.fwdCofDir0[i0][i1] * arc_weight(k),     i0,          i2,          i1,          i3,		i0 + 1,      i2 + shape_vce.meanDir0[i0][i1] - k,          i1,		i3 );
+					add_gs_arc_chain(chain, col.low[0],     i0,          i2,          i1,          i3,		i0 + 1,      i2 + col.mean[0],          i1,		i3 );
 					
-					m_graph.add_arc(i0,          i2,          i1,          i3,		i0 + 1,      i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],	i1,		i3 );//Hard constraint
+					add_gs_arc(i0,          i2,          i1,          i3,		i0 + 1,      i2 + col.mean[0] - col.low[0],	i1,		i3 );//Hard constraint
 				
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0 + 1,      i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],	i1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[0] - col.low[0]) <= (s2 - 1) )
+						add_gs_arc(i0,          i2,          i1,          i3,		i0 + 1,      i2 + col.mean[0] - col.low[0],	i1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0 + 1,      s2 - 1,	i1,		i3 );//Hard constraint
+						add_gs_arc(i0,          i2,          i1,          i3,		i0 + 1,      s2 - 1,	i1,		i3 );//Hard constraint
 				
 					
 				
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1]) >= 0 )
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0 + 1,      i2 + shape_vce.meanDir0[i0][i1] - shape_vce.lowDir0[i0][i1],	i1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[0] - col.low[0]) >= 0 )
+						add_gs_arc(i0,          i2,          i1,          i3,		i0 + 1,      i2 + col.mean[0] - col.low[0],	i1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0 + 1,      0,          i1,		i3 );//Hard constraint
+						add_gs_arc(i0,          i2,          i1,          i3,		i0 + 1,      0,          i1,		i3 );//Hard constraint
 				}
 				//End boundary condition
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( shape_vce.meanDir0[i0][i1] < 0 )
-				upBound = -shape_vce.meanDir0[i0][i1];
+				if ( col.mean[0] < 0 )
+				upBound = -col.mean[0];
 
-				if ( (shape_vce.meanDir0[i0][i1] + shape_vce.upDir0[i0][i1]) > 0 )
-				lowBound = shape_vce.meanDir0[i0][i1] + shape_vce.upDir0[i0][i1];
+				if ( (col.mean[0] + col.up[0]) > 0 )
+				lowBound = col.mean[0] + col.up[0];
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.back_cof[0], col.up[0]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.upDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.backCofDir0[i0][i1] * arc_weight(k),     i0 + 1,          i2,          i1,          i3,		i0,      i2 - shape_vce.meanDir0[i0][i1] - k,	i1,		i3 );
+					add_gs_arc_chain(chain, col.up[0],     i0 + 1,          i2,          i1,          i3,		i0,      i2 - col.mean[0],	i1,		i3 );
 
-					m_graph.add_arc( i0 + 1,          i2,          i1,          i3,		i0,      i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],	i1,		i3 );//Hard constraints
+					add_gs_arc( i0 + 1,          i2,          i1,          i3,		i0,      i2 - col.mean[0] - col.up[0],	i1,		i3 );//Hard constraints
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i0 + 1,          i2,          i1,          i3,		i0,      i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],	i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[0] - col.up[0]) <= (s2 - 1) )
+						add_gs_arc( i0 + 1,          i2,          i1,          i3,		i0,      i2 - col.mean[0] - col.up[0],	i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0 + 1,          i2,          i1,          i3,		i0,      s2 - 1,	i1,		i3 );//Hard constraints
+						add_gs_arc( i0 + 1,          i2,          i1,          i3,		i0,      s2 - 1,	i1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1]) >= 0 )
-						m_graph.add_arc( i0 + 1,          i2,          i1,          i3,		i0,      i2 - shape_vce.meanDir0[i0][i1] - shape_vce.upDir0[i0][i1],	i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[0] - col.up[0]) >= 0 )
+						add_gs_arc( i0 + 1,          i2,          i1,          i3,		i0,      i2 - col.mean[0] - col.up[0],	i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0 + 1,          i2,          i1,          i3,		i0,      0,          i1,		i3 );//Hard constraints
+						add_gs_arc( i0 + 1,          i2,          i1,          i3,		i0,      0,          i1,		i3 );//Hard constraints
 				}
 				//End boundary condition		
 			} //for i0
@@ -893,66 +2125,69 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_vce_arcs_y(const shape_vce_type&
             for (i0 = 0; i0 < s0; ++i0) {
 				
 				int upBound = 0, lowBound = 0; 
+				const shape_column_type& col = shape_vce(i0, i1);
 				//Forward
-                if ( shape_vce.meanDir1[i0][i1] > 0 )
-				upBound = shape_vce.meanDir1[i0][i1];
+                if ( col.mean[1] > 0 )
+				upBound = col.mean[1];
 
-				if ( (shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) < 0 )
-				lowBound = - ( shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]);
+				if ( (col.mean[1] - col.low[1]) < 0 )
+				lowBound = - ( col.mean[1] - col.low[1]);
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.fwd_cof[1], col.low[1]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.lowDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.fwdCofDir1[i0][i1] * arc_weight(k),     i0,          i2,          i1,          i3,		i0,     i2 + shape_vce.meanDir1[i0][i1] - k,	i1 + 1,		i3 );
+					add_gs_arc_chain(chain, col.low[1],     i0,          i2,          i1,          i3,		i0,     i2 + col.mean[1],	i1 + 1,		i3 );
 					
-					m_graph.add_arc( i0,          i2,          i1,          i3,		i0,      i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1], 	i1 + 1,		i3 );//Hard constraint
+					add_gs_arc( i0,          i2,          i1,          i3,		i0,      i2 + col.mean[1] - col.low[1], 	i1 + 1,		i3 );//Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0,          i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],	i1 + 1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[1] - col.low[1]) <= (s2 - 1) )
+						add_gs_arc(i0,          i2,          i1,          i3,		i0,          i2 + col.mean[1] - col.low[1],	i1 + 1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0,      s2 - 1,	i1 + 1,		i3 );//Hard constraint
+						add_gs_arc(i0,          i2,          i1,          i3,		i0,      s2 - 1,	i1 + 1,		i3 );//Hard constraint
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1]) >= 0 )
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0,       i2 + shape_vce.meanDir1[i0][i1] - shape_vce.lowDir1[i0][i1],	i1 + 1,		i3 );//Hard constraint
+					if ( (i2 + col.mean[1] - col.low[1]) >= 0 )
+						add_gs_arc(i0,          i2,          i1,          i3,		i0,       i2 + col.mean[1] - col.low[1],	i1 + 1,		i3 );//Hard constraint
 					else
-						m_graph.add_arc(i0,          i2,          i1,          i3,		i0,     0,	i1 + 1,		i3 );//Hard constraint
+						add_gs_arc(i0,          i2,          i1,          i3,		i0,     0,	i1 + 1,		i3 );//Hard constraint
 				}
 				//End boundary condition
 
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( shape_vce.meanDir1[i0][i1] < 0 )
-				upBound = -shape_vce.meanDir1[i0][i1];
+				if ( col.mean[1] < 0 )
+				upBound = -col.mean[1];
 
-				if ( (shape_vce.meanDir1[i0][i1] + shape_vce.upDir1[i0][i1]) > 0 )
-				lowBound = shape_vce.meanDir1[i0][i1] + shape_vce.upDir1[i0][i1];
+				if ( (col.mean[1] + col.up[1]) > 0 )
+				lowBound = col.mean[1] + col.up[1];
 
+				// Convex arc weights of this column pair.
+				fill_arc_chain(chain, col.back_cof[1], col.up[1]);
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < shape_vce.upDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(shape_vce.backCofDir1[i0][i1] * arc_weight(k),     i0,       i2,	i1 + 1,          i3,		i0,      i2 - shape_vce.meanDir1[i0][i1] - k,	i1,		i3 );
+					add_gs_arc_chain(chain, col.up[1],     i0,       i2,	i1 + 1,          i3,		i0,      i2 - col.mean[1],	i1,		i3 );
 				    
-					m_graph.add_arc( i0,          i2,          i1 + 1,          i3,		i0,      i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],	i1,		i3 ); //Hard constraint
+					add_gs_arc( i0,          i2,          i1 + 1,          i3,		i0,      i2 - col.mean[1] - col.up[1],	i1,		i3 ); //Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i0,       i2,  	i1 + 1,          i3,		i0,      i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],	i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[1] - col.up[1]) <= (s2 - 1) )
+						add_gs_arc( i0,       i2,  	i1 + 1,          i3,		i0,      i2 - col.mean[1] - col.up[1],	i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0,        i2,		i1 + 1,          i3,		i0,      s2 - 1,	i1,		i3 );//Hard constraints
+						add_gs_arc( i0,        i2,		i1 + 1,          i3,		i0,      s2 - 1,	i1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1]) >= 0 )
-						m_graph.add_arc( i0,	i2,		i1 + 1,		i3,		i0,      i2 - shape_vce.meanDir1[i0][i1] - shape_vce.upDir1[i0][i1],	i1,		i3 );//Hard constraints
+					if ( (i2 - col.mean[1] - col.up[1]) >= 0 )
+						add_gs_arc( i0,	i2,		i1 + 1,		i3,		i0,      i2 - col.mean[1] - col.up[1],	i1,		i3 );//Hard constraints
 					else
-						m_graph.add_arc( i0,	i2,		i1 + 1,          i3,		i0,      0,          i1,		i3 );//Hard constraints
+						add_gs_arc( i0,	i2,		i1 + 1,          i3,		i0,      0,          i1,		i3 );//Hard constraints
 				}
 				//End boundary condition		
 			} //for i0
@@ -1218,11 +2453,11 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_gs_gc_arcs()
 							ii = s2 - i2 + 1 + r; 
 					
 						if ( ii >= 0 && ii < s2 ) 
-							m_graph.add_arc(i2, i0, i1, k0, ii, i0, i1, k1);
+							add_gs_arc(i2, i0, i1, k0, ii, i0, i1, k1);
 						else if ( ii >= s2 ) //Boundary case
-							m_graph.add_arc(i2, i0, i1, k0, s2 - 1, i0, i1, k1);
+							add_gs_arc(i2, i0, i1, k0, s2 - 1, i0, i1, k1);
 						else //Boundary case
-							m_graph.add_arc(i2, i0, i1, k0, 0, i0, i1, k1 );	
+							add_gs_arc(i2, i0, i1, k0, 0, i0, i1, k1 );	
 					} // for i2
 		}
 		else if ( dir == 2 || dir == 3)
@@ -1240,11 +2475,11 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_gs_gc_arcs()
 							ii = s2 - i2 + 1 + r; 
 					
 						if ( ii >= 0 && ii < s2 ) 
-							m_graph.add_arc(i0, i2, i1, k0, i0, ii, i1, k1);
+							add_gs_arc(i0, i2, i1, k0, i0, ii, i1, k1);
 						else if ( ii >= s2 ) //Boundary case
-							m_graph.add_arc(i0, i2, i1, k0, i0, s2 - 1, i1, k1);
+							add_gs_arc(i0, i2, i1, k0, i0, s2 - 1, i1, k1);
 						else //Boundary case
-							m_graph.add_arc(i0, i2, i1, k0, i0, 0, i1, k1 );	
+							add_gs_arc(i0, i2, i1, k0, i0, 0, i1, k1 );	
 					} // for i2
 		}
 		else if ( dir == 4 || dir == 5)
@@ -1262,11 +2497,11 @@ optnet_gs_gt_multi_dir<_Cost, _Cap, _Tg>::build_gs_gc_arcs()
 							ii = s2 - i2 + 1 + r; 
 					
 						if ( ii >= 0 && ii < s2 ) 
-							m_graph.add_arc(i0, i1, i2, k0, i0, i1, ii, k1);
+							add_gs_arc(i0, i1, i2, k0, i0, i1, ii, k1);
 						else if ( ii >= s2 ) //Boundary case
-							m_graph.add_arc(i0, i1, i2, k0, i0, i1, s2 - 1, k1);
+							add_gs_arc(i0, i1, i2, k0, i0, i1, s2 - 1, k1);
 						else //Boundary case
-							m_graph.add_arc(i0, i1, i2, k0, i0, i1, 0, k1 );	
+							add_gs_arc(i0, i1, i2, k0, i0, i1, 0, k1 );	
 					} // for i2
 		}
 	} // for i3
@@ -19,11 +19,14 @@
 #   include <optnet/_base/array.hxx>
 #   include <optnet/_base/array_ref.hxx>
 #   include <optnet/_pseudo/optnet_np_pseudoflow.hxx>
+#   include <optnet/_xtra/graphics/sphere_mesh.hxx>
+#   include <optnet_graphcut/optnet_shape_model.hxx>
 
 #   if defined(_MSC_VER) && (_MSC_VER > 1000) && (_MSC_VER <= 1200)
 #       pragma warning(disable: 4018)
 #       pragma warning(disable: 4146)
 #   endif
+#   include <deque>
 #   include <vector>
 
 
@@ -70,24 +73,23 @@ class optnet_gs_gt_multi_dir
     //typedef std::vector<_Intra>                 intra_vector;
     typedef std::vector<_Inter>                 inter_vector;
 	
-	struct _Shape_VCE{              //Added by Sq
-		size_t	k;
-		int		dir;				//Six directions, 0: x-positive; 1: x-negative;
-                                    //                2: y-positive; 3: y-negative;
-                                    //                4: z-positive; 5: z-negative; 									 
-		int     **meanDir0;        
-		int     **meanDir1;
-		int     **upDir0;
-		int     **upDir1;
-		int     **lowDir0;
-		int     **lowDir1;
-		float	**fwdCofDir0;
-		float	**backCofDir0;
-		float	**fwdCofDir1;
-		float	**backCofDir1;
+	typedef std::vector<shape_prior>             shape_vce_vector;
+
+	struct _Column_bounds{          // Feasible surface heights
+		int					axis;	// The search direction (0, 1 or 2).
+		int					s0;		// Number of columns along i0.
+		std::vector<int>	lo;		// Lowest feasible height per column.
+		std::vector<int>	hi;		// Highest feasible height per column.
 	};
 
-	typedef std::vector<_Shape_VCE>              shape_vce_vector;
+	typedef std::vector<_Column_bounds>          column_bounds_vector;
+
+	enum {                          // Node states w.r.t. column bounds
+		PRUNED_BELOW,               // below the column base (source side)
+		COLUMN_BASE,                // the lowest feasible node
+		COLUMN_FREE,                // a regular node
+		PRUNED_ABOVE                // above the feasible range (sink side)
+	};
 
 public:
     typedef size_t                              size_type;
@@ -101,7 +103,8 @@ public:
     typedef array_base<size_type>               net_base_type;
     typedef array_ref<size_type>                net_ref_type;
     typedef array<size_type>                    net_type; 
-    typedef _Shape_VCE            				shape_vce_type;	
+    typedef shape_prior                         shape_vce_type;
+    typedef shape_column                        shape_column_type;
 	//
 	struct _Inter_cutcut {      //Added by Sq
 		size_t k[2];
@@ -111,6 +114,21 @@ public:
 	typedef _Inter_cutcut						inter_cutcut_type;
 	typedef std::vector<_Inter_cutcut>          inter_cutcut_vector;
 	//
+	typedef array_base<unsigned char>           label_base_type;
+	typedef array<unsigned char>                label_type;
+	//
+	struct _Lesion_roi {            // A lesion subgraph
+		size_type			begin[3];   // The first voxel of the box.
+		size_type			end[3];     // One past the last voxel of the box.
+		std::vector<size_type>	labels; // The lesion IDs solved in the box.
+	};
+	//
+	typedef _Lesion_roi							lesion_roi_type;
+	typedef std::vector<_Lesion_roi>            lesion_roi_vector;
+	//
+	typedef array_base<int>                     region_base_type;
+	typedef xtra::graphics::sphere_mesh<double> sphere_mesh_type;
+	//
 	long flow_value;
 	bool is_vce;
 	int pow_vce;
@@ -191,11 +209,25 @@ public:
 	///////////////////////////////////////////////////////////////////////
     ///  Set the shape prior.
     ///
-    ///  @param  shape_vce
+    ///  @param  shape_vce  The shape prior of surface shape_vce.k; it is
+    ///                     copied. Its size must match the plane of the
+    ///                     graph normal to its direction.
     ///
     ///////////////////////////////////////////////////////////////////////
 	void set_shape_prior(const shape_vce_type& shape_vce);
 
+    ///////////////////////////////////////////////////////////////////////
+    ///  Set the shape priors of all surfaces from a shape model.
+    ///
+    ///  @param  model  The shape model; its priors are copied, replacing
+    ///                 the shape priors set before.
+    ///
+    ///  @exception std::invalid_argument The model was built for another
+    ///                                   graph size.
+    ///
+    ///////////////////////////////////////////////////////////////////////
+    void set_shape_model(const shape_model& model);
+
     ///////////////////////////////////////////////////////////////////////
     ///  Solve the optimal surface problem using the given cost function
     ///  and smoothness constraints.
@@ -226,6 +258,30 @@ public:
     void solve_all (net_base_type& net,      // [OUT]
                capacity_type* pflow = 0 // [OUT]
                );
+
+	///////////////////////////////////////////////////////////////////////
+	///  Get the labeled image of the cut found by the last solve_all.
+	///
+	///  @param net   The resulting labeled image; for a graph search
+	///               surface, the voxel on the surface in every column
+	///               is 1 and the others are 0.
+	///
+	///  @remarks The labels of the graph cut surfaces are copied from
+	///           the graph in memory order instead of node by node.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void extract_labels(net_base_type& net) const;
+
+	///////////////////////////////////////////////////////////////////////
+	///  Get the labeled image of the last solve_all as a bit mask.
+	///
+	///  @param bits  The resulting mask, one bit per voxel of the
+	///               labeled image (see extract_labels): the label of
+	///               voxel n (the index into net.data()) is bit n % 8
+	///               of byte n / 8.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void extract_label_bits(std::vector<unsigned char>& bits) const;
 	///////////////////////////////////////////////////////////////////////
 	// Set cost of nodes in graph search framework.
 	void set_gs_cost(const cost_array_type& cost) { m_pcost_gs = &cost; };
@@ -243,24 +299,269 @@ public:
 	void set_neigh_cost(const cost_array_type& cost) { m_pcost_neigh = &cost; };
 	
 	void set_neigh_coef(capacity_type* coef) { m_neigh_coef = coef; }
+
+	///////////////////////////////////////////////////////////////////////
+	///  Enable/disable pruning of the graph search columns.
+	///
+	///  @param enable  If true (default), the feasible height interval of
+	///                 each column is propagated through the hard shape
+	///                 constraints before the graph is built, and the
+	///                 column segments outside it are left out of the
+	///                 graph. The solution is not affected.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void set_column_pruning(bool enable) { m_column_pruning = enable; }
+
+	///////////////////////////////////////////////////////////////////////
+	///  Enable/disable the progress output of the solvers.
+	///
+	///  @param verbose  If true (default), the graph construction and
+	///                  max-flow progress is printed to stdout.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void set_verbose(bool verbose) { m_verbose = verbose; m_graph.set_verbose(verbose); }
+
+	///////////////////////////////////////////////////////////////////////
+	///  Find the disjoint subgraphs of a labelled seed map.
+	///
+	///  @param seeds   The object seeds, one non-zero ID per lesion.
+	///  @param region  The region that may contain object voxels (the
+	///                 background seed image: all 0-voxels are
+	///                 definitely background).
+	///  @param rois    The resulting boxes, each holding the connected
+	///                 region voxels of one or more lesions plus a
+	///                 one-voxel background margin. Lesions whose boxes
+	///                 overlap are merged into one box.
+	///
+	///////////////////////////////////////////////////////////////////////
+	static void find_lesion_rois(const label_base_type& seeds,
+	                             const label_base_type& region,
+	                             lesion_roi_vector&     rois
+	                             );
+
+	///////////////////////////////////////////////////////////////////////
+	///  Segment several lesions at once.
+	///
+	///  @param seeds   The object seeds, one non-zero ID per lesion.
+	///  @param rois    The lesion subgraphs (see find_lesion_rois).
+	///  @param net     The resulting multi-label image; every object
+	///                 voxel connected to a seed is set to the ID of its
+	///                 lesion (that of the nearest connected seed), all
+	///                 other voxels to 0.
+	///  @param pflow   The output sum of the maximum flows of the boxes.
+	///
+	///  @remarks Only the graph cut surfaces are supported. Every box
+	///           is solved as an independent graph with the costs,
+	///           neighbor coefficients and context relations set on
+	///           this object; the boxes are solved concurrently when
+	///           OpenMP is available, without progress output. The
+	///           create() function does not need to be called.
+	///           Object components that contain no seed are left to
+	///           the background, inside the boxes as outside them; so
+	///           unlike solve_all(), only the seeded lesions are kept.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void solve_lesions(const label_base_type&   seeds,
+	                   const lesion_roi_vector& rois,
+	                   net_base_type&           net,      // [OUT]
+	                   capacity_type*           pflow = 0 // [OUT]
+	                   );
+
+	///////////////////////////////////////////////////////////////////////
+	///  Segment on supervoxels.
+	///
+	///  @param regions      The region (supervoxel) ID of every voxel,
+	///                      0 to num_regions - 1 (e.g., computed by
+	///                      optnet::xtra::iwt).
+	///  @param num_regions  The number of regions.
+	///  @param net          The resulting labeled image; all voxels of a
+	///                      region get the same label.
+	///  @param pflow        The output maximum flow value.
+	///
+	///  @remarks Only the graph cut surfaces are supported. The graph has
+	///           one node per region and surface: the regional and
+	///           context terms are summed over the voxels of a region,
+	///           and the boundary terms over the faces between two
+	///           regions. Any labeling that is constant on the regions
+	///           has the same cut cost as in the voxel graph, up to the
+	///           faces of the image boundary. The create() function does
+	///           not need to be called.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void solve_supervoxels(const region_base_type& regions,
+	                       size_type               num_regions,
+	                       net_base_type&          net,      // [OUT]
+	                       capacity_type*          pflow = 0 // [OUT]
+	                       );
+
+	///////////////////////////////////////////////////////////////////////
+	///  Segment a star-shaped object on spherical columns.
+	///
+	///  @param center       The star center (i0, i1, i2), in voxels;
+	///                      e.g., the centroid of the object seeds.
+	///  @param directions   The column directions: the vertices of a
+	///                      unit sphere mesh (see sphere_mesh_cache).
+	///  @param num_samples  The number of samples along every column.
+	///  @param step         The sample spacing along the columns, in
+	///                      voxels.
+	///  @param smoothness   The maximum difference of the surface
+	///                      heights (in samples) of two adjacent columns.
+	///  @param net          The resulting labeled image; the voxels
+	///                      farther than (num_samples - 1/2) * step from
+	///                      the center are background.
+	///  @param pflow        The output maximum flow value.
+	///
+	///  @remarks Only the graph cut surfaces are supported. The region,
+	///           boundary and context costs are sampled along the rays
+	///           from the center by trilinear interpolation, into a
+	///           (samples x directions) column array per surface. The
+	///           column graph makes every column an interval starting
+	///           at the center, and limits the height differences of
+	///           adjacent columns. The regional and context terms are
+	///           weighted by the volume of the shell cell of a sample,
+	///           and the boundary terms by the area of its faces, so
+	///           the cut cost approximates that of the voxel graph. The
+	///           create() function does not need to be called.
+	///
+	///////////////////////////////////////////////////////////////////////
+	void solve_star(const double*            center,
+	                const sphere_mesh_type&  directions,
+	                size_type                num_samples,
+	                double                   step,
+	                int                      smoothness,
+	                net_base_type&           net,      // [OUT]
+	                capacity_type*           pflow = 0 // [OUT]
+	                );
 	
 	
 private:
 
+	struct _Region_adjacency {      // Two adjacent supervoxels
+		int					region;	// The higher region ID.
+		size_type			index;	// The first of its arc weights.
+	};
+
     ///////////////////////////////////////////////////////////////////////
     // Compute the upper and lower margin of the 3-D subgraphs. The nodes
     // above the upper bound and below the lower bound can never be on
     // the resulting surfaces.
-    //void get_bounds_of_subgraphs();
+    void get_bounds_of_subgraphs();
+
+	///////////////////////////////////////////////////////////////////////
+	// Tighten the height intervals of two adjacent columns c0 and c1
+	// that are linked by hard constraints with the shifts d01 and d10.
+	// Returns false if the intervals became empty.
+	bool relax_column_bounds(_Column_bounds&    bounds,
+	                         int                s2,
+	                         int                c0,
+	                         int                c1,
+	                         int                d01,
+	                         int                d10,
+	                         std::deque<int>&   queue,
+	                         std::vector<char>& queued
+	                         );
+
+	///////////////////////////////////////////////////////////////////////
+	// Return the state of a graph node with respect to the column bounds.
+	inline int column_state(size_type i0, size_type i1, size_type i2, size_type i3) const
+	{
+		if ( i3 >= m_bounds.size() || m_bounds[i3].lo.empty() )
+			return COLUMN_FREE;
+
+		const _Column_bounds& bounds = m_bounds[i3];
+		size_type c;
+		int       h;
+
+		switch ( bounds.axis ) {
+		case 0:  c = i2 * bounds.s0 + i1; h = (int)i0; break;
+		case 1:  c = i2 * bounds.s0 + i0; h = (int)i1; break;
+		default: c = i1 * bounds.s0 + i0; h = (int)i2; break;
+		}
+
+		if ( h <  bounds.lo[c] ) return PRUNED_BELOW;
+		if ( h == bounds.lo[c] ) return COLUMN_BASE;
+		if ( h >  bounds.hi[c] ) return PRUNED_ABOVE;
+		return COLUMN_FREE;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Return the height of the column base (i0, i1 are column indices in
+	// the coordinates of the search direction).
+	inline int column_floor(size_type i0, size_type i1, size_type i3) const
+	{
+		if ( i3 >= m_bounds.size() || m_bounds[i3].lo.empty() )
+			return 0;
+		return m_bounds[i3].lo[i1 * m_bounds[i3].s0 + i0];
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Return the index (into the labeled image) of the voxel on the
+	// surface of shape prior p in column (i0, i1).
+	size_type find_surface_voxel(size_type p, size_type i0, size_type i1) const;
+
+	///////////////////////////////////////////////////////////////////////
+	// Set the bits offset to offset + count - 1 of a bit mask to the
+	// labels (0 or 1).
+	static void pack_label_bits(const unsigned char* labels,
+	                            size_type            count,
+	                            unsigned char*       bits,
+	                            size_type            offset
+	                            );
+
+	///////////////////////////////////////////////////////////////////////
+	// Add a hard (infinite) or a weighted arc to the graph search
+	// subgraphs, taking the pruned column segments into account.
+	void add_gs_arc(size_type tail_0, size_type tail_1, size_type tail_2, size_type tail_3,
+	                size_type head_0, size_type head_1, size_type head_2, size_type head_3
+	                );
+
+	void add_gs_arc_cost(capacity_type cost,
+	                     size_type tail_0, size_type tail_1, size_type tail_2, size_type tail_3,
+	                     size_type head_0, size_type head_1, size_type head_2, size_type head_3
+	                     );
+
+	///////////////////////////////////////////////////////////////////////
+	// Add the convex (VCE) arcs from one node to the head node and the
+	// count - 1 nodes below it as one arc chain.
+	void add_gs_arc_chain(const std::vector<capacity_type>& chain,
+	                      int       count,
+	                      size_type tail_0, size_type tail_1, size_type tail_2, size_type tail_3,
+	                      size_type head_0, size_type head_1, size_type head_2, size_type head_3
+	                      );
+
+	///////////////////////////////////////////////////////////////////////
+	// Fill the arc chain weights cof * arc_weight(k), k = 0..count-1.
+	void fill_arc_chain(std::vector<capacity_type>& chain, float cof, int count);
+
+	///////////////////////////////////////////////////////////////////////
+	// Sample surface k of a cost array at (x0, x1, x2) by trilinear
+	// interpolation.
+	static double sample_cost(const cost_array_type& cost,
+	                          double                 x0,
+	                          double                 x1,
+	                          double                 x2,
+	                          size_type              k
+	                          );
+
+	///////////////////////////////////////////////////////////////////////
+	// Solve the subgraph of one lesion box and write its labels to net.
+	capacity_type solve_lesion(const label_base_type&  seeds,
+	                           const lesion_roi_type& roi,
+	                           net_base_type&         net
+	                           );
 
     ///////////////////////////////////////////////////////////////////////
-    // Transform the costs of the graph nodes based on the given
-    // cost vector.
-    void transform_costs_x(const shape_vce_type& shape_vce);
-	
-	void transform_costs_y(const shape_vce_type& shape_vce);
-	
-	void transform_costs_z(const shape_vce_type& shape_vce);
+    // Transform the costs of the graph nodes of all graph search
+    // surfaces based on the given cost vector.
+    void transform_costs();
+
+	///////////////////////////////////////////////////////////////////////
+	// Compute the signed terminal capacities (see add_st_arcs) of the
+	// nodes (i0, *, *) of the surface of a shape prior, in node order.
+	void transform_column_costs(const shape_vce_type& shape_vce,
+	                            size_type             i0,
+	                            capacity_type*        caps
+	                            ) const;
     
     ///////////////////////////////////////////////////////////////////////
     // Construct the arcs of the underlying graph.
@@ -311,6 +612,7 @@ private:
 	//int arc_weight( int k , size_type i0, size_type i1, size_type i3, int dir, int fwdFlag);
 	
 	///////////////////////////////////////////////////////////////////////
+	// The weight of the k-th convex arc (cached).
 	int arc_weight( int k );
 
     graph_type                m_graph;
@@ -322,6 +624,11 @@ private:
 	size_type                 m_num_surf_graphsearch;
 	size_type                 m_num_surf_graphcut;
 	capacity_type*			  m_neigh_coef;
+	column_bounds_vector	  m_bounds;
+	bool					  m_column_pruning;
+	bool					  m_verbose;
+	std::vector<int>		  m_arc_weights;
+	int						  m_arc_weight_pow;
 };
 
 } // optnet
@@ -0,0 +1,413 @@
+/*
+ ==========================================================================
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ ==========================================================================
+ */
+
+#ifndef ___OPTNET_SHAPE_MODEL_HXX___
+#   define ___OPTNET_SHAPE_MODEL_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#   endif
+
+#   include <optnet/config.h>
+#   include <optnet_graphcut/optnet_shape_prior.hxx>
+#   include <map>
+#   include <string>
+#   include <utility>
+
+
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+///  @class shape_model
+///  @brief A precompiled shape model: the shape priors of all surfaces of
+///         an organ model, built for one graph geometry.
+///
+///  A model is identified by its id (e.g., the organ model name) and the
+///  size of the graph it was built for. It is stored in a compact binary
+///  file: the tag "OSPM", a version, the id, the geometry and the number
+///  of priors, followed by the shape_prior records.
+///////////////////////////////////////////////////////////////////////////
+class shape_model
+{
+public:
+
+    typedef size_t                      size_type;
+    typedef std::vector<shape_prior>    prior_vector;
+
+    ///////////////////////////////////////////////////////////////////////
+    /// Default constructor.
+    ///////////////////////////////////////////////////////////////////////
+    shape_model() { m_geometry[0] = m_geometry[1] = m_geometry[2] = 0; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Constructs an empty model.
+    ///
+    ///  @param id  The model id.
+    ///  @param s0  The graph size along i0.
+    ///  @param s1  The graph size along i1.
+    ///  @param s2  The graph size along i2.
+    ///////////////////////////////////////////////////////////////////////
+    shape_model(const std::string& id,
+                size_type          s0,
+                size_type          s1,
+                size_type          s2
+                ) : m_id(id)
+    {
+        m_geometry[0] = s0;
+        m_geometry[1] = s1;
+        m_geometry[2] = s2;
+    }
+
+    inline const std::string&  id()              const { return m_id;  }
+    inline size_type           geometry(int i)   const { return m_geometry[i]; }
+    inline const size_type*    geometry()        const { return m_geometry; }
+
+    inline size_type           num_priors()      const { return m_priors.size(); }
+    inline const shape_prior&  prior(size_type i) const { return m_priors[i]; }
+    inline shape_prior&        prior(size_type i)      { return m_priors[i]; }
+    inline const prior_vector& priors()          const { return m_priors; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Adds the shape prior of a surface to the model.
+    ///////////////////////////////////////////////////////////////////////
+    inline void add_prior(const shape_prior& prior)
+    {
+        m_priors.push_back(prior);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Gets the number of columns of a shape prior for the given search
+    ///  direction: the size of the graph plane normal to it.
+    ///////////////////////////////////////////////////////////////////////
+    static void plane_size(int              dir,
+                           const size_type* geometry,
+                           size_type&       s0,
+                           size_type&       s1
+                           )
+    {
+        if (dir == 0 || dir == 1) {
+            s0 = geometry[1];
+            s1 = geometry[2];
+        }
+        else if (dir == 2 || dir == 3) {
+            s0 = geometry[0];
+            s1 = geometry[2];
+        }
+        else {
+            s0 = geometry[0];
+            s1 = geometry[1];
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns true if the model was built for the given geometry.
+    ///////////////////////////////////////////////////////////////////////
+    inline bool matches(const std::string& id, const size_type* geometry) const
+    {
+        return m_id == id &&
+               m_geometry[0] == geometry[0] &&
+               m_geometry[1] == geometry[1] &&
+               m_geometry[2] == geometry[2];
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Loads the model from a binary shape-model file.
+    ///
+    ///  @exception optnet::io::io_error Failed reading the file, or the
+    ///                                  file is not a shape-model file.
+    ///////////////////////////////////////////////////////////////////////
+    void load(const char* name)
+    {
+        FILE* pfile;
+
+        if (0 != secure_fopen(&pfile, name, "rb")) {
+            throw_exception(io::io_error(
+                "shape_model::load: Failed opening file."
+                ));
+        }
+
+        bool ok = read(pfile);
+        fclose(pfile);
+
+        if (!ok) {
+            throw_exception(io::io_error(
+                "shape_model::load: Failed reading shape model."
+                ));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Saves the model into a binary shape-model file.
+    ///
+    ///  @exception optnet::io::io_error Failed writing the file.
+    ///////////////////////////////////////////////////////////////////////
+    void save(const char* name) const
+    {
+        FILE* pfile;
+
+        if (0 != secure_fopen(&pfile, name, "wb")) {
+            throw_exception(io::io_error(
+                "shape_model::save: Failed opening file."
+                ));
+        }
+
+        bool ok = write(pfile);
+        if (0 != fclose(pfile)) ok = false;
+
+        if (!ok) {
+            throw_exception(io::io_error(
+                "shape_model::save: Failed writing shape model."
+                ));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Reads the model from an open file.
+    ///
+    ///  @return false on a read error or a malformed file.
+    ///////////////////////////////////////////////////////////////////////
+    bool read(FILE* pfile)
+    {
+        using namespace optnet::utils;
+
+        char    tag[4];
+        int     head[6]; // version, id length, s0, s1, s2, number of priors
+        bool    swap;
+
+        if (fread(tag, 1, 4, pfile) != 4 ||
+            0 != memcmp(tag, magic(), 4) ||
+            fread(head, sizeof(int), 6, pfile) != 6) {
+            return false;
+        }
+
+        swap = (VERSION != head[0]);
+        if (swap) {
+            for (int i = 0; i < 6; ++i) swap_endian32(&head[i]);
+            if (VERSION != head[0]) return false;
+        }
+        for (int i = 1; i < 6; ++i) {
+            if (head[i] < 0) return false;
+        }
+
+        // The id length and the number of priors come from the file:
+        // check them against the rest of the file before allocating.
+        long left = shape_prior::bytes_left(pfile);
+        if (left < 0 || head[1] > left ||
+            (size_t)head[5] > (size_t)(left - head[1]) / PRIOR_HEAD_SIZE) {
+            return false;
+        }
+
+        std::vector<char> id(head[1] + 1, 0);
+        if (head[1] > 0 &&
+            fread(&id[0], 1, head[1], pfile) != (size_t)head[1]) {
+            return false;
+        }
+
+        m_id          = &id[0];
+        m_geometry[0] = (size_type)head[2];
+        m_geometry[1] = (size_type)head[3];
+        m_geometry[2] = (size_type)head[4];
+        m_priors.resize(head[5]);
+
+        for (size_type i = 0; i < m_priors.size(); ++i) {
+            if (!m_priors[i].read(pfile)) return false;
+        }
+
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Writes the model into an open file.
+    ///
+    ///  @return false on a write error.
+    ///////////////////////////////////////////////////////////////////////
+    bool write(FILE* pfile) const
+    {
+        int head[6] = { VERSION,
+                        (int)m_id.size(),
+                        (int)m_geometry[0],
+                        (int)m_geometry[1],
+                        (int)m_geometry[2],
+                        (int)m_priors.size() };
+
+        if (fwrite(magic(), 1, 4, pfile) != 4 ||
+            fwrite(head, sizeof(int), 6, pfile) != 6 ||
+            fwrite(m_id.data(), 1, m_id.size(), pfile) != m_id.size()) {
+            return false;
+        }
+
+        for (size_type i = 0; i < m_priors.size(); ++i) {
+            if (!m_priors[i].write(pfile)) return false;
+        }
+
+        return true;
+    }
+
+private:
+
+    enum { VERSION = 1 };
+
+    // The size of the smallest shape_prior record: its tag and header.
+    enum { PRIOR_HEAD_SIZE = 4 + 5 * sizeof(int) };
+
+    // The tag of a binary shape-model file.
+    static const char* magic() { return "OSPM"; }
+
+    std::string     m_id;
+    size_type       m_geometry[3];
+    prior_vector    m_priors;
+};
+
+
+///////////////////////////////////////////////////////////////////////////
+///  @class shape_model_cache
+///  @brief An in-process cache of shape models, keyed by model id and
+///         graph geometry.
+///
+///  Cases that use the same organ model on the same geometry share one
+///  copy of the model; only the first one reads the model file.
+///  References returned by the cache stay valid until clear() is called.
+///////////////////////////////////////////////////////////////////////////
+class shape_model_cache
+{
+public:
+
+    typedef size_t  size_type;
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the process-wide cache.
+    ///////////////////////////////////////////////////////////////////////
+    static shape_model_cache& global()
+    {
+        static shape_model_cache cache;
+        return cache;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Finds a cached model.
+    ///
+    ///  @return The model, or 0 if it is not cached.
+    ///////////////////////////////////////////////////////////////////////
+    const shape_model* find(const std::string& id,
+                            const size_type*   geometry
+                            ) const
+    {
+        const shape_model* model = 0;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp critical(optnet_shape_model_cache)
+    #endif
+        {
+            model_map::const_iterator it = m_models.find(key(id, geometry));
+            if (it != m_models.end()) model = &(it->second);
+        }
+
+        return model;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Adds a model to the cache, unless a model of the same id and
+    ///  geometry is cached already; a cached model is never replaced, as
+    ///  other threads may be using it.
+    ///
+    ///  @return The cached model: the given one, or the one cached before.
+    ///////////////////////////////////////////////////////////////////////
+    const shape_model& insert(const shape_model& model)
+    {
+        const shape_model* cached;
+
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp critical(optnet_shape_model_cache)
+    #endif
+        {
+            cached = &(m_models.insert(model_map::value_type(
+                key(model.id(), model.geometry()), model)).first->second);
+        }
+
+        return *cached;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the model of the given id and geometry, reading it from
+    ///  a shape-model file if it is not cached yet.
+    ///
+    ///  @exception optnet::io::io_error Failed reading the file.
+    ///  @exception std::invalid_argument The file holds another model,
+    ///                                   or one built for another
+    ///                                   geometry.
+    ///////////////////////////////////////////////////////////////////////
+    const shape_model& load(const char*        name,
+                            const std::string& id,
+                            const size_type*   geometry
+                            )
+    {
+        const shape_model* cached = find(id, geometry);
+        if (0 != cached) return *cached;
+
+        shape_model model;
+        model.load(name);
+
+        if (!model.matches(id, geometry)) {
+            throw_exception(std::invalid_argument(
+                "shape_model_cache::load: The file holds another model or geometry."
+                ));
+        }
+
+        return insert(model);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    inline size_type size() const { return m_models.size(); }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Removes all cached models.
+    ///////////////////////////////////////////////////////////////////////
+    void clear()
+    {
+    #ifdef __OPTNET_PRAGMA_OMP__
+    #   pragma omp critical(optnet_shape_model_cache)
+    #endif
+        m_models.clear();
+    }
+
+private:
+
+    struct key_type
+    {
+        std::string id;
+        size_type   geometry[3];
+
+        bool operator<(const key_type& rhs) const
+        {
+            if (id != rhs.id) return id < rhs.id;
+            for (int i = 0; i < 3; ++i) {
+                if (geometry[i] != rhs.geometry[i])
+                    return geometry[i] < rhs.geometry[i];
+            }
+            return false;
+        }
+    };
+
+    typedef std::map<key_type, shape_model> model_map;
+
+    static key_type key(const std::string& id, const size_type* geometry)
+    {
+        key_type k;
+        k.id = id;
+        for (int i = 0; i < 3; ++i) k.geometry[i] = geometry[i];
+        return k;
+    }
+
+    model_map    m_models;
+};
+
+} // optnet
+
+#endif
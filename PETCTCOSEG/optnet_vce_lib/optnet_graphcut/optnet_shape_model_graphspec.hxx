@@ -0,0 +1,163 @@
+/*
+ ==========================================================================
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ ==========================================================================
+ */
+
+#ifndef ___OPTNET_SHAPE_MODEL_GRAPHSPEC_HXX___
+#   define ___OPTNET_SHAPE_MODEL_GRAPHSPEC_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#   endif
+
+//
+// The converter from graphspec XML files to binary shape models. It
+// needs the XML back-end of graphspec (MSXML or Xerces), and is meant
+// for the offline tools that build the model library; the solvers only
+// need optnet_shape_model.hxx.
+//
+#   include <optnet/_alpha/graphspec.hxx>
+#   include <optnet_graphcut/optnet_shape_model.hxx>
+#   include <cmath>
+
+
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+///  Builds the shape prior of a surface from a graph target spec.
+///
+///  The spec must have one column per column of the graph plane normal
+///  to dir, with id i0 + i1 * s0. The offset of the surface along each
+///  column (the column's scaling factor) gives the surface height, and
+///  the expected height difference between adjacent columns is the
+///  difference of their offsets.
+///
+///  @param spec      The graph target specification.
+///  @param surf      The surface of the spec to use.
+///  @param k         The graph-search surface the prior applies to.
+///  @param dir       The search direction (0 to 5).
+///  @param geometry  The graph size.
+///  @param scale     The number of voxels per unit of column offset.
+///  @param up        The allowed deviation above the mean.
+///  @param low       The allowed deviation below the mean.
+///  @param fwd_cof   The convex penalty of deviations below the mean.
+///  @param back_cof  The convex penalty of deviations above the mean.
+///
+///  @exception std::invalid_argument The spec does not match the graph.
+///////////////////////////////////////////////////////////////////////////
+inline shape_prior
+shape_prior_from_graphspec(const graphspec&  spec,
+                           size_t            surf,
+                           size_t            k,
+                           int               dir,
+                           const size_t*     geometry,
+                           double            scale,
+                           int               up,
+                           int               low,
+                           float             fwd_cof,
+                           float             back_cof
+                           )
+{
+    size_t              s0, s1, i0, i1, i;
+    shape_prior         prior;
+    std::vector<double> height;
+    std::vector<char>   found;
+
+    shape_model::plane_size(dir, geometry, s0, s1);
+
+    if (surf >= OPTNET_GRAPHSPEC_MAX_SURF || spec.num_columns() != s0 * s1) {
+        throw_exception(std::invalid_argument(
+            "shape_prior_from_graphspec: The spec does not match the graph."
+            ));
+    }
+
+    // Collect the column heights by column id.
+    height.assign(s0 * s1, 0.0);
+    found.assign(s0 * s1, 0);
+    for (i = 0; i < spec.num_columns(); ++i) {
+        const graphspec::column_type& c = spec.get_column(i);
+        if (c.id < 0 || (size_t)c.id >= s0 * s1 || found[c.id]) {
+            throw_exception(std::invalid_argument(
+                "shape_prior_from_graphspec: Invalid column id."
+                ));
+        }
+        height[c.id] = c.fact[surf] * scale;
+        found[c.id]  = 1;
+    }
+
+    prior.create(k, dir, s0, s1);
+
+    for (i1 = 0; i1 < s1; ++i1) {
+        for (i0 = 0; i0 < s0; ++i0) {
+            shape_column& col = prior(i0, i1);
+            double        h   = height[i0 + i1 * s0];
+
+            if (i0 + 1 < s0) {
+                col.mean[0] = (int)floor(height[i0 + 1 + i1 * s0] - h + 0.5);
+            }
+            if (i1 + 1 < s1) {
+                col.mean[1] = (int)floor(height[i0 + (i1 + 1) * s0] - h + 0.5);
+            }
+            for (int d = 0; d < 2; ++d) {
+                col.up[d]       = up;
+                col.low[d]      = low;
+                col.fwd_cof[d]  = fwd_cof;
+                col.back_cof[d] = back_cof;
+            }
+        }
+    }
+
+    return prior;
+}
+
+///////////////////////////////////////////////////////////////////////////
+///  Converts a graph target spec (.ont XML) into a binary shape-model
+///  file, with one shape prior per surface of the spec.
+///
+///  @param spec_name   The name of the graphspec file.
+///  @param model_name  The name of the shape-model file to write.
+///  @param id          The model id.
+///  @param geometry    The graph size the model is built for.
+///  @param num_surf    The number of surfaces to convert; surface j of
+///                     the spec becomes graph-search surface j.
+///  @param dir         The search direction (0 to 5).
+///
+///  The remaining parameters are as in shape_prior_from_graphspec.
+///
+///  @exception std::runtime_error Failed loading the spec.
+///  @exception optnet::io::io_error Failed writing the model.
+///////////////////////////////////////////////////////////////////////////
+inline void
+convert_graphspec_to_shape_model(const char*        spec_name,
+                                 const char*        model_name,
+                                 const std::string& id,
+                                 const size_t*      geometry,
+                                 size_t             num_surf,
+                                 int                dir,
+                                 double             scale,
+                                 int                up,
+                                 int                low,
+                                 float              fwd_cof,
+                                 float              back_cof
+                                 )
+{
+    graphspec spec;
+    spec.load(spec_name);
+
+    shape_model model(id, geometry[0], geometry[1], geometry[2]);
+    for (size_t j = 0; j < num_surf; ++j) {
+        model.add_prior(shape_prior_from_graphspec(spec, j, j, dir,
+            geometry, scale, up, low, fwd_cof, back_cof));
+    }
+
+    model.save(model_name);
+}
+
+} // optnet
+
+#endif
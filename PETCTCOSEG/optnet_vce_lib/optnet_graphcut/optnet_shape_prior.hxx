@@ -0,0 +1,281 @@
+/*
+ ==========================================================================
+ |   Written by agent <agent@local>
+ |
+ ==========================================================================
+ | Copyright (c) 2026 agent <agent@local>. All Rights Reserved.
+ ==========================================================================
+ */
+
+#ifndef ___OPTNET_SHAPE_PRIOR_HXX___
+#   define ___OPTNET_SHAPE_PRIOR_HXX___
+
+#   if defined(_MSC_VER) && (_MSC_VER > 1000)
+#       pragma once
+#       pragma warning(disable: 4786)
+#   endif
+
+#   include <optnet/_base/except.hxx>
+#   include <optnet/_base/secure_s.hxx>
+#   include <optnet/_utils/endian.hxx>
+#   include <cstdio>
+#   include <cstring>
+#   include <vector>
+
+
+namespace optnet {
+
+///////////////////////////////////////////////////////////////////////////
+///  @struct shape_column
+///  @brief  The shape prior of one column of a graph-search surface, for
+///          both in-plane directions (dir-0 along i0, dir-1 along i1).
+///
+///  The surface height difference from this column to its successor in
+///  direction d is expected to be mean[d], and is hard-constrained to
+///  [mean[d] - low[d], mean[d] + up[d]]. fwd_cof[d] and back_cof[d]
+///  weight the convex penalty of the deviations below and above the
+///  mean.
+///////////////////////////////////////////////////////////////////////////
+struct shape_column
+{
+    int     mean[2];
+    int     up[2];
+    int     low[2];
+    float   fwd_cof[2];
+    float   back_cof[2];
+};
+
+///////////////////////////////////////////////////////////////////////////
+///  @class shape_prior
+///  @brief The shape prior of a graph-search surface: one shape_column
+///         record per column, stored contiguously with i0 varying
+///         fastest.
+///////////////////////////////////////////////////////////////////////////
+class shape_prior
+{
+public:
+
+    typedef size_t                      size_type;
+    typedef shape_column                column_type;
+    typedef std::vector<shape_column>   column_vector;
+
+    size_type   k;      // The surface the prior applies to.
+    int         dir;    // Six directions, 0: x-positive; 1: x-negative;
+                        //                2: y-positive; 3: y-negative;
+                        //                4: z-positive; 5: z-negative;
+
+    ///////////////////////////////////////////////////////////////////////
+    /// Default constructor.
+    ///////////////////////////////////////////////////////////////////////
+    shape_prior() : k(0), dir(0), m_s0(0), m_s1(0) {}
+
+    ///////////////////////////////////////////////////////////////////////
+    /// Constructs a shape prior of s0 x s1 columns (see create).
+    ///////////////////////////////////////////////////////////////////////
+    shape_prior(size_type k_, int dir_, size_type s0, size_type s1)
+    {
+        create(k_, dir_, s0, s1);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Allocates s0 x s1 columns and resets them to no deviation from a
+    ///  flat surface (mean 0), a unit hard smoothness (up = low = 1) and
+    ///  no convex penalty.
+    ///
+    ///  @param k_    The surface the prior applies to.
+    ///  @param dir_  The search direction (0 to 5).
+    ///  @param s0    The number of columns along i0.
+    ///  @param s1    The number of columns along i1.
+    ///////////////////////////////////////////////////////////////////////
+    void create(size_type k_, int dir_, size_type s0, size_type s1)
+    {
+        column_type column;
+
+        for (int d = 0; d < 2; ++d) {
+            column.mean[d]     = 0;
+            column.up[d]       = 1;
+            column.low[d]      = 1;
+            column.fwd_cof[d]  = 0;
+            column.back_cof[d] = 0;
+        }
+
+        k    = k_;
+        dir  = dir_;
+        m_s0 = s0;
+        m_s1 = s1;
+        m_columns.assign(s0 * s1, column);
+    }
+
+    inline column_type& operator()(size_type i0, size_type i1)
+    {
+        return m_columns[i0 + i1 * m_s0];
+    }
+    inline const column_type& operator()(size_type i0, size_type i1) const
+    {
+        return m_columns[i0 + i1 * m_s0];
+    }
+
+    inline size_type            size_0() const  { return m_s0; }
+    inline size_type            size_1() const  { return m_s1; }
+    inline bool                 empty()  const  { return m_columns.empty(); }
+    inline const column_vector& columns() const { return m_columns; }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Loads the shape prior from a binary shape-prior file.
+    ///
+    ///  @exception optnet::io::io_error Failed reading the file, or the file
+    ///                              is not a shape-prior file.
+    ///////////////////////////////////////////////////////////////////////
+    void load(const char* name)
+    {
+        FILE* pfile;
+
+        if (0 != secure_fopen(&pfile, name, "rb")) {
+            throw_exception(io::io_error(
+                "shape_prior::load: Failed opening file."
+                ));
+        }
+
+        bool ok = read(pfile);
+        fclose(pfile);
+
+        if (!ok) {
+            throw_exception(io::io_error(
+                "shape_prior::load: Failed reading shape prior."
+                ));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Saves the shape prior into a binary shape-prior file.
+    ///
+    ///  @exception optnet::io::io_error Failed writing the file.
+    ///////////////////////////////////////////////////////////////////////
+    void save(const char* name) const
+    {
+        FILE* pfile;
+
+        if (0 != secure_fopen(&pfile, name, "wb")) {
+            throw_exception(io::io_error(
+                "shape_prior::save: Failed opening file."
+                ));
+        }
+
+        bool ok = write(pfile);
+        if (0 != fclose(pfile)) ok = false;
+
+        if (!ok) {
+            throw_exception(io::io_error(
+                "shape_prior::save: Failed writing shape prior."
+                ));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Reads the shape prior from an open file, at its current position.
+    ///  Files written on a host of the other byte order are swapped.
+    ///
+    ///  @return false on a read error or a malformed record.
+    ///////////////////////////////////////////////////////////////////////
+    bool read(FILE* pfile)
+    {
+        using namespace optnet::utils;
+
+        char    tag[4];
+        int     head[5]; // version, k, dir, s0, s1
+        bool    swap;
+
+        if (fread(tag, 1, 4, pfile) != 4 ||
+            0 != memcmp(tag, magic(), 4) ||
+            fread(head, sizeof(int), 5, pfile) != 5) {
+            return false;
+        }
+
+        swap = (VERSION != head[0]);
+        if (swap) {
+            for (int i = 0; i < 5; ++i) swap_endian32(&head[i]);
+            if (VERSION != head[0]) return false;
+        }
+        if (head[1] < 0 || head[2] < 0 || head[2] > 5 ||
+            head[3] < 0 || head[4] < 0) {
+            return false;
+        }
+
+        // The sizes come from the file: check them against the rest of
+        // the file before allocating the columns.
+        long left = bytes_left(pfile);
+        if (left < 0 ||
+            (head[3] > 0 &&
+             (size_t)head[4] > (size_t)left / sizeof(column_type) / (size_t)head[3])) {
+            return false;
+        }
+
+        k    = (size_type)head[1];
+        dir  = head[2];
+        m_s0 = (size_type)head[3];
+        m_s1 = (size_type)head[4];
+        m_columns.resize(m_s0 * m_s1);
+
+        if (m_columns.empty()) return true;
+        if (fread(&m_columns[0], sizeof(column_type), m_columns.size(), pfile)
+            != m_columns.size()) {
+            return false;
+        }
+
+        if (swap) {
+            int* p = reinterpret_cast<int*>(&m_columns[0]);
+            int* q = p + m_columns.size() * (sizeof(column_type) / sizeof(int));
+            for (; p < q; ++p) swap_endian32(p);
+        }
+
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Writes the shape prior into an open file, at its current position.
+    ///
+    ///  @return false on a write error.
+    ///////////////////////////////////////////////////////////////////////
+    bool write(FILE* pfile) const
+    {
+        int head[5] = { VERSION, (int)k, dir, (int)m_s0, (int)m_s1 };
+
+        if (fwrite(magic(), 1, 4, pfile) != 4 ||
+            fwrite(head, sizeof(int), 5, pfile) != 5) {
+            return false;
+        }
+
+        return m_columns.empty() ||
+            fwrite(&m_columns[0], sizeof(column_type), m_columns.size(), pfile)
+                == m_columns.size();
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    ///  Returns the number of bytes from the current position of an open
+    ///  file to its end, or -1 if the file cannot be positioned.
+    ///////////////////////////////////////////////////////////////////////
+    static long bytes_left(FILE* pfile)
+    {
+        long pos = ftell(pfile), end;
+
+        if (pos < 0 || 0 != fseek(pfile, 0, SEEK_END)) return -1;
+        end = ftell(pfile);
+        if (0 != fseek(pfile, pos, SEEK_SET) || end < pos) return -1;
+
+        return end - pos;
+    }
+
+private:
+
+    enum { VERSION = 1 };
+
+    // The tag of a binary shape-prior record.
+    static const char* magic() { return "OSPR"; }
+
+    size_type       m_s0, m_s1;
+    column_vector   m_columns;
+};
+
+} // optnet
+
+#endif
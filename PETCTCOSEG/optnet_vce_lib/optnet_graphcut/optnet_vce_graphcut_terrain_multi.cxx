@@ -24,7 +24,9 @@ namespace optnet {
 ///////////////////////////////////////////////////////////////////////////
 template <typename _Cost, typename _Cap, typename _Tg>
 optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::optnet_vce_graphcut_terrain_multi() :
-    m_pcost_gs(0)
+    m_pcost_gs(0),
+    m_prior_s0(0),
+    m_prior_s1(0)
 {}
 
 ///////////////////////////////////////////////////////////////////////////
@@ -79,78 +81,21 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::create( size_type s_0, size
     // Temporarily save a pointer to the cost vector.
     //m_pcost = &cost;
 
-	//Initialize hard smoothness constraints;
-	smooth_array.resize( num_surf_graphsearch );
-	for (size_type i = 0; i < num_surf_graphsearch; ++i) {
-        smooth_array[i].smoothDir0 = new int* [ s_0 ];
-		smooth_array[i].smoothDir1 = new int* [ s_0 ];
-		for ( size_type j = 0; j < s_0; j++)
-		{
-			smooth_array[i].smoothDir0[j] = new int [ s_1 ];
-			smooth_array[i].smoothDir1[j] = new int [ s_1 ];
-			for ( size_type k = 0; k < s_1; k++)
-			{
-				smooth_array[i].smoothDir0[j][k] = 1;
-				smooth_array[i].smoothDir1[j][k] = 1;
-			} //for k
-		} //for j
-
-    }//for i
-	//Initialize vce constraints;
-	vce_para.resize( num_surf_graphsearch );
-	for ( size_type i = 0; i < num_surf_graphsearch; ++i ) {
-        vce_para[i].meanDir0 = new int* [s_0];
-		vce_para[i].meanDir1 = new int* [s_0];
-		vce_para[i].upDir0 = new int* [s_0];
-		vce_para[i].upDir1 = new int* [s_0];
-		vce_para[i].lowDir0 = new int* [s_0];
-		vce_para[i].lowDir1 = new int* [s_0];
-		for ( size_type j = 0; j < s_0; j++)
-		{
-			vce_para[i].meanDir0[j] = new int [s_1];
-		    vce_para[i].meanDir1[j] = new int [s_1];
-		    vce_para[i].upDir0[j] = new int [s_1];
-		    vce_para[i].upDir1[j] = new int [s_1];
-		    vce_para[i].lowDir0[j] = new int [s_1];
-		    vce_para[i].lowDir1[j] = new int [s_1];
-			for ( size_type k = 0; k < s_1; k++)
-			{
-                vce_para[i].meanDir0[j][k] = 0;
-		        vce_para[i].meanDir1[j][k] = 0;
-		        vce_para[i].upDir0[j][k] = 1;
-		        vce_para[i].upDir1[j][k] = 1;
-		        vce_para[i].lowDir0[j][k] = 1;
-		        vce_para[i].lowDir1[j][k] = 1;
-			} //for k
-		} //for j
-
-    }//for i
-	//Initialize arc coefficients;
-	arc_cof.resize( num_surf_graphsearch );
-	for ( size_type i = 0; i < num_surf_graphsearch; ++i) {
-        arc_cof[i].fwdDir0 = new int* [s_0];
-		arc_cof[i].fwdDir1 = new int* [s_0];
-		arc_cof[i].backDir0 = new int* [s_0];
-		arc_cof[i].backDir1 = new int* [s_0];
-
-		for ( size_type j = 0; j < s_0; j++)
-		{
-			arc_cof[i].fwdDir0[j] = new int [s_1];
-		    arc_cof[i].fwdDir1[j] = new int [s_1];
-		    arc_cof[i].backDir0[j] = new int [s_1];
-		    arc_cof[i].backDir1[j] = new int [s_1];
-
-			for ( size_type k = 0; k < s_1; k++)
-			{
-                arc_cof[i].fwdDir0[j][k] = 0;
-		        arc_cof[i].fwdDir1[j][k] = 0;
-		        arc_cof[i].backDir0[j][k] = 0;
-		        arc_cof[i].backDir1[j][k] = 0;
-
-			} //for k
-		} //for j
-
-    }//for i
+	// Initialize the per-column shape priors: unit hard smoothness, no
+	// shape deviation and no convex penalties.
+	column_prior_type prior;
+	for ( int d = 0; d < 2; d++ )
+	{
+		prior.smooth[d] = 1;
+		prior.mean[d] = 0;
+		prior.up[d] = 1;
+		prior.low[d] = 1;
+		prior.fwd[d] = 0;
+		prior.back[d] = 0;
+	}
+	m_prior_s0 = s_0;
+	m_prior_s1 = s_1;
+	m_column_prior.assign( num_surf_graphsearch * s_0 * s_1, prior );
 }
 ///////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////
@@ -163,13 +108,13 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::arc_weight(int k , size_typ
    int cof;
    //power = pow_vce;
    if ( dir == 0 && fwdFlag == 0)
-   cof = arc_cof[i3].fwdDir0[i0][i1];
+   cof = column_prior(i3, i0, i1).fwd[0];
    else if ( dir == 0 && fwdFlag == 1)
-   cof = arc_cof[i3].backDir0[i0][i1];
+   cof = column_prior(i3, i0, i1).back[0];
    else if ( dir == 1 && fwdFlag == 0)
-   cof = arc_cof[i3].fwdDir1[i0][i1];
+   cof = column_prior(i3, i0, i1).fwd[1];
    else
-   cof = arc_cof[i3].backDir1[i0][i1];
+   cof = column_prior(i3, i0, i1).back[1];
 
    if ( k == 0)
    weight = cof;
@@ -240,47 +185,35 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::solve_all(net_base_type& ne
     flow = m_graph.solve();
     
     // Get the labeled image..
-    for (i3 = 0; i3 < m_graph.size_3(); ++i3) {	
+    for (i3 = 0; i3 < m_num_surf_graphsearch; ++i3) {	
             for (i1 = 0; i1 < m_graph.size_1(); ++i1) {
                 for (i0 = 0; i0 < m_graph.size_0(); ++i0) {
 
                     // Find upper envelope.
-					if ( i3 < m_num_surf_graphsearch )
-					{
-						 size_type lowest;
+					size_type lowest;
                 
-                         lowest = m_intra[i3].margin[0];
+                    lowest = m_intra[i3].margin[0];
 
-                         for ( i2 = lowest; i2 < m_graph.size_2() - m_intra[i3].margin[1]; ++i2) 
-						 {
-                    
-                             // Find upper envelope.
-                             if (!m_graph.in_source_set(i0, i1, i2, i3))
-                             break;
-                         }
-						 if ( i3 == 0)
-							 net( i0, i1, i2, i3 ) = 1;
-						 else 
-							 net( i0, i1, m_graph.size_2() - i2 - 1, i3 ) = 1;
-					}
-					else
+                    for ( i2 = lowest; i2 < m_graph.size_2() - m_intra[i3].margin[1]; ++i2) 
 					{
-                      for (i2 = 0; i2 < m_graph.size_2(); ++i2) 
-					  {
-						
-                         if ( m_graph.in_source_set( i0, i1, i2, i3 ) )
-						    net( i0, i1, i2, i3 ) = 1;
-					     else
-						    net( i0, i1, i2, i3 ) = 0;
-							
-							
-					  }
-					}
+                    
+                        // Find upper envelope.
+                        if (!m_graph.in_source_set(i0, i1, i2, i3))
+                        break;
+                    }
+					if ( i3 == 0)
+						net( i0, i1, i2, i3 ) = 1;
+					else 
+						net( i0, i1, m_graph.size_2() - i2 - 1, i3 ) = 1;
 
                 } // for i0
             } // for i1
     } // for i3
 
+    // Copy the graph cut labels in memory order.
+    for (i3 = m_num_surf_graphsearch; i3 < m_graph.size_3(); ++i3)
+        m_graph.get_labels(&net(0, 0, 0, i3), i3, 0, m_graph.size_2());
+
     if (0 != pflow)
         *pflow = flow;
 }
@@ -411,42 +344,41 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::transform_costs()
 
     m_graph.set_initial_flow(0);
 
-        // Construct the s-t graph "G_st".
+    std::vector<capacity_type> caps(s0 * s1 * s2);
+    const ptrdiff_t            step = (ptrdiff_t)(s0 * s1);
+
+        // Construct the s-t graph "G_st", one block of arcs per surface.
         for (i3 = 0; i3 < s3; ++i3) {
             // Nodes below margin[0] and above s2-margin[1] will
             // be ignored.
-            for (i2 = m_intra[i3].margin[0] + 1;
-                i2 < s2 - m_intra[i3].margin[1];
-                ++i2) {
+            const size_type lo = m_intra[i3].margin[0];
+            const size_type hi = s2 - m_intra[i3].margin[1];
+
+            std::fill(caps.begin(), caps.end(), (capacity_type)0);
+
+            for (i0 = 0; i0 < s0; ++i0) {
                 for (i1 = 0; i1 < s1; ++i1) {
-                    for (i0 = 0; i0 < s0; ++i0) {
-						capacity_type cap;
-                   
-						if ( i3 == 0 )
-                        cap = (capacity_type)(*m_pcost_gs)(i0, i1, i2, i3)
-                            - (capacity_type)(*m_pcost_gs)(i0, i1, i2 - 1, i3);
-						else     //Reverse the image. 
-						cap = (capacity_type)(*m_pcost_gs)(i0, i1, s2 - i2 - 1, i3)
-                            - (capacity_type)(*m_pcost_gs)(i0, i1, s2 - i2, i3);
-
-                        if (cap >= 0) // non-negative -> connect to t
-                            m_graph.add_st_arc(0, +cap, i0, i1, i2, i3);
-                        else          // negative     -> connect to s
-                            m_graph.add_st_arc(-cap, 0, i0, i1, i2, i3);
-
-                    } // for i0
+                    capacity_type*   col = &caps[(i0 * s1 + i1) * s2];
+                    const cost_type* c   = &(*m_pcost_gs)(i0, i1, 0, i3);
+
+                    // Non-negative -> connect to t, negative -> to s.
+                    if ( i3 == 0 ) {
+                        for (i2 = lo + 1; i2 < hi; ++i2)
+                            col[i2] = (capacity_type)c[i2 * step]
+                                    - (capacity_type)c[(i2 - 1) * step];
+                    }
+                    else {   //Reverse the image. 
+                        for (i2 = lo + 1; i2 < hi; ++i2)
+                            col[i2] = (capacity_type)c[(s2 - i2 - 1) * step]
+                                    - (capacity_type)c[(s2 - i2) * step];
+                    }
+
+                    // cost = -1 at the lowest margin.
+                    col[lo] = -100000;
                 } // for i1
-            } // for i2
-        } // for i3
+            } // for i0
 
-        for (i3 = 0; i3 < s3; ++i3) {
-            i2 = m_intra[i3].margin[0]; // lowest margin
-            for (i1 = 0; i1 < s1; ++i1) {
-                for (i0 = 0; i0 < s0; ++i0) {
-                    // cost = -1
-                    m_graph.add_st_arc(100000, 0, i0, i1, i2, i3);
-                } // for i0
-            } // for i1
+            m_graph.add_st_arcs(&caps[0], caps.size(), 0, 0, 0, i3);
         } // for i3
 
 
@@ -499,14 +431,14 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_arcs()
         
             for (i1 = 0; i1 < s1; ++i1) {
                 for (i0 = 1; i0 < s0 - 1; ++i0) {
-					for (i2 = s2 - bounds1 - 1; i2 > smooth_array[i3].smoothDir0[i0][i1] + bounds0; --i2) {
+					for (i2 = s2 - bounds1 - 1; i2 > column_prior(i3, i0, i1).smooth[0] + bounds0; --i2) {
 					
-                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0 - 1,      i1,          i2 - smooth_array[i3].smoothDir0[i0][i1],    i3);
-                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0 + 1,      i1,          i2 - smooth_array[i3].smoothDir0[i0][i1],    i3);
+                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0 - 1,      i1,          i2 - column_prior(i3, i0, i1).smooth[0],    i3);
+                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0 + 1,      i1,          i2 - column_prior(i3, i0, i1).smooth[0],    i3);
 					} }{
-                    for (i2 = s2 - bounds1 - 1; i2 > smooth_array[i3].smoothDir0[i0][i1] + bounds0; --i2) {
-                    m_graph.add_arc(0,           i1,          i2,          i3,          1,           i1,          i2 - smooth_array[i3].smoothDir0[i0][i1],    i3);
-                    m_graph.add_arc(s0 - 1,      i1,          i2,          i3,          s0 - 2,      i1,          i2 - smooth_array[i3].smoothDir0[i0][i1],    i3);
+                    for (i2 = s2 - bounds1 - 1; i2 > column_prior(i3, i0, i1).smooth[0] + bounds0; --i2) {
+                    m_graph.add_arc(0,           i1,          i2,          i3,          1,           i1,          i2 - column_prior(i3, i0, i1).smooth[0],    i3);
+                    m_graph.add_arc(s0 - 1,      i1,          i2,          i3,          s0 - 2,      i1,          i2 - column_prior(i3, i0, i1).smooth[0],    i3);
 					}
                 } // for i0 boundary condition
             } // for i1
@@ -518,14 +450,14 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_arcs()
 			 
             for (i0 = 0; i0 < s0; ++i0) {
                 for (i1 = 1; i1 < s1 - 1; ++i1) {
-					for (i2 = s2 - bounds1 - 1; i2 > smooth_array[i3].smoothDir1[i0][i1] + bounds0; --i2) {
-                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0,          i1 - 1,      i2 - smooth_array[i3].smoothDir1[i0][i1],    i3);
-                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0,          i1 + 1,      i2 - smooth_array[i3].smoothDir1[i0][i1],    i3);
+					for (i2 = s2 - bounds1 - 1; i2 > column_prior(i3, i0, i1).smooth[1] + bounds0; --i2) {
+                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0,          i1 - 1,      i2 - column_prior(i3, i0, i1).smooth[1],    i3);
+                    m_graph.add_arc(i0,          i1,          i2,          i3,          i0,          i1 + 1,      i2 - column_prior(i3, i0, i1).smooth[1],    i3);
 			        }
                    } {
-                   for (i2 = s2 - bounds1 - 1;i2 > smooth_array[i3].smoothDir1[i0][i1] + bounds0;--i2) {
-                    m_graph.add_arc(i0,          0,           i2,          i3,          i0,          1,           i2 - smooth_array[i3].smoothDir1[i0][i1],    i3);
-                    m_graph.add_arc(i0,          s1 - 1,      i2,          i3,          i0,          s1 - 2,      i2 - smooth_array[i3].smoothDir1[i0][i1],    i3);
+                   for (i2 = s2 - bounds1 - 1;i2 > column_prior(i3, i0, i1).smooth[1] + bounds0;--i2) {
+                    m_graph.add_arc(i0,          0,           i2,          i3,          i0,          1,           i2 - column_prior(i3, i0, i1).smooth[1],    i3);
+                    m_graph.add_arc(i0,          s1 - 1,      i2,          i3,          i0,          s1 - 2,      i2 - column_prior(i3, i0, i1).smooth[1],    i3);
 			      }
                 } // for i0
             } // for i1
@@ -741,26 +673,26 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
 				
 				int upBound = 0, lowBound = 0; 
 				//Forward
-                if ( vce_para[i3].meanDir0[i0][i1] > 0 )
-				upBound = vce_para[i3].meanDir0[i0][i1];
+                if ( column_prior(i3, i0, i1).mean[0] > 0 )
+				upBound = column_prior(i3, i0, i1).mean[0];
 				//cout<<"The upBound is: "<<upBound<<endl;
 
-				if ( (vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1]) < 0 )
-				lowBound = - ( vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1]);
+				if ( (column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0]) < 0 )
+				lowBound = - ( column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0]);
 
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < vce_para[i3].lowDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3,  0,   0),     i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + vce_para[i3].meanDir0[i0][i1] - k,		i3 );
+					for (int k = 0; k < column_prior(i3, i0, i1).low[0]; k++)
+				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3,  0,   0),     i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + column_prior(i3, i0, i1).mean[0] - k,		i3 );
 					
-					m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1],		i3 );//Hard constraint
+					m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0],		i3 );//Hard constraint
 				
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0]) <= (s2 - 1) )
+						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0],		i3 );//Hard constraint
 					else
 						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          s2 - 1,		i3 );//Hard constraint
 				
@@ -769,39 +701,39 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1]) >= 0 )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + vce_para[i3].meanDir0[i0][i1] - vce_para[i3].lowDir0[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0]) >= 0 )
+						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          i2 + column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).low[0],		i3 );//Hard constraint
 					else
 						m_graph.add_arc(i0,          i1,          i2,          i3,		i0 + 1,      i1,          0,		i3 );//Hard constraint
 				}
 				//End boundary condition
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( vce_para[i3].meanDir0[i0][i1] < 0 )
-				upBound = -vce_para[i3].meanDir0[i0][i1];
+				if ( column_prior(i3, i0, i1).mean[0] < 0 )
+				upBound = -column_prior(i3, i0, i1).mean[0];
 
-				if ( (vce_para[i3].meanDir0[i0][i1] + vce_para[i3].upDir0[i0][i1]) > 0 )
-				lowBound = vce_para[i3].meanDir0[i0][i1] + vce_para[i3].upDir0[i0][i1];
+				if ( (column_prior(i3, i0, i1).mean[0] + column_prior(i3, i0, i1).up[0]) > 0 )
+				lowBound = column_prior(i3, i0, i1).mean[0] + column_prior(i3, i0, i1).up[0];
 
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < vce_para[i3].upDir0[i0][i1]; k++)
-				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3, 0,  1),     i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir0[i0][i1] - k,		i3 );
+					for (int k = 0; k < column_prior(i3, i0, i1).up[0]; k++)
+				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3, 0,  1),     i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[0] - k,		i3 );
 
-					m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir0[i0][i1] - vce_para[i3].upDir0[i0][i1],		i3 );//Hard constraints
+					m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).up[0],		i3 );//Hard constraints
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - vce_para[i3].meanDir0[i0][i1] - vce_para[i3].upDir0[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir0[i0][i1] - vce_para[i3].upDir0[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).up[0]) <= (s2 - 1) )
+						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).up[0],		i3 );//Hard constraints
 					else
 						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          s2 - 1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - vce_para[i3].meanDir0[i0][i1] - vce_para[i3].upDir0[i0][i1]) >= 0 )
-						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir0[i0][i1] - vce_para[i3].upDir0[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).up[0]) >= 0 )
+						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[0] - column_prior(i3, i0, i1).up[0],		i3 );//Hard constraints
 					else
 						m_graph.add_arc( i0 + 1,          i1,          i2,          i3,		i0,      i1,          0,		i3 );//Hard constraints
 				}
@@ -826,7 +758,7 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
   
 	  //Smaller than hard smoothness constraints
 	  /*
-		for (i2 = smooth_array[i3].smoothDir0[i0][i1]; i2>0; --i2){
+		for (i2 = column_prior(i3, i0, i1).smooth[0]; i2>0; --i2){
 			for (i1 = 0; i1 < s1; ++i1) {
             for (i0 = 1; i0 < s0 - 1; ++i0) {
 
@@ -868,31 +800,31 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
 				
 				int upBound = 0, lowBound = 0; 
 				//Forward
-                if ( vce_para[i3].meanDir1[i0][i1] > 0 )
-				upBound = vce_para[i3].meanDir1[i0][i1];
+                if ( column_prior(i3, i0, i1).mean[1] > 0 )
+				upBound = column_prior(i3, i0, i1).mean[1];
 
-				if ( (vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1]) < 0 )
-				lowBound = - ( vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1]);
+				if ( (column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1]) < 0 )
+				lowBound = - ( column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1]);
 
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < vce_para[i3].lowDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3, 1,  0),     i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + vce_para[i3].meanDir1[i0][i1] - k,		i3 );
+					for (int k = 0; k < column_prior(i3, i0, i1).low[1]; k++)
+				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3, 1,  0),     i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + column_prior(i3, i0, i1).mean[1] - k,		i3 );
 					
-					m_graph.add_arc( i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1],		i3 );//Hard constraint
+					m_graph.add_arc( i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1],		i3 );//Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 				{
-					if ( (i2 + vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1]) <= (s2 - 1) )
+						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1],		i3 );//Hard constraint
 					else
 						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          s2 - 1,		i3 );//Hard constraint
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 + vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1]) >= 0 )
-						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + vce_para[i3].meanDir1[i0][i1] - vce_para[i3].lowDir1[i0][i1],		i3 );//Hard constraint
+					if ( (i2 + column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1]) >= 0 )
+						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          i2 + column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).low[1],		i3 );//Hard constraint
 					else
 						m_graph.add_arc(i0,          i1,          i2,          i3,		i0,      i1 + 1,          0,		i3 );//Hard constraint
 				}
@@ -900,31 +832,31 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
 
 				//Backward
 				upBound = 0, lowBound = 0;
-				if ( vce_para[i3].meanDir1[i0][i1] < 0 )
-				upBound = -vce_para[i3].meanDir1[i0][i1];
+				if ( column_prior(i3, i0, i1).mean[1] < 0 )
+				upBound = -column_prior(i3, i0, i1).mean[1];
 
-				if ( (vce_para[i3].meanDir1[i0][i1] + vce_para[i3].upDir1[i0][i1]) > 0 )
-				lowBound = vce_para[i3].meanDir1[i0][i1] + vce_para[i3].upDir1[i0][i1];
+				if ( (column_prior(i3, i0, i1).mean[1] + column_prior(i3, i0, i1).up[1]) > 0 )
+				lowBound = column_prior(i3, i0, i1).mean[1] + column_prior(i3, i0, i1).up[1];
 
 				for (i2 = s2 - 1 - upBound; i2 >= lowBound; --i2) {
                 
-					for (int k = 0; k < vce_para[i3].upDir1[i0][i1]; k++)
-				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3, 1,   1),     i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir1[i0][i1] - k,		i3 );
+					for (int k = 0; k < column_prior(i3, i0, i1).up[1]; k++)
+				    m_graph.add_arc_cost(arc_weight(k, i0, i1, i3, 1,   1),     i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[1] - k,		i3 );
 				    
-					m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir1[i0][i1] - vce_para[i3].upDir1[i0][i1],		i3 ); //Hard constraint
+					m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).up[1],		i3 ); //Hard constraint
 				} //for i2
 				//Boundary condition
 				for ( i2 = s2 - upBound; i2 <= s2 - 1; i2++ )
 					{
-					if ( (i2 - vce_para[i3].meanDir1[i0][i1] - vce_para[i3].upDir1[i0][i1]) <= (s2 - 1) )
-						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir1[i0][i1] - vce_para[i3].upDir1[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).up[1]) <= (s2 - 1) )
+						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).up[1],		i3 );//Hard constraints
 					else
 						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          s2 - 1,		i3 );//Hard constraints
 				}
 				for ( i2 = lowBound - 1; i2 >= 0; i2-- )
 				{
-					if ( (i2 - vce_para[i3].meanDir1[i0][i1] - vce_para[i3].upDir1[i0][i1]) >= 0 )
-						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - vce_para[i3].meanDir1[i0][i1] - vce_para[i3].upDir1[i0][i1],		i3 );//Hard constraints
+					if ( (i2 - column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).up[1]) >= 0 )
+						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          i2 - column_prior(i3, i0, i1).mean[1] - column_prior(i3, i0, i1).up[1],		i3 );//Hard constraints
 					else
 						m_graph.add_arc( i0,          i1 + 1,          i2,          i3,		i0,      i1,          0,		i3 );//Hard constraints
 				}
@@ -948,7 +880,7 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
    
 	  //Smaller than hard smoothness constraints
       /*
-		for (i2 = smooth_array[i3].smoothDir1[i0][i1]; i2>0; --i2){
+		for (i2 = column_prior(i3, i0, i1).smooth[1]; i2>0; --i2){
 		  for (i0 = 0; i0 < s0; ++i0) {
 			for (i1 = 1; i1 < s1 - 1; ++i1) {
             
@@ -1076,9 +1008,6 @@ optnet_vce_graphcut_terrain_multi<_Cost, _Cap, _Tg>::build_vce_arcs()
 	  }
 
      */	
-    //Free memory
-		vce_para.clear();
-		arc_cof.clear();
 
 
   
@@ -70,33 +70,16 @@ class optnet_vce_graphcut_terrain_multi
     typedef std::vector<_Intra>                 intra_vector;
     typedef std::vector<_Inter>                 inter_vector;
 	
-	struct _Smooth{               //Added by Sq
-		int     **smoothDir0;        
-		int     **smoothDir1;        
+	struct _Column_prior{          // Shape prior of one column, for the
+		int     smooth[2];          // two in-plane directions (dir-0 and
+		int     mean[2];            // dir-1), stored contiguously so that
+		int     up[2];              // building the arcs of a column reads
+		int     low[2];             // a single record.
+		int     fwd[2];
+		int     back[2];
 	};
 
-	typedef std::vector<_Smooth>           smooth_vector;
-
-	struct _ArcCof{               //Added by Sq
-		int     **fwdDir0;
-		int     **backDir0;
-		int     **fwdDir1;
-		int     **backDir1;
-	};
-
-	typedef std::vector<_ArcCof>              arc_cof_vector;
-
-
-	struct _VCE{               //Added by Sq
-		int     **meanDir0;        
-		int     **meanDir1;
-		int     **upDir0;
-		int     **upDir1;
-		int     **lowDir0;
-		int     **lowDir1;
-	};
-
-	typedef std::vector<_VCE>              vce_vector;
+	typedef std::vector<_Column_prior>     column_prior_vector;
 
 	
 
@@ -129,9 +112,21 @@ public:
 	capacity_type **arc_cost_pos;
 	capacity_type **arc_cost_neg;
 	int pow_vce;
-	smooth_vector   smooth_array;
-	vce_vector      vce_para;
-	arc_cof_vector  arc_cof;
+
+	typedef _Column_prior                       column_prior_type;
+
+	///////////////////////////////////////////////////////////////////////
+	///  Returns the shape prior of column (i0, i1) of the k-th
+	///  graph-search surface. The priors are allocated by create().
+	///////////////////////////////////////////////////////////////////////
+	column_prior_type& column_prior(size_type k, size_type i0, size_type i1)
+	{
+		return m_column_prior[(k * m_prior_s1 + i1) * m_prior_s0 + i0];
+	}
+	const column_prior_type& column_prior(size_type k, size_type i0, size_type i1) const
+	{
+		return m_column_prior[(k * m_prior_s1 + i1) * m_prior_s0 + i0];
+	}
     
     ///////////////////////////////////////////////////////////////////////
     /// Default constructor.
@@ -298,6 +293,9 @@ private:
     graph_type                m_graph;
     intra_vector              m_intra;
     inter_vector              m_inter;
+	column_prior_vector       m_column_prior;
+	size_type                 m_prior_s0;
+	size_type                 m_prior_s1;
 	inter_cutsearch_vector    m_inter_cutsearch;
 	size_type                 m_num_surf_graphsearch;
 	size_type                 m_num_surf_graphcut;